@@ -616,10 +616,10 @@ bool KateDocManager::loadMetaInfos(KTextEditor::Document *doc, const KUrl &url)
 
   QByteArray md5;
   bool ok = true;
+  KConfigGroup urlGroup( m_metaInfos, url.prettyUrl() );
 
-  if (computeUrlMD5(url, md5))
+  if (urlMD5(urlGroup, url, md5))
   {
-    KConfigGroup urlGroup( m_metaInfos, url.prettyUrl() );
     const QString old_md5 = urlGroup.readEntry("MD5");
 
     if ((const char *)md5 == old_md5)
@@ -663,7 +663,13 @@ void KateDocManager::saveMetaInfos(KTextEditor::Document *doc)
     return;
   }
 
-  if (computeUrlMD5(doc->url(), md5))
+  // the document computed the digest of the file while loading or saving it,
+  // it only describes the file on disk if nobody changed that meanwhile
+  const bool modifiedOnDisc = documentInfo(doc)->modifiedOnDisc;
+  if (!modifiedOnDisc)
+    md5 = doc->property("digest").toByteArray();
+
+  if (!md5.isEmpty() || computeUrlMD5(doc->url(), md5))
   {
     KConfigGroup urlGroup( m_metaInfos, doc->url().prettyUrl() );
 
@@ -672,10 +678,39 @@ void KateDocManager::saveMetaInfos(KTextEditor::Document *doc)
 
     urlGroup.writeEntry("MD5", (const char *)md5);
     urlGroup.writeEntry("Time", QDateTime::currentDateTime());
+
+    // remember the file the digest belongs to, loadMetaInfos() then doesn't hash it again
+    const QFileInfo fi(doc->url().toLocalFile());
+    if (doc->url().isLocalFile() && fi.exists() && !modifiedOnDisc)
+    {
+      urlGroup.writeEntry("Size", fi.size());
+      urlGroup.writeEntry("Modified", fi.lastModified());
+    }
+    else
+    {
+      urlGroup.deleteEntry("Size");
+      urlGroup.deleteEntry("Modified");
+    }
+
     m_metaInfos->sync();
   }
 }
 
+bool KateDocManager::urlMD5(const KConfigGroup &urlGroup, const KUrl &url, QByteArray &result)
+{
+  // file unchanged since the digest was stored: no need to read it
+  const QFileInfo fi(url.toLocalFile());
+  if (url.isLocalFile() && fi.exists() && urlGroup.hasKey("Size") && urlGroup.hasKey("Modified")
+      && urlGroup.readEntry("Size", qint64(-1)) == fi.size()
+      && urlGroup.readEntry("Modified", QDateTime()) == fi.lastModified())
+  {
+    result = urlGroup.readEntry("MD5", QString()).toLatin1();
+    return !result.isEmpty();
+  }
+
+  return computeUrlMD5(url, result);
+}
+
 bool KateDocManager::computeUrlMD5(const KUrl &url, QByteArray &result)
 {
   QFile f(url.toLocalFile());
@@ -41,6 +41,7 @@ namespace KParts
 }
 
 class KConfig;
+class KConfigGroup;
 class KateMainWindow;
 
 class KateDocumentInfo
@@ -199,6 +200,7 @@ class KateDocManager : public QObject
     bool loadMetaInfos(KTextEditor::Document *doc, const KUrl &url);
     void saveMetaInfos(KTextEditor::Document *doc);
     bool computeUrlMD5(const KUrl &url, QByteArray &result);
+    bool urlMD5(const KConfigGroup &urlGroup, const KUrl &url, QByteArray &result);
 
     Kate::DocumentManager *m_documentManager;
     QList<KTextEditor::Document*> m_docList;
@@ -33,6 +33,9 @@ KateProject::KateProject ()
   : QObject ()
   , m_worker (new KateProjectWorker (this))
   , m_thread (m_worker)
+  , m_indexPending (false)
+  , m_indexDirty (false)
+  , m_trigramIndexPending (false)
   , m_notesDocument(0)
 {
   /**
@@ -168,6 +171,12 @@ void KateProject::loadProjectDone (KateProjectSharedQStandardItem topLevel, Kate
    * model changed
    */
   emit modelChanged ();
+
+  /**
+   * update indices for new files list
+   */
+  updateIndex ();
+  updateTrigramIndex ();
 }
 
 void KateProject::loadIndexDone (KateProjectSharedProjectIndex projectIndex)
@@ -176,11 +185,75 @@ void KateProject::loadIndexDone (KateProjectSharedProjectIndex projectIndex)
    * move to our project
    */
   m_projectIndex = projectIndex;
+  m_indexPending = false;
 
   /**
    * notify external world that data is available
    */
   emit indexChanged ();
+
+  /**
+   * files changed in between? update again
+   */
+  if (m_indexDirty)
+    updateIndex ();
+}
+
+void KateProject::updateIndex ()
+{
+  /**
+   * already updating? do it again afterwards
+   */
+  if (m_indexPending) {
+    m_indexDirty = true;
+    return;
+  }
+
+  /**
+   * store index as project local file, else in the temp dir
+   */
+  QString ctagsIndexFile = m_fileName + ".d" + QDir::separator() + "ctags";
+  if (!QDir().mkpath (m_fileName + ".d"))
+    ctagsIndexFile = QDir::tempPath () + QString ("/kate.project.%1.ctags").arg (qHash (m_fileName));
+
+  /**
+   * trigger worker to update the index
+   */
+  m_indexPending = true;
+  m_indexDirty = false;
+  QMetaObject::invokeMethod (m_worker, "loadIndex", Qt::QueuedConnection, Q_ARG(QString, ctagsIndexFile), Q_ARG(QStringList, files ()));
+}
+
+void KateProject::updateTrigramIndex ()
+{
+  /**
+   * not wanted for this project? drop any old index
+   */
+  if (!m_projectMap["trigrams"].toBool()) {
+    m_trigramIndex.clear ();
+    return;
+  }
+
+  /**
+   * already building, or no place to store the index?
+   */
+  if (m_trigramIndexPending || !QDir().mkpath (m_fileName + ".d"))
+    return;
+
+  /**
+   * trigger worker to build the index
+   */
+  m_trigramIndexPending = true;
+  QMetaObject::invokeMethod (m_worker, "loadTrigramIndex", Qt::QueuedConnection, Q_ARG(QString, m_fileName + ".d" + QDir::separator() + "trigrams.index"), Q_ARG(QStringList, files ()));
+}
+
+void KateProject::loadTrigramIndexDone (KateProjectSharedTrigramIndex trigramIndex)
+{
+  /**
+   * move to our project
+   */
+  m_trigramIndex = trigramIndex;
+  m_trigramIndexPending = false;
 }
 
 QFile *KateProject::projectLocalFile (const QString &file) const
@@ -27,6 +27,7 @@
 #include <QTextDocument>
 
 #include "kateprojectindex.h"
+#include "kateprojecttrigramindex.h"
 
 /**
  * Shared pointer data types.
@@ -41,6 +42,9 @@ Q_DECLARE_METATYPE(KateProjectSharedQMapStringItem)
 typedef QSharedPointer<KateProjectIndex> KateProjectSharedProjectIndex;
 Q_DECLARE_METATYPE(KateProjectSharedProjectIndex)
 
+typedef QSharedPointer<KateProjectTrigramIndex> KateProjectSharedTrigramIndex;
+Q_DECLARE_METATYPE(KateProjectSharedTrigramIndex)
+
 /**
  * Private worker thread.
  * Will take care of worker object deletion.
@@ -186,6 +190,32 @@ class KateProject : public QObject
     {
       return m_projectIndex.data();
     }
+
+    /**
+     * Update the project index in the background.
+     * Only the files changed since the last update are tagged again,
+     * the current index stays usable until the new one is there.
+     * Will be stored in a projectLocalFile "ctags".
+     */
+    void updateIndex ();
+
+    /**
+     * Access to the trigram index of the project files.
+     * May be null, the index is only built if the project enables "trigrams".
+     * Don't store this pointer, might change.
+     * @return trigram index
+     */
+    KateProjectTrigramIndex *trigramIndex ()
+    {
+      return m_trigramIndex.data();
+    }
+
+    /**
+     * Build or update the trigram index in the background, if the project enables it.
+     * Only the new and changed files are read again.
+     * Will be stored in a projectLocalFile "trigrams.index".
+     */
+    void updateTrigramIndex ();
     
     /**
      * Will try to open a project local file.
@@ -221,6 +251,12 @@ class KateProject : public QObject
      */
     void loadIndexDone (KateProjectSharedProjectIndex projectIndex);
 
+    /**
+     * Used for worker to send back the results of trigram index loading
+     * @param trigramIndex new trigram index
+     */
+    void loadTrigramIndexDone (KateProjectSharedTrigramIndex trigramIndex);
+
   signals:
     /**
      * Emited on project map changes.
@@ -289,6 +325,26 @@ class KateProject : public QObject
      * project index, if any
      */
     KateProjectSharedProjectIndex m_projectIndex;
+
+    /**
+     * is the worker updating the project index?
+     */
+    bool m_indexPending;
+
+    /**
+     * did files change while the project index was updated?
+     */
+    bool m_indexDirty;
+
+    /**
+     * trigram index, if any
+     */
+    KateProjectSharedTrigramIndex m_trigramIndex;
+
+    /**
+     * is the worker building a trigram index?
+     */
+    bool m_trigramIndexPending;
     
     /**
      * notes buffer for project local notes
@@ -22,14 +22,43 @@
 
 #include <QProcess>
 #include <QDir>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QTemporaryFile>
 
 /**
  * include ctags reading
  */
 #include "ctags/readtags.c"
 
-KateProjectIndex::KateProjectIndex (const QStringList &files)
- : m_ctagsIndexFile (QDir::tempPath () + "/kate.project.ctags")
+/**
+ * pseudo tag for each indexed file, with its state when tagged
+ */
+static const char KateFilePseudoTag[] = "!_KATE_FILE\t";
+
+/**
+ * compare tag lines byte wise, like the sort of ctags does
+ */
+static bool tagLineLessThan (const QByteArray &line1, const QByteArray &line2)
+{
+  const int compare = memcmp (line1.constData(), line2.constData(), qMin (line1.size(), line2.size()));
+  return compare ? (compare < 0) : (line1.size() < line2.size());
+}
+
+/**
+ * get file name of a tag line, the second field
+ */
+static QByteArray tagLineFile (const QByteArray &line)
+{
+  const int start = line.indexOf ('\t') + 1;
+  const int end = start ? line.indexOf ('\t', start) : -1;
+  return (end < 0) ? QByteArray () : QByteArray::fromRawData (line.constData() + start, end - start);
+}
+
+KateProjectIndex::KateProjectIndex (const QStringList &files, const QString &ctagsIndexFile)
+ : m_ctagsIndexFile (ctagsIndexFile)
  , m_ctagsIndexHandle (0)
 {
   /**
@@ -50,29 +79,146 @@ KateProjectIndex::~KateProjectIndex ()
 }
 
 void KateProjectIndex::loadCtags (const QStringList &files)
+{
+  /**
+   * read old index, if any
+   */
+  QByteArray oldIndex;
+  QFile oldIndexFile (m_ctagsIndexFile);
+  if (oldIndexFile.open (QIODevice::ReadOnly)) {
+    oldIndex = oldIndexFile.readAll ();
+    oldIndexFile.close ();
+  }
+
+  /**
+   * split it up into lines, the pseudo tags are in front
+   * get the state of the files at the time they were tagged
+   */
+  QList<QByteArray> oldTags = oldIndex.split ('\n');
+  QHash<QByteArray, QByteArray> oldStates;
+  int firstOldTag = 0;
+  for (; firstOldTag < oldTags.size () && oldTags[firstOldTag].startsWith ("!_"); ++firstOldTag) {
+    const QByteArray &line = oldTags[firstOldTag];
+    if (line.startsWith (KateFilePseudoTag)) {
+      const QByteArray file = tagLineFile (line);
+      oldStates.insert (QByteArray (file.constData(), file.size()), line.mid (line.lastIndexOf ('\t') + 1));
+    }
+  }
+
+  /**
+   * unchanged files keep their tags, the others need to be tagged
+   */
+  QSet<QByteArray> unchangedFiles;
+  QList<QPair<QByteArray, QByteArray> > states;
+  QStringList changedFiles;
+  foreach (const QString &file, files) {
+    const QFileInfo info (file);
+    const QByteArray name = QFile::encodeName (file);
+    const QByteArray state = QByteArray::number (info.lastModified ().toTime_t ()) + ' ' + QByteArray::number (info.size ());
+    states.append (qMakePair (name, state));
+
+    if (oldStates.value (name) == state)
+      unchangedFiles.insert (name);
+    else
+      changedFiles.append (file);
+  }
+
+  /**
+   * nothing changed, nothing removed? use the old index as it is
+   */
+  if (changedFiles.isEmpty () && unchangedFiles.size () == oldStates.size () && !oldStates.isEmpty ()) {
+    tagFileInfo info;
+    memset (&info, 0, sizeof (tagFileInfo));
+    m_ctagsIndexHandle = tagsOpen (QFile::encodeName (m_ctagsIndexFile), &info);
+    return;
+  }
+
+  /**
+   * tag the changed files
+   * if that fails, ctags is not around, no index
+   */
+  QList<QByteArray> newTags;
+  if (!changedFiles.isEmpty () && !runCtags (changedFiles, newTags))
+    return;
+
+  /**
+   * write new index: pseudo tags, then the tags of the unchanged files merged with the new ones
+   */
+  QFile newIndexFile (m_ctagsIndexFile + ".new");
+  if (!newIndexFile.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    return;
+
+  newIndexFile.write ("!_TAG_FILE_FORMAT\t2\t/extended format/\n");
+  newIndexFile.write ("!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n");
+  for (int i = 0; i < states.size (); ++i)
+    newIndexFile.write (KateFilePseudoTag + states[i].first + '\t' + states[i].second + '\n');
+
+  int oldTag = firstOldTag;
+  int newTag = 0;
+  while (true) {
+    /**
+     * skip old tags of changed or removed files
+     */
+    while (oldTag < oldTags.size () && (oldTags[oldTag].isEmpty () || !unchangedFiles.contains (tagLineFile (oldTags[oldTag]))))
+      ++oldTag;
+
+    const bool oldLeft = oldTag < oldTags.size ();
+    const bool newLeft = newTag < newTags.size ();
+    if (!oldLeft && !newLeft)
+      break;
+
+    const QByteArray &line = (!newLeft || (oldLeft && tagLineLessThan (oldTags[oldTag], newTags[newTag]))) ? oldTags[oldTag++] : newTags[newTag++];
+    newIndexFile.write (line);
+    newIndexFile.write ("\n");
+  }
+
+  const bool written = newIndexFile.error () == QFile::NoError;
+  newIndexFile.close ();
+  if (!written)
+    return;
+
+  /**
+   * replace old index, readers of it keep their open file
+   * if that fails, use the new file
+   */
+  QString indexFile = m_ctagsIndexFile;
+  QFile::remove (m_ctagsIndexFile);
+  if (!QFile::rename (newIndexFile.fileName (), m_ctagsIndexFile))
+    indexFile = newIndexFile.fileName ();
+
+  /**
+   * try to open ctags file
+   */
+  tagFileInfo info;
+  memset (&info, 0, sizeof (tagFileInfo));
+  m_ctagsIndexHandle = tagsOpen (QFile::encodeName (indexFile), &info);
+}
+
+bool KateProjectIndex::runCtags (const QStringList &files, QList<QByteArray> &tags)
 {
   /**
    * create temporary file
    * if not possible, fail
    */
-  if (!m_ctagsIndexFile.open ())
-    return;
+  QTemporaryFile ctagsFile (QDir::tempPath () + "/kate.project.ctags");
+  if (!ctagsFile.open ())
+    return false;
   
   /**
    * close file again, other process will use it
    */
-  m_ctagsIndexFile.close ();
+  ctagsFile.close ();
    
   /**
-   * try to run ctags for all files in this project
-   * output to our ctags index file
+   * try to run ctags for the files
+   * output to our temporary file, sorted below
    */
   QProcess ctags;
   QStringList args;
-  args << "-L" << "-" << "-f" << m_ctagsIndexFile.fileName() << "--fields=+K+n";
+  args << "-L" << "-" << "-f" << ctagsFile.fileName() << "--fields=+K+n" << "--sort=no";
   ctags.start("ctags", args);
   if (!ctags.waitForStarted())
-    return;
+    return false;
   
   /**
    * write files list and close write channel
@@ -81,39 +227,28 @@ void KateProjectIndex::loadCtags (const QStringList &files)
   ctags.closeWriteChannel();
     
   /**
-   * wait for done
+   * wait for done, tagging a lot of files may take a while
    */
-  if (!ctags.waitForFinished())
-    return;
+  if (!ctags.waitForFinished(-1))
+    return false;
   
   /**
    * file not openable, bad
    */
-  if (!m_ctagsIndexFile.open ())
-    return;
-  
-  /**
-   * get size
-   */
-  qint64 size = m_ctagsIndexFile.size ();
-  
-  /**
-   * close again
-   */
-  m_ctagsIndexFile.close ();
-  
-  /**
-   * empty file, bad
-   */
-  if (!size)
-    return;
-  
+  if (!ctagsFile.open ())
+    return false;
+
   /**
-   * try to open ctags file
+   * collect the tags, without the pseudo tags
    */
-  tagFileInfo info;
-  memset (&info, 0, sizeof (tagFileInfo));
-  m_ctagsIndexHandle = tagsOpen (m_ctagsIndexFile.fileName().toLocal8Bit(), &info);
+  foreach (const QByteArray &line, ctagsFile.readAll ().split ('\n')) {
+    if (!line.isEmpty () && !line.startsWith ("!_"))
+      tags.append (line);
+  }
+  ctagsFile.close ();
+
+  qSort (tags.begin (), tags.end (), tagLineLessThan);
+  return true;
 }
 
 void KateProjectIndex::findMatches (QStandardItemModel &model, const QString &searchWord, MatchType type)
@@ -25,7 +25,6 @@
 #include <ktexteditor/view.h>
 
 #include <QStringList>
-#include <QTemporaryFile>
 #include <QStandardItemModel>
 
 /**
@@ -39,6 +38,10 @@
  * Allows you to search for stuff and to get some useful auto-completion.
  * Is created in Worker thread in the background, then passed to project in
  * the main thread for usage.
+ *
+ * The ctags index is kept in a file between updates, only the files changed
+ * since the last update are tagged again. An update writes a new file and
+ * replaces the old one, an index in use keeps reading the old one.
  */
 class KateProjectIndex
 {
@@ -46,8 +49,9 @@ class KateProjectIndex
     /**
      * construct new index for given files
      * @param files files to index
+     * @param ctagsIndexFile file to store the ctags index in, an index in it is updated
      */
-    KateProjectIndex (const QStringList &files);
+    KateProjectIndex (const QStringList &files, const QString &ctagsIndexFile);
 
     /**
      * deconstruct project
@@ -91,16 +95,24 @@ class KateProjectIndex
 
   private:
     /**
-     * Load ctags tags.
+     * Load ctags tags, tag the files changed since the last update.
      * @param files files to index
      */
     void loadCtags (const QStringList &files);
+
+    /**
+     * Run ctags for the given files.
+     * @param files files to tag
+     * @param tags tag lines, without pseudo tags, will be filled
+     * @return success
+     */
+    bool runCtags (const QStringList &files, QList<QByteArray> &tags);
     
   private:
     /**
      * ctags index file
      */
-    QTemporaryFile m_ctagsIndexFile;
+    QString m_ctagsIndexFile;
     
     /**
      * handle to ctags file for querying, if possible
@@ -51,6 +51,7 @@ KateProjectPlugin::KateProjectPlugin (QObject* parent, const QList<QVariant>&)
   qRegisterMetaType<KateProjectSharedQStandardItem>("KateProjectSharedQStandardItem");
   qRegisterMetaType<KateProjectSharedQMapStringItem>("KateProjectSharedQMapStringItem");
   qRegisterMetaType<KateProjectSharedProjectIndex>("KateProjectSharedProjectIndex");
+  qRegisterMetaType<KateProjectSharedTrigramIndex>("KateProjectSharedTrigramIndex");
  
   /**
    * connect to important signals, e.g. for auto project loading
@@ -196,6 +197,7 @@ void KateProjectPlugin::slotDocumentCreated (KTextEditor::Document *document)
    */
   connect (document, SIGNAL(documentUrlChanged (KTextEditor::Document *)), this, SLOT(slotDocumentUrlChanged (KTextEditor::Document *)));
   connect (document, SIGNAL(destroyed (QObject *)), this, SLOT(slotDocumentDestroyed (QObject *)));
+  connect (document, SIGNAL(documentSavedOrUploaded (KTextEditor::Document *, bool)), this, SLOT(slotDocumentSaved (KTextEditor::Document *)));
 
   /**
    * trigger slot once, for existing docs
@@ -227,6 +229,15 @@ void KateProjectPlugin::slotDocumentUrlChanged (KTextEditor::Document *document)
     m_document2Project[document] = project;
 }
 
+void KateProjectPlugin::slotDocumentSaved (KTextEditor::Document *document)
+{
+  /**
+   * tag the saved file again, if it belongs to a project
+   */
+  if (KateProject *project = m_document2Project.value (document))
+    project->updateIndex ();
+}
+
 void KateProjectPlugin::slotDirectoryChanged (const QString &path)
 {
   /**
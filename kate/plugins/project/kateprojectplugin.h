@@ -123,6 +123,12 @@ class KateProjectPlugin : public Kate::Plugin
      */
     void slotDocumentUrlChanged (KTextEditor::Document *document);
 
+    /**
+     * Document saved, update the index of its project.
+     * @param document document that was saved
+     */
+    void slotDocumentSaved (KTextEditor::Document *document);
+
     /**
      * did some project file change?
      * @param path name of directory that did change
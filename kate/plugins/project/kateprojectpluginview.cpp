@@ -224,6 +224,33 @@ QStringList KateProjectPluginView::projectFiles () const
   return active->project()->files ();
 }
 
+QVariantMap KateProjectPluginView::projectFilesContaining (const QStringList &files, const QString &text) const
+{
+  QVariantMap result;
+  KateProjectView *active = static_cast<KateProjectView *> (m_stackedProjectViews->currentWidget ());
+  if (!active || !active->project()->trigramIndex ()) {
+    result["files"] = files;
+    return result;
+  }
+
+  /**
+   * filter with index, then let the worker catch up with files changed meanwhile
+   */
+  QHash<QString, QPair<qint64, uint> > skipped;
+  result["files"] = active->project()->trigramIndex ()->filesContaining (files, text, &skipped);
+  active->project()->updateTrigramIndex ();
+
+  /**
+   * pass on what the index knows about the skipped files, they are checked in the search threads
+   */
+  QVariantHash skippedStamps;
+  skippedStamps.reserve (skipped.size ());
+  for (QHash<QString, QPair<qint64, uint> >::const_iterator it = skipped.constBegin (); it != skipped.constEnd (); ++it)
+    skippedStamps.insert (it.key (), QVariantList () << it.value ().first << it.value ().second);
+  result["skipped"] = skippedStamps;
+  return result;
+}
+
 void KateProjectPluginView::slotViewChanged ()
 {
   /**
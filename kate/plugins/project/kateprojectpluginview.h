@@ -76,6 +76,19 @@ class KateProjectPluginView : public Kate::PluginView, public Kate::XMLGUIClient
      */
     QStringList projectFiles () const;
 
+    /**
+     * files of the given ones that may contain the given text, according to the trigram
+     * index of the current active project; used by the search plugin
+     * the index may be older than the files: the skipped files come with the size and
+     * modification time the index knows, the caller must search those that changed since;
+     * each query triggers an update of the index in the background
+     * @param files files to filter
+     * @param text text to search for
+     * @return map with "files", files as they are if no index is around, else the ones that may contain text,
+     *         and "skipped", hash of skipped file to list of indexed size and modification time in seconds
+     */
+    Q_INVOKABLE QVariantMap projectFilesContaining (const QStringList &files, const QString &text) const;
+
   public slots:
     /**
      * Create views for given project.
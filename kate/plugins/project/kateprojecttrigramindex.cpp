@@ -0,0 +1,675 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "kateprojecttrigramindex.h"
+
+#include <QBitArray>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+#include <string.h>
+
+/**
+ * on disk format, in host byte order
+ */
+namespace {
+
+const char IndexMagic[8] = { 'K', 'A', 'T', 'E', 'T', 'R', 'I', 0 };
+const quint32 IndexVersion = 1;
+const quint32 IndexByteOrder = 0x01020304;
+
+/**
+ * files bigger than this are not indexed but always searched
+ */
+const qint64 MaxIndexedFileSize = 16 * 1024 * 1024;
+
+/**
+ * trigrams are made of three 7 bit ASCII characters
+ */
+const int TrigramBits = 21;
+
+struct Header
+{
+  char magic[8];
+  quint32 version;
+  quint32 byteOrder;
+  quint32 fileCount;
+  quint32 trigramCount;
+  quint32 postingsSize;
+  quint32 namesSize;
+};
+
+struct FileEntry
+{
+  enum Flags {
+    /**
+     * content not indexed, e.g. binary or too big, file is always a candidate
+     */
+    NotIndexed = 1
+  };
+
+  quint32 nameOffset;
+  quint32 nameLength;
+  qint64 size;
+  quint32 modified;
+  quint32 flags;
+};
+
+struct TrigramEntry
+{
+  quint32 trigram;
+  quint32 postingsOffset;
+  quint32 postingsLength;
+};
+
+inline const Header *header (const uchar *data)
+{
+  return reinterpret_cast<const Header *> (data);
+}
+
+inline const FileEntry *fileTable (const uchar *data)
+{
+  return reinterpret_cast<const FileEntry *> (data + sizeof (Header));
+}
+
+inline const TrigramEntry *trigramTable (const uchar *data)
+{
+  return reinterpret_cast<const TrigramEntry *> (fileTable (data) + header (data)->fileCount);
+}
+
+inline const uchar *postingsData (const uchar *data)
+{
+  return reinterpret_cast<const uchar *> (trigramTable (data) + header (data)->trigramCount);
+}
+
+inline const char *namesData (const uchar *data)
+{
+  return reinterpret_cast<const char *> (postingsData (data) + header (data)->postingsSize);
+}
+
+inline bool operator< (const TrigramEntry &entry, quint32 trigram)
+{
+  return entry.trigram < trigram;
+}
+
+/**
+ * fold ASCII letters to lower case, trigrams ignore the case
+ */
+inline uint foldCase (uint c)
+{
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+/**
+ * only ASCII characters are encoded the same in all encodings we read files in
+ */
+inline bool isTrigramCharacter (uint c)
+{
+  return c < 0x80 && c != '\n' && c != '\r';
+}
+
+void writeVarint (QByteArray &out, quint32 value)
+{
+  while (value >= 0x80) {
+    out.append (char ((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.append (char (value));
+}
+
+/**
+ * check a posting list: complete varints, ascending file numbers below fileCount
+ */
+bool isValidPostings (const uchar *postings, quint32 length, quint32 fileCount)
+{
+  const uchar *const end = postings + length;
+  qint64 file = -1;
+  while (postings < end) {
+    quint32 delta = 0;
+    int shift = 0;
+    uchar byte;
+    do {
+      if (postings == end || shift > 28)
+        return false;
+      byte = *postings++;
+      delta |= quint32 (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    /**
+     * only the first file number may be 0, as delta to 0
+     */
+    if (file >= 0 && delta == 0)
+      return false;
+    file = qMax (file, qint64 (0)) + delta;
+    if (file >= fileCount)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * check the whole index: header, sizes of the tables, offsets into the names and postings,
+ * order of the tables and the posting lists, the queries rely on all of them
+ */
+bool isValidIndex (const uchar *data, qint64 size)
+{
+  if (size < qint64 (sizeof (Header)))
+    return false;
+
+  const Header *h = header (data);
+  const qint64 expectedSize = qint64 (sizeof (Header)) + qint64 (h->fileCount) * sizeof (FileEntry)
+    + qint64 (h->trigramCount) * sizeof (TrigramEntry) + h->postingsSize + h->namesSize;
+  if (memcmp (h->magic, IndexMagic, sizeof (IndexMagic)) || h->version != IndexVersion
+      || h->byteOrder != IndexByteOrder || expectedSize != size)
+    return false;
+
+  const FileEntry *files = fileTable (data);
+  const char *names = namesData (data);
+  for (quint32 i = 0; i < h->fileCount; ++i) {
+    if (qint64 (files[i].nameOffset) + files[i].nameLength > h->namesSize)
+      return false;
+
+    if (i > 0) {
+      const QByteArray name = QByteArray::fromRawData (names + files[i].nameOffset, files[i].nameLength);
+      const QByteArray previous = QByteArray::fromRawData (names + files[i - 1].nameOffset, files[i - 1].nameLength);
+      if (!(previous < name))
+        return false;
+    }
+  }
+
+  const TrigramEntry *trigrams = trigramTable (data);
+  for (quint32 i = 0; i < h->trigramCount; ++i) {
+    if (trigrams[i].trigram >= (1u << TrigramBits) || (i > 0 && trigrams[i - 1].trigram >= trigrams[i].trigram)
+        || qint64 (trigrams[i].postingsOffset) + trigrams[i].postingsLength > h->postingsSize
+        || !isValidPostings (postingsData (data) + trigrams[i].postingsOffset, trigrams[i].postingsLength, h->fileCount))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * decode posting list, deltas to the file number before
+ * the posting lists of a mapped index are checked by isValidIndex
+ */
+void readPostings (const uchar *postings, quint32 length, QVector<quint32> &files)
+{
+  files.clear ();
+  const uchar *const end = postings + length;
+  quint32 file = 0;
+  while (postings < end) {
+    quint32 delta = 0;
+    int shift = 0;
+    uchar byte;
+    do {
+      byte = *postings++;
+      delta |= quint32 (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    file += delta;
+    files.append (file);
+  }
+}
+
+/**
+ * posting list under construction
+ */
+struct Postings
+{
+  Postings () : last (0) {}
+
+  void append (quint32 file)
+  {
+    writeVarint (data, file - last);
+    last = file;
+  }
+
+  QByteArray data;
+  quint32 last;
+};
+
+/**
+ * one file for the new index
+ */
+struct IndexFile
+{
+  QByteArray name;
+  QString path;
+  qint64 size;
+  quint32 modified;
+  quint32 flags;
+
+  bool operator< (const IndexFile &other) const
+  {
+    return name < other.name;
+  }
+};
+
+}
+
+KateProjectTrigramIndex::KateProjectTrigramIndex (const QString &fileName, const QStringList &files)
+  : m_file (fileName)
+  , m_data (0)
+  , m_size (0)
+  , m_readFiles (0)
+{
+  /**
+   * build the index, reuse the old one
+   * on failure, the old index is used if any
+   */
+  if (!build (files))
+    map ();
+}
+
+KateProjectTrigramIndex::~KateProjectTrigramIndex ()
+{
+  unmap ();
+}
+
+bool KateProjectTrigramIndex::map ()
+{
+  unmap ();
+
+  if (!m_file.open (QIODevice::ReadOnly))
+    return false;
+
+  /**
+   * map whole file, check that it is an index of this version, complete and consistent
+   */
+  m_size = m_file.size ();
+  uchar *data = (m_size >= qint64 (sizeof (Header))) ? m_file.map (0, m_size) : 0;
+  if (!data) {
+    m_file.close ();
+    m_size = 0;
+    return false;
+  }
+
+  if (!isValidIndex (data, m_size)) {
+    m_file.unmap (data);
+    m_file.close ();
+    m_size = 0;
+    return false;
+  }
+
+  m_data = data;
+  return true;
+}
+
+void KateProjectTrigramIndex::unmap ()
+{
+  if (m_data) {
+    m_file.unmap (const_cast<uchar *> (m_data));
+    m_data = 0;
+  }
+  m_file.close ();
+  m_size = 0;
+}
+
+bool KateProjectTrigramIndex::build (const QStringList &files)
+{
+  /**
+   * old index, if any, to take over the unchanged files
+   */
+  map ();
+  const quint32 oldFileCount = m_data ? header (m_data)->fileCount : 0;
+  QVector<qint32> oldToNew (oldFileCount, -1);
+
+  /**
+   * files sorted by UTF-8 name, as the file table
+   */
+  QVector<IndexFile> indexFiles;
+  indexFiles.reserve (files.size ());
+  foreach (const QString &path, files) {
+    IndexFile file;
+    file.name = path.toUtf8 ();
+    file.path = path;
+    indexFiles.append (file);
+  }
+  qSort (indexFiles);
+
+  /**
+   * read the new and changed files, collect their trigrams
+   * the files are read in order, therefore the posting lists are sorted
+   */
+  QHash<quint32, Postings> newPostings;
+  QBitArray seen (1 << TrigramBits);
+  QVector<quint32> fileTrigrams;
+  quint32 fileCount = 0;
+  for (int i = 0; i < indexFiles.size (); ++i) {
+    /**
+     * skip dupes
+     */
+    if (fileCount > 0 && indexFiles[fileCount - 1].name == indexFiles[i].name)
+      continue;
+
+    IndexFile &file = indexFiles[fileCount] = indexFiles[i];
+    const quint32 number = fileCount++;
+
+    QFileInfo info (file.path);
+    file.size = info.size ();
+    file.modified = info.lastModified ().toTime_t ();
+    file.flags = 0;
+
+    /**
+     * unchanged since the old index?
+     */
+    const int oldNumber = m_data ? findFile (file.name) : -1;
+    if (oldNumber != -1) {
+      const FileEntry &oldFile = fileTable (m_data)[oldNumber];
+      if (oldFile.size == file.size && oldFile.modified == file.modified) {
+        file.flags = oldFile.flags;
+        oldToNew[oldNumber] = number;
+        continue;
+      }
+    }
+
+    /**
+     * read the file, files that can't be read or are binary are not indexed
+     */
+    ++m_readFiles;
+    QFile content (file.path);
+    if (file.size > MaxIndexedFileSize || !content.open (QIODevice::ReadOnly)) {
+      file.flags = FileEntry::NotIndexed;
+      continue;
+    }
+
+    const QByteArray data = content.readAll ();
+    content.close ();
+
+    const uchar *bytes = reinterpret_cast<const uchar *> (data.constData ());
+    const bool utf16 = data.size () >= 2 && ((bytes[0] == 0xfe && bytes[1] == 0xff) || (bytes[0] == 0xff && bytes[1] == 0xfe));
+    if (utf16 || memchr (bytes, 0, data.size ())) {
+      file.flags = FileEntry::NotIndexed;
+      continue;
+    }
+
+    /**
+     * collect each trigram once
+     */
+    quint32 trigram = 0;
+    int run = 0;
+    for (int j = 0; j < data.size (); ++j) {
+      const uint c = bytes[j];
+      if (!isTrigramCharacter (c)) {
+        run = 0;
+        continue;
+      }
+
+      trigram = ((trigram << 7) | foldCase (c)) & ((1 << TrigramBits) - 1);
+      if (++run >= 3 && !seen.testBit (trigram)) {
+        seen.setBit (trigram);
+        fileTrigrams.append (trigram);
+      }
+    }
+
+    foreach (quint32 fileTrigram, fileTrigrams) {
+      newPostings[fileTrigram].append (number);
+      seen.clearBit (fileTrigram);
+    }
+    fileTrigrams.clear ();
+  }
+  indexFiles.resize (fileCount);
+
+  /**
+   * nothing changed? keep the old index, no need to write it again
+   */
+  if (m_data && m_readFiles == 0 && fileCount == oldFileCount && !oldToNew.contains (-1))
+    return true;
+
+  /**
+   * all trigrams, of the old and the new files
+   */
+  QVector<quint32> trigrams;
+  trigrams.reserve (newPostings.size () + (m_data ? header (m_data)->trigramCount : 0));
+  for (QHash<quint32, Postings>::const_iterator it = newPostings.constBegin (); it != newPostings.constEnd (); ++it)
+    trigrams.append (it.key ());
+  if (m_data) {
+    for (quint32 i = 0; i < header (m_data)->trigramCount; ++i)
+      trigrams.append (trigramTable (m_data)[i].trigram);
+  }
+  qSort (trigrams);
+  trigrams.erase (std::unique (trigrams.begin (), trigrams.end ()), trigrams.end ());
+
+  /**
+   * merge the posting lists of the unchanged files with the ones of the new files
+   * the file numbers are sorted in both, the old ones only need to be renumbered
+   */
+  QVector<TrigramEntry> trigramEntries;
+  trigramEntries.reserve (trigrams.size ());
+  QByteArray postings;
+  QVector<quint32> oldFiles, newFiles;
+  foreach (quint32 trigram, trigrams) {
+    oldFiles.clear ();
+    const uchar *oldPostings;
+    quint32 oldLength;
+    if (m_data && findTrigram (trigram, oldPostings, oldLength)) {
+      readPostings (oldPostings, oldLength, oldFiles);
+      int kept = 0;
+      for (int i = 0; i < oldFiles.size (); ++i) {
+        if (oldToNew[oldFiles[i]] != -1)
+          oldFiles[kept++] = oldToNew[oldFiles[i]];
+      }
+      oldFiles.resize (kept);
+    }
+
+    newFiles.clear ();
+    QHash<quint32, Postings>::const_iterator it = newPostings.constFind (trigram);
+    if (it != newPostings.constEnd ())
+      readPostings (reinterpret_cast<const uchar *> (it->data.constData ()), it->data.size (), newFiles);
+
+    if (oldFiles.isEmpty () && newFiles.isEmpty ())
+      continue;
+
+    TrigramEntry entry;
+    entry.trigram = trigram;
+    entry.postingsOffset = postings.size ();
+
+    quint32 last = 0;
+    int i = 0, j = 0;
+    while (i < oldFiles.size () || j < newFiles.size ()) {
+      const quint32 file = (j == newFiles.size () || (i < oldFiles.size () && oldFiles[i] < newFiles[j])) ? oldFiles[i++] : newFiles[j++];
+      writeVarint (postings, file - last);
+      last = file;
+    }
+
+    entry.postingsLength = postings.size () - entry.postingsOffset;
+    trigramEntries.append (entry);
+  }
+
+  /**
+   * file table and names
+   */
+  QVector<FileEntry> fileEntries (fileCount);
+  QByteArray names;
+  for (quint32 i = 0; i < fileCount; ++i) {
+    fileEntries[i].nameOffset = names.size ();
+    fileEntries[i].nameLength = indexFiles[i].name.size ();
+    fileEntries[i].size = indexFiles[i].size;
+    fileEntries[i].modified = indexFiles[i].modified;
+    fileEntries[i].flags = indexFiles[i].flags;
+    names.append (indexFiles[i].name);
+  }
+
+  Header newHeader;
+  memcpy (newHeader.magic, IndexMagic, sizeof (IndexMagic));
+  newHeader.version = IndexVersion;
+  newHeader.byteOrder = IndexByteOrder;
+  newHeader.fileCount = fileCount;
+  newHeader.trigramCount = trigramEntries.size ();
+  newHeader.postingsSize = postings.size ();
+  newHeader.namesSize = names.size ();
+
+  /**
+   * write the new index next to the old one, then replace it
+   */
+  QFile newFile (m_file.fileName () + ".new");
+  if (!newFile.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  bool ok = newFile.write (reinterpret_cast<const char *> (&newHeader), sizeof (Header)) == sizeof (Header);
+  ok = ok && newFile.write (reinterpret_cast<const char *> (fileEntries.constData ()), fileEntries.size () * sizeof (FileEntry)) == qint64 (fileEntries.size () * sizeof (FileEntry));
+  ok = ok && newFile.write (reinterpret_cast<const char *> (trigramEntries.constData ()), trigramEntries.size () * sizeof (TrigramEntry)) == qint64 (trigramEntries.size () * sizeof (TrigramEntry));
+  ok = ok && newFile.write (postings) == postings.size ();
+  ok = ok && newFile.write (names) == names.size ();
+  newFile.close ();
+
+  unmap ();
+  if (!ok || (QFile::exists (m_file.fileName ()) && !QFile::remove (m_file.fileName ()))
+      || !QFile::rename (newFile.fileName (), m_file.fileName ())) {
+    QFile::remove (newFile.fileName ());
+    return false;
+  }
+
+  return map ();
+}
+
+int KateProjectTrigramIndex::findFile (const QByteArray &utf8Name) const
+{
+  const FileEntry *files = fileTable (m_data);
+  const char *names = namesData (m_data);
+
+  /**
+   * binary search in the file table, sorted by name
+   */
+  int low = 0;
+  int high = header (m_data)->fileCount;
+  while (low < high) {
+    const int middle = (low + high) / 2;
+    const FileEntry &file = files[middle];
+    int compare = memcmp (names + file.nameOffset, utf8Name.constData (), qMin (file.nameLength, quint32 (utf8Name.size ())));
+    if (!compare)
+      compare = int (file.nameLength) - utf8Name.size ();
+
+    if (!compare)
+      return middle;
+    if (compare < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return -1;
+}
+
+bool KateProjectTrigramIndex::findTrigram (quint32 trigram, const uchar *&postings, quint32 &length) const
+{
+  const TrigramEntry *begin = trigramTable (m_data);
+  const TrigramEntry *end = begin + header (m_data)->trigramCount;
+  const TrigramEntry *entry = std::lower_bound (begin, end, trigram);
+  if (entry == end || entry->trigram != trigram)
+    return false;
+
+  postings = postingsData (m_data) + entry->postingsOffset;
+  length = entry->postingsLength;
+  return true;
+}
+
+QStringList KateProjectTrigramIndex::filesContaining (const QStringList &files, const QString &text, QHash<QString, QPair<qint64, uint> > *skipped) const
+{
+  /**
+   * no index, all files may contain the text
+   */
+  if (!m_data)
+    return files;
+
+  /**
+   * trigrams of the ASCII parts of the text
+   */
+  QVector<quint32> trigrams;
+  quint32 trigram = 0;
+  int run = 0;
+  for (int i = 0; i < text.size (); ++i) {
+    const uint c = text.at (i).unicode ();
+    if (!isTrigramCharacter (c)) {
+      run = 0;
+      continue;
+    }
+
+    trigram = ((trigram << 7) | foldCase (c)) & ((1 << TrigramBits) - 1);
+    if (++run >= 3)
+      trigrams.append (trigram);
+  }
+
+  if (trigrams.isEmpty ())
+    return files;
+
+  /**
+   * intersect the posting lists, start with the shortest one
+   */
+  QVector<QPair<quint32, const uchar *> > lists;
+  foreach (quint32 textTrigram, trigrams) {
+    const uchar *postings;
+    quint32 length;
+    if (!findTrigram (textTrigram, postings, length)) {
+      lists.clear ();
+      break;
+    }
+    lists.append (qMakePair (length, postings));
+  }
+  qSort (lists);
+
+  QBitArray candidates (header (m_data)->fileCount);
+  if (!lists.isEmpty ()) {
+    QVector<quint32> result, next;
+    readPostings (lists[0].second, lists[0].first, result);
+    for (int i = 1; i < lists.size () && !result.isEmpty (); ++i) {
+      readPostings (lists[i].second, lists[i].first, next);
+      int kept = 0;
+      for (int a = 0, b = 0; a < result.size () && b < next.size ();) {
+        if (result[a] < next[b])
+          ++a;
+        else if (next[b] < result[a])
+          ++b;
+        else {
+          result[kept++] = result[a];
+          ++a;
+          ++b;
+        }
+      }
+      result.resize (kept);
+    }
+
+    foreach (quint32 file, result)
+      candidates.setBit (file);
+  }
+
+  /**
+   * keep the candidates and the files the index doesn't know
+   * no stat of the files here, this runs in the gui thread, the caller checks the skipped ones
+   */
+  const FileEntry *fileEntries = fileTable (m_data);
+  QStringList result;
+  foreach (const QString &file, files) {
+    const int number = findFile (file.toUtf8 ());
+    if (number == -1 || candidates.testBit (number) || (fileEntries[number].flags & FileEntry::NotIndexed))
+      result.append (file);
+    else if (skipped)
+      skipped->insert (file, qMakePair (fileEntries[number].size, uint (fileEntries[number].modified)));
+  }
+
+  return result;
+}
+
+// kate: space-indent on; indent-width 2; replace-tabs on;
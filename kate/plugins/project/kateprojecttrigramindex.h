@@ -0,0 +1,159 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_PROJECT_TRIGRAM_INDEX_H
+#define KATE_PROJECT_TRIGRAM_INDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+
+/**
+ * Class representing the trigram index of the content of all project files.
+ * It knows for each trigram of ASCII characters, case folded, which files contain it.
+ * The search in files uses it to skip files that can't contain a text.
+ *
+ * The index is stored in a file that is memory mapped for the queries:
+ *   header, file table sorted by UTF-8 file name, trigram table sorted by trigram,
+ *   posting lists of ascending file numbers as varint encoded deltas, file names.
+ * Is created in Worker thread in the background, then passed to project in
+ * the main thread for usage.
+ * Queries only use the index, they don't look at the files: the files they skip
+ * are reported with the size and modification time the index knows, the caller
+ * must still search those that changed since.
+ */
+class KateProjectTrigramIndex
+{
+  public:
+    /**
+     * construct new trigram index, stored in the given file
+     * if the file contains an index already, the unchanged files are taken over from it
+     * @param fileName index file to use
+     * @param files files to index
+     */
+    KateProjectTrigramIndex (const QString &fileName, const QStringList &files);
+
+    /**
+     * deconstruct index
+     */
+    ~KateProjectTrigramIndex ();
+
+    /**
+     * Is the index usable?
+     * @return true if the index file was written and is mapped
+     */
+    bool isValid () const
+    {
+      return m_data;
+    }
+
+    /**
+     * Size of the index file.
+     * @return size in bytes
+     */
+    qint64 size () const
+    {
+      return m_size;
+    }
+
+    /**
+     * Number of files whose content was read to build the index.
+     * The other files were taken over from the index before.
+     * @return number of read files
+     */
+    int readFiles () const
+    {
+      return m_readFiles;
+    }
+
+    /**
+     * Filter the files that may contain the given text, according to the index.
+     * Files that are not in the index or could not be indexed are always kept,
+     * only ASCII trigrams of the text are used.
+     * The index may be older than the files, skipped files that changed since may contain the text.
+     * @param files files to filter
+     * @param text text to search for, case sensitive or not
+     * @param skipped if not null, filled with the skipped files and their indexed size and modification time
+     * @return files that may contain the text, in the order of files
+     */
+    QStringList filesContaining (const QStringList &files, const QString &text, QHash<QString, QPair<qint64, uint> > *skipped = 0) const;
+
+  private:
+    /**
+     * Build the index and write it to the index file.
+     * @param files files to index
+     * @return success
+     */
+    bool build (const QStringList &files);
+
+    /**
+     * Map the index file, check its header, offsets and posting lists.
+     * A broken index is not mapped.
+     * @return success
+     */
+    bool map ();
+
+    /**
+     * Unmap and close the index file.
+     */
+    void unmap ();
+
+    /**
+     * Search a file in the file table.
+     * @param utf8Name UTF-8 encoded file name
+     * @return file number or -1 if not found
+     */
+    int findFile (const QByteArray &utf8Name) const;
+
+    /**
+     * Search the posting list of a trigram.
+     * @param trigram trigram to search for
+     * @param postings set to the varint encoded posting list
+     * @param length set to the size of the posting list in bytes
+     * @return false if no file contains the trigram
+     */
+    bool findTrigram (quint32 trigram, const uchar *&postings, quint32 &length) const;
+
+  private:
+    /**
+     * index file, mapped for queries
+     */
+    QFile m_file;
+
+    /**
+     * mapped index file content, null if not valid
+     */
+    const uchar *m_data;
+
+    /**
+     * size of the index file
+     */
+    qint64 m_size;
+
+    /**
+     * number of files read by the last build
+     */
+    int m_readFiles;
+};
+
+#endif
+
+// kate: space-indent on; indent-width 2; replace-tabs on;
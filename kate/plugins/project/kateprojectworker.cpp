@@ -56,20 +56,11 @@ void KateProjectWorker::loadProject (QString baseDir, QVariantMap projectMap)
   KateProjectSharedQMapStringItem file2Item (new QMap<QString, QStandardItem *> ());
   loadProject (topLevel.data(), projectMap, file2Item.data());
 
-  /**
-   * create some local backup of some data we need for further processing!
-   */
-  QStringList files = file2Item->keys ();
-
   /**
    * feed back our results
+   * the project will trigger the index loading for the new files
    */
   QMetaObject::invokeMethod (m_project, "loadProjectDone", Qt::QueuedConnection, Q_ARG(KateProjectSharedQStandardItem, topLevel), Q_ARG(KateProjectSharedQMapStringItem, file2Item));
-
-  /**
-   * load index
-   */
-  loadIndex (files);
 }
 
 void KateProjectWorker::loadProject (QStandardItem *parent, const QVariantMap &project, QMap<QString, QStandardItem *> *file2Item)
@@ -384,13 +375,14 @@ void KateProjectWorker::loadFilesEntry (QStandardItem *parent, const QVariantMap
   }
 }
 
-void KateProjectWorker::loadIndex (const QStringList &files)
+void KateProjectWorker::loadIndex (QString ctagsIndexFile, QStringList files)
 {
   /**
    * create new index, this will do the loading in the constructor
+   * only files changed since the index in the file was written are tagged
    * wrap it into shared pointer for transfer to main thread
    */
-  KateProjectSharedProjectIndex index (new KateProjectIndex(files));
+  KateProjectSharedProjectIndex index (new KateProjectIndex(files, ctagsIndexFile));
 
   /**
    * send new index object back to project
@@ -398,4 +390,18 @@ void KateProjectWorker::loadIndex (const QStringList &files)
   QMetaObject::invokeMethod (m_project, "loadIndexDone", Qt::QueuedConnection, Q_ARG(KateProjectSharedProjectIndex, index));
 }
 
+void KateProjectWorker::loadTrigramIndex (QString fileName, QStringList files)
+{
+  /**
+   * create new trigram index, this will build or update the index file in the constructor
+   * wrap it into shared pointer for transfer to main thread
+   */
+  KateProjectSharedTrigramIndex index (new KateProjectTrigramIndex (fileName, files));
+
+  /**
+   * send new index object back to project
+   */
+  QMetaObject::invokeMethod (m_project, "loadTrigramIndexDone", Qt::QueuedConnection, Q_ARG(KateProjectSharedTrigramIndex, index));
+}
+
 // kate: space-indent on; indent-width 2; replace-tabs on;
@@ -60,6 +60,22 @@ class KateProjectWorker : public QObject
      * @param projectMap full map containing the whole project as copy to work on
      */
     void loadProject (QString baseDir, QVariantMap projectMap);
+
+    /**
+     * Build or update the trigram index of the project files.
+     * Will inform the project after loading was done and pass over the index.
+     * @param fileName index file, an index in it is updated
+     * @param files list of all project files to index
+     */
+    void loadTrigramIndex (QString fileName, QStringList files);
+
+    /**
+     * Load index for whole project.
+     * Will inform the project after loading was done and pass over the index.
+     * @param ctagsIndexFile file for the ctags index, an index in it is updated
+     * @param files list of all project files to index
+     */
+    void loadIndex (QString ctagsIndexFile, QStringList files);
     
   private:
     /**
@@ -78,12 +94,7 @@ class KateProjectWorker : public QObject
      * @param file2Item mapping file => item, will be filled
      */
     void loadFilesEntry (QStandardItem *parent, const QVariantMap &filesEntry, QMap<QString, QStandardItem *> *file2Item);
-    
-    /**
-     * Load index for whole project.
-     * @param files list of all project files to index
-     */
-    void loadIndex (const QStringList &files);
+
     
   private:
     /**
@@ -0,0 +1,149 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "kateprojecttrigramindex.h"
+
+#include <qtest_kde.h>
+#include <ktempdir.h>
+
+#include <QObject>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+
+#include <stdio.h>
+
+/**
+ * Trigram index benchmark, indexes a synthetic tree of 50k files
+ * (50 folders of 1000 files with 40 lines each) and prints index size,
+ * build time and the time to update it, then measures query latency.
+ *
+ * Usage:
+ *   kateprojecttrigramindexbenchmark [QTest options] [query:<row>]
+ */
+class KateProjectTrigramIndexBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+
+    void build();
+    void update();
+
+    void query_data();
+    void query();
+
+  private:
+    KTempDir m_tree;
+    QStringList m_files;
+    QString m_indexFile;
+};
+
+QTEST_KDEMAIN_CORE(KateProjectTrigramIndexBenchmark)
+
+void KateProjectTrigramIndexBenchmark::initTestCase()
+{
+  for (int folder = 0; folder < 50; ++folder) {
+    const QString path = m_tree.name() + QString ("folder%1/").arg (folder);
+    QVERIFY(QDir().mkpath (path));
+
+    for (int i = 0; i < 1000; ++i) {
+      QFile file (path + QString ("file%1.cpp").arg (i));
+      QVERIFY(file.open (QFile::WriteOnly));
+
+      // 10 functions of 4 lines, every file has a unique name, every tenth file calls commonIdentifier
+      const int number = folder * 1000 + i;
+      QByteArray text = "// uniqueName" + QByteArray::number (number) + "\n";
+      for (int function = 0; function < 10; ++function) {
+        text += "int function" + QByteArray::number (function) + "(int value)\n{\n";
+        text += (i % 10 == 0) ? "    return commonIdentifier(value);\n" : "    return value;\n";
+        text += "}\n";
+      }
+      file.write (text);
+      m_files << file.fileName ();
+    }
+  }
+
+  m_indexFile = m_tree.name() + "trigrams.index";
+}
+
+void KateProjectTrigramIndexBenchmark::build()
+{
+  QElapsedTimer timer;
+  timer.start ();
+  KateProjectTrigramIndex index (m_indexFile, m_files);
+  const qint64 elapsed = timer.elapsed ();
+
+  QVERIFY(index.isValid ());
+  QCOMPARE(index.readFiles (), m_files.size ());
+  printf ("build:  %d files read in %lld ms, index of %lld bytes\n", index.readFiles (), elapsed, index.size ());
+}
+
+void KateProjectTrigramIndexBenchmark::update()
+{
+  // change every 500th file, the others are taken over from the index
+  for (int i = 0; i < m_files.size (); i += 500) {
+    QFile file (m_files[i]);
+    QVERIFY(file.open (QFile::Append));
+    file.write ("// changed\n");
+  }
+
+  QElapsedTimer timer;
+  timer.start ();
+  KateProjectTrigramIndex index (m_indexFile, m_files);
+  const qint64 elapsed = timer.elapsed ();
+
+  QVERIFY(index.isValid ());
+  QCOMPARE(index.readFiles (), m_files.size () / 500);
+  printf ("update: %d files read in %lld ms, index of %lld bytes\n", index.readFiles (), elapsed, index.size ());
+}
+
+void KateProjectTrigramIndexBenchmark::query_data()
+{
+  QTest::addColumn<QString>("text");
+  QTest::addColumn<int>("candidates");
+
+  QTest::newRow("common identifier") << "commonIdentifier" << 5000;
+  QTest::newRow("common identifier, other case") << "COMMONIDENTIFIER" << 5000;
+  QTest::newRow("unique name") << "uniqueName12345" << 1;
+  QTest::newRow("changed") << "// changed" << 100;
+  QTest::newRow("no match") << "uncommonIdentifier" << 0;
+  QTest::newRow("too short") << "in" << 50000;
+}
+
+void KateProjectTrigramIndexBenchmark::query()
+{
+  QFETCH(QString, text);
+  QFETCH(int, candidates);
+
+  KateProjectTrigramIndex index (m_indexFile, m_files);
+  QVERIFY(index.isValid ());
+  QCOMPARE(index.readFiles (), 0);
+
+  QStringList result;
+  QBENCHMARK {
+    result = index.filesContaining (m_files, text);
+  }
+
+  QCOMPARE(result.size (), candidates);
+}
+
+#include "kateprojecttrigramindexbenchmark.moc"
@@ -0,0 +1,107 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "kateprojecttrigramindex.h"
+
+#include <qtest_kde.h>
+#include <ktempdir.h>
+
+#include <QObject>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+class KateProjectTrigramIndexTest : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+
+    void filesContaining();
+    void editedAfterIndexing();
+
+  private:
+    bool writeFile (const QString &fileName, const QByteArray &content);
+
+  private:
+    KTempDir m_tree;
+    QStringList m_files;
+    QString m_indexFile;
+};
+
+QTEST_KDEMAIN_CORE(KateProjectTrigramIndexTest)
+
+bool KateProjectTrigramIndexTest::writeFile (const QString &fileName, const QByteArray &content)
+{
+  QFile file (fileName);
+  return file.open (QFile::WriteOnly) && file.write (content) == content.size ();
+}
+
+void KateProjectTrigramIndexTest::initTestCase()
+{
+  m_files << m_tree.name() + "alpha.cpp" << m_tree.name() + "beta.cpp" << m_tree.name() + "binary.dat";
+  QVERIFY(writeFile (m_files[0], "int alphaValue;\n"));
+  QVERIFY(writeFile (m_files[1], "int betaValue;\n"));
+  QVERIFY(writeFile (m_files[2], QByteArray ("gammaValue\0", 11)));
+  m_indexFile = m_tree.name() + "trigrams.index";
+}
+
+void KateProjectTrigramIndexTest::filesContaining()
+{
+  KateProjectTrigramIndex index (m_indexFile, m_files);
+  QVERIFY(index.isValid ());
+
+  // the binary file is not indexed and always kept, the others are skipped with their stamps
+  QHash<QString, QPair<qint64, uint> > skipped;
+  QCOMPARE(index.filesContaining (m_files, "ALPHAvalue", &skipped), QStringList () << m_files[0] << m_files[2]);
+  QCOMPARE(skipped.size (), 1);
+  const QFileInfo beta (m_files[1]);
+  QCOMPARE(skipped.value (m_files[1]), qMakePair (beta.size (), beta.lastModified ().toTime_t ()));
+
+  // unknown files are kept
+  const QString unknown = m_tree.name() + "unknown.cpp";
+  QCOMPARE(index.filesContaining (QStringList () << unknown, "alphaValue"), QStringList () << unknown);
+}
+
+void KateProjectTrigramIndexTest::editedAfterIndexing()
+{
+  KateProjectTrigramIndex index (m_indexFile, m_files);
+  QVERIFY(index.isValid ());
+  QCOMPARE(index.filesContaining (m_files, "deltaValue"), QStringList () << m_files[2]);
+
+  // edited file, the index doesn't know yet, it is skipped with the stamp of the old content
+  QVERIFY(writeFile (m_files[1], "int betaValue;\nint deltaValue;\n"));
+  QHash<QString, QPair<qint64, uint> > skipped;
+  const QStringList result = index.filesContaining (m_files, "deltaValue", &skipped);
+
+  // so the search still finds it: it is a candidate or the stamp differs from the file
+  const QFileInfo beta (m_files[1]);
+  QVERIFY(result.contains (m_files[1])
+          || (skipped.contains (m_files[1]) && skipped.value (m_files[1]) != qMakePair (beta.size (), beta.lastModified ().toTime_t ())));
+
+  // an update of the index reads the edited file again
+  KateProjectTrigramIndex updated (m_indexFile, m_files);
+  QVERIFY(updated.isValid ());
+  QCOMPARE(updated.readFiles (), 1);
+  QCOMPARE(updated.filesContaining (m_files, "deltaValue"), QStringList () << m_files[1] << m_files[2]);
+}
+
+#include "kateprojecttrigramindextest.moc"
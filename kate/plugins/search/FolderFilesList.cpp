@@ -26,13 +26,27 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QFileInfoList>
+#include <QDateTime>
+#include <QMutexLocker>
 
-FolderFilesList::FolderFilesList(QObject *parent) : QThread(parent) {}
+// inotify watches are a limited resource, folders beyond are only checked by their modification time
+static const int MaxWatchedFolders = 4096;
+
+FolderFilesList::FolderFilesList(QObject *parent) : QThread(parent), m_watchedFolders(0)
+{
+    // the new folders are watched once the listing is done, in the thread of the watcher
+    connect(this, SIGNAL(finished()), this, SLOT(watchFolders()));
+
+    connect(&m_watcher, SIGNAL(dirty(QString)),   this, SLOT(folderDirty(QString)));
+    connect(&m_watcher, SIGNAL(created(QString)), this, SLOT(folderDirty(QString)));
+    connect(&m_watcher, SIGNAL(deleted(QString)), this, SLOT(folderDirty(QString)));
+}
 
 FolderFilesList::~FolderFilesList()
 {
     m_cancelSearch = true;
     wait();
+    qDeleteAll(m_folders);
 }
 
 void FolderFilesList::run()
@@ -59,7 +73,13 @@ void FolderFilesList::generateList(const QString &folder,
     m_hidden       = hidden;
     m_symlinks     = symlinks;
     m_binary       = binary;
-    m_types        = types.split(',');
+
+    // the same matching as the name filters of QDir
+    QStringList tmpTypes = types.split(',');
+    m_typeList.clear();
+    for (int i=0; i<tmpTypes.size(); i++) {
+        m_typeList << QRegExp(tmpTypes[i], Qt::CaseInsensitive, QRegExp::Wildcard);
+    }
 
     QStringList tmpExcludes = excludes.split(',');
     m_excludeList.clear();
@@ -79,6 +99,40 @@ void FolderFilesList::cancelSearch()
     m_cancelSearch = true;
 }
 
+void FolderFilesList::watchFolders()
+{
+    // without inotify the watcher would poll each folder, the folders are listed on each search then
+    if (m_watcher.internalMethod() == KDirWatch::INotify) {
+        foreach (const QString &path, m_listedFolders) {
+            if (m_watchedFolders < MaxWatchedFolders && !m_watcher.contains(path)) {
+                m_watcher.addDir(path, KDirWatch::WatchFiles);
+                m_watchedFolders++;
+                // changes between the listing and now were not watched, list it once more
+                QMutexLocker locker(&m_dirtyMutex);
+                m_watchedPaths << path;
+                m_dirtyFolders << path;
+            }
+        }
+    }
+    foreach (const QString &path, m_removedFolders) {
+        if (m_watcher.contains(path)) {
+            m_watcher.removeDir(path);
+            m_watchedFolders--;
+        }
+        QMutexLocker locker(&m_dirtyMutex);
+        m_watchedPaths.remove(path);
+    }
+    m_listedFolders.clear();
+    m_removedFolders.clear();
+}
+
+void FolderFilesList::folderDirty(const QString &path)
+{
+    // the watcher names the changed file or the folder itself, list both candidates again
+    QMutexLocker locker(&m_dirtyMutex);
+    m_dirtyFolders << path << QFileInfo(path).absolutePath();
+}
+
 void FolderFilesList::checkNextItem(const QFileInfo &item)
 {
     if (m_cancelSearch) {
@@ -91,33 +145,175 @@ void FolderFilesList::checkNextItem(const QFileInfo &item)
         m_files << item.absoluteFilePath();
     }
     else {
-        QDir currentDir(item.absoluteFilePath());
+        checkNextFolder(QDir::cleanPath(item.absoluteFilePath()));
+    }
+}
 
-        if (!currentDir.isReadable()) {
-            kDebug() << currentDir.absolutePath() << "Not readable";
-            return;
-        }
+void FolderFilesList::checkNextFolder(const QString &path)
+{
+    if (m_cancelSearch) {
+        return;
+    }
 
-        QDir::Filters    filter  = QDir::Files | QDir::NoDotAndDotDot | QDir::Readable;
-        if (m_hidden)    filter |= QDir::Hidden;
-        if (m_recursive) filter |= QDir::AllDirs;
-        if (!m_symlinks) filter |= QDir::NoSymLinks;
+    Folder *currentFolder = folder(path);
+    if (!currentFolder) {
+        kDebug() << path << "Not readable";
+        return;
+    }
 
-        QFileInfoList currentItems = currentDir.entryInfoList(m_types, filter);
+    const QString prefix = path.endsWith('/') ? path : path + '/';
+    bool skip;
+    for (int i = 0; i < currentFolder->entries.size(); ++i) {
+        Entry &entry = currentFolder->entries[i];
 
-        bool skip;
-        for (int i = 0; i<currentItems.size(); ++i) {
-            skip = false;
-            for (int j=0; j<m_excludeList.size(); j++) {
-                if (m_excludeList[j].exactMatch(currentItems[i].fileName())) {
-                    skip = true;
+        // the filters of QDir::entryInfoList, name filters are not applied to folders
+        if (!entry.readable || (entry.hidden && !m_hidden) || (entry.symLink && !m_symlinks)) {
+            continue;
+        }
+        if (entry.dir && !m_recursive) {
+            continue;
+        }
+        if (!entry.dir) {
+            skip = true;
+            for (int j=0; j<m_typeList.size(); j++) {
+                if (m_typeList[j].exactMatch(entry.name)) {
+                    skip = false;
                     break;
                 }
             }
-            if (!skip) {
-                checkNextItem(currentItems[i]);
+            if (skip) {
+                continue;
+            }
+        }
+
+        skip = false;
+        for (int j=0; j<m_excludeList.size(); j++) {
+            if (m_excludeList[j].exactMatch(entry.name)) {
+                skip = true;
+                break;
+            }
+        }
+        if (skip) {
+            continue;
+        }
+
+        if (entry.dir) {
+            checkNextFolder(prefix + entry.name);
+            if (m_cancelSearch) {
+                return;
             }
         }
+        else if (m_binary || !isBinary(prefix + entry.name, entry)) {
+            m_files << prefix + entry.name;
+        }
     }
 }
 
+FolderFilesList::Folder *FolderFilesList::folder(const QString &path)
+{
+    QFileInfo info(path);
+    const uint modified = info.lastModified().toTime_t();
+
+    bool dirty;
+    bool watched;
+    {
+        QMutexLocker locker(&m_dirtyMutex);
+        dirty = m_dirtyFolders.remove(path);
+        watched = m_watchedPaths.contains(path);
+    }
+
+    // only the watcher tells about changed files, folders without a watch are listed again
+    Folder *cached = m_folders.value(path);
+    if (cached && watched && !dirty && cached->modified == modified) {
+        return cached;
+    }
+
+    QDir currentDir(path);
+    if (!currentDir.isReadable()) {
+        if (cached) {
+            removeFolders(path);
+        }
+        return 0;
+    }
+
+    // list everything, the filters of the search are applied on the cached entries
+    const uint listed = QDateTime::currentDateTime().toTime_t();
+    const QFileInfoList currentItems = currentDir.entryInfoList(QDir::Files | QDir::AllDirs | QDir::Hidden | QDir::NoDotAndDotDot);
+
+    // keep the binary check of unchanged files and drop the folders that are gone
+    QHash<QString, int> oldEntries;
+    if (cached) {
+        for (int i = 0; i < cached->entries.size(); ++i) {
+            oldEntries.insert(cached->entries[i].name, i);
+        }
+    }
+
+    QVector<Entry> entries;
+    entries.reserve(currentItems.size());
+    for (int i = 0; i < currentItems.size(); ++i) {
+        const QFileInfo &item = currentItems[i];
+        Entry entry;
+        entry.name     = item.fileName();
+        entry.dir      = item.isDir();
+        entry.symLink  = item.isSymLink();
+        entry.hidden   = item.isHidden();
+        entry.readable = item.isReadable();
+        entry.modified = item.lastModified().toTime_t();
+        entry.size     = item.size();
+        entry.binary   = -1;
+
+        const int old = oldEntries.value(entry.name, -1);
+        if (old != -1) {
+            const Entry &oldEntry = cached->entries[old];
+            if (!oldEntry.dir && !entry.dir && oldEntry.modified == entry.modified && oldEntry.size == entry.size
+                && oldEntry.modified < cached->listed) {
+                entry.binary = oldEntry.binary;
+            }
+            oldEntries.remove(entry.name);
+        }
+        entries << entry;
+    }
+
+    if (cached) {
+        QHash<QString, int>::const_iterator it = oldEntries.constBegin();
+        for (; it != oldEntries.constEnd(); ++it) {
+            if (cached->entries[it.value()].dir) {
+                removeFolders((path.endsWith('/') ? path : path + '/') + it.key());
+            }
+        }
+    }
+    else {
+        cached = new Folder;
+        m_folders.insert(path, cached);
+        m_listedFolders << path;
+    }
+    cached->modified = modified;
+    cached->listed = listed;
+    cached->entries = entries;
+    return cached;
+}
+
+bool FolderFilesList::isBinary(const QString &path, Entry &entry)
+{
+    if (entry.binary == -1) {
+        entry.binary = KMimeType::isBinaryData(path) ? 1 : 0;
+    }
+    return entry.binary == 1;
+}
+
+void FolderFilesList::removeFolders(const QString &path)
+{
+    // the folder and everything below it
+    const QString prefix = path + '/';
+    QHash<QString, Folder *>::iterator it = m_folders.begin();
+    while (it != m_folders.end()) {
+        if (it.key() == path || it.key().startsWith(prefix)) {
+            m_removedFolders << it.key();
+            delete it.value();
+            it = m_folders.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
@@ -26,7 +26,20 @@
 #include <QFileInfo>
 #include <QVector>
 #include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
 
+#include <kdirwatch.h>
+
+/**
+ * Lists the files of a folder to search in.
+ * The listings of the folders and the binary check of the files are kept between
+ * searches. The listing of a folder the directory watcher watches is used until
+ * the watcher reports a change in it, other folders are listed again on each search.
+ * The binary check of a file is kept while its modification time and size are the
+ * same, if it was modified before the second of the listing.
+ */
 class FolderFilesList: public QThread
 {
     Q_OBJECT
@@ -50,8 +63,47 @@ public:
 public Q_SLOTS:
     void cancelSearch();
 
+private Q_SLOTS:
+    void watchFolders();
+    void folderDirty(const QString &path);
+
 private:
+    /**
+     * Cached entry of a folder listing, without any filters applied.
+     */
+    struct Entry {
+        QString name;
+        bool    dir;
+        bool    symLink;
+        bool    hidden;
+        bool    readable;
+        // the binary check is valid as long as modification time and size are
+        uint    modified;
+        qint64  size;
+        // -1 if not checked yet, else if the file has binary content
+        int     binary;
+    };
+
+    /**
+     * Cached listing of a folder.
+     */
+    struct Folder {
+        uint           modified;
+        // time of the listing, modification times in this second can't tell changes after it
+        uint           listed;
+        QVector<Entry> entries;
+    };
+
     void checkNextItem(const QFileInfo &item);
+    void checkNextFolder(const QString &path);
+
+    /**
+     * Valid listing of the folder, listed again if needed, 0 if it is not readable.
+     */
+    Folder *folder(const QString &path);
+
+    bool isBinary(const QString &path, Entry &entry);
+    void removeFolders(const QString &path);
 
 private:
     QString          m_folder;
@@ -62,8 +114,19 @@ private:
     bool             m_hidden;
     bool             m_symlinks;
     bool             m_binary;
-    QStringList      m_types;
+    QVector<QRegExp> m_typeList;
     QVector<QRegExp> m_excludeList;
+
+    // only used by the listing thread
+    QHash<QString, Folder *> m_folders;
+    QStringList      m_listedFolders;
+    QStringList      m_removedFolders;
+
+    KDirWatch        m_watcher;
+    int              m_watchedFolders;
+    QMutex           m_dirtyMutex;
+    QSet<QString>    m_dirtyFolders;
+    QSet<QString>    m_watchedPaths;
 };
 
 
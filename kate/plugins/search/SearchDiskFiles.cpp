@@ -23,9 +23,168 @@
 #include <kdebug.h>
 
 #include <QDir>
-#include <QTextStream>
+#include <QFile>
+#include <QDateTime>
+#include <QTextCodec>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutexLocker>
 
-SearchDiskFiles::SearchDiskFiles(QObject *parent) : QThread(parent), m_cancelSearch(true) {}
+#include <string.h>
+
+// interval in ms to hand over the found matches
+static const int MatchesBatchInterval = 100;
+
+// matches are only reported in the first characters of a line
+static const int MaxLineLength = 512;
+
+/**
+ * Finds a byte string in raw file data, optionally ignoring the case of ASCII letters.
+ * The candidates are found with memchr() for one byte of the needle, which the C library
+ * implements with vector instructions, and are then compared in full.
+ */
+class LiteralSearch
+{
+public:
+    LiteralSearch(const QByteArray &needle, Qt::CaseSensitivity caseSensitivity)
+    : m_needle(caseSensitivity == Qt::CaseSensitive ? needle : needle.toLower())
+    , m_caseSensitive(caseSensitivity == Qt::CaseSensitive)
+    , m_anchor(0)
+    , m_anchorLower(0)
+    , m_anchorUpper(0)
+    {
+        // nothing to anchor on, the search is not used for non-literal patterns
+        if (m_needle.isEmpty()) {
+            return;
+        }
+
+        // look for a byte that is rare in source code, prefer anything but lower case letters and spaces
+        for (int i = 0; i < m_needle.size(); i++) {
+            const char c = m_needle.at(i);
+            if (!(c >= 'a' && c <= 'z') && c != ' ') {
+                m_anchor = i;
+                break;
+            }
+        }
+        m_anchorLower = m_needle.at(m_anchor);
+        m_anchorUpper = (m_caseSensitive || m_anchorLower < 'a' || m_anchorLower > 'z') ? m_anchorLower : m_anchorLower - 'a' + 'A';
+    }
+
+    int length() const { return m_needle.size(); }
+
+    /**
+     * Offset of the first occurrence at or after @p from, -1 if there is none.
+     */
+    int indexIn(const char *data, int size, int from) const
+    {
+        const int length = m_needle.size();
+        if (size - from < length) {
+            return -1;
+        }
+
+        // the anchor byte of a match lies in [p, end)
+        const char *p = data + from + m_anchor;
+        const char *const end = data + size - length + m_anchor + 1;
+        const char *nextLower = 0;
+        const char *nextUpper = 0;
+        while (p < end) {
+            if (nextLower < p) {
+                nextLower = static_cast<const char *>(memchr(p, m_anchorLower, end - p));
+                if (!nextLower) nextLower = end;
+            }
+            if (m_anchorUpper == m_anchorLower) {
+                nextUpper = nextLower;
+            }
+            else if (nextUpper < p) {
+                nextUpper = static_cast<const char *>(memchr(p, m_anchorUpper, end - p));
+                if (!nextUpper) nextUpper = end;
+            }
+            p = qMin(nextLower, nextUpper);
+            if (p == end) {
+                break;
+            }
+
+            const char *const start = p - m_anchor;
+            if (matchesAt(start)) {
+                return start - data;
+            }
+            p++;
+        }
+        return -1;
+    }
+
+private:
+    bool matchesAt(const char *start) const
+    {
+        if (m_caseSensitive) {
+            return memcmp(start, m_needle.constData(), m_needle.size()) == 0;
+        }
+        for (int i = 0; i < m_needle.size(); i++) {
+            char c = start[i];
+            if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+            if (c != m_needle.at(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const QByteArray m_needle;
+    const bool       m_caseSensitive;
+    int              m_anchor;
+    char             m_anchorLower;
+    char             m_anchorUpper;
+};
+
+bool SearchDiskFiles::literalText(const QRegExp &regExp, QString &literal)
+{
+    literal.clear();
+    if (regExp.patternSyntax() == QRegExp::FixedString) {
+        literal = regExp.pattern();
+        return true;
+    }
+    if (regExp.patternSyntax() != QRegExp::RegExp && regExp.patternSyntax() != QRegExp::RegExp2) {
+        return false;
+    }
+
+    static const QString special = QLatin1String(".^$*+?()[]{}|");
+    const QString pattern = regExp.pattern();
+    for (int i = 0; i < pattern.size(); i++) {
+        const QChar c = pattern.at(i);
+        if (c == QLatin1Char('\\')) {
+            // escaped letters and digits are character classes, back references or control characters
+            if (i + 1 == pattern.size() || pattern.at(i + 1).isLetterOrNumber()) {
+                return false;
+            }
+            literal += pattern.at(++i);
+        }
+        else if (special.contains(c)) {
+            return false;
+        }
+        else {
+            literal += c;
+        }
+    }
+    return true;
+}
+
+class SearchDiskFilesWorker: public QRunnable
+{
+public:
+    SearchDiskFilesWorker(SearchDiskFiles *search) : m_search(search) {}
+
+    void run() { m_search->searchFiles(); }
+
+private:
+    SearchDiskFiles *m_search;
+};
+
+SearchDiskFiles::SearchDiskFiles(QObject *parent)
+: QThread(parent)
+, m_cancelSearch(true)
+, m_matchesPending(false)
+{}
 
 SearchDiskFiles::~SearchDiskFiles()
 {
@@ -34,7 +193,8 @@ SearchDiskFiles::~SearchDiskFiles()
 }
 
 void SearchDiskFiles::startSearch(const QStringList &files,
-                               const QRegExp &regexp)
+                               const QRegExp &regexp,
+                               const QHash<QString, FileStamp> &skipUnchanged)
 {
     if (files.size() == 0) {
         emit searchDone();
@@ -42,27 +202,52 @@ void SearchDiskFiles::startSearch(const QStringList &files,
     }
     m_cancelSearch = false;
     m_files = files;
+    m_skipUnchanged = skipUnchanged;
     m_regExp = regexp;
+    m_nextFile = 0;
+    m_searchedFiles = 0;
+
+    // literal patterns are searched in the raw bytes if the locale encoding keeps ASCII as is
+    // and one character is always encoded the same way, as UTF-8 and Latin-1 do
+    m_literal.clear();
+    QString literal;
+    QTextCodec *codec = QTextCodec::codecForLocale();
+    const int mib = codec->mibEnum();
+    if (literalText(regexp, literal) && !literal.isEmpty()
+        && !literal.contains(QLatin1Char('\n')) && !literal.contains(QLatin1Char('\r'))
+        && (mib == 106 || mib == 4 || mib == 3) && codec->canEncode(literal))
+    {
+        bool ascii = true;
+        for (int i = 0; i < literal.size(); i++) {
+            ascii = ascii && literal.at(i).unicode() < 128;
+        }
+        // the bytes of other characters can't be compared ignoring the case
+        if (ascii || regexp.caseSensitivity() == Qt::CaseSensitive) {
+            m_literal = codec->fromUnicode(literal);
+            m_literalLength = literal.size();
+        }
+    }
 
     start();
 }
 
 void SearchDiskFiles::run()
 {
-    foreach (QString fileName, m_files) {
-        if (m_cancelSearch) {
-            break;
-        }
+    QThreadPool workers;
+    const int workerCount = qBound(1, QThread::idealThreadCount(), m_files.size());
+    workers.setMaxThreadCount(workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        workers.start(new SearchDiskFilesWorker(this));
+    }
 
-        if (m_regExp.pattern().contains("\\n")) {
-            searchMultiLineRegExp(fileName);
-        }
-        else {
-            searchSingleLineRegExp(fileName);
-        }
+    // hand over the matches in batches, not each one in its own event
+    while (!workers.waitForDone(MatchesBatchInterval)) {
+        emitMatchesFound();
     }
-    emit searchDone();
+    emitMatchesFound();
+
     m_cancelSearch = true;
+    emit searchDone();
 }
 
 void SearchDiskFiles::cancelSearch()
@@ -75,79 +260,203 @@ bool SearchDiskFiles::searching()
     return !m_cancelSearch;
 }
 
-void SearchDiskFiles::searchSingleLineRegExp(const QString &fileName)
+QList<SearchDiskFiles::Match> SearchDiskFiles::takeMatches()
 {
-    QFile file (fileName);
+    QMutexLocker locker(&m_matchesMutex);
+    QList<Match> matches;
+    matches.swap(m_matches);
+    m_matchesPending = false;
+    return matches;
+}
 
-    if (!file.open(QFile::ReadOnly)) {
-        return;
+int SearchDiskFiles::searchedFiles() const
+{
+    return m_searchedFiles;
+}
+
+void SearchDiskFiles::emitMatchesFound()
+{
+    {
+        QMutexLocker locker(&m_matchesMutex);
+        if (m_matches.isEmpty() || m_matchesPending) {
+            return;
+        }
+        m_matchesPending = true;
+    }
+    emit matchesFound();
+}
+
+void SearchDiskFiles::searchFiles()
+{
+    // matching changes the state of the regexp, each worker needs its own
+    QRegExp regExp(m_regExp.pattern(), m_regExp.caseSensitivity(), m_regExp.patternSyntax());
+    regExp.setMinimal(m_regExp.isMinimal());
+    const bool multiLine = regExp.pattern().contains("\\n");
+    const LiteralSearch literal(m_literal, m_regExp.caseSensitivity());
+    QTextCodec *const localeCodec = QTextCodec::codecForLocale();
+
+    QList<Match> matches;
+    while (!m_cancelSearch) {
+        const int index = m_nextFile.fetchAndAddRelaxed(1);
+        if (index >= m_files.size()) {
+            break;
+        }
+        const QString &fileName = m_files.at(index);
+
+        // files excluded by an index are only searched if they changed since it was updated
+        QHash<QString, FileStamp>::const_iterator skip = m_skipUnchanged.constFind(fileName);
+        if (skip != m_skipUnchanged.constEnd()) {
+            const QFileInfo info(fileName);
+            if (info.size() == skip.value().first && info.lastModified().toTime_t() == skip.value().second) {
+                continue;
+            }
+        }
+
+        QFile file(fileName);
+        if (!file.open(QFile::ReadOnly)) {
+            continue;
+        }
+
+        // read the file at once, decode it like QTextStream: unicode if it has a byte order mark, else in the locale encoding
+        const QByteArray data = file.readAll();
+        file.close();
+        QTextCodec *const utfCodec = QTextCodec::codecForUtfText(data, 0);
+
+        if (!m_literal.isEmpty() && !utfCodec) {
+            searchLiteral(fileName, data, literal, localeCodec, matches);
+        }
+        else {
+            QString text = (utfCodec ? utfCodec : localeCodec)->toUnicode(data);
+            if (multiLine) {
+                searchMultiLineRegExp(fileName, text, regExp, matches);
+            }
+            else {
+                searchSingleLineRegExp(fileName, text, regExp, matches);
+            }
+        }
+        m_searchedFiles.ref();
+
+        if (!matches.isEmpty()) {
+            QMutexLocker locker(&m_matchesMutex);
+            m_matches += matches;
+            matches.clear();
+        }
     }
+}
 
-    QTextStream stream (&file);
-    QString line;
+void SearchDiskFiles::searchSingleLineRegExp(const QString &fileName, const QString &text, QRegExp &regExp, QList<Match> &matches)
+{
+    int lineStart = 0;
     int i = 0;
     int column;
-    while (!(line=stream.readLine()).isNull()) {
+    while (lineStart < text.size()) {
         if (m_cancelSearch) break;
-        column = m_regExp.indexIn(line);
+
+        int lineEnd = text.indexOf('\n', lineStart);
+        const int nextLineStart = (lineEnd == -1) ? text.size() : lineEnd + 1;
+        if (lineEnd == -1) {
+            lineEnd = text.size();
+        }
+        if (lineEnd > lineStart && text.at(lineEnd - 1) == '\r') {
+            lineEnd--;
+        }
+
+        // search the line inside of the text, it is only copied for a match
+        QString line = QString::fromRawData(text.constData() + lineStart, lineEnd - lineStart);
+        column = regExp.indexIn(line);
         while (column != -1) {
-            if (m_regExp.cap().isEmpty()) break;
+            if (regExp.matchedLength() == 0) break;
             // limit line length
-            if (line.length() > 512) line = line.left(512);
-            emit matchFound(fileName, i, column, line, m_regExp.matchedLength());
-            column = m_regExp.indexIn(line, column + m_regExp.cap().size());
+            if (line.length() > MaxLineLength) line = QString::fromRawData(line.constData(), MaxLineLength);
+            matches.append(Match(fileName, i, column, QString(line.constData(), line.length()), regExp.matchedLength()));
+            column = regExp.indexIn(line, column + regExp.matchedLength());
         }
+
+        lineStart = nextLineStart;
         i++;
     }
 }
 
-void SearchDiskFiles::searchMultiLineRegExp(const QString &fileName)
+void SearchDiskFiles::searchMultiLineRegExp(const QString &fileName, QString &text, QRegExp &regExp, QList<Match> &matches)
 {
-    QFile file (fileName);
     int column = 0;
     int line = 0;
-    static QString fullDoc;
-    static QVector<int> lineStart;
+    QVector<int> lineStart;
 
+    text.remove('\r');
 
-    if (!file.open(QFile::ReadOnly)) {
-        return;
-    }
-
-    QTextStream stream (&file);
-    fullDoc = stream.readAll();
-    fullDoc.remove('\r');
-
-    lineStart.clear();
     lineStart << 0;
-    for (int i=0; i<fullDoc.size()-1; i++) {
-        if (fullDoc[i] == '\n') {
+    for (int i=0; i<text.size()-1; i++) {
+        if (text[i] == '\n') {
             lineStart << i+1;
         }
     }
 
-    column = m_regExp.indexIn(fullDoc, column);
+    column = regExp.indexIn(text, column);
     while (column != -1) {
         if (m_cancelSearch) break;
-        if (m_regExp.cap().isEmpty()) break;
+        if (regExp.matchedLength() == 0) break;
         // search for the line number of the match
-        int i;
-        line = -1;
-        for (i=1; i<lineStart.size(); i++) {
-            if (lineStart[i] > column) {
-                line = i-1;
-                break;
+        line = (qUpperBound(lineStart.constBegin(), lineStart.constEnd(), column) - lineStart.constBegin()) - 1;
+        matches.append(Match(fileName,
+                             line,
+                             (column - lineStart[line]),
+                             text.mid(lineStart[line], column - lineStart[line])+regExp.cap(),
+                             regExp.matchedLength()));
+        column = regExp.indexIn(text, column + regExp.matchedLength());
+    }
+}
+
+void SearchDiskFiles::searchLiteral(const QString &fileName, const QByteArray &data, const LiteralSearch &literal, QTextCodec *codec, QList<Match> &matches)
+{
+    const char *const text = data.constData();
+    const int size = data.size();
+
+    // lines are only counted and decoded up to the hits
+    int line = 0;
+    int lineStart = 0;
+    int lineEnd = -1;
+    int counted = 0;
+    QString lineContent;
+    int column = 0;
+    int columnOffset = 0;
+
+    int offset = literal.indexIn(text, size, 0);
+    while (offset != -1) {
+        if (m_cancelSearch) break;
+
+        if (offset >= lineEnd) {
+            // first hit in a line, count the line feeds up to it
+            const char *lineFeed;
+            while ((lineFeed = static_cast<const char *>(memchr(text + counted, '\n', offset - counted)))) {
+                counted = lineFeed - text + 1;
+                lineStart = counted;
+                line++;
+            }
+            counted = offset;
+
+            lineFeed = static_cast<const char *>(memchr(text + offset, '\n', size - offset));
+            lineEnd = lineFeed ? lineFeed - text : size;
+            int contentEnd = lineEnd;
+            if (contentEnd > lineStart && text[contentEnd - 1] == '\r') {
+                contentEnd--;
             }
+
+            lineContent = codec->toUnicode(text + lineStart, contentEnd - lineStart);
+            column = codec->toUnicode(text + lineStart, offset - lineStart).size();
+            if (lineContent.size() > MaxLineLength) lineContent.truncate(MaxLineLength);
         }
-        if (line == -1) {
-            break;
+        else {
+            // the following hits must be inside of the shortened line, like for regular expressions
+            column += codec->toUnicode(text + columnOffset, offset - columnOffset).size();
+            if (column + m_literalLength > lineContent.size()) {
+                offset = literal.indexIn(text, size, lineEnd);
+                continue;
+            }
         }
-        emit matchFound(fileName,
-                        line,
-                        (column - lineStart[line]),
-                        fullDoc.mid(lineStart[line], column - lineStart[line])+m_regExp.cap(),
-                        m_regExp.matchedLength());
-        column = m_regExp.indexIn(fullDoc, column + m_regExp.matchedLength());
+        columnOffset = offset;
+
+        matches.append(Match(fileName, line, column, lineContent, m_literalLength));
+        offset = literal.indexIn(text, size, offset + literal.length());
     }
 }
-
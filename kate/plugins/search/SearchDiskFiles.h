@@ -27,37 +27,118 @@
 #include <QVector>
 #include <QMutex>
 #include <QStringList>
+#include <QHash>
+#include <QPair>
+#include <QAtomicInt>
 
+class QTextCodec;
+class LiteralSearch;
+
+/**
+ * Searches files on disk with a pool of worker threads, one per core.
+ * The workers take the files one after the other from the list, each with its own
+ * regular expression. This thread collects their matches and hands them over in
+ * timed batches: matchesFound() tells that takeMatches() has something.
+ *
+ * Literal patterns, plain text or a regular expression without special characters,
+ * are searched in the raw bytes of the files; only the lines with a hit are decoded.
+ */
 class SearchDiskFiles: public QThread
 {
     Q_OBJECT
 
 public:
+    /**
+     * One match in a file
+     */
+    struct Match {
+        Match(const QString &fileName, int line, int column, const QString &lineContent, int matchLen)
+        : fileName(fileName), line(line), column(column), lineContent(lineContent), matchLen(matchLen) {}
+
+        QString fileName;
+        int     line;
+        int     column;
+        QString lineContent;
+        int     matchLen;
+    };
+
+    /**
+     * Size and modification time in seconds of a file
+     */
+    typedef QPair<qint64, uint> FileStamp;
+
     SearchDiskFiles(QObject *parent = 0);
     ~SearchDiskFiles();
 
+    /**
+     * Start to search the files.
+     * The files in @p skipUnchanged are only searched if their size or modification time
+     * differ from the given ones, the workers check that. An index uses it for the files it
+     * excludes, to catch those changed after it was updated.
+     */
     void startSearch(const QStringList &iles,
-                     const QRegExp &regexp);
+                     const QRegExp &regexp,
+                     const QHash<QString, FileStamp> &skipUnchanged = QHash<QString, FileStamp>());
     void run();
 
     bool searching();
 
+    /**
+     * Take the matches found since the last call.
+     */
+    QList<Match> takeMatches();
+
+    /**
+     * Number of files searched by the last or current search.
+     */
+    int searchedFiles() const;
+
+    /**
+     * The text a pattern stands for, if it has no special characters.
+     * Escaped special characters like "\." are taken as the character itself.
+     */
+    static bool literalText(const QRegExp &regExp, QString &literal);
+
 private:
-    void searchSingleLineRegExp(const QString &fileName);
-    void searchMultiLineRegExp(const QString &fileName);
+    friend class SearchDiskFilesWorker;
+
+    /**
+     * Work of one worker thread, search files until none is left.
+     */
+    void searchFiles();
+
+    void searchSingleLineRegExp(const QString &fileName, const QString &text, QRegExp &regExp, QList<Match> &matches);
+    void searchMultiLineRegExp(const QString &fileName, QString &text, QRegExp &regExp, QList<Match> &matches);
+    void searchLiteral(const QString &fileName, const QByteArray &data, const LiteralSearch &literal, QTextCodec *codec, QList<Match> &matches);
+
+    /**
+     * Tell about new matches, if the last batch was taken already.
+     */
+    void emitMatchesFound();
 
 public Q_SLOTS:
     void cancelSearch();
 
 Q_SIGNALS:
-    void matchFound(const QString &url, int line, int column,
-                    const QString &lineContent, int matchLen);
+    void matchesFound();
     void searchDone();
 
 private:
     QRegExp          m_regExp;
     QStringList      m_files;
-    bool             m_cancelSearch;
+    QHash<QString, FileStamp> m_skipUnchanged;
+    volatile bool    m_cancelSearch;
+
+    // the pattern in the locale encoding if it is searched in the raw bytes, else empty
+    QByteArray       m_literal;
+    int              m_literalLength;
+
+    QAtomicInt       m_nextFile;
+    QAtomicInt       m_searchedFiles;
+
+    QMutex           m_matchesMutex;
+    QList<Match>     m_matches;
+    bool             m_matchesPending;
 };
 
 
@@ -299,8 +299,7 @@ m_projectPluginView(0)
 
     connect(&m_folderFilesList, SIGNAL(finished()),  this, SLOT(folderFileListChanged()));
 
-    connect(&m_searchDiskFiles, SIGNAL(matchFound(QString,int,int,QString,int)),
-            this,              SLOT(matchFound(QString,int,int,QString,int)));
+    connect(&m_searchDiskFiles, SIGNAL(matchesFound()), this, SLOT(diskMatchesFound()));
     connect(&m_searchDiskFiles, SIGNAL(searchDone()),  this, SLOT(searchDone()));
 
     connect(m_kateApp->documentManager(), SIGNAL(documentWillBeDeleted(KTextEditor::Document*)),
@@ -575,13 +574,35 @@ void KatePluginSearchView::startSearch()
                 files.removeAt(index);
             }
         }
+
+        // the trigram index of the project, if any, skips the files that can't contain a literal pattern,
+        // the skipped files are still searched if they changed since the index was updated
+        QString literal;
+        QHash<QString, SearchDiskFiles::FileStamp> skipUnchanged;
+        if (m_projectPluginView && SearchDiskFiles::literalText(reg, literal) && !literal.isEmpty()) {
+            QVariantMap candidates;
+            if (QMetaObject::invokeMethod(m_projectPluginView, "projectFilesContaining", Q_RETURN_ARG(QVariantMap, candidates),
+                                          Q_ARG(QStringList, files), Q_ARG(QString, literal))) {
+                files = candidates.value("files").toStringList();
+                const QVariantHash skipped = candidates.value("skipped").toHash();
+                skipUnchanged.reserve(skipped.size());
+                for (QVariantHash::const_iterator it = skipped.constBegin(); it != skipped.constEnd(); ++it) {
+                    const QVariantList stamp = it.value().toList();
+                    if (stamp.size() == 2) {
+                        files << it.key();
+                        skipUnchanged.insert(it.key(), SearchDiskFiles::FileStamp(stamp[0].toLongLong(), stamp[1].toUInt()));
+                    }
+                }
+            }
+        }
+
         // search order is important: Open files starts immediately and should finish
         // earliest after first event loop.
         // The DiskFile might finish immediately
         if (openList.size() > 0) {
             m_searchOpenFiles.startSearch(openList, m_curResults->regExp);
         }
-        m_searchDiskFiles.startSearch(files, reg);
+        m_searchDiskFiles.startSearch(files, reg, skipUnchanged);
     }
     m_toolView->setCursor(Qt::WaitCursor);
 
@@ -818,6 +839,21 @@ void KatePluginSearchView::matchFound(const QString &url, int line, int column,
     addMatchMark(doc, line, column, matchLen);
 }
 
+void KatePluginSearchView::diskMatchesFound()
+{
+    const QList<SearchDiskFiles::Match> matches = m_searchDiskFiles.takeMatches();
+    if (!m_curResults) {
+        return;
+    }
+
+    // add the whole batch before the tree is painted again
+    m_curResults->tree->setUpdatesEnabled(false);
+    foreach (const SearchDiskFiles::Match &match, matches) {
+        matchFound(match.fileName, match.line, match.column, match.lineContent, match.matchLen);
+    }
+    m_curResults->tree->setUpdatesEnabled(true);
+}
+
 void KatePluginSearchView::clearMarks()
 {
     // FIXME: check for ongoing search...
@@ -121,6 +121,7 @@ private Q_SLOTS:
 
     void matchFound(const QString &fileName, int line, int column,
                     const QString &lineContent, int matchLen);
+    void diskMatchesFound();
 
     void addMatchMark(KTextEditor::Document* doc, int line, int column, int len);
 
@@ -0,0 +1,133 @@
+/*   Kate search plugin
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program in a file called COPYING; if not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "SearchDiskFiles.h"
+
+#include <qtest_kde.h>
+#include <ktempdir.h>
+
+#include <QObject>
+#include <QDir>
+#include <QFile>
+#include <QEventLoop>
+#include <QElapsedTimer>
+
+#include <stdio.h>
+
+/**
+ * Search in files benchmark, searches a synthetic tree of 100k files
+ * (100 folders of 1000 files with 40 lines each) and prints files/s and matches/s.
+ *
+ * Usage:
+ *   searchdiskfilesbenchmark [QTest options] [searchFiles:<row>]
+ */
+class SearchDiskFilesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void searchFiles_data();
+    void searchFiles();
+
+public Q_SLOTS:
+    void collectMatches();
+
+private:
+    KTempDir         m_tree;
+    QStringList      m_files;
+    SearchDiskFiles *m_search;
+    int              m_matches;
+};
+
+QTEST_KDEMAIN_CORE(SearchDiskFilesBenchmark)
+
+void SearchDiskFilesBenchmark::initTestCase()
+{
+    for (int folder = 0; folder < 100; folder++) {
+        const QString path = m_tree.name() + QString("folder%1/").arg(folder);
+        QVERIFY(QDir().mkpath(path));
+
+        for (int i = 0; i < 1000; i++) {
+            QFile file(path + QString("file%1.cpp").arg(i));
+            QVERIFY(file.open(QFile::WriteOnly));
+
+            // 10 functions of 4 lines, every tenth file calls commonIdentifier
+            QByteArray text;
+            for (int function = 0; function < 10; function++) {
+                text += "int function" + QByteArray::number(function) + "(int value)\n{\n";
+                text += (i % 10 == 0) ? "    return commonIdentifier(value);\n" : "    return value;\n";
+                text += "}\n";
+            }
+            file.write(text);
+            m_files << file.fileName();
+        }
+    }
+}
+
+void SearchDiskFilesBenchmark::searchFiles_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<int>("matches");
+    QTest::addColumn<bool>("matchCase");
+
+    QTest::newRow("common identifier") << "commonIdentifier" << 100000 << true;
+    QTest::newRow("common identifier, ignore case") << "COMMONidentifier" << 100000 << false;
+    QTest::newRow("common identifier, escaped") << "commonIdentifier\\(value\\)" << 100000 << true;
+    QTest::newRow("common identifier, regexp") << "common[I]dentifier" << 100000 << true;
+    QTest::newRow("every word") << "\\w+" << 6100000 << true;
+    QTest::newRow("no match") << "uncommonIdentifier" << 0 << true;
+    QTest::newRow("multi-line") << "\\{\\n    return c" << 100000 << true;
+}
+
+void SearchDiskFilesBenchmark::searchFiles()
+{
+    QFETCH(QString, pattern);
+    QFETCH(int, matches);
+    QFETCH(bool, matchCase);
+
+    SearchDiskFiles search;
+    m_search = &search;
+    m_matches = 0;
+    connect(&search, SIGNAL(matchesFound()), this, SLOT(collectMatches()));
+
+    QEventLoop loop;
+    connect(&search, SIGNAL(searchDone()), &loop, SLOT(quit()));
+
+    QElapsedTimer timer;
+    timer.start();
+    search.startSearch(m_files, QRegExp(pattern, matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive));
+    loop.exec();
+    const double seconds = qMax<qint64>(timer.elapsed(), 1) / 1000.0;
+
+    printf("%-32s %8d files %6.0f files/s %8d matches %9.0f matches/s\n", qPrintable(pattern),
+           search.searchedFiles(), search.searchedFiles() / seconds, m_matches, m_matches / seconds);
+
+    QCOMPARE(search.searchedFiles(), m_files.size());
+    QCOMPARE(m_matches, matches);
+}
+
+void SearchDiskFilesBenchmark::collectMatches()
+{
+    m_matches += m_search->takeMatches().size();
+}
+
+#include "searchdiskfilesbenchmark.moc"
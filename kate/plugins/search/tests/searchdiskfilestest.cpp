@@ -0,0 +1,218 @@
+/*   Kate search plugin
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program in a file called COPYING; if not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "SearchDiskFiles.h"
+
+#include <qtest_kde.h>
+#include <ktempdir.h>
+
+#include <QObject>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTextCodec>
+
+class SearchDiskFilesTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void skipUnchanged();
+
+    void literalText_data();
+    void literalText();
+
+    void literalMatchesRegExp_data();
+    void literalMatchesRegExp();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &content);
+    QList<SearchDiskFiles::Match> search(const QStringList &files, const QRegExp &regExp,
+                                         const QHash<QString, SearchDiskFiles::FileStamp> &skipUnchanged = QHash<QString, SearchDiskFiles::FileStamp>());
+
+private:
+    KTempDir    m_tree;
+    QStringList m_files;
+};
+
+static bool matchLessThan(const SearchDiskFiles::Match &a, const SearchDiskFiles::Match &b)
+{
+    if (a.fileName != b.fileName) return a.fileName < b.fileName;
+    if (a.line != b.line) return a.line < b.line;
+    return a.column < b.column;
+}
+
+QTEST_KDEMAIN_CORE(SearchDiskFilesTest)
+
+void SearchDiskFilesTest::initTestCase()
+{
+    // the raw bytes are only searched for UTF-8 and Latin-1 locales
+    QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+
+    // a long line with hits before, at and after the 512 character cut
+    QByteArray longLine(600, 'x');
+    longLine.replace(100, 6, "needle");
+    longLine.replace(300, 6, "NEEDLE");
+    longLine.replace(506, 6, "needle");
+    QByteArray crossingLine(600, 'x');
+    crossingLine.replace(509, 6, "needle");
+    crossingLine.replace(530, 6, "needle");
+
+    m_files << writeFile("crlf.txt", "needle a.b\r\nno match\r\n\r\nneedle needle\r\n");
+    m_files << writeFile("long.txt", longLine + "\n" + crossingLine + "\nneedle\n");
+    m_files << writeFile("case.txt", "Needle NEEDLE needle nEeDlE\nneedleneedle\naaaaa\n");
+    m_files << writeFile("utf8.txt", "äöü needle ü needle\nGrüße aus der Straße\nÄÖÜ äöü\n\tneedle");
+    m_files << writeFile("bom.txt", "\xef\xbb\xbfäöü needle\nneedle\n");
+    m_files << writeFile("escaped.txt", "a.b a\\b axb\na\\\\b a..b\n");
+    QVERIFY(!m_files.contains(QString()));
+}
+
+QString SearchDiskFilesTest::writeFile(const QString &name, const QByteArray &content)
+{
+    QFile file(m_tree.name() + name);
+    if (!file.open(QFile::WriteOnly) || file.write(content) != content.size()) {
+        return QString();
+    }
+    return file.fileName();
+}
+
+QList<SearchDiskFiles::Match> SearchDiskFilesTest::search(const QStringList &files, const QRegExp &regExp,
+                                                          const QHash<QString, SearchDiskFiles::FileStamp> &skipUnchanged)
+{
+    SearchDiskFiles search;
+    search.startSearch(files, regExp, skipUnchanged);
+    search.wait();
+    return search.takeMatches();
+}
+
+void SearchDiskFilesTest::skipUnchanged()
+{
+    // a file an index excluded, as it was when indexed
+    const QString fileName = writeFile("skipped.cpp", "int alpha;\n");
+    QVERIFY(!fileName.isEmpty());
+    const QFileInfo indexed(fileName);
+    QHash<QString, SearchDiskFiles::FileStamp> skip;
+    skip.insert(fileName, SearchDiskFiles::FileStamp(indexed.size(), indexed.lastModified().toTime_t()));
+
+    // unchanged, it isn't read
+    const QRegExp regExp("gamma", Qt::CaseSensitive, QRegExp::FixedString);
+    QVERIFY(search(QStringList() << fileName, regExp, skip).isEmpty());
+
+    // edited after indexing, it is searched and the match is found
+    QVERIFY(writeFile("skipped.cpp", "int alpha;\nint gamma;\n") == fileName);
+    const QList<SearchDiskFiles::Match> matches = search(QStringList() << fileName, regExp, skip);
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches[0].fileName, fileName);
+    QCOMPARE(matches[0].line, 1);
+    QCOMPARE(matches[0].column, 4);
+
+    // files not in the hash are always searched
+    QCOMPARE(search(QStringList() << fileName, regExp).size(), 1);
+}
+
+void SearchDiskFilesTest::literalText_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<int>("syntax");
+    QTest::addColumn<bool>("isLiteral");
+    QTest::addColumn<QString>("literal");
+
+    QTest::newRow("plain") << "needle" << int(QRegExp::RegExp) << true << "needle";
+    QTest::newRow("escaped dot") << "a\\.b" << int(QRegExp::RegExp) << true << "a.b";
+    QTest::newRow("escaped backslash") << "a\\\\b" << int(QRegExp::RegExp2) << true << "a\\b";
+    QTest::newRow("fixed string") << "a.b(" << int(QRegExp::FixedString) << true << "a.b(";
+    QTest::newRow("dot") << "a.b" << int(QRegExp::RegExp) << false << "";
+    QTest::newRow("character class") << "\\d" << int(QRegExp::RegExp) << false << "";
+    QTest::newRow("trailing backslash") << "a\\" << int(QRegExp::RegExp) << false << "";
+    QTest::newRow("wildcard") << "needle" << int(QRegExp::Wildcard) << false << "";
+}
+
+void SearchDiskFilesTest::literalText()
+{
+    QFETCH(QString, pattern);
+    QFETCH(int, syntax);
+    QFETCH(bool, isLiteral);
+    QFETCH(QString, literal);
+
+    QString text;
+    QCOMPARE(SearchDiskFiles::literalText(QRegExp(pattern, Qt::CaseSensitive, QRegExp::PatternSyntax(syntax)), text), isLiteral);
+    if (isLiteral) {
+        QCOMPARE(text, literal);
+    }
+}
+
+void SearchDiskFilesTest::literalMatchesRegExp_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("matchCase");
+
+    QTest::newRow("plain") << "needle" << true;
+    QTest::newRow("ignore case") << "NEEDLE" << false;
+    QTest::newRow("mixed case") << "nEeDlE" << true;
+    QTest::newRow("repeated") << "aa" << true;
+    QTest::newRow("line start") << "no" << true;
+    QTest::newRow("escaped dot") << "a\\.b" << true;
+    QTest::newRow("escaped backslash") << "a\\\\b" << true;
+    QTest::newRow("escaped dots") << "a\\.\\.b" << true;
+    QTest::newRow("utf-8") << QString::fromUtf8("Straße") << true;
+    QTest::newRow("utf-8 after utf-8") << QString::fromUtf8("äöü") << true;
+    QTest::newRow("utf-8, ignore case, decoded") << QString::fromUtf8("äöü") << false;
+    QTest::newRow("tab") << "\tneedle" << true;
+    QTest::newRow("no match") << "haystack" << false;
+}
+
+void SearchDiskFilesTest::literalMatchesRegExp()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, matchCase);
+
+    const Qt::CaseSensitivity caseSensitivity = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const QRegExp literal(pattern, caseSensitivity);
+    QString text;
+    QVERIFY(SearchDiskFiles::literalText(literal, text));
+
+    // a group makes the same pattern a regular expression, it is searched in the decoded text
+    const QRegExp regExp("(?:" + pattern + ")", caseSensitivity);
+    QVERIFY(!SearchDiskFiles::literalText(regExp, text));
+
+    QList<SearchDiskFiles::Match> literalMatches = search(m_files, literal);
+    QList<SearchDiskFiles::Match> regExpMatches = search(m_files, regExp);
+    qSort(literalMatches.begin(), literalMatches.end(), matchLessThan);
+    qSort(regExpMatches.begin(), regExpMatches.end(), matchLessThan);
+
+    QCOMPARE(literalMatches.size(), regExpMatches.size());
+    for (int i = 0; i < literalMatches.size(); i++) {
+        QCOMPARE(literalMatches[i].fileName, regExpMatches[i].fileName);
+        QCOMPARE(literalMatches[i].line, regExpMatches[i].line);
+        QCOMPARE(literalMatches[i].column, regExpMatches[i].column);
+        QCOMPARE(literalMatches[i].matchLen, regExpMatches[i].matchLen);
+        QCOMPARE(literalMatches[i].lineContent, regExpMatches[i].lineContent);
+    }
+
+    // a fixed string is the same literal
+    QString fixed;
+    SearchDiskFiles::literalText(literal, fixed);
+    QList<SearchDiskFiles::Match> fixedMatches = search(m_files, QRegExp(fixed, caseSensitivity, QRegExp::FixedString));
+    QCOMPARE(fixedMatches.size(), literalMatches.size());
+}
+
+#include "searchdiskfilestest.moc"
@@ -26,6 +26,9 @@ namespace Kate {
 TextBlock::TextBlock (TextBuffer *buffer, int startLine)
   : m_buffer (buffer)
   , m_startLine (startLine)
+  , m_startLineRevision (-1)
+  , m_index (-1)
+  , m_bracketSummaryValid (false)
 {
 }
 
@@ -38,13 +41,16 @@ TextBlock::~TextBlock ()
   // it only is a hint for ranges for this block, not the storage of them
 }
 
-void TextBlock::setStartLine (int startLine)
+int TextBlock::startLine () const
 {
-  // allow only valid lines
-  Q_ASSERT (startLine >= 0);
-  Q_ASSERT (startLine < m_buffer->lines ());
-
-  m_startLine = startLine;
+  // block not yet in the index or cached value still valid?
+  if (m_index < 0 || m_startLineRevision == m_buffer->m_blockIndexRevision)
+    return m_startLine;
+
+  // line counts did change, ask the block index
+  m_startLine = m_buffer->startLineOfBlock (m_index);
+  m_startLineRevision = m_buffer->m_blockIndexRevision;
+  return m_startLine;
 }
 
 TextLine TextBlock::line (int line) const
@@ -62,6 +68,41 @@ TextLine TextBlock::line (int line) const
   return m_lines.at(line);
 }
 
+void TextBlock::appendLine (const QChar *unicode, int length, bool compact)
+{
+  // only text that fits into Latin-1 can be stored compact
+  for (int i = 0; compact && i < length; ++i)
+    compact = unicode[i].unicode() < 256;
+
+  if (!compact) {
+    m_lines.append (TextLine (new TextLineData (QString (unicode, length))));
+    m_bracketSummaryValid = false;
+    return;
+  }
+
+  // append the text to the arena of this block, start one if needed
+  if (!m_arena)
+    m_arena = new TextLineArena ();
+
+  const int offset = m_arena->data.size ();
+  m_arena->data.resize (offset + length);
+  char *data = m_arena->data.data () + offset;
+  for (int i = 0; i < length; ++i)
+    data[i] = unicode[i].toLatin1 ();
+
+  m_lines.append (TextLine (new TextLineData (m_arena, offset, length)));
+  m_bracketSummaryValid = false;
+}
+
+void TextBlock::finishAppending ()
+{
+  if (!m_arena)
+    return;
+
+  m_arena->data.squeeze ();
+  m_arena = QExplicitlySharedDataPointer<TextLineArena> ();
+}
+
 void TextBlock::text (QString &text) const
 {
   // combine all lines
@@ -70,7 +111,7 @@ void TextBlock::text (QString &text) const
       if (i > 0 || startLine() > 0)
         text.append ('\n');
 
-      text.append (m_lines.at(i)->text ());
+      text.append (m_lines.at(i)->textCopy ());
   }
 }
 
@@ -88,6 +129,7 @@ void TextBlock::wrapLine (const KTextEditor::Cursor &position, int fixStartLines
 
   // create new line and insert it
   m_lines.insert (m_lines.begin() + line + 1, TextLine (new TextLineData()));
+  m_bracketSummaryValid = false;
 
   // cases for modification:
   // 1. line is wrapped in the middle
@@ -127,11 +169,18 @@ void TextBlock::wrapLine (const KTextEditor::Cursor &position, int fixStartLines
    * cursor and range handling below
    */
 
+  // the ranges filed for the wrapped line or behind it shift, take them out and refile them after the cursors moved
+  const QList<TextRange *> shiftedRanges = takeRangesFromLine (line);
+
   // no cursors will leave or join this block
 
   // no cursors in this block, no work to do..
-  if (m_cursors.empty())
+  // the ranges must be taken out above first, the filing by line is stale now; a range
+  // filed in this block has its cursors here, so with no cursors none was taken out
+  if (m_cursors.empty()) {
+    Q_ASSERT (shiftedRanges.isEmpty());
     return;
+  }
 
   // move all cursors on the line which has the text inserted
   // remember all ranges modified
@@ -169,6 +218,10 @@ void TextBlock::wrapLine (const KTextEditor::Cursor &position, int fixStartLines
         changedRanges.insert (cursor->kateRange());
   }
 
+  // refile the shifted ranges, the unchanged ones are skipped by the lookup update
+  foreach (TextRange *range, shiftedRanges)
+    updateRange (range);
+
   // check validity of all ranges, might invalidate them...
   foreach (TextRange *range, changedRanges)
     range->checkValidity ();
@@ -191,6 +244,8 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
     TextLine newFirst = previousBlock->m_lines.last();
     m_lines[0] = newFirst;
     previousBlock->m_lines.erase (previousBlock->m_lines.begin() + (previousBlock->lines () - 1));
+    previousBlock->m_bracketSummaryValid = false;
+    m_bracketSummaryValid = false;
 
     // append text
     const int oldSizeOfPreviousLine = newFirst->text().size();
@@ -204,9 +259,6 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
       newFirst->markAsModified(true);
     }
 
-    // patch startLine of this block
-    --m_startLine;
-
     /**
      * fix all start lines
      * we need to do this NOW, else the range update will FAIL!
@@ -223,13 +275,20 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
      * cursor and range handling below
      */
 
+    // the ranges filed for the moved line shift, take them out of the previous block and refile them after the cursors moved
+    const QList<TextRange *> shiftedRanges = previousBlock->takeRangesFromLine (lastLineOfPreviousBlock);
+
     // no cursors in this block and the previous one, no work to do..
-    if (m_cursors.empty() && previousBlock->m_cursors.empty())
+    // the ranges must be taken out above first, the filing by line of the previous block is stale now;
+    // a range filed in it has its cursors there, so with no cursors none was taken out
+    if (m_cursors.empty() && previousBlock->m_cursors.empty()) {
+      Q_ASSERT (shiftedRanges.isEmpty());
       return;
+    }
 
     // move all cursors because of the unwrapped line
     // remember all ranges modified
-    QSet<TextRange *> changedRanges;
+    QSet<TextRange *> changedRanges = shiftedRanges.toSet();
     foreach (TextCursor *cursor, m_cursors) {
         // this is the unwrapped line
         if (cursor->lineInBlock() == 0) {
@@ -292,6 +351,7 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
     m_lines.at(line-1)->markAsSavedOnDisk(true);
 
   m_lines.erase (m_lines.begin () + line);
+  m_bracketSummaryValid = false;
 
   /**
    * fix all start lines
@@ -309,9 +369,16 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
    * cursor and range handling below
    */
 
+  // the ranges filed for the unwrapped line or behind it shift, take them out and refile them after the cursors moved
+  const QList<TextRange *> shiftedRanges = takeRangesFromLine (line);
+
   // no cursors in this block, no work to do..
-  if (m_cursors.empty())
+  // the ranges must be taken out above first, the filing by line is stale now; a range
+  // filed in this block has its cursors here, so with no cursors none was taken out
+  if (m_cursors.empty()) {
+    Q_ASSERT (shiftedRanges.isEmpty());
     return;
+  }
 
   // move all cursors because of the unwrapped line
   // remember all ranges modified
@@ -335,6 +402,10 @@ void TextBlock::unwrapLine (int line, TextBlock *previousBlock, int fixStartLine
         changedRanges.insert (cursor->kateRange());
   }
 
+  // refile the shifted ranges, the unchanged ones are skipped by the lookup update
+  foreach (TextRange *range, shiftedRanges)
+    updateRange (range);
+
   // check validity of all ranges, might invalidate them...
   foreach (TextRange *range, changedRanges)
     range->checkValidity ();
@@ -347,6 +418,7 @@ void TextBlock::insertText (const KTextEditor::Cursor &position, const QString &
 
   // get text
   QString &textOfLine = m_lines.at(line)->textReadWrite ();
+  m_bracketSummaryValid = false;
   int oldLength = textOfLine.size ();
   m_lines.at(line)->markAsModified(true);
 
@@ -409,6 +481,7 @@ void TextBlock::removeText (const KTextEditor::Range &range, QString &removedTex
 
   // get text
   QString &textOfLine = m_lines.at(line)->textReadWrite ();
+  m_bracketSummaryValid = false;
   int oldLength = textOfLine.size ();
 
   // check if valid column
@@ -486,6 +559,7 @@ TextBlock *TextBlock::splitBlock (int fromLine)
   for (int i = fromLine; i < m_lines.size(); ++i)
     newBlock->m_lines.append (m_lines.at(i));
   m_lines.resize (fromLine);
+  m_bracketSummaryValid = false;
 
   // move cursors
   QSet<TextCursor*> oldBlockSet;
@@ -500,9 +574,9 @@ TextBlock *TextBlock::splitBlock (int fromLine)
   }
   m_cursors = oldBlockSet;
 
-  // fix ALL ranges!
-  QList<TextRange*> allRanges = m_uncachedRanges.toList() + m_cachedLineForRanges.keys();
-  foreach (TextRange *range, allRanges) {
+  // fix the ranges filed for the moved lines, the ones spanning this block span the new one, too
+  QList<TextRange*> movedRanges = takeRangesFromLine (fromLine) + m_spanningRanges.toList();
+  foreach (TextRange *range, movedRanges) {
       // update both blocks
       updateRange (range);
       newBlock->updateRange (range);
@@ -527,14 +601,16 @@ void TextBlock::mergeBlock (TextBlock *targetBlock)
   for (int i = 0; i < m_lines.size(); ++i)
     targetBlock->m_lines.append (m_lines.at(i));
   m_lines.clear ();
-
-  // fix ALL ranges!
-  QList<TextRange*> allRanges = m_uncachedRanges.toList() + m_cachedLineForRanges.keys();
-  foreach(TextRange* range, allRanges) {
-    // update both blocks
-    updateRange (range);
+  targetBlock->m_bracketSummaryValid = false;
+  m_bracketSummaryValid = false;
+
+  // fix ALL ranges! this block is empty now, the target one gets them
+  QList<TextRange*> allRanges = m_spanningRanges.toList() + m_filedLinesForRanges.keys();
+  m_rangesForLine.clear ();
+  m_filedLinesForRanges.clear ();
+  m_spanningRanges.clear ();
+  foreach(TextRange* range, allRanges)
     targetBlock->updateRange (range);
-  }
 }
 
 void TextBlock::deleteBlockContent ()
@@ -547,6 +623,7 @@ void TextBlock::deleteBlockContent ()
 
   // kill lines
   m_lines.clear ();
+  m_bracketSummaryValid = false;
 }
 
 void TextBlock::clearBlockContent (TextBlock *targetBlock)
@@ -565,6 +642,23 @@ void TextBlock::clearBlockContent (TextBlock *targetBlock)
 
   // kill lines
   m_lines.clear ();
+  m_bracketSummaryValid = false;
+}
+
+void TextBlock::moveCursorsToLine (TextBlock *targetBlock, int line, int column, QSet<TextRange *> &changedRanges)
+{
+  // move all cursors, including the ones of ranges
+  foreach (TextCursor *cursor, m_cursors) {
+    cursor->m_line = line;
+    cursor->m_column = column;
+    cursor->m_block = targetBlock;
+    targetBlock->m_cursors.insert (cursor);
+
+    // remember range, if any
+    if (cursor->kateRange())
+      changedRanges.insert (cursor->kateRange());
+  }
+  m_cursors.clear ();
 }
 
 void TextBlock::markModifiedLinesAsSaved ()
@@ -577,6 +671,26 @@ void TextBlock::markModifiedLinesAsSaved ()
   }
 }
 
+bool TextBlock::bracketSummary (TextBracketSummary &summary) const
+{
+  // summarize all lines, if not cached, only possible if all of them have up-to-date brackets
+  if (!m_bracketSummaryValid) {
+    TextBracketSummary blockSummary;
+    foreach (const TextLine &line, m_lines) {
+      if (!line->bracketsValid ())
+        return false;
+
+      blockSummary.append (line->bracketSummary ());
+    }
+
+    m_bracketSummary = blockSummary;
+    m_bracketSummaryValid = true;
+  }
+
+  summary = m_bracketSummary;
+  return true;
+}
+
 void TextBlock::updateRange (TextRange* range)
 {
   /**
@@ -584,95 +698,86 @@ void TextBlock::updateRange (TextRange* range)
    */
   const int startLine = range->startInternal().lineInternal();
   const int endLine = range->endInternal().lineInternal();
-  const bool isSingleLine = startLine == endLine;
 
   /**
    * perhaps remove range and be done
    */
-  if ((endLine < m_startLine) || (startLine >= (m_startLine + lines()))) {
+  const int blockStartLine = this->startLine ();
+  if ((endLine < blockStartLine) || (startLine >= (blockStartLine + lines()))) {
     removeRange (range);
     return;
   }
 
   /**
-   * The range is still a single-line range, and is still cached to the correct line.
+   * simple case: range spans the whole block, no need to file it per line
    */
-  if(isSingleLine && m_cachedLineForRanges.contains (range) && (m_cachedLineForRanges.value(range) == startLine - m_startLine))
-    return;
+  if ((startLine < blockStartLine) && (endLine >= (blockStartLine + lines()))) {
+    if (m_spanningRanges.contains (range))
+      return;
 
-  /**
-   * The range is still a multi-line range, and is already in the correct set.
-   */
-  if(!isSingleLine && m_uncachedRanges.contains (range))
+    removeRange (range);
+    m_spanningRanges.insert (range);
     return;
+  }
 
   /**
-   * remove, if already there!
+   * lines of this block the range intersects
    */
-  removeRange(range);
+  const int firstLine = qMax (startLine - blockStartLine, 0);
+  const int lastLine = qMin (endLine - blockStartLine, lines() - 1);
 
   /**
-   * simple case: multi-line range
+   * The range is already filed for the correct lines.
    */
-  if (!isSingleLine) {
-    /**
-     * The range cannot be cached per line, as it spans multiple lines
-     */
-    m_uncachedRanges.insert(range);
+  QHash<TextRange*, QPair<int, int> >::const_iterator it = m_filedLinesForRanges.constFind (range);
+  if (it != m_filedLinesForRanges.constEnd() && it->first == firstLine && it->second == lastLine)
     return;
-  }
 
   /**
-   * The range is contained by a single line, put it into the line-cache
+   * remove, if already there!
    */
-  const int lineOffset = startLine - m_startLine;
+  removeRange(range);
 
   /**
    * enlarge cache if needed
    */
-  if (m_cachedRangesForLine.size() <= lineOffset)
-    m_cachedRangesForLine.resize(lineOffset+1);
+  if (m_rangesForLine.size() <= lastLine)
+    m_rangesForLine.resize(lastLine+1);
 
   /**
    * insert into mapping
    */
-  m_cachedRangesForLine[lineOffset].insert(range);
-  m_cachedLineForRanges[range] = lineOffset;
+  for (int line = firstLine; line <= lastLine; ++line)
+    m_rangesForLine[line].insert(range);
+  m_filedLinesForRanges.insert (range, qMakePair (firstLine, lastLine));
 }
 
 void TextBlock::removeRange (TextRange* range)
 {
   /**
-   * uncached range? remove it and be done
+   * spanning range? remove it and be done
    */
-  if(m_uncachedRanges.remove (range)) {
+  if(m_spanningRanges.remove (range)) {
     /**
-     * must be only uncached!
+     * must be only spanning!
      */
-    Q_ASSERT (!m_cachedLineForRanges.contains(range));
+    Q_ASSERT (!m_filedLinesForRanges.contains(range));
     return;
   }
 
   /**
-   * cached range?
+   * filed range?
    */
-  QHash<TextRange*, int>::iterator it = m_cachedLineForRanges.find(range);
-  if (it != m_cachedLineForRanges.end()) {
-    /**
-     * must be only cached!
-     */
-    Q_ASSERT (!m_uncachedRanges.contains(range));
-
-    /**
-     * query the range from cache, must be there
-     */
-    Q_ASSERT (m_cachedRangesForLine.at(*it).contains(range));
-
+  QHash<TextRange*, QPair<int, int> >::iterator it = m_filedLinesForRanges.find(range);
+  if (it != m_filedLinesForRanges.end()) {
     /**
-     * remove it and be done
+     * remove it from all lines it was filed for and be done
      */
-    m_cachedRangesForLine[*it].remove(range);
-    m_cachedLineForRanges.erase(it);
+    for (int line = it->first; line <= it->second; ++line) {
+      Q_ASSERT (m_rangesForLine.at(line).contains(range));
+      m_rangesForLine[line].remove(range);
+    }
+    m_filedLinesForRanges.erase(it);
     return;
   }
 
@@ -681,4 +786,27 @@ void TextBlock::removeRange (TextRange* range)
    */
 }
 
+QList<TextRange*> TextBlock::takeRangesFromLine (int line)
+{
+  /**
+   * remove all ranges filed for the given line or behind it
+   */
+  QList<TextRange*> ranges;
+  QHash<TextRange*, QPair<int, int> >::const_iterator it = m_filedLinesForRanges.constBegin();
+  for (; it != m_filedLinesForRanges.constEnd(); ++it)
+    if (it->second >= line)
+      ranges.append (it.key());
+
+  foreach (TextRange *range, ranges)
+    removeRange (range);
+
+  /**
+   * the lines are empty now, drop them, they will be allocated again on demand
+   */
+  if (m_rangesForLine.size() > line)
+    m_rangesForLine.resize (line);
+
+  return ranges;
+}
+
 }
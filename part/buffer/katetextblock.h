@@ -23,6 +23,8 @@
 
 #include <QtCore/QVector>
 #include <QtCore/QSet>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
 
 #include "katepartprivate_export.h"
 #include <ktexteditor/cursor.h>
@@ -42,6 +44,7 @@ class KATEPART_TESTS_EXPORT TextBlock {
   friend class TextCursor;
   friend class TextRange;
   friend class TextBuffer;
+  friend class TextLoaderThread;
 
   public:
     /**
@@ -58,15 +61,10 @@ class KATEPART_TESTS_EXPORT TextBlock {
 
     /**
      * Start line of this block.
+     * Cached, if the line counts of the buffer's blocks changed, it is looked up in the block index.
      * @return start line of this block
      */
-    int startLine () const { return m_startLine; }
-
-    /**
-     * Set start line of this block.
-     * @param startLine new start line of this block
-     */
-    void setStartLine (int startLine);
+    int startLine () const;
 
     /**
      * Retrieve a text line.
@@ -79,7 +77,23 @@ class KATEPART_TESTS_EXPORT TextBlock {
      * Append a new line.
      * @param line line to append
      */
-    void appendLine (TextLine line) { m_lines.append (line); }
+    void appendLine (TextLine line) { m_lines.append (line); m_bracketSummaryValid = false; }
+
+    /**
+     * Append a new line with the given text.
+     * With compact storage, text which fits into Latin-1 is stored 8-bit in the arena of this block,
+     * it is converted to a QString only once it is accessed.
+     * @param unicode text of the line
+     * @param length length of the text
+     * @param compact use compact storage, if possible
+     */
+    void appendLine (const QChar *unicode, int length, bool compact);
+
+    /**
+     * Done with appending lines, shrink the arena to its content.
+     * The lines keep it alive, the block will start a new one on next compact append.
+     */
+    void finishAppending ();
 
     /**
      * Number of lines in this block.
@@ -157,12 +171,23 @@ class KATEPART_TESTS_EXPORT TextBlock {
     void clearBlockContent (TextBlock *targetBlock);
 
     /**
-     * Return all ranges in this block which might intersect the given line.
+     * Move all cursors of this block to one position in the given block.
+     * This is used by TextBuffer::removeLines() before the lines of this block are removed.
+     * @param targetBlock block for the cursors
+     * @param line line in the target block, relative to its start
+     * @param column column for the cursors
+     * @param changedRanges ranges of the moved cursors are added here, their validity must be checked afterwards
+     */
+    void moveCursorsToLine (TextBlock *targetBlock, int line, int column, QSet<TextRange *> &changedRanges);
+
+    /**
+     * Return all ranges in this block which intersect the given line.
+     * These are the ranges spanning the whole block and the ones filed for the line.
      * @param line line to check intersection
-     * @return list of sets of possible candidate ranges
+     * @return list of sets of ranges
      */
     QList<QSet<TextRange*> > rangesForLine (int line) const {
-      return QList<QSet<TextRange*> >() << m_uncachedRanges << cachedRangesForLine(line);
+      return QList<QSet<TextRange*> >() << m_spanningRanges << filedRangesForLine(line);
     }
 
     /**
@@ -171,7 +196,7 @@ class KATEPART_TESTS_EXPORT TextBlock {
      * @return contained in this blocks mapping?
      */
     bool containsRange (TextRange* range) const {
-      return m_cachedLineForRanges.contains(range) || m_uncachedRanges.contains(range);
+      return m_filedLinesForRanges.contains(range) || m_spanningRanges.contains(range);
     }
 
     /**
@@ -179,10 +204,22 @@ class KATEPART_TESTS_EXPORT TextBlock {
      */
     void markModifiedLinesAsSaved ();
 
+    /**
+     * Summary of the code brackets of all lines of this block, cached until the block changes.
+     * @param summary will be filled with the summary
+     * @return false, if the brackets of any line are outdated, the summary is not usable then
+     */
+    bool bracketSummary (TextBracketSummary &summary) const;
+
+    /**
+     * The code brackets of a line changed, drop the cached summary.
+     */
+    void invalidateBracketSummary () { m_bracketSummaryValid = false; }
+
   private:
     /**
      * Update a range from this block.
-     * Will move the range to right set, either cached for one-line ranges or not.
+     * Will move the range to right set, either the spanning ones or filed for the lines it covers in this block.
      * @param range range to update
      */
     void updateRange(TextRange* range);
@@ -194,15 +231,22 @@ class KATEPART_TESTS_EXPORT TextBlock {
     void removeRange (TextRange* range);
 
     /**
-     * Return all ranges in this block which might intersect the given line and only span one line.
-     * For them an internal fast lookup cache is hold.
+     * Remove all ranges filed for lines starting with the given one and drop these lines from the lookup.
+     * Used before lines are inserted or removed inside the block, as the filed lines of them shift.
+     * @param line first line in block which will shift
+     * @return removed ranges, update them once the lines are fixed
+     */
+    QList<TextRange*> takeRangesFromLine (int line);
+
+    /**
+     * Return all ranges in this block which intersect the given line, but do not span the whole block.
      * @param line line to check intersection
      * @return set of ranges
      */
-    QSet<TextRange*> cachedRangesForLine (int line) const {
-      line -= m_startLine;
-      if(line >= 0 && line < m_cachedRangesForLine.size())
-        return m_cachedRangesForLine[line];
+    QSet<TextRange*> filedRangesForLine (int line) const {
+      line -= startLine ();
+      if(line >= 0 && line < m_rangesForLine.size())
+        return m_rangesForLine[line];
       else
         return QSet<TextRange*>();
     }
@@ -219,9 +263,24 @@ class KATEPART_TESTS_EXPORT TextBlock {
     QVector<Kate::TextLine> m_lines;
 
     /**
-     * Startline of this block
+     * Startline of this block, cached, only valid if m_startLineRevision matches the block index revision of the buffer
+     */
+    mutable int m_startLine;
+
+    /**
+     * Block index revision of the buffer the start line was computed for
+     */
+    mutable qint64 m_startLineRevision;
+
+    /**
+     * Index of this block in the buffer, -1 if not yet in the block index of the buffer
      */
-    int m_startLine;
+    int m_index;
+
+    /**
+     * Arena compact stored lines are appended to, if any.
+     */
+    QExplicitlySharedDataPointer<TextLineArena> m_arena;
 
     /**
      * Set of cursors for this block.
@@ -229,20 +288,31 @@ class KATEPART_TESTS_EXPORT TextBlock {
     QSet<TextCursor *> m_cursors;
 
     /**
-     * Contains for each line-offset the ranges that were cached into it.
-     * These ranges are fully contained by the line.
+     * Contains for each line-offset the ranges that intersect it, for all ranges starting or ending in this block.
+     * A range is filed for each line of this block it covers, lookup per line is constant, not linear in the ranges of the block.
+     */
+    QVector<QSet<TextRange *> > m_rangesForLine;
+
+    /**
+     * Maps for each filed range the first and last line-offset it was filed for.
+     */
+    QHash<TextRange *, QPair<int, int> > m_filedLinesForRanges;
+
+    /**
+     * This contains all the ranges starting in front and ending behind this block.
+     * They intersect each line, no need to file them per line.
      */
-    QVector<QSet<TextRange *> > m_cachedRangesForLine;
+    QSet<TextRange *> m_spanningRanges;
 
     /**
-     * Maps for each cached range the line into which the range was cached.
+     * Cached summary of the code brackets of all lines, only valid if m_bracketSummaryValid is set
      */
-    QHash<TextRange *, int> m_cachedLineForRanges;
+    mutable TextBracketSummary m_bracketSummary;
 
     /**
-     * This contains all the ranges that are not cached.
+     * Is the cached bracket summary valid? Reset by each change of the lines.
      */
-    QSet<TextRange *> m_uncachedRanges;
+    mutable bool m_bracketSummaryValid;
 };
 
 }
@@ -22,6 +22,9 @@
 
 #include "katetextbuffer.h"
 #include "katetextloader.h"
+#include "katetextloaderthread.h"
+#include "katetextsaver.h"
+#include "katetextsaverthread.h"
 
 // this is unfortunate, but needed for performance
 #include "katedocument.h"
@@ -29,7 +32,6 @@
 
 #include <kde_file.h>
 
-#include <KSaveFile>
 
 #if 0
 #define EDIT_DEBUG kDebug()
@@ -45,6 +47,7 @@ TextBuffer::TextBuffer (KateDocument *parent, int blockSize)
   , m_history (*this)
   , m_blockSize (blockSize)
   , m_lines (0)
+  , m_blockIndexRevision (0)
   , m_lastUsedBlock (0)
   , m_revision (0)
   , m_editingTransactions (0)
@@ -59,6 +62,12 @@ TextBuffer::TextBuffer (KateDocument *parent, int blockSize)
   , m_endOfLineMode (eolUnix)
   , m_newLineAtEof (false)
   , m_lineLengthLimit (4096)
+  , m_allowMemoryMapping (true)
+  , m_compactLineStorage (false)
+  , m_bytesDecodedMoreThanOnce (0)
+  , m_loadingThread (0)
+  , m_savingThread (0)
+  , m_savingRevision (-1)
 {
   // minimal block size must be > 0
   Q_ASSERT (m_blockSize > 0);
@@ -75,6 +84,16 @@ TextBuffer::~TextBuffer ()
   // not allowed during editing
   Q_ASSERT (m_editingTransactions == 0);
 
+  // stop background loading, the thread creates blocks for us
+  abortLoading ();
+
+  // stop background saving, don't block until the file is written, the old file on disk stays
+  if (m_savingThread) {
+    m_savingThread->abort ();
+    delete m_savingThread;
+    m_savingThread = 0;
+  }
+
   // kill all ranges, work on copy, they will remove themself from the hash
   QSet<TextRange *> copyRanges = m_ranges;
   qDeleteAll (copyRanges);
@@ -108,6 +127,12 @@ void TextBuffer::clear ()
   // not allowed during editing
   Q_ASSERT (m_editingTransactions == 0);
 
+  // stop background loading, if any
+  abortLoading ();
+
+  // a running background save writes the old content, it is no longer a saved revision of the buffer
+  m_savingRevision = -1;
+
   invalidateRanges();
 
   // new block for empty buffer
@@ -125,8 +150,9 @@ void TextBuffer::clear ()
   // insert one block with one empty line
   m_blocks.append (newBlock);
 
-  // reset lines and last used block
+  // reset lines, block index and last used block
   m_lines = 1;
+  rebuildBlockIndex ();
   m_lastUsedBlock = 0;
 
   // reset revision
@@ -138,6 +164,9 @@ void TextBuffer::clear ()
   // reset the filter device
   m_mimeTypeForFilterDev = "text/plain";
 
+  // reset load statistics
+  m_bytesDecodedMoreThanOnce = 0;
+
   // clear edit history
   m_history.clear ();
 
@@ -373,6 +402,173 @@ void TextBuffer::removeText (const KTextEditor::Range &range)
   emit textRemoved (range, text);
 }
 
+void TextBuffer::insertLines (int line, const QStringList &texts)
+{
+  // debug output for REAL low-level debugging
+  EDIT_DEBUG << "insertLines" << line << texts.size();
+
+  // only allowed if editing transaction running
+  Q_ASSERT (m_editingTransactions > 0);
+
+  // lines can be inserted in front of each line or appended
+  Q_ASSERT (line >= 0);
+  Q_ASSERT (line <= lines());
+
+  // skip work, if no lines to insert
+  if (texts.isEmpty())
+    return;
+
+  /**
+   * the lines in front of the insertion end with the block before this index,
+   * the block at this index starts with the line the new lines are inserted in front of
+   * cursors and ranges of it stay valid, as they are relative to their block
+   */
+  const int blockIndex = splitBlocksAt (line);
+
+  /**
+   * fill new blocks with the lines, the last one might be smaller
+   */
+  QVector<TextBlock *> newBlocks;
+  foreach (const QString &text, texts) {
+    if (newBlocks.isEmpty() || newBlocks.last()->lines() >= m_blockSize)
+      newBlocks.append (new TextBlock (this, line + newBlocks.size() * m_blockSize));
+
+    TextLine textLine (new TextLineData (text));
+    textLine->markAsModified (true);
+    newBlocks.last()->appendLine (textLine);
+  }
+
+  m_blocks.insert (m_blocks.begin() + blockIndex, newBlocks.size(), 0);
+  qCopy (newBlocks.constBegin(), newBlocks.constEnd(), m_blocks.begin() + blockIndex);
+  m_lines += texts.size();
+
+  // block indices did change
+  rebuildBlockIndex ();
+
+  /**
+   * notify the text history
+   */
+  m_history.insertLines (line, texts.size());
+
+  /**
+   * multi-line ranges across the insertion now span the new blocks, too, add them there
+   */
+  const int tailIndex = blockIndex + newBlocks.size();
+  if (tailIndex < m_blocks.size()) {
+    TextBlock *tailBlock = m_blocks.at(tailIndex);
+    QList<TextRange *> crossingRanges = tailBlock->m_spanningRanges.toList();
+    foreach (TextRange *range, tailBlock->filedRangesForLine (tailBlock->startLine()))
+      if (range->startInternal().lineInternal() < tailBlock->startLine())
+        crossingRanges.append (range);
+
+    foreach (TextRange *range, crossingRanges)
+      range->checkValidity ();
+  }
+
+  // remember changes
+  ++m_revision;
+
+  // update changed line interval
+  if (line < m_editingMinimalLineChanged || m_editingMinimalLineChanged == -1)
+    m_editingMinimalLineChanged = line;
+
+  if (line <= m_editingMaximalLineChanged)
+    m_editingMaximalLineChanged += texts.size();
+  else
+    m_editingMaximalLineChanged = line + texts.size() - 1;
+
+  /**
+   * balance the blocks at the borders of the inserted lines, the ones in between are full
+   * go from back to front, balancing only changes the blocks at and behind the index
+   */
+  for (int index = qMin (tailIndex, m_blocks.size() - 1); index >= qMax (blockIndex - 1, 0); --index)
+    balanceBlock (index);
+
+  // emit signal about done change
+  emit linesInserted (line, texts);
+}
+
+void TextBuffer::removeLines (int from, int to)
+{
+  // debug output for REAL low-level debugging
+  EDIT_DEBUG << "removeLines" << from << to;
+
+  // only allowed if editing transaction running
+  Q_ASSERT (m_editingTransactions > 0);
+
+  // valid lines, at least one line must remain
+  Q_ASSERT (from >= 0);
+  Q_ASSERT (from <= to);
+  Q_ASSERT (to < lines());
+  Q_ASSERT (to - from + 1 < lines());
+
+  const int count = to - from + 1;
+
+  /**
+   * cursors on the removed lines move to the start of the line behind them
+   * if the last lines are removed, to the end of the line in front of them
+   */
+  const bool linesFollow = (to + 1) < lines();
+  const int oldLineLength = linesFollow ? -1 : line (from - 1)->length();
+
+  /**
+   * the removed lines get blocks of their own
+   */
+  const int firstBlock = splitBlocksAt (from);
+  const int lastBlock = splitBlocksAt (to + 1);
+
+  TextBlock *targetBlock = linesFollow ? m_blocks.at(lastBlock) : m_blocks.at(firstBlock - 1);
+  const int targetLine = linesFollow ? 0 : (targetBlock->lines() - 1);
+  const int targetColumn = linesFollow ? 0 : oldLineLength;
+
+  // move the cursors, remember all ranges modified, then delete the blocks
+  QSet<TextRange *> changedRanges;
+  for (int index = firstBlock; index < lastBlock; ++index) {
+    TextBlock *block = m_blocks.at(index);
+    block->moveCursorsToLine (targetBlock, targetLine, targetColumn, changedRanges);
+    block->m_lines.clear ();
+    delete block;
+  }
+
+  m_blocks.erase (m_blocks.begin() + firstBlock, m_blocks.begin() + lastBlock);
+  m_lines -= count;
+
+  // block indices did change
+  rebuildBlockIndex ();
+
+  /**
+   * notify the text history
+   */
+  m_history.removeLines (from, count, oldLineLength);
+
+  // check validity of all ranges, might invalidate them...
+  foreach (TextRange *range, changedRanges)
+    range->checkValidity ();
+
+  // remember changes
+  ++m_revision;
+
+  // update changed line interval, the line that took the place of the removed ones or the one in front of them
+  const int changedLine = linesFollow ? from : (from - 1);
+  if (changedLine < m_editingMinimalLineChanged || m_editingMinimalLineChanged == -1)
+    m_editingMinimalLineChanged = changedLine;
+
+  if (m_editingMaximalLineChanged > to)
+    m_editingMaximalLineChanged -= count;
+  else
+    m_editingMaximalLineChanged = changedLine;
+
+  /**
+   * balance the blocks at the border of the removed lines
+   * go from back to front, balancing only changes the blocks at and behind the index
+   */
+  for (int index = qMin (firstBlock, m_blocks.size() - 1); index >= qMax (firstBlock - 1, 0); --index)
+    balanceBlock (index);
+
+  // emit signal about done change
+  emit linesRemoved (from, to);
+}
+
 int TextBuffer::blockForLine (int line) const
 {
   // only allow valid lines
@@ -400,33 +596,29 @@ int TextBuffer::blockForLine (int line) const
 
   /**
    * search for right block
-   * use binary search
-   * if we leave this loop not by returning the found element we have an error
-   */
-  int blockStart = 0;
-  int blockEnd = m_blocks.size() - 1;
-  while (blockEnd >= blockStart) {
-    // get middle and ensure it is OK
-    int middle = blockStart + ((blockEnd - blockStart) / 2);
-    Q_ASSERT (middle >= 0);
-    Q_ASSERT (middle < m_blocks.size());
-
-    // facts bout this block
-    TextBlock* block = m_blocks[middle];
-    const int start = block->startLine();
-    const int lines = block->lines ();
-
-    // right block found, remember it and return it
-    if (start <= line && line < (start + lines)) {
-      m_lastUsedBlock = middle;
-      return middle;
+   * descend in the block index, find the last block with start line <= line
+   * empty blocks are skipped, as their successor has the same start line
+   */
+  const int blocks = m_blocks.size();
+  Q_ASSERT (m_blockIndex.size() == blocks + 1);
+  int step = 1;
+  while (2 * step <= blocks)
+    step *= 2;
+
+  int index = 0;
+  int remaining = line;
+  for (; step > 0; step /= 2) {
+    if (index + step <= blocks && m_blockIndex[index + step] <= remaining) {
+      index += step;
+      remaining -= m_blockIndex[index];
     }
+  }
 
-    // half our stuff ;)
-    if (line < start)
-      blockEnd = middle - 1;
-    else
-      blockStart = middle + 1;
+  // right block found, remember it and return it
+  if (index < blocks) {
+    Q_ASSERT (remaining < m_blocks[index]->lines ());
+    m_lastUsedBlock = index;
+    return index;
   }
 
   // we should always find a block
@@ -439,20 +631,87 @@ void TextBuffer::fixStartLines (int startBlock)
   // only allow valid start block
   Q_ASSERT (startBlock >= 0);
   Q_ASSERT (startBlock < m_blocks.size());
+  Q_ASSERT (m_blockIndex.size() == m_blocks.size() + 1);
 
-  // new start line for next block
-  TextBlock* block = m_blocks.at(startBlock);
-  int newStartLine = block->startLine () + block->lines ();
+  /**
+   * update line counts in the block index
+   * only the given block and the next one can have changed, an unwrap might move one line between them
+   */
+  bool changed = false;
+  const int lastBlock = qMin (startBlock + 1, m_blocks.size() - 1);
+  for (int index = startBlock; index <= lastBlock; ++index) {
+    // difference between real line count and the one in the index
+    const int delta = m_blocks.at(index)->lines () - (startLineOfBlock (index + 1) - startLineOfBlock (index));
+    if (delta == 0)
+      continue;
+
+    for (int i = index + 1; i < m_blockIndex.size(); i += i & (-i))
+      m_blockIndex[i] += delta;
+    changed = true;
+  }
 
-  // fixup block
-  for (int index = startBlock + 1; index < m_blocks.size(); ++index) {
-    // set new start line
-    block = m_blocks.at(index);
-    block->setStartLine (newStartLine);
+  // invalidate start lines cached in the blocks
+  if (changed)
+    ++m_blockIndexRevision;
+}
 
-    // calculate next start line
-    newStartLine += block->lines ();
+void TextBuffer::rebuildBlockIndex ()
+{
+  // linear construction of the tree, each node adds its sum to its parent
+  m_blockIndex.fill (0, m_blocks.size() + 1);
+  int startLine = 0;
+  for (int index = 0; index < m_blocks.size(); ++index) {
+    TextBlock *block = m_blocks.at(index);
+    block->m_index = index;
+    block->m_startLine = startLine;
+    startLine += block->lines ();
+
+    const int i = index + 1;
+    m_blockIndex[i] += block->lines ();
+    const int parent = i + (i & (-i));
+    if (parent < m_blockIndex.size())
+      m_blockIndex[parent] += m_blockIndex[i];
   }
+
+  // start lines set above are valid for the new revision
+  ++m_blockIndexRevision;
+  foreach (TextBlock *block, m_blocks)
+    block->m_startLineRevision = m_blockIndexRevision;
+}
+
+int TextBuffer::startLineOfBlock (int index) const
+{
+  Q_ASSERT (index >= 0);
+  Q_ASSERT (index < m_blockIndex.size());
+
+  // sum up line counts of all blocks in front of this one
+  int startLine = 0;
+  for (int i = index; i > 0; i -= i & (-i))
+    startLine += m_blockIndex[i];
+  return startLine;
+}
+
+int TextBuffer::splitBlocksAt (int line)
+{
+  // behind the last line, no block to split
+  if (line == lines())
+    return m_blocks.size();
+
+  // get block, this will assert on invalid line
+  const int blockIndex = blockForLine (line);
+  TextBlock *block = m_blocks.at(blockIndex);
+
+  // block already starts with the line
+  if (line == block->startLine())
+    return blockIndex;
+
+  // split the block, the new block behind it starts with the line
+  TextBlock *newBlock = block->splitBlock (line - block->startLine());
+  m_blocks.insert (m_blocks.begin() + blockIndex + 1, newBlock);
+
+  // block indices did change
+  rebuildBlockIndex ();
+  return blockIndex + 1;
 }
 
 void TextBuffer::balanceBlock (int index)
@@ -472,6 +731,9 @@ void TextBuffer::balanceBlock (int index)
     Q_ASSERT (newBlock);
     m_blocks.insert (m_blocks.begin() + index + 1, newBlock);
 
+    // block indices did change
+    rebuildBlockIndex ();
+
     // split is done
     return;
   }
@@ -496,6 +758,9 @@ void TextBuffer::balanceBlock (int index)
   // delete old block
   delete blockToBalance;
   m_blocks.erase (m_blocks.begin() + index);
+
+  // block indices did change
+  rebuildBlockIndex ();
 }
 
 void TextBuffer::debugPrint (const QString &title) const
@@ -531,7 +796,14 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
   /**
    * construct the file loader for the given file, with correct prober type
    */
-  Kate::TextLoader file (filename, m_encodingProberType);
+  Kate::TextLoader file (filename, m_encodingProberType, m_allowMemoryMapping);
+
+  /**
+   * detection stage: check the start of the file and some samples which round of the
+   * triple play below is the first one that will work, this avoids to decode the whole
+   * file again and again just to find out the given encoding doesn't fit
+   */
+  const int firstRound = enforceTextCodec ? 0 : file.detectFirstRound (m_textCodec, m_fallbackTextCodec);
 
   /**
    * triple play, maximal three loading rounds
@@ -540,7 +812,7 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
    * 2) use fallback encoding, be done, if no encoding errors happen
    * 3) use again given encoding, be done in any case
    */
-  for (int i = 0; i < (enforceTextCodec ? 1 : 4);  ++i) {
+  for (int i = firstRound; i < (enforceTextCodec ? 1 : 4);  ++i) {
     /**
      * kill all blocks beside first one
      */
@@ -569,7 +841,13 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
     else if (i == 2)
       codec = m_fallbackTextCodec;
 
-    if (!file.open (codec)) {
+    /**
+     * if not enforced and not last round, the loader may switch to the fallback codec if
+     * an error happens after only ascii was read, then only the failing chunk is decoded again
+     */
+    QTextCodec *switchCodec = (!enforceTextCodec && i < 3) ? m_fallbackTextCodec : 0;
+
+    if (!file.open (codec, switchCodec)) {
       // create one dummy textline, in any case
       m_blocks.last()->appendLine (TextLine (new TextLineData()));
       m_lines++;
@@ -600,54 +878,30 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
        */
       do {
         /**
-         * calculate line length
+         * calculate line length, wrap if too long
          */
-        int lineLength = length;
-        if ((m_lineLengthLimit > 0) && (lineLength > m_lineLengthLimit)) {
-            /**
-             * search for place to wrap
-             */
-            int spacePosition = m_lineLengthLimit-1;
-            for (int testPosition = m_lineLengthLimit-1; (testPosition >= 0) && (testPosition >= (m_lineLengthLimit - (m_lineLengthLimit/10))); --testPosition) {
-                /**
-                 * wrap place found?
-                 */
-                if (unicodeData[testPosition].isSpace() || unicodeData[testPosition].isPunct()) {
-                    spacePosition = testPosition;
-                    break;
-                }
-            }
-
-            /**
-             * wrap the line
-             */
-            lineLength = spacePosition+1;
-            length -= lineLength;
-            tooLongLinesWrapped = true;
-        } else {
-            /**
-             * be done after this round
-             */
-            length = 0;
-        }
-
-        /**
-         * construct new text line with content from file
-         * move data pointer
-         */
-        TextLine textLine = TextLine (new TextLineData(QString (unicodeData, lineLength)));
-        unicodeData += lineLength;
+        const int lineLength = TextLoader::wrappedLineLength (unicodeData, length, m_lineLengthLimit);
+        if (lineLength < length)
+          tooLongLinesWrapped = true;
+        length -= lineLength;
 
         /**
          * ensure blocks aren't too large
+         * new blocks get their line vector allocated once, no regrowth while appending
          */
-        if (m_blocks.last()->lines() >= m_blockSize)
-            m_blocks.append (new TextBlock (this, m_blocks.last()->startLine() + m_blocks.last()->lines()));
+        if (m_blocks.last()->lines() >= m_blockSize) {
+            m_blocks.last()->finishAppending ();
+            TextBlock *newBlock = new TextBlock (this, m_blocks.last()->startLine() + m_blocks.last()->lines());
+            newBlock->m_lines.reserve (m_blockSize);
+            m_blocks.append (newBlock);
+        }
 
         /**
-         * append line to last block
+         * append new text line with content from file to last block
+         * move data pointer
          */
-        m_blocks.last()->appendLine (textLine);
+        m_blocks.last()->appendLine (unicodeData, lineLength, m_compactLineStorage);
+        unicodeData += lineLength;
         ++m_lines;
       } while (length > 0);
     }
@@ -660,9 +914,17 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
     }
   }
 
+  // index the loaded blocks
+  m_blocks.last()->finishAppending ();
+  rebuildBlockIndex ();
+  m_lastUsedBlock = 0;
+
   // save md5sum of file on disk
   setDigest (file.digest ());
 
+  // remember how much work was done in vain
+  m_bytesDecodedMoreThanOnce = file.bytesDecodedMoreThanOnce ();
+
   // remember if BOM was found
   if (file.byteOrderMarkFound ())
     setGenerateByteOrderMark (true);
@@ -684,6 +946,12 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
   // report BOM
   kDebug (13020) << (file.byteOrderMarkFound () ? "Found" : "Didn't find") << "byte order mark";
 
+  // report wasted decoding
+  kDebug (13020) << "Decoded" << m_bytesDecodedMoreThanOnce << "bytes more than once";
+
+  // report memory mapping
+  kDebug (13020) << (file.isMemoryMapped () ? "Used" : "Didn't use") << "memory mapping";
+
   // report filter device mime-type
   kDebug (13020) << "used filter device for mime-type" << m_mimeTypeForFilterDev;
 
@@ -694,6 +962,162 @@ bool TextBuffer::load (const QString &filename, bool &encodingErrors, bool &tooL
   return true;
 }
 
+bool TextBuffer::loadInBackground (const QString &filename, bool enforceTextCodec)
+{
+  // fallback codec must exist
+  Q_ASSERT (m_fallbackTextCodec);
+
+  // codec must be set!
+  Q_ASSERT (m_textCodec);
+
+  /**
+   * first: clear buffer in any case!
+   */
+  clear ();
+
+  /**
+   * check if this is a normal file or not, else exit
+   */
+  KDE_struct_stat sbuf;
+  if (KDE::stat(filename, &sbuf) != 0 || !S_ISREG(sbuf.st_mode))
+    return false;
+
+  /**
+   * only one round in the background, choose the codec with the detection stage
+   * round 1 means byte order mark or encoding prober, this is done by the loader
+   */
+  int round = 0;
+  if (!enforceTextCodec) {
+    Kate::TextLoader file (filename, m_encodingProberType, m_allowMemoryMapping);
+    round = file.detectFirstRound (m_textCodec, m_fallbackTextCodec);
+  }
+
+  QTextCodec *codec = m_textCodec;
+  if (round == 1)
+    codec = 0;
+  else if (round == 2)
+    codec = m_fallbackTextCodec;
+
+  /**
+   * start the thread, the blocks will arrive in takeLoadedBlocks
+   */
+  m_loadingFilename = filename;
+  m_loadingThread = new TextLoaderThread (this, filename, m_encodingProberType, codec, m_fallbackTextCodec
+    , !enforceTextCodec && round < 3, m_allowMemoryMapping, m_compactLineStorage, m_blockSize, m_lineLengthLimit);
+  connect (m_loadingThread, SIGNAL(blocksAvailable()), this, SLOT(takeLoadedBlocks()), Qt::QueuedConnection);
+  connect (m_loadingThread, SIGNAL(finished()), this, SLOT(finishLoading()), Qt::QueuedConnection);
+  m_loadingThread->start ();
+  return true;
+}
+
+void TextBuffer::abortLoading ()
+{
+  if (!m_loadingThread)
+    return;
+
+  // the destructor will stop the thread and delete the not taken blocks
+  TextLoaderThread *thread = m_loadingThread;
+  m_loadingThread = 0;
+  delete thread;
+
+  kDebug (13020) << "Aborted loading of file" << m_loadingFilename;
+}
+
+void TextBuffer::takeLoadedBlocks ()
+{
+  // loading aborted in between? then this is a late signal of the old thread
+  if (!m_loadingThread || sender() != m_loadingThread)
+    return;
+
+  appendLoadedBlocks ();
+}
+
+void TextBuffer::appendLoadedBlocks ()
+{
+  QVector<TextBlock *> blocks = m_loadingThread->takeBlocks ();
+  if (blocks.isEmpty())
+    return;
+
+  /**
+   * first block: replace the empty line of our initial block with its lines
+   * cursors in the initial block stay valid, they are all at 0,0
+   */
+  int firstNewBlock = 0;
+  if (blocks.first()->startLine() == 0) {
+    Q_ASSERT (m_blocks.size() == 1);
+    Q_ASSERT (m_lines == 1);
+
+    TextBlock *initialBlock = m_blocks.first();
+    initialBlock->m_lines = blocks.first()->m_lines;
+    blocks.first()->m_lines.clear ();
+    delete blocks.first();
+
+    m_lines = initialBlock->lines ();
+    firstNewBlock = 1;
+  }
+
+  /**
+   * append other blocks, they have already the right start lines
+   */
+  for (int i = firstNewBlock; i < blocks.size(); ++i) {
+    Q_ASSERT (blocks.at(i)->startLine() == m_lines);
+    m_blocks.append (blocks.at(i));
+    m_lines += blocks.at(i)->lines ();
+  }
+
+  // index the new blocks
+  rebuildBlockIndex ();
+
+  // tell the world
+  emit loadingProgress (m_loadingFilename, m_lines);
+}
+
+void TextBuffer::finishLoading ()
+{
+  // loading aborted in between? then this is a late signal of the old thread
+  if (!m_loadingThread || sender() != m_loadingThread)
+    return;
+
+  // get the last blocks, then the thread is no longer needed
+  m_loadingThread->wait ();
+  appendLoadedBlocks ();
+  TextLoaderThread *thread = m_loadingThread;
+  m_loadingThread = 0;
+
+  // failed? buffer stays empty
+  if (!thread->success ()) {
+    delete thread;
+    kDebug (13020) << "Failed to load file" << m_loadingFilename << "in the background";
+    emit loadingFinished (m_loadingFilename, false, false, false);
+    return;
+  }
+
+  // same as for load: remember codec, md5sum, bom, eol + mime type
+  setTextCodec (thread->textCodec ());
+  setDigest (thread->digest ());
+  m_bytesDecodedMoreThanOnce = thread->bytesDecodedMoreThanOnce ();
+  if (thread->byteOrderMarkFound ())
+    setGenerateByteOrderMark (true);
+  if (thread->eol() != eolUnknown)
+    setEndOfLineMode (thread->eol());
+  m_mimeTypeForFilterDev = thread->mimeTypeForFilterDev ();
+
+  const bool encodingErrors = thread->encodingErrors ();
+  const bool tooLongLinesWrapped = thread->tooLongLinesWrapped ();
+  delete thread;
+
+  // assert that one line is there!
+  Q_ASSERT (m_lines > 0);
+
+  // report CODEC + ERRORS
+  kDebug (13020) << "Loaded file " << m_loadingFilename << "in the background with codec" << m_textCodec->name()
+    << (encodingErrors ? "with" : "without") << "encoding errors";
+
+  // emit success
+  emit loaded (m_loadingFilename, encodingErrors);
+  emit loadingFinished (m_loadingFilename, true, encodingErrors, tooLongLinesWrapped);
+}
+
 const QByteArray &TextBuffer::digest () const
 {
   return m_digest;
@@ -722,60 +1146,23 @@ bool TextBuffer::save (const QString &filename)
   Q_ASSERT (m_textCodec);
 
   /**
-   * use KSaveFile for save write + rename
+   * construct saver with the settings of this buffer and try to open
    */
-  KSaveFile saveFile (filename);
-  if (!saveFile.open())
+  TextSaver saver (filename, m_mimeTypeForFilterDev, m_textCodec, generateByteOrderMark(), endOfLineMode());
+  if (!saver.open())
     return false;
 
-  /**
-   * construct correct filter device and try to open
-   */
-  QIODevice *file = KFilterDev::device (&saveFile, m_mimeTypeForFilterDev, false);
-  const bool deleteFile = file;
-  if (!file)
-    file = &saveFile;
-
-  /**
-   * try to open, if new file
-   */
-  if (deleteFile) {
-    if (!file->open (QIODevice::WriteOnly)) {
-      delete file;
-      return false;
-    }
-  }
-
-  /**
-   * construct stream + disable Unicode headers
-   */
-  QTextStream stream (file);
-  stream.setCodec (QTextCodec::codecForName("UTF-16"));
-
-  // set the correct codec
-  stream.setCodec (m_textCodec);
-
-  // generate byte order mark?
-  stream.setGenerateByteOrderMark (generateByteOrderMark());
-
-  // our loved eol string ;)
-  QString eol = "\n"; //m_doc->config()->eolString ();
-  if (endOfLineMode() == eolDos)
-    eol = QString ("\r\n");
-  else if (endOfLineMode() == eolMac)
-    eol = QString ("\r");
-
   // just dump the lines out ;)
   for (int i = 0; i < m_lines; ++i)
   {
     // get line to save
     Kate::TextLine textline = line (i);
 
-    stream << textline->text();
+    saver.write (textline->textCopy());
 
     // append correct end of line string
     if ((i+1) < m_lines)
-      stream << eol;
+      saver.writeEndOfLine ();
   }
 
   if (m_newLineAtEof) {
@@ -783,39 +1170,18 @@ bool TextBuffer::save (const QString &filename)
     const Kate::TextLine lastLine = line (m_lines - 1);
     const int firstChar = lastLine->firstChar();
     if (firstChar > -1 || lastLine->length() > 0) {
-      stream << eol;
+      saver.writeEndOfLine ();
     }
   }
 
-  // flush stream
-  stream.flush ();
-
-  // close and delete file
-  if (deleteFile) {
-    file->close ();
-    delete file;
-  }
-
-  // flush file
-  if (!saveFile.flush())
-    return false;
-
-#ifndef Q_OS_WIN
-  // ensure that the file is written to disk
-#ifdef HAVE_FDATASYNC
-  fdatasync (saveFile.handle());
-#else
-  fsync (saveFile.handle());
-#endif
-#endif
-
   // did save work?
-  // only finalize if stream status == OK
-  bool ok = (stream.status() == QTextStream::Ok) && saveFile.finalize();
+  bool ok = saver.finish ();
 
-  // remember this revision as last saved if we had success!
-  if (ok)
+  // remember this revision as last saved and the digest of the file on disk if we had success!
+  if (ok) {
     m_history.setLastSavedRevision ();
+    setDigest (saver.digest ());
+  }
 
   // report CODEC + ERRORS
   kDebug (13020) << "Saved file " << filename << "with codec" << m_textCodec->name()
@@ -832,6 +1198,105 @@ bool TextBuffer::save (const QString &filename)
   return ok;
 }
 
+bool TextBuffer::saveInBackground (const QString &filename)
+{
+  // codec must be set!
+  Q_ASSERT (m_textCodec);
+
+  // one save at a time
+  if (m_savingThread)
+    return false;
+
+  /**
+   * take the snapshot, the text is shared with the lines, changes of them will detach it
+   */
+  QVector<TextLineSnapshot> lines;
+  lines.reserve (m_lines);
+  for (int i = 0; i < m_blocks.size(); ++i) {
+    const QVector<TextLine> &blockLines = m_blocks.at(i)->m_lines;
+    for (int j = 0; j < blockLines.size(); ++j)
+      lines.append (blockLines.at(j)->snapshot ());
+  }
+
+  /**
+   * start the thread, the results arrive in finishSaving
+   */
+  m_savingFilename = filename;
+  m_savingRevision = revision ();
+  m_savingThread = new TextSaverThread (filename, lines, m_newLineAtEof, m_mimeTypeForFilterDev
+    , m_textCodec, generateByteOrderMark(), endOfLineMode());
+  connect (m_savingThread, SIGNAL(progress(int)), this, SLOT(updateSavingProgress(int)), Qt::QueuedConnection);
+  connect (m_savingThread, SIGNAL(finished()), this, SLOT(finishSaving()), Qt::QueuedConnection);
+  m_savingThread->start ();
+  return true;
+}
+
+void TextBuffer::abortSaving ()
+{
+  if (!m_savingThread)
+    return;
+
+  // stop the thread, if it did already replace the file, this is a normal end
+  m_savingThread->abort ();
+  kDebug (13020) << "Aborted saving of file" << m_savingFilename;
+  completeSaving ();
+}
+
+void TextBuffer::updateSavingProgress (int lines)
+{
+  // saving aborted in between? then this is a late signal of the old thread
+  if (!m_savingThread || sender() != m_savingThread)
+    return;
+
+  emit savingProgress (m_savingFilename, lines);
+}
+
+void TextBuffer::finishSaving ()
+{
+  // saving aborted in between? then this is a late signal of the old thread
+  if (!m_savingThread || sender() != m_savingThread)
+    return;
+
+  completeSaving ();
+}
+
+void TextBuffer::completeSaving ()
+{
+  m_savingThread->wait ();
+  TextSaverThread *thread = m_savingThread;
+  m_savingThread = 0;
+
+  // failed or aborted? the old file stays
+  if (!thread->success ()) {
+    const QString errorString = thread->errorString ();
+    delete thread;
+    kDebug (13020) << "Failed to save file" << m_savingFilename << "in the background:" << errorString;
+    emit savingFinished (m_savingFilename, false, errorString);
+    return;
+  }
+
+  setDigest (thread->digest ());
+  delete thread;
+
+  // report CODEC
+  kDebug (13020) << "Saved file " << m_savingFilename << "in the background with codec" << m_textCodec->name();
+
+  /**
+   * the revision of the snapshot is saved, if the buffer did not change meanwhile, it is all on disk
+   * lines changed while saving stay modified
+   */
+  const bool unchanged = (m_savingRevision == revision ());
+  if (m_savingRevision >= 0)
+    m_history.setLastSavedRevision (m_savingRevision);
+
+  if (unchanged) {
+    markModifiedLinesAsSaved ();
+    emit saved (m_savingFilename);
+  }
+
+  emit savingFinished (m_savingFilename, true, QString ());
+}
+
 void TextBuffer::notifyAboutRangeChange (KTextEditor::View *view, int startLine, int endLine, bool rangeWithAttribute)
 {
   /**
@@ -861,6 +1326,20 @@ void TextBuffer::markModifiedLinesAsSaved()
     block->markModifiedLinesAsSaved ();
 }
 
+bool TextBuffer::blockBracketSummary (int line, int &firstLine, int &lastLine, TextBracketSummary &summary) const
+{
+  // get block, this will assert on invalid line
+  const TextBlock *block = m_blocks.at(blockForLine (line));
+  firstLine = block->startLine ();
+  lastLine = firstLine + block->lines () - 1;
+  return block->bracketSummary (summary);
+}
+
+void TextBuffer::invalidateBracketSummary (int line)
+{
+  m_blocks.at(blockForLine (line))->invalidateBracketSummary ();
+}
+
 QList<TextRange *> TextBuffer::rangesForLine (int line, KTextEditor::View *view, bool rangesWithAttributeOnly) const
 {
   // get block, this will assert on invalid line
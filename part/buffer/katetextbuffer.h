@@ -23,6 +23,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QVector>
 #include <QtCore/QSet>
 #include <QtCore/QTextCodec>
@@ -41,6 +42,9 @@
 
 namespace Kate {
 
+class TextLoaderThread;
+class TextSaverThread;
+
 /**
  * Class representing a text buffer.
  * The interface is line based, internally the text will be stored in blocks of text lines.
@@ -73,6 +77,7 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
 
     /**
      * Destruct the text buffer
+     * A save in the background is aborted, the old file on disk stays, unless the thread did already replace it.
      * Virtual, we allow inheritance
      */
     virtual ~TextBuffer ();
@@ -160,6 +165,19 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     void setLineLengthLimit (int lineLengthLimit) { m_lineLengthLimit = lineLengthLimit; }
 
+    /**
+     * Allow memory mapping of uncompressed local files on load, default on.
+     * @param allowMemoryMapping should load try to map the file instead of reading it chunk by chunk?
+     */
+    void setAllowMemoryMapping (bool allowMemoryMapping) { m_allowMemoryMapping = allowMemoryMapping; }
+
+    /**
+     * Store loaded lines compact, Latin-1 text of a block in one arena, converted to QString on first access.
+     * Default off.
+     * @param compactLineStorage should load use compact storage for lines that fit into Latin-1?
+     */
+    void setCompactLineStorage (bool compactLineStorage) { m_compactLineStorage = compactLineStorage; }
+
     /**
      * Load the given file. This will first clear the buffer and then load the file.
      * Even on error during loading the buffer will still be cleared.
@@ -173,6 +191,32 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     virtual bool load (const QString &filename, bool &encodingErrors, bool &tooLongLinesWrapped, bool enforceTextCodec);
 
+    /**
+     * Load the given file in the background. This will first clear the buffer and then start
+     * a thread to load the file. The lines are appended to the buffer as soon as they are read,
+     * loadingProgress is emitted for each new batch, loadingFinished + loaded once all is done.
+     * The encoding is chosen up front by a detection on the start of the file, there are no additional
+     * loading rounds. Until loadingFinished is emitted, no editing is allowed.
+     * Before calling this, setTextCodec must have been used to set codec!
+     * @param filename file to open
+     * @param enforceTextCodec enforce to use only the set text codec
+     * @return success, the loading was started
+     */
+    bool loadInBackground (const QString &filename, bool enforceTextCodec);
+
+    /**
+     * Is a file loading in the background?
+     * @return loading in progress
+     */
+    bool isLoading () const { return m_loadingThread; }
+
+    /**
+     * Load statistics: bytes decoded more than once by the last load.
+     * This happens for the encoding detection and if a codec turned out to be wrong while loading.
+     * @return bytes decoded more than once
+     */
+    qint64 bytesDecodedMoreThanOnce () const { return m_bytesDecodedMoreThanOnce; }
+
     /**
      * Save the current buffer content to the given file.
      * Before calling this, setTextCodec and setFallbackTextCodec must have been used to set codec!
@@ -182,12 +226,44 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     virtual bool save (const QString &filename);
 
+    /**
+     * Save the current buffer content to the given file in the background.
+     * A snapshot of the lines is taken, this is cheap, the text itself is shared with the lines.
+     * Encoding, compression and replacing the file are done by a thread, the buffer can be changed meanwhile.
+     * savingProgress is emitted while writing, savingFinished once all is done. On success, saved is emitted, too,
+     * if the buffer did not change meanwhile, its content is on disk then.
+     * Before calling this, setTextCodec and setFallbackTextCodec must have been used to set codec!
+     * This is API for users of the buffer only: KateDocument saves with save(), as
+     * KParts::ReadWritePart::saveFile() must have written the file once it returns.
+     * @param filename file to save
+     * @return success, the saving was started, false if a save is already running
+     */
+    bool saveInBackground (const QString &filename);
+
+    /**
+     * Is a file saved in the background?
+     * @return saving in progress
+     */
+    bool isSaving () const { return m_savingThread; }
+
+    /**
+     * Abort background saving, if running. The old file on disk stays, unless the thread did already replace it.
+     * savingFinished is emitted in any case.
+     */
+    void abortSaving ();
+
     /**
      * Lines currently stored in this buffer.
      * This is never 0, even clear will let one empty line remain.
      */
     int lines () const { Q_ASSERT (m_lines > 0); return m_lines; }
 
+    /**
+     * Block size in lines the buffer tries to hold, as passed to the constructor.
+     * @return block size
+     */
+    int blockSize () const { return m_blockSize; }
+
     /**
      * Revision of this buffer. Is set to 0 on construction, clear() (load will trigger clear()).
      * Is incremented on each change to the buffer.
@@ -297,6 +373,27 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     virtual void removeText (const KTextEditor::Range &range);
 
+    /**
+     * Insert whole lines in front of the given line, in one step.
+     * The lines are spliced into the blocks at once, this is much faster than wrapping
+     * and inserting text line by line, e.g. for large pastes.
+     * Cursors on the given line and behind it move down.
+     * @param line line in front of which the new lines are inserted, lines() to append them
+     * @param texts text of the new lines
+     * Virtual, can be overwritten.
+     */
+    virtual void insertLines (int line, const QStringList &texts);
+
+    /**
+     * Remove whole lines, in one step. At least one line must remain in the buffer.
+     * Cursors on the removed lines move to the start of the line behind them,
+     * or to the end of the line in front of them, if the last lines are removed.
+     * @param from first line to remove
+     * @param to last line to remove
+     * Virtual, can be overwritten.
+     */
+    virtual void removeLines (int from, int to);
+
     /**
      * TextHistory of this buffer
      * @return text history for this buffer
@@ -317,12 +414,43 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     void loaded (const QString &filename, bool encodingErrors);
 
+    /**
+     * Background loading made progress, more lines were appended.
+     * @param filename file which is loaded
+     * @param lines number of lines loaded until now
+     */
+    void loadingProgress (const QString &filename, int lines);
+
+    /**
+     * Background loading is done. On success, loaded is emitted, too.
+     * @param filename file which was loaded
+     * @param success the file got loaded, perhaps with encoding errors
+     * @param encodingErrors were there problems occurred while decoding the file?
+     * @param tooLongLinesWrapped were too long lines found and wrapped?
+     */
+    void loadingFinished (const QString &filename, bool success, bool encodingErrors, bool tooLongLinesWrapped);
+
     /**
      * Buffer saved successfully a file
      * @param filename file which was saved
      */
     void saved (const QString &filename);
 
+    /**
+     * Background saving made progress.
+     * @param filename file which is saved
+     * @param lines number of lines written until now
+     */
+    void savingProgress (const QString &filename, int lines);
+
+    /**
+     * Background saving is done. On success, saved is emitted, too, if the buffer did not change meanwhile.
+     * @param filename file which was saved
+     * @param success the file got written and replaced
+     * @param errorString human readable error, if saving failed, empty if it was aborted
+     */
+    void savingFinished (const QString &filename, bool success, const QString &errorString);
+
     /**
      * Editing transaction has started.
      */
@@ -359,7 +487,58 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     void textRemoved (const KTextEditor::Range &range, const QString &text);
 
+    /**
+     * Whole lines got inserted.
+     * @param line line of the first inserted line
+     * @param texts text of the inserted lines
+     */
+    void linesInserted (int line, const QStringList &texts);
+
+    /**
+     * Whole lines got removed.
+     * @param from first removed line
+     * @param to last removed line
+     */
+    void linesRemoved (int from, int to);
+
+  private Q_SLOTS:
+    /**
+     * Append the blocks the loader thread did read until now.
+     */
+    void takeLoadedBlocks ();
+
+    /**
+     * Loader thread is done, adopt its results.
+     */
+    void finishLoading ();
+
+    /**
+     * Saver thread did write more lines.
+     * @param lines number of lines written until now
+     */
+    void updateSavingProgress (int lines);
+
+    /**
+     * Saver thread is done, adopt its results.
+     */
+    void finishSaving ();
+
   private:
+    /**
+     * Abort background loading, if running.
+     */
+    void abortLoading ();
+
+    /**
+     * Saver thread is stopped, adopt its results and tell the world.
+     */
+    void completeSaving ();
+
+    /**
+     * Append the blocks the loader thread did read until now.
+     */
+    void appendLoadedBlocks ();
+
     /**
      * Find block containing given line.
      * @param line we want to find block for this line
@@ -368,11 +547,33 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
     int blockForLine (int line) const;
 
     /**
-     * Fix start lines of all blocks after the given one
+     * Fix start lines of all blocks after the given one.
+     * Only the line counts of the given block and its successor may have changed,
+     * they are updated in the block index, which is O(log blocks).
      * @param startBlock index of block from which we start to fix
      */
     void fixStartLines (int startBlock);
 
+    /**
+     * Rebuild the block index from the line counts of all blocks.
+     * Needed after blocks got inserted or removed, O(blocks).
+     */
+    void rebuildBlockIndex ();
+
+    /**
+     * Start line of the block with the given index, looked up in the block index.
+     * @param index block index, may be the number of blocks, then the number of lines is returned
+     * @return start line of the block
+     */
+    int startLineOfBlock (int index) const;
+
+    /**
+     * Split the blocks, such that a block starts with the given line.
+     * @param line line that shall start a block, may be lines()
+     * @return index of the block starting with the line, number of blocks for lines()
+     */
+    int splitBlocksAt (int line);
+
     /**
      * Balance the given block. Look if it is too small or too large.
      * @param index block to balance
@@ -422,6 +623,23 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     QList<TextRange *> rangesForLine (int line, KTextEditor::View *view, bool rangesWithAttributeOnly) const;
 
+    /**
+     * Summary of the code brackets of the block containing the given line.
+     * Used to skip whole blocks when searching matching brackets.
+     * @param line line in the block
+     * @param firstLine will be set to the first line of the block
+     * @param lastLine will be set to the last line of the block
+     * @param summary will be filled with the summary
+     * @return false, if the brackets of any line of the block are outdated, look at its lines one by one then
+     */
+    bool blockBracketSummary (int line, int &firstLine, int &lastLine, TextBracketSummary &summary) const;
+
+    /**
+     * The code brackets of the given line changed, drop the cached summary of its block.
+     * @param line line with changed brackets
+     */
+    void invalidateBracketSummary (int line);
+
     /**
      * Check if the given range pointer is still valid.
      * @return range pointer still belongs to range for this buffer
@@ -439,7 +657,7 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
   public:
     /**
     * md5 digest of the document on disk, set either through file loading
-    * in openFile() or in KateDocument::saveFile()
+    * in openFile() or while writing the file in save()
     * @return md5 digest for this document
     */
     const QByteArray &digest () const;
@@ -480,6 +698,19 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      */
     int m_lines;
 
+    /**
+     * Block index: Fenwick tree over the line counts of the blocks, 1-based.
+     * Allows to find the block for a line and the start line of a block in O(log blocks),
+     * without touching all blocks behind an edit.
+     */
+    QVector<int> m_blockIndex;
+
+    /**
+     * Revision of the block index, incremented on each change of it.
+     * Blocks use it to check if their cached start line is still valid.
+     */
+    qint64 m_blockIndexRevision;
+
     /**
      * Last used block in the buffer. Is used for speeding up blockForLine.
      * May contain invalid index, must be checked before using.
@@ -567,6 +798,46 @@ class KATEPART_TESTS_EXPORT TextBuffer : public QObject {
      * Limit for line length, longer lines will be wrapped on load
      */
     int m_lineLengthLimit;
+
+    /**
+     * Allow memory mapping of files on load?
+     */
+    bool m_allowMemoryMapping;
+
+    /**
+     * Store loaded lines compact?
+     */
+    bool m_compactLineStorage;
+
+    /**
+     * Bytes decoded more than once by the last load
+     */
+    qint64 m_bytesDecodedMoreThanOnce;
+
+    /**
+     * Thread for background loading, if running
+     */
+    TextLoaderThread *m_loadingThread;
+
+    /**
+     * File loaded in the background
+     */
+    QString m_loadingFilename;
+
+    /**
+     * Thread for background saving, if running
+     */
+    TextSaverThread *m_savingThread;
+
+    /**
+     * File saved in the background
+     */
+    QString m_savingFilename;
+
+    /**
+     * Revision of the snapshot saved in the background, -1 if the buffer got cleared meanwhile
+     */
+    qint64 m_savingRevision;
 };
 
 }
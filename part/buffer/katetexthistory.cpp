@@ -21,6 +21,8 @@
 #include "katetexthistory.h"
 #include "katetextbuffer.h"
 
+#include <QtCore/QtAlgorithms>
+
 namespace Kate {
 
 TextHistory::TextHistory (TextBuffer &buffer)
@@ -106,6 +108,29 @@ void TextHistory::removeText (const KTextEditor::Range &range, int oldLineLength
   addEntry (entry);
 }
 
+void TextHistory::insertLines (int line, int count)
+{
+  // create and add new entry
+  Entry entry;
+  entry.type = Entry::InsertLines;
+  entry.line = line;
+  entry.column = 0;
+  entry.length = count;
+  addEntry (entry);
+}
+
+void TextHistory::removeLines (int from, int count, int oldLineLength)
+{
+  // create and add new entry
+  Entry entry;
+  entry.type = Entry::RemoveLines;
+  entry.line = from;
+  entry.column = 0;
+  entry.length = count;
+  entry.oldLineLength = oldLineLength;
+  addEntry (entry);
+}
+
 void TextHistory::addEntry (const Entry &entry)
 {
   /**
@@ -308,6 +333,40 @@ void TextHistory::Entry::transformCursor (int &cursorLine, int &cursorColumn, bo
 
       return;
 
+    /**
+     * Insert lines
+     */
+    case InsertLines:
+      /**
+       * lines behind the inserted ones move down
+       */
+      cursorLine += length;
+      return;
+
+    /**
+     * Remove lines
+     */
+    case RemoveLines:
+      /**
+       * lines behind the removed ones move up
+       */
+      if (cursorLine >= line + length) {
+        cursorLine -= length;
+        return;
+      }
+
+      /**
+       * cursors on removed lines go to the start of the line behind them, or the end of the line in front of them
+       */
+      if (oldLineLength < 0) {
+        cursorLine = line;
+        cursorColumn = 0;
+      } else {
+        cursorLine = line - 1;
+        cursorColumn = oldLineLength;
+      }
+      return;
+
     /**
      * nothing
      */
@@ -425,6 +484,42 @@ void TextHistory::Entry::reverseTransformCursor (int &cursorLine, int &cursorCol
         cursorColumn =  oldLineLength + length;
       return;
 
+    /**
+     * Insert lines
+     */
+    case InsertLines:
+      /**
+       * ignore lines in front of the inserted ones
+       */
+      if (cursorLine < line)
+        return;
+
+      /**
+       * cursors on inserted lines go to the start of the line they were inserted in front of
+       */
+      if (cursorLine < line + length) {
+        cursorLine = line;
+        cursorColumn = 0;
+        return;
+      }
+
+      /**
+       * lines behind the inserted ones move up
+       */
+      cursorLine -= length;
+      return;
+
+    /**
+     * Remove lines
+     */
+    case RemoveLines:
+      /**
+       * lines behind the removed ones move down, only if there were lines behind them
+       */
+      if (cursorLine >= line && oldLineLength < 0)
+        cursorLine += length;
+      return;
+
     /**
      * nothing
      */
@@ -584,4 +679,225 @@ void TextHistory::transformRange (KTextEditor::Range &range, KTextEditor::Moving
   
 }
 
+/**
+ * Cursor of a batch, sorted by line only, the order of cursors on the same line does not matter.
+ */
+struct BatchCursor {
+  bool operator< (const BatchCursor &other) const { return line < other.line; }
+
+  int line;
+  int column;
+  int index;
+};
+
+/**
+ * Batch of cursors transformed together.
+ * The cursors are kept sorted by line, each history entry keeps this order, as no entry moves a line in front of an other one.
+ * Lines of cursors behind the changed lines are only shifted, these shifts are accumulated in a Fenwick tree over the
+ * sorted cursors: a run of entries on distinct lines collapses into one line offset per cursor, applied once at the end.
+ * Only the cursors on the changed lines of an entry are transformed one by one.
+ */
+class TextHistory::CursorBatch {
+  public:
+    /**
+     * Construct batch for the given cursors.
+     * @param cursors cursors to transform
+     */
+    CursorBatch (const QVector<KTextEditor::Cursor> &cursors)
+      : m_cursors (cursors.size())
+      , m_offsets (cursors.size() + 1, 0)
+    {
+      for (int i = 0; i < cursors.size(); ++i) {
+        m_cursors[i].line = cursors.at(i).line();
+        m_cursors[i].column = cursors.at(i).column();
+        m_cursors[i].index = i;
+      }
+      qStableSort (m_cursors.begin(), m_cursors.end());
+    }
+
+    /**
+     * Apply one history entry to all cursors.
+     * @param entry history entry
+     * @param moveOnInsert behavior of the cursors on insert of text at their position
+     */
+    void apply (const Entry &entry, bool moveOnInsert)
+    {
+      switch (entry.type) {
+        case Entry::WrapLine:
+          transform (entry, moveOnInsert, entry.line, entry.line, 1);
+          return;
+
+        case Entry::UnwrapLine:
+          transform (entry, moveOnInsert, entry.line, entry.line, -1);
+          return;
+
+        case Entry::InsertText:
+        case Entry::RemoveText:
+          transform (entry, moveOnInsert, entry.line, entry.line, 0);
+          return;
+
+        case Entry::InsertLines:
+          transform (entry, moveOnInsert, entry.line, entry.line - 1, entry.length);
+          return;
+
+        case Entry::RemoveLines:
+          transform (entry, moveOnInsert, entry.line, entry.line + entry.length - 1, -entry.length);
+          return;
+
+        default:
+          return;
+      }
+    }
+
+    /**
+     * Write the transformed cursors back.
+     * @param cursors cursors the batch was constructed with
+     */
+    void result (QVector<KTextEditor::Cursor> &cursors) const
+    {
+      for (int i = 0; i < m_cursors.size(); ++i)
+        cursors[m_cursors.at(i).index] = KTextEditor::Cursor (line (i), m_cursors.at(i).column);
+    }
+
+  private:
+    /**
+     * Transform the cursors on the changed lines one by one, shift the lines of the ones behind them.
+     * @param entry history entry
+     * @param moveOnInsert behavior of the cursors on insert of text at their position
+     * @param firstLine first changed line
+     * @param lastLine last changed line, smaller than the first one if no cursors must be transformed one by one
+     * @param offset line offset for cursors behind the changed lines
+     */
+    void transform (const Entry &entry, bool moveOnInsert, int firstLine, int lastLine, int offset)
+    {
+      const int first = lowerBound (firstLine);
+      const int last = (lastLine < firstLine) ? first : lowerBound (lastLine + 1);
+
+      /**
+       * cursors on changed lines, might get out of order among each other, sort them again
+       */
+      if (first < last) {
+        for (int i = first; i < last; ++i) {
+          BatchCursor &cursor = m_cursors[i];
+          cursor.line = line (i);
+          entry.transformCursor (cursor.line, cursor.column, moveOnInsert);
+        }
+
+        qStableSort (m_cursors.begin() + first, m_cursors.begin() + last);
+
+        for (int i = first; i < last; ++i)
+          m_cursors[i].line -= offsetFor (i);
+      }
+
+      /**
+       * shift all cursors behind the changed lines
+       */
+      if (offset != 0 && last < m_cursors.size())
+        for (int i = last + 1; i < m_offsets.size(); i += i & -i)
+          m_offsets[i] += offset;
+    }
+
+    /**
+     * Accumulated line offset of cursor with given index.
+     * @param index index of sorted cursor
+     * @return line offset
+     */
+    int offsetFor (int index) const
+    {
+      int offset = 0;
+      for (int i = index + 1; i > 0; i -= i & -i)
+        offset += m_offsets.at(i);
+      return offset;
+    }
+
+    /**
+     * Current line of cursor with given index.
+     * @param index index of sorted cursor
+     * @return line
+     */
+    int line (int index) const
+    {
+      return m_cursors.at(index).line + offsetFor (index);
+    }
+
+    /**
+     * Index of first cursor with line not in front of the given one.
+     * @param wantedLine line to search for
+     * @return index of first cursor with line >= wantedLine, number of cursors if none
+     */
+    int lowerBound (int wantedLine) const
+    {
+      int first = 0;
+      int count = m_cursors.size();
+      while (count > 0) {
+        const int half = count / 2;
+        if (line (first + half) < wantedLine) {
+          first += half + 1;
+          count -= half + 1;
+        } else
+          count = half;
+      }
+      return first;
+    }
+
+  private:
+    /**
+     * cursors, sorted by line, line without the accumulated offset
+     */
+    QVector<BatchCursor> m_cursors;
+
+    /**
+     * Fenwick tree of line offsets, 1-based, the offset of a cursor is the prefix sum up to it
+     */
+    QVector<int> m_offsets;
+};
+
+void TextHistory::transformCursors (QVector<KTextEditor::Cursor> &cursors, KTextEditor::MovingCursor::InsertBehavior insertBehavior, qint64 fromRevision, qint64 toRevision)
+{
+  /**
+   * -1 special meaning for from/toRevision
+   */
+  if (fromRevision == -1)
+    fromRevision = revision ();
+
+  if (toRevision == -1)
+    toRevision = revision ();
+
+  /**
+   * shortcut, same revision or nothing to do
+   */
+  if (fromRevision == toRevision || cursors.isEmpty())
+    return;
+
+  /**
+   * reverse transform: done rarely, transform the cursors one by one
+   */
+  if (toRevision < fromRevision) {
+    for (int i = 0; i < cursors.size(); ++i) {
+      int line = cursors.at(i).line(), column = cursors.at(i).column();
+      transformCursor (line, column, insertBehavior, fromRevision, toRevision);
+      cursors[i] = KTextEditor::Cursor (line, column);
+    }
+    return;
+  }
+
+  /**
+   * some invariants must hold
+   */
+  Q_ASSERT (!m_historyEntries.empty ());
+  Q_ASSERT (fromRevision >= m_firstHistoryEntryRevision);
+  Q_ASSERT (fromRevision < (m_firstHistoryEntryRevision + m_historyEntries.size()));
+  Q_ASSERT (toRevision >= m_firstHistoryEntryRevision);
+  Q_ASSERT (toRevision < (m_firstHistoryEntryRevision + m_historyEntries.size()));
+
+  /**
+   * transform all cursors in one sweep over the history
+   */
+  const bool moveOnInsert = insertBehavior == KTextEditor::MovingCursor::MoveOnInsert;
+  CursorBatch batch (cursors);
+  for (int rev = fromRevision - m_firstHistoryEntryRevision + 1; rev <= (toRevision - m_firstHistoryEntryRevision); ++rev)
+    batch.apply (m_historyEntries.at(rev), moveOnInsert);
+  batch.result (cursors);
+}
+
 }
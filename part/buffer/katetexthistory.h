@@ -22,6 +22,7 @@
 #define KATE_TEXTHISTORY_H
 
 #include <QtCore/QList>
+#include <QtCore/QVector>
 
 #include <ktexteditor/range.h>
 
@@ -86,7 +87,26 @@ class KATEPART_TESTS_EXPORT TextHistory {
      */
     void transformRange (KTextEditor::Range &range, KTextEditor::MovingRange::InsertBehaviors insertBehaviors, KTextEditor::MovingRange::EmptyBehavior emptyBehavior, qint64 fromRevision, qint64 toRevision = -1);
 
+    /**
+     * Transform many cursors from one revision to an other.
+     * The history entries are applied to all cursors in one sweep, entries only shifting the lines behind them
+     * are accumulated and applied once, only the cursors on the changed lines are transformed one by one.
+     * This is much faster than transforming the cursors one by one, if a lot of them and a lot of edits are involved.
+     * Range endpoints can be transformed this way, too, one call for the starts, one for the ends, but
+     * unlike transformRange() empty ranges are not handled, they need to be checked afterwards.
+     * @param cursors cursors to transform, any order
+     * @param insertBehavior behavior of the cursors on insert of text at their position
+     * @param fromRevision from this revision we want to transform
+     * @param toRevision to this revision we want to transform, default of -1 is current revision
+     */
+    void transformCursors (QVector<KTextEditor::Cursor> &cursors, KTextEditor::MovingCursor::InsertBehavior insertBehavior, qint64 fromRevision, qint64 toRevision = -1);
+
   private:
+    /**
+     * Batch of cursors transformed together by transformCursors(), defined in the implementation.
+     */
+    class CursorBatch;
+
     /**
      * Class representing one entry in the editing history.
      */
@@ -117,6 +137,8 @@ class KATEPART_TESTS_EXPORT TextHistory {
           , UnwrapLine
           , InsertText
           , RemoveText
+          , InsertLines
+          , RemoveLines
         };
 
         /**
@@ -154,6 +176,7 @@ class KATEPART_TESTS_EXPORT TextHistory {
 
         /**
          * old line length (needed for unwrap and insert)
+         * for removed lines: length of the line in front of them, -1 if lines followed them
          */
         int oldLineLength;
     };
@@ -179,6 +202,12 @@ class KATEPART_TESTS_EXPORT TextHistory {
      */
     void setLastSavedRevision ();
 
+    /**
+     * Set given revision as last saved revision, for a save of an older revision in the background
+     * @param revision revision which was saved
+     */
+    void setLastSavedRevision (qint64 revision) { m_lastSavedRevision = revision; }
+
     /**
      * Notify about wrap line at given cursor position.
      * @param position line/column as cursor where to wrap
@@ -207,6 +236,21 @@ class KATEPART_TESTS_EXPORT TextHistory {
      */
     void removeText (const KTextEditor::Range &range, int oldLineLength);
 
+    /**
+     * Notify about insert of whole lines.
+     * @param line line in front of which the lines were inserted
+     * @param count number of inserted lines
+     */
+    void insertLines (int line, int count);
+
+    /**
+     * Notify about remove of whole lines.
+     * @param from first removed line
+     * @param count number of removed lines
+     * @param oldLineLength text length of the line in front of the removed ones, -1 if lines followed them
+     */
+    void removeLines (int from, int count, int oldLineLength);
+
     /**
      * Generic function to add a entry to the history. Is used by the above functions for the different editing primitives.
      * @param entry new entry to add
@@ -22,19 +22,115 @@
 
 namespace Kate {
 
+TextBracketSummary::TextBracketSummary ()
+{
+  for (int i = 0; i < 3; ++i) {
+    depthChange[i] = 0;
+    minForward[i] = 0;
+    minBackward[i] = 0;
+  }
+}
+
+void TextBracketSummary::append (QChar bracket)
+{
+  const int k = kind (bracket);
+  if (k < 0)
+    return;
+
+  // summary of the single bracket, appended like any other summary
+  TextBracketSummary single;
+  const int depth = isOpening (bracket) ? 1 : -1;
+  single.depthChange[k] = depth;
+  single.minForward[k] = qMin (0, depth);
+  single.minBackward[k] = qMin (0, -depth);
+  append (single);
+}
+
+void TextBracketSummary::append (const TextBracketSummary &other)
+{
+  for (int i = 0; i < 3; ++i) {
+    // forward, the other brackets are reached with our depth change, backward the other way around
+    minForward[i] = qMin (minForward[i], depthChange[i] + other.minForward[i]);
+    minBackward[i] = qMin (other.minBackward[i], minBackward[i] - other.depthChange[i]);
+    depthChange[i] += other.depthChange[i];
+  }
+}
+
+const TextLineMetaData TextLineData::s_emptyMetaData;
+
 TextLineData::TextLineData ()
-  : m_flags (0)
+  : m_arenaOffset (0)
+  , m_arenaLength (0)
+  , m_metaData (0)
+  , m_flags (0)
 {
 }
 
 TextLineData::TextLineData (const QString &text)
   : m_text (text)
+  , m_arenaOffset (0)
+  , m_arenaLength (0)
+  , m_metaData (0)
+  , m_flags (0)
+{
+}
+
+TextLineData::TextLineData (const QExplicitlySharedDataPointer<TextLineArena> &arena, int offset, int length)
+  : m_arena (arena)
+  , m_arenaOffset (offset)
+  , m_arenaLength (length)
+  , m_metaData (0)
   , m_flags (0)
 {
+  Q_ASSERT (m_arena);
+  Q_ASSERT (offset >= 0 && offset + length <= m_arena->data.size());
 }
 
 TextLineData::~TextLineData ()
 {
+  delete m_metaData;
+}
+
+QString TextLineData::textCopy () const
+{
+  if (m_arena)
+    return QString::fromLatin1 (m_arena->data.constData() + m_arenaOffset, m_arenaLength);
+
+  return m_text;
+}
+
+TextLineSnapshot TextLineData::snapshot () const
+{
+  // share the string or the arena, both are never changed in place while shared
+  TextLineSnapshot snapshot;
+  snapshot.m_text = m_text;
+  snapshot.m_arena = m_arena;
+  snapshot.m_arenaOffset = m_arenaOffset;
+  snapshot.m_arenaLength = m_arenaLength;
+  return snapshot;
+}
+
+QString TextLineSnapshot::text () const
+{
+  if (m_arena)
+    return QString::fromLatin1 (m_arena->data.constData() + m_arenaOffset, m_arenaLength);
+
+  return m_text;
+}
+
+void TextLineData::materializeText () const
+{
+  // convert once, the arena is freed after the last line of it did this
+  m_text = QString::fromLatin1 (m_arena->data.constData() + m_arenaOffset, m_arenaLength);
+  m_arena = QExplicitlySharedDataPointer<TextLineArena> ();
+}
+
+TextBracketSummary TextLineData::bracketSummary () const
+{
+  TextBracketSummary summary;
+  foreach (int column, bracketsList ())
+    summary.append (at (column));
+  return summary;
 }
 
 int TextLineData::firstChar() const
@@ -44,15 +140,16 @@ int TextLineData::firstChar() const
 
 int TextLineData::lastChar() const
 {
-  return previousNonSpaceChar(m_text.length() - 1);
+  return previousNonSpaceChar(length() - 1);
 }
 
 int TextLineData::nextNonSpaceChar (int pos) const
 {
   Q_ASSERT (pos >= 0);
 
-  for(int i = pos; i < m_text.length(); i++)
-    if (!m_text[i].isSpace())
+  // works on compact stored text, too, no conversion needed
+  for(int i = pos; i < length(); i++)
+    if (!at(i).isSpace())
       return i;
 
   return -1;
@@ -60,11 +157,11 @@ int TextLineData::nextNonSpaceChar (int pos) const
 
 int TextLineData::previousNonSpaceChar (int pos) const
 {
-  if (pos >= m_text.length())
-    pos = m_text.length() - 1;
+  if (pos >= length())
+    pos = length() - 1;
 
   for(int i = pos; i >= 0; i--)
-    if (!m_text[i].isSpace())
+    if (!at(i).isSpace())
       return i;
 
   return -1;
@@ -81,8 +178,8 @@ QString TextLineData::leadingWhitespace() const
 int TextLineData::indentDepth (int tabWidth) const
 {
   int d = 0;
-  const int len = m_text.length();
-  const QChar *unicode = m_text.unicode();
+  const int len = text().length();
+  const QChar *unicode = text().unicode();
 
   for(int i = 0; i < len; ++i)
   {
@@ -105,13 +202,13 @@ bool TextLineData::matchesAt(int column, const QString& match) const
   if (column < 0)
     return false;
 
-  const int len = m_text.length();
+  const int len = text().length();
   const int matchlen = match.length();
 
   if ((column + matchlen) > len)
     return false;
 
-  const QChar *unicode = m_text.unicode();
+  const QChar *unicode = text().unicode();
   const QChar *matchUnicode = match.unicode();
 
   for (int i=0; i < matchlen; ++i)
@@ -127,8 +224,8 @@ int TextLineData::toVirtualColumn (int column, int tabWidth) const
     return 0;
 
   int x = 0;
-  const int zmax = qMin(column, m_text.length());
-  const QChar *unicode = m_text.unicode();
+  const int zmax = qMin(column, text().length());
+  const QChar *unicode = text().unicode();
 
   for ( int z = 0; z < zmax; ++z)
   {
@@ -146,8 +243,8 @@ int TextLineData::fromVirtualColumn (int column, int tabWidth) const
   if (column < 0)
     return 0;
 
-  const int zmax = qMin(m_text.length(), column);
-  const QChar *unicode = m_text.unicode();
+  const int zmax = qMin(text().length(), column);
+  const QChar *unicode = text().unicode();
 
   int x = 0;
   int z = 0;
@@ -168,8 +265,8 @@ int TextLineData::fromVirtualColumn (int column, int tabWidth) const
 int TextLineData::virtualLength (int tabWidth) const
 {
   int x = 0;
-  const int len = m_text.length();
-  const QChar *unicode = m_text.unicode();
+  const int len = text().length();
+  const QChar *unicode = text().unicode();
 
   for ( int z = 0; z < len; ++z)
   {
@@ -185,18 +282,19 @@ int TextLineData::virtualLength (int tabWidth) const
 void TextLineData::addAttribute (int start, int length, int attribute)
 {
   // try to append to previous range
-  if ((m_attributesList.size() > 2) && (m_attributesList[m_attributesList.size()-1] == attribute)
-      && (m_attributesList[m_attributesList.size()-3]+m_attributesList[m_attributesList.size()-2]
+  QVector<int> &attributesList = metaDataReadWrite ().attributesList;
+  if ((attributesList.size() > 2) && (attributesList[attributesList.size()-1] == attribute)
+      && (attributesList[attributesList.size()-3]+attributesList[attributesList.size()-2]
          == start))
   {
-    m_attributesList[m_attributesList.size()-2] += length;
+    attributesList[attributesList.size()-2] += length;
     return;
   }
 
-  m_attributesList.resize (m_attributesList.size()+3);
-  m_attributesList[m_attributesList.size()-3] = start;
-  m_attributesList[m_attributesList.size()-2] = length;
-  m_attributesList[m_attributesList.size()-1] = attribute;
+  attributesList.resize (attributesList.size()+3);
+  attributesList[attributesList.size()-3] = start;
+  attributesList[attributesList.size()-2] = length;
+  attributesList[attributesList.size()-1] = attribute;
 }
 
 }
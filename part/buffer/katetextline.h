@@ -24,11 +24,156 @@
 #include <QtCore/QVector>
 #include <QtCore/QString>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QSharedData>
+#include <QtCore/QByteArray>
 
 #include "katepartprivate_export.h"
 
 namespace Kate {
 
+/**
+ * Storage for the 8-bit text of lines, shared by all lines stored in it.
+ * A block fills one arena while loading, the lines keep it alive.
+ */
+class TextLineArena : public QSharedData {
+  public:
+    /**
+     * Latin-1 text of all lines, without separators
+     */
+    QByteArray data;
+};
+
+/**
+ * Text of a line at one point in time, shares the storage with the line, no copy is done.
+ * Later changes of the line don't touch it, it can be read in another thread, like for saving in the background.
+ */
+class TextLineSnapshot {
+  friend class TextLineData;
+
+  public:
+    /**
+     * Construct empty snapshot.
+     */
+    TextLineSnapshot () : m_arenaOffset (0), m_arenaLength (0) {}
+
+    /**
+     * Text of the line at the time the snapshot was taken.
+     * @return text of the line
+     */
+    QString text () const;
+
+    /**
+     * Length of the text.
+     * @return length of the text
+     */
+    int length () const { return m_arena ? m_arenaLength : m_text.length(); }
+
+  private:
+    QString m_text;
+    QExplicitlySharedDataPointer<TextLineArena> m_arena;
+    int m_arenaOffset;
+    int m_arenaLength;
+};
+
+/**
+ * Summary of the code brackets of a line or of a whole block, used to skip them when searching matching brackets.
+ * For each kind of bracket, (), {} and [], it holds the change of the nesting depth and the minimal depth
+ * reached on the way, scanning forward or backward.
+ */
+class KATEPART_TESTS_EXPORT TextBracketSummary {
+  public:
+    /**
+     * Construct empty summary.
+     */
+    TextBracketSummary ();
+
+    /**
+     * Kind of bracket.
+     * @param c character to check
+     * @return 0 for (), 1 for {}, 2 for [], -1 if no bracket
+     */
+    static int kind (QChar c)
+    {
+      switch (c.unicode()) {
+        case '(': case ')': return 0;
+        case '{': case '}': return 1;
+        case '[': case ']': return 2;
+        default: return -1;
+      }
+    }
+
+    /**
+     * Is the given bracket an opening one?
+     * @param c bracket to check
+     * @return opening bracket?
+     */
+    static bool isOpening (QChar c) { return c == QLatin1Char ('(') || c == QLatin1Char ('{') || c == QLatin1Char ('['); }
+
+    /**
+     * Append a bracket behind the summarized ones.
+     * @param bracket bracket to append, other characters are ignored
+     */
+    void append (QChar bracket);
+
+    /**
+     * Append the brackets summarized by an other summary behind the summarized ones.
+     * @param other summary to append
+     */
+    void append (const TextBracketSummary &other);
+
+  public:
+    /**
+     * opening minus closing brackets, for each kind
+     */
+    int depthChange[3];
+
+    /**
+     * minimum of opening minus closing brackets in all prefixes, for each kind, <= 0
+     * scanning forward with depth d, the depth reaches 0 inside iff d + minForward <= 0
+     */
+    int minForward[3];
+
+    /**
+     * minimum of closing minus opening brackets in all suffixes, for each kind, <= 0
+     * scanning backward with depth d, the depth reaches 0 inside iff d + minBackward <= 0
+     */
+    int minBackward[3];
+};
+
+/**
+ * Highlighting and folding data of a text line, only allocated once any of it is set.
+ */
+class TextLineMetaData {
+  public:
+    /**
+     * store the attribs, int array
+     * one int start, next one len, next one attrib
+     *
+     * TODO: KDE5 replace with movable struct of three ints.
+     */
+    QVector<int> attributesList;
+
+    /**
+     * context stack
+     */
+    QVector<short> ctx;
+
+    /**
+     * list of folding starts/ends
+     */
+    QVector<int> foldingList;
+
+    /**
+     * indentation stack
+     */
+    QVector<unsigned short> indentationDepth;
+
+    /**
+     * columns of the brackets in code, not in comments, strings and the like, found while highlighting
+     */
+    QVector<int> brackets;
+};
+
 /**
  * Class representing a single text line.
  * For efficience reasons, not only pure text is stored here, but also additional data.
@@ -53,7 +198,8 @@ class KATEPART_TESTS_EXPORT TextLineData {
       flagNoIndentationBasedFolding = 8,
       flagNoIndentationBasedFoldingAtStart = 16,
       flagLineModified = 32,
-      flagLineSavedOnDisk = 64
+      flagLineSavedOnDisk = 64,
+      flagBracketsValid = 128
     };
 
     /**
@@ -67,6 +213,14 @@ class KATEPART_TESTS_EXPORT TextLineData {
      */
     TextLineData (const QString &text);
 
+    /**
+     * Construct a text line stored compact as Latin-1 in the given arena.
+     * @param arena arena holding the text
+     * @param offset start of the text in the arena
+     * @param length length of the text
+     */
+    TextLineData (const QExplicitlySharedDataPointer<TextLineArena> &arena, int offset, int length);
+
     /**
      * Destruct the text line
      */
@@ -74,9 +228,29 @@ class KATEPART_TESTS_EXPORT TextLineData {
 
     /**
      * Accessor to the text contained in this line.
+     * Compact stored text is converted to a QString on first access.
      * @return text of this line as constant reference
      */
-    const QString &text () const { return m_text; }
+    const QString &text () const { if (m_arena) materializeText (); return m_text; }
+
+    /**
+     * Text of this line, without keeping a converted copy for compact stored text.
+     * Use this for one time traversals of the whole buffer, like saving.
+     * @return text of this line
+     */
+    QString textCopy () const;
+
+    /**
+     * Snapshot of the text of this line, for reading in another thread while the line is changed.
+     * @return snapshot of the text
+     */
+    TextLineSnapshot snapshot () const;
+
+    /**
+     * Is the text of this line still stored compact as Latin-1?
+     * @return compact storage used?
+     */
+    bool isCompact () const { return m_arena; }
 
     /**
      * Returns the position of the first non-whitespace character
@@ -114,8 +288,8 @@ class KATEPART_TESTS_EXPORT TextLineData {
      */
     inline QChar at (int column) const
     {
-      if (column >= 0 && column < m_text.length())
-        return m_text[column];
+      if (column >= 0 && column < length())
+        return m_arena ? QChar (QLatin1Char (m_arena->data.at (m_arenaOffset + column))) : m_text[column];
 
       return QChar();
     }
@@ -127,10 +301,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
      */
     inline QChar operator[](int column) const
     {
-      if (column >= 0 && column < m_text.length())
-        return m_text[column];
-
-      return QChar();
+      return at (column);
     }
 
     inline void markAsModified(bool modified)
@@ -183,7 +354,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
     /**
      * Returns the line's length.
      */
-    int length() const { return m_text.length(); }
+    int length() const { return m_arena ? m_arenaLength : m_text.length(); }
 
     /**
      * Returns \e true, if the line's hl-continue flag is set, otherwise returns
@@ -203,7 +374,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * Returns the complete text line (as a QString reference).
      * @return text of this line, read-only
      */
-    const QString& string() const { return m_text; }
+    const QString& string() const { return text (); }
 
     /**
      * Returns the substring with \e length beginning at the given \e column.
@@ -212,7 +383,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * @return wanted part of text
      */
     QString string (int column, int length) const
-    { return m_text.mid(column, length); }
+    { return text ().mid(column, length); }
 
     /**
      * Leading whitespace of this line
@@ -250,12 +421,12 @@ class KATEPART_TESTS_EXPORT TextLineData {
     /**
      * Returns \e true, if the line starts with \e match, otherwise returns \e false.
      */
-    bool startsWith(const QString& match) const { return m_text.startsWith (match); }
+    bool startsWith(const QString& match) const { return text ().startsWith (match); }
 
     /**
      * Returns \e true, if the line ends with \e match, otherwise returns \e false.
      */
-    bool endsWith(const QString& match) const { return m_text.endsWith (match); }
+    bool endsWith(const QString& match) const { return text ().endsWith (match); }
 
     /**
      * Gets the attribute at the given position
@@ -266,12 +437,13 @@ class KATEPART_TESTS_EXPORT TextLineData {
      */
     int attribute (int pos) const
     {
-      for (int i=0; i < m_attributesList.size(); i+=3)
+      const QVector<int> &attributesList = metaData ().attributesList;
+      for (int i=0; i < attributesList.size(); i+=3)
       {
-        if (pos >= m_attributesList[i] && pos < m_attributesList[i]+m_attributesList[i+1])
-          return m_attributesList[i+2];
+        if (pos >= attributesList[i] && pos < attributesList[i]+attributesList[i+1])
+          return attributesList[i+2];
 
-        if (pos < m_attributesList[i])
+        if (pos < attributesList[i])
           break;
       }
 
@@ -282,7 +454,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * context stack
      * @return context stack
      */
-    const QVector<short> &ctxArray () const { return m_ctx; }
+    const QVector<short> &ctxArray () const { return metaData ().ctx; }
 
     /**
      * @return true if any context at the line end has the noIndentBasedFolding flag set
@@ -298,13 +470,32 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * folding list
      * @return folding array
      */
-    const QVector<int> &foldingListArray () const { return m_foldingList; }
+    const QVector<int> &foldingListArray () const { return metaData ().foldingList; }
 
     /**
      * indentation stack
      * @return indentation array
      */
-    const QVector<unsigned short> &indentationDepthArray () const { return m_indentationDepth; }
+    const QVector<unsigned short> &indentationDepthArray () const { return metaData ().indentationDepth; }
+
+    /**
+     * Are the code brackets of this line up-to-date?
+     * They are set while highlighting and outdated by each change of the text.
+     * @return brackets valid?
+     */
+    bool bracketsValid () const { return m_flags & flagBracketsValid; }
+
+    /**
+     * code brackets, only up-to-date if bracketsValid()
+     * @return columns of the code brackets, ascending
+     */
+    const QVector<int> &bracketsList () const { return metaData ().brackets; }
+
+    /**
+     * Summary of the code brackets of this line.
+     * @return summary
+     */
+    TextBracketSummary bracketSummary () const;
 
     /**
      * Add attribute for given start + length to this line
@@ -317,13 +508,13 @@ class KATEPART_TESTS_EXPORT TextLineData {
     /**
      * Clear attributes of this line
      */
-    void clearAttributes () { m_attributesList.clear (); }
+    void clearAttributes () { if (m_metaData) m_metaData->attributesList.clear (); }
 
     /**
      * Accessor to attributes
      * @return attributes of this line
      */
-    const QVector<int> &attributesList () const { return m_attributesList; }
+    const QVector<int> &attributesList () const { return metaData ().attributesList; }
 
     /**
      * set hl continue flag
@@ -349,7 +540,7 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * Sets the syntax highlight context number
      * @param val new context array
      */
-    void setContext (QVector<short> &val) { m_ctx = val; }
+    void setContext (QVector<short> &val) { if (m_metaData || !val.isEmpty()) metaDataReadWrite ().ctx = val; }
 
     /**
      * sets if for the next line indent based folding should be disabled
@@ -375,50 +566,78 @@ class KATEPART_TESTS_EXPORT TextLineData {
      * update folding list
      * @param val new folding list
      */
-    void setFoldingList (QVector<int> &val) { m_foldingList = val; }
+    void setFoldingList (QVector<int> &val) { if (m_metaData || !val.isEmpty()) metaDataReadWrite ().foldingList = val; }
 
     /**
      * update indentation stack
      * @param val new indentation stack
      */
-    void setIndentationDepth (QVector<unsigned short> &val) { m_indentationDepth = val; }
+    void setIndentationDepth (QVector<unsigned short> &val) { if (m_metaData || !val.isEmpty()) metaDataReadWrite ().indentationDepth = val; }
+
+    /**
+     * update code brackets, marks them as valid until the text changes
+     * @param val new columns of code brackets, ascending
+     */
+    void setBrackets (const QVector<int> &val) { if (m_metaData || !val.isEmpty()) metaDataReadWrite ().brackets = val; m_flags |= flagBracketsValid; }
 
   private:
     /**
      * Accessor to the text contained in this line.
      * This accessor is private, only the friend class text buffer/block is allowed to access the text read/write.
+     * The code brackets get outdated, the text will be changed.
      * @return text of this line
      */
-    QString &textReadWrite () { return m_text; }
+    QString &textReadWrite () { if (m_arena) materializeText (); m_flags &= ~flagBracketsValid; return m_text; }
+
+    /**
+     * Convert the compact stored text to the QString and drop the reference to the arena.
+     */
+    void materializeText () const;
+
+    /**
+     * Highlighting and folding data of this line, shared empty data if nothing set until now.
+     * @return meta data of this line
+     */
+    const TextLineMetaData &metaData () const { return m_metaData ? *m_metaData : s_emptyMetaData; }
+
+    /**
+     * Highlighting and folding data of this line, allocated on first use.
+     * @return meta data of this line
+     */
+    TextLineMetaData &metaDataReadWrite () { if (!m_metaData) m_metaData = new TextLineMetaData (); return *m_metaData; }
 
   private:
+    Q_DISABLE_COPY (TextLineData)
+
     /**
-     * text of this line
+     * text of this line, empty as long as the text is stored in the arena
      */
-    QString m_text;
+    mutable QString m_text;
 
     /**
-     * store the attribs, int array
-     * one int start, next one len, next one attrib
-     *
-     * TODO: KDE5 replace with movable struct of three ints.
+     * arena with the Latin-1 text of this line, if stored compact
      */
-    QVector<int> m_attributesList;
+    mutable QExplicitlySharedDataPointer<TextLineArena> m_arena;
 
     /**
-     * context stack
+     * start of the text of this line in the arena
      */
-    QVector<short> m_ctx;
+    int m_arenaOffset;
 
     /**
-     * list of folding starts/ends
+     * length of the text of this line in the arena
      */
-    QVector<int> m_foldingList;
+    int m_arenaLength;
 
     /**
-     * indentation stack
+     * highlighting and folding data, 0 until any of it is set
+     */
+    TextLineMetaData *m_metaData;
+
+    /**
+     * empty meta data, returned for lines without any
      */
-    QVector<unsigned short> m_indentationDepth;
+    static const TextLineMetaData s_emptyMetaData;
 
     /**
      * flags
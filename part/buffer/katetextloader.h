@@ -23,11 +23,16 @@
 
 #include <QtCore/QString>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDateTime>
+
+#include <string.h> // memchr
 
 // on the fly compression
 #include <kfilterdev.h>
 #include <kmimetype.h>
 #include <kcodecs.h> // KMD5
+#include <kdebug.h>
 
 namespace Kate {
 
@@ -38,6 +43,26 @@ namespace Kate {
  */
 static const qint64 KATE_FILE_LOADER_BS  = 256 * 1024;
 
+/**
+ * chunk size used to hand out data from memory mapped files, 4 mb per default
+ * chunks are extended up to the next newline, to avoid partial lines in the decoded text
+ */
+static const qint64 KATE_FILE_LOADER_MAP_BS  = 4 * 1024 * 1024;
+
+/**
+ * only files not modified for that many seconds are memory mapped, files still
+ * being written, like logs, might be truncated while mapped, which would crash us
+ */
+static const int KATE_FILE_LOADER_MAP_AGE  = 10;
+
+/**
+ * encoding detection looks at the start of the file, 256 kb per default,
+ * plus a few samples of 64 kb spread over the rest of the file, if it can seek
+ */
+static const qint64 KATE_FILE_LOADER_DETECT_BS  = 256 * 1024;
+static const qint64 KATE_FILE_LOADER_SAMPLE_BS  = 64 * 1024;
+static const int KATE_FILE_LOADER_SAMPLES  = 4;
+
 /**
  * File Loader, will handle reading of files + detecting encoding
  */
@@ -48,8 +73,9 @@ class TextLoader
      * Construct file loader for given file.
      * @param filename file to open
      * @param proberType prober type
+     * @param allowMemoryMapping use memory mapping for uncompressed local files
      */
-    TextLoader (const QString &filename, KEncodingProber::ProberType proberType)
+    TextLoader (const QString &filename, KEncodingProber::ProberType proberType, bool allowMemoryMapping = true)
       : m_codec (0)
       , m_eof (false) // default to not eof
       , m_lastWasEndOfLine (true) // at start of file, we had a virtual newline
@@ -57,11 +83,18 @@ class TextLoader
       , m_position (0)
       , m_lastLineStart (0)
       , m_eol (TextBuffer::eolUnknown) // no eol type detected atm
-      , m_buffer (KATE_FILE_LOADER_BS, 0)
       , m_converterState (0)
       , m_bomFound (false)
       , m_firstRead (true)
       , m_proberType (proberType)
+      , m_allowMemoryMapping (allowMemoryMapping)
+      , m_mappedData (0)
+      , m_mappedSize (0)
+      , m_mappedPosition (0)
+      , m_switchCodec (0)
+      , m_asciiOnly (true)
+      , m_readBytes (0)
+      , m_decodedBytes (0)
     {
       // try to get mimetype for on the fly decompression, don't rely on filename!
       QFile testMime (filename);
@@ -79,6 +112,7 @@ class TextLoader
      */
     ~TextLoader ()
     {
+      unmapFile ();
       delete m_file;
       delete m_converterState;
     }
@@ -86,11 +120,17 @@ class TextLoader
     /**
      * open file with given codec
      * @param codec codec to use, if 0, will do some auto-dectect or fallback
+     * @param switchCodec codec to switch to, if decoding fails after only ascii was read,
+     *        the failing chunk will be decoded again, no need to start from scratch, 0 to disable this
      * @return success
      */
-    bool open (QTextCodec *codec)
+    bool open (QTextCodec *codec, QTextCodec *switchCodec = 0)
     {
       m_codec = codec;
+      m_switchCodec = switchCodec;
+      m_asciiOnly = true;
+      m_readBytes = 0;
+      m_digest.reset ();
       m_eof = false;
       m_lastWasEndOfLine = true;
       m_lastWasR = false;
@@ -104,10 +144,98 @@ class TextLoader
       m_firstRead = true;
 
       // if already opened, close the file...
+      unmapFile ();
       if (m_file->isOpen())
         m_file->close ();
 
-      return m_file->open (QIODevice::ReadOnly);
+      if (!m_file->open (QIODevice::ReadOnly))
+        return false;
+
+      /**
+       * no filter device needed? then try to map the file, we can then avoid to copy
+       * all data into our read buffer, if that fails, we just read the file chunk by chunk
+       * files modified recently might still be written, don't map them
+       */
+      if (m_allowMemoryMapping) {
+        QFile *plainFile = qobject_cast<QFile *> (m_file);
+        if (plainFile && plainFile->size() > 0
+            && QFileInfo (*plainFile).lastModified ().secsTo (QDateTime::currentDateTime ()) >= KATE_FILE_LOADER_MAP_AGE) {
+          m_mappedData = plainFile->map (0, plainFile->size());
+          if (m_mappedData)
+            m_mappedSize = plainFile->size();
+        }
+      }
+
+      return true;
+    }
+
+    /**
+     * is the file memory mapped?
+     * @return file is mapped, no read buffer is used
+     */
+    bool isMemoryMapped () const { return m_mappedData; }
+
+    /**
+     * Detection stage for the triple play of TextBuffer::load.
+     * Checks the start of the file and some samples spread over it, which round will be the
+     * first one to decode the file without errors:
+     * 0) given codec, 1) byte order mark or encoding prober, 2) fallback codec, 3) nothing works
+     * File will be opened again by open() afterwards.
+     * @param codec codec given by the user
+     * @param fallbackCodec fallback codec
+     * @return first round to try
+     */
+    int detectFirstRound (QTextCodec *codec, QTextCodec *fallbackCodec)
+    {
+      // open file, without codec, we only get raw data
+      if (!open (0))
+        return 0;
+
+      /**
+       * collect the start of the file and some samples
+       * samples are only possible if we can seek, not for compressed files
+       */
+      QList<QByteArray> samples;
+      QFile *plainFile = qobject_cast<QFile *> (m_file);
+      const qint64 size = plainFile ? plainFile->size() : 0;
+      for (int i = 0; i <= KATE_FILE_LOADER_SAMPLES; ++i) {
+        const qint64 start = (i == 0) ? 0 : (size / KATE_FILE_LOADER_SAMPLES) * i - KATE_FILE_LOADER_SAMPLE_BS;
+        const qint64 length = (i == 0) ? KATE_FILE_LOADER_DETECT_BS : KATE_FILE_LOADER_SAMPLE_BS;
+
+        // nothing more to sample, either no seeking or file too small
+        if (i > 0 && (start < KATE_FILE_LOADER_DETECT_BS || (size - start) < length))
+          break;
+
+        // read, not the mapping: the samples are decoded later, the file might be truncated meanwhile
+        if (start == 0 || m_file->seek (start))
+          samples.append (m_file->read (length));
+      }
+
+      // empty file, nothing to detect
+      if (samples.isEmpty() || samples.first().isEmpty())
+        return 0;
+
+      // 0) given codec
+      if (codec && decodesWithoutErrors (codec, samples))
+        return 0;
+
+      // 1) byte order mark, this one always wins in round 1
+      if (QTextCodec::codecForUtfText (samples.first().left (16), 0))
+        return 1;
+
+      // 1) encoding prober on the start of the file
+      KEncodingProber prober (m_proberType);
+      prober.feed (samples.first().constData(), samples.first().size());
+      QTextCodec *proberCodec = (prober.confidence() > 0.5) ? QTextCodec::codecForName (prober.encoding()) : 0;
+      if (proberCodec && decodesWithoutErrors (proberCodec, samples))
+        return 1;
+
+      // 2) fallback codec
+      if (fallbackCodec && decodesWithoutErrors (fallbackCodec, samples))
+        return 2;
+
+      // 3) nothing did work
+      return 3;
     }
 
     /**
@@ -179,10 +307,12 @@ class TextLoader
           // try to load more text if something is around
           if (!m_eof)
           {
-            int c = m_file->read (m_buffer.data(), m_buffer.size());
+            const char *data = 0;
+            int c = readChunk (data);
 
             // update md5 hash sum
-            m_digest.update(m_buffer.data(), c);
+            if (c > 0)
+              m_digest.update(data, c);
 
             // kill the old lines...
             m_text.remove (0, m_lastLineStart);
@@ -194,7 +324,7 @@ class TextLoader
               int bomBytes = 0;
               if (m_firstRead) {
                 // use first 16 bytes max to allow BOM detection of codec
-                QByteArray bom (m_buffer.data(), qMin (16, c));
+                QByteArray bom (data, qMin (16, c));
                 QTextCodec *codecForByteOrderMark = QTextCodec::codecForUtfText (bom, 0);
 
                 // if codec != null, we found a BOM!
@@ -225,7 +355,7 @@ class TextLoader
                      * no unicode BOM found, trigger prober
                      */
                     KEncodingProber prober (m_proberType);
-                    prober.feed (m_buffer.constData(), c);
+                    prober.feed (data, c);
 
                     // we found codec with some confidence?
                     if (prober.confidence() > 0.5)
@@ -241,16 +371,38 @@ class TextLoader
               }
 
               Q_ASSERT (m_codec);
-              QString unicode = m_codec->toUnicode (m_buffer.constData() + bomBytes, c - bomBytes, m_converterState);
-
-              // detect broken encoding
-              for (int i = 0; i < unicode.size(); ++i) {
-                  if (unicode[i] == 0) {
-                    encodingError = true;
-                    break;
-                  }
+              QString unicode = m_codec->toUnicode (data + bomBytes, c - bomBytes, m_converterState);
+              m_decodedBytes += c;
+
+              // detect broken encoding, keep errors of earlier chunks of this line
+              const bool chunkError = containsNull (unicode);
+
+              /**
+               * broken encoding, but all chunks in front of this one were plain ascii?
+               * then switch the codec and only decode this chunk again, the lines read so far
+               * would be the same with any ascii compatible codec, but only if the current one is such one, too
+               */
+              bool switched = false;
+              if (chunkError && m_asciiOnly && m_readBytes > 0 && isAsciiCompatible (m_codec)) {
+                QTextCodec *codec = codecForChunk (data, c);
+                if (codec) {
+                  kDebug (13020) << "Switching codec from" << m_codec->name() << "to" << codec->name() << "at byte" << m_readBytes;
+                  m_codec = codec;
+                  delete m_converterState;
+                  m_converterState = new QTextCodec::ConverterState (QTextCodec::ConvertInvalidToNull);
+                  unicode = m_codec->toUnicode (data, c, m_converterState);
+                  m_decodedBytes += c;
+                  switched = true;
+                }
               }
 
+              encodingError = encodingError || (chunkError && !switched);
+
+              // remember if all read so far is ascii, needed to allow codec switch
+              if (m_asciiOnly)
+                m_asciiOnly = isAscii (data, c);
+              m_readBytes += c;
+
               m_text.append (unicode);
             }
 
@@ -352,11 +504,235 @@ class TextLoader
       return !encodingError;
     }
 
+    /**
+     * Length of the first part of a line, if it needs to be wrapped because of the line length limit.
+     * Tries to wrap at a space or punctuation in the last tenth of the allowed length.
+     * @param unicodeData line data
+     * @param length line length
+     * @param lineLengthLimit limit for line length, <= 0 for no limit
+     * @return length of first part, length itself if no wrap is needed
+     */
+    static int wrappedLineLength (const QChar *unicodeData, int length, int lineLengthLimit)
+    {
+      if ((lineLengthLimit <= 0) || (length <= lineLengthLimit))
+        return length;
+
+      /**
+       * search for place to wrap
+       */
+      int spacePosition = lineLengthLimit-1;
+      for (int testPosition = lineLengthLimit-1; (testPosition >= 0) && (testPosition >= (lineLengthLimit - (lineLengthLimit/10))); --testPosition) {
+        /**
+         * wrap place found?
+         */
+        if (unicodeData[testPosition].isSpace() || unicodeData[testPosition].isPunct()) {
+          spacePosition = testPosition;
+          break;
+        }
+      }
+
+      return spacePosition+1;
+    }
+
     QByteArray digest ()
     {
       return m_digest.hexDigest();
     }
 
+    /**
+     * Bytes decoded more than once, by detection, codec switches or additional loading rounds.
+     * Only valid after the complete file is read.
+     * @return number of bytes decoded in vain
+     */
+    qint64 bytesDecodedMoreThanOnce () const { return m_decodedBytes - m_readBytes; }
+
+  private:
+    /**
+     * get next chunk of raw data from the file
+     * for mapped files, this just points into the mapping
+     * @param data will point to the data of the chunk
+     * @return size of chunk, 0 on end of file, -1 on error
+     */
+    int readChunk (const char *&data)
+    {
+      /**
+       * file truncated while mapped? touching the mapping behind the end of the file
+       * would crash with SIGBUS, read the rest of the file normally then
+       */
+      if (m_mappedData && m_file->size () < m_mappedSize) {
+        const qint64 position = m_mappedPosition;
+        unmapFile ();
+        if (!m_file->seek (position))
+          return -1;
+      }
+
+      /**
+       * normal file read into our buffer, only allocated if needed
+       */
+      if (!m_mappedData) {
+        if (m_buffer.isEmpty ())
+          m_buffer.resize (KATE_FILE_LOADER_BS);
+        data = m_buffer.constData();
+        return m_file->read (m_buffer.data(), m_buffer.size());
+      }
+
+      /**
+       * mapped file, nothing to copy, just point into the mapping
+       */
+      data = reinterpret_cast<const char *> (m_mappedData) + m_mappedPosition;
+      const qint64 remaining = m_mappedSize - m_mappedPosition;
+      if (remaining <= 0)
+        return 0;
+
+      /**
+       * extend chunk up to next newline, then the text from the last chunk is completely
+       * consumed if we need the next one and the removal of old lines is for free
+       * memchr is vectorized by the libc, this is way faster than our QChar loop
+       */
+      qint64 chunk = qMin (remaining, KATE_FILE_LOADER_MAP_BS);
+      if (chunk < remaining) {
+        const char *newline = static_cast<const char *> (memchr (data + chunk, '\n', qMin (remaining - chunk, KATE_FILE_LOADER_MAP_BS)));
+        if (newline)
+          chunk = (newline - data) + 1;
+      }
+
+      m_mappedPosition += chunk;
+      return chunk;
+    }
+
+    /**
+     * does the unicode text contain null chars?
+     * used to detect encoding errors, as we convert invalid chars to null
+     * @param unicode text to check
+     * @return null chars found?
+     */
+    static bool containsNull (const QString &unicode)
+    {
+      const QChar *data = unicode.unicode ();
+      for (int i = 0; i < unicode.size(); ++i)
+        if (data[i].isNull())
+          return true;
+      return false;
+    }
+
+    /**
+     * is the given data 7-bit ascii only?
+     * @param data data to check
+     * @param size size of data
+     * @return data only contains ascii bytes
+     */
+    static bool isAscii (const char *data, int size)
+    {
+      for (int i = 0; i < size; ++i)
+        if (static_cast<uchar> (data[i]) >= 0x80)
+          return false;
+      return true;
+    }
+
+    /**
+     * does the given codec decode all ascii bytes to the same latin-1 characters?
+     * only then we can switch codecs after an ascii only start of the file
+     * @param codec codec to check
+     * @return codec is ascii compatible
+     */
+    static bool isAsciiCompatible (QTextCodec *codec)
+    {
+      char ascii[128];
+      for (int i = 0; i < 128; ++i)
+        ascii[i] = i;
+
+      const QString unicode = codec->toUnicode (ascii, 128);
+      if (unicode.size() != 128)
+        return false;
+
+      for (int i = 0; i < 128; ++i)
+        if (unicode.at(i).unicode() != i)
+          return false;
+
+      return true;
+    }
+
+    /**
+     * choose codec to decode the chunk which failed to decode with the current one
+     * first try the encoding prober on the chunk, then the switch codec
+     * @param data chunk data
+     * @param size chunk size
+     * @return codec that can decode the chunk or 0
+     */
+    QTextCodec *codecForChunk (const char *data, int size)
+    {
+      // switching allowed at all?
+      if (!m_switchCodec)
+        return 0;
+
+      QList<QTextCodec *> candidates;
+      KEncodingProber prober (m_proberType);
+      prober.feed (data, size);
+      if (prober.confidence() > 0.5 && QTextCodec::codecForName (prober.encoding()))
+        candidates.append (QTextCodec::codecForName (prober.encoding()));
+      candidates.append (m_switchCodec);
+
+      foreach (QTextCodec *codec, candidates) {
+        if (codec == m_codec || !isAsciiCompatible (codec))
+          continue;
+
+        QTextCodec::ConverterState state (QTextCodec::ConvertInvalidToNull);
+        if (!containsNull (codec->toUnicode (data, size, &state)))
+          return codec;
+      }
+
+      return 0;
+    }
+
+    /**
+     * decode the given samples of a file, used for detection
+     * the first sample is the start of the file, the others are taken from the middle,
+     * for them we skip the first partial line, only full characters are decoded
+     * @param codec codec to test
+     * @param samples samples to decode
+     * @return no encoding errors occurred
+     */
+    bool decodesWithoutErrors (QTextCodec *codec, const QList<QByteArray> &samples)
+    {
+      // utf-16 and utf-32 have no byte based newlines, only check the start
+      const int mib = codec->mibEnum ();
+      const bool onlyStart = (mib == 1013 || mib == 1014 || mib == 1015 || mib == 1017 || mib == 1018 || mib == 1019);
+
+      for (int i = 0; i < samples.size(); ++i) {
+        if (i > 0 && onlyStart)
+          break;
+
+        const QByteArray &sample = samples.at(i);
+        int start = 0;
+        if (i > 0) {
+          start = sample.indexOf ('\n') + 1;
+          if (start == 0)
+            continue;
+        }
+
+        QTextCodec::ConverterState state (QTextCodec::ConvertInvalidToNull);
+        const QString unicode = codec->toUnicode (sample.constData() + start, sample.size() - start, &state);
+        m_decodedBytes += sample.size() - start;
+        if (containsNull (unicode))
+          return false;
+      }
+
+      return true;
+    }
+
+    /**
+     * remove the mapping of the file, if any
+     */
+    void unmapFile ()
+    {
+      if (m_mappedData)
+        static_cast<QFile *> (m_file)->unmap (m_mappedData);
+
+      m_mappedData = 0;
+      m_mappedSize = 0;
+      m_mappedPosition = 0;
+    }
+
   private:
     QTextCodec *m_codec;
     bool m_eof;
@@ -374,6 +750,14 @@ class TextLoader
     bool m_bomFound;
     bool m_firstRead;
     KEncodingProber::ProberType m_proberType;
+    bool m_allowMemoryMapping;
+    uchar *m_mappedData;
+    qint64 m_mappedSize;
+    qint64 m_mappedPosition;
+    QTextCodec *m_switchCodec;
+    bool m_asciiOnly;
+    qint64 m_readBytes;
+    qint64 m_decodedBytes;
 };
 
 }
@@ -0,0 +1,216 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "katetextloaderthread.h"
+#include "katetextblock.h"
+#include "katetextloader.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutexLocker>
+
+namespace Kate {
+
+/**
+ * publish loaded blocks at most every 50 ms, the first block is published at once
+ */
+static const int KATE_LOADER_PUBLISH_INTERVAL = 50;
+
+TextLoaderThread::TextLoaderThread (TextBuffer *buffer, const QString &filename, KEncodingProber::ProberType proberType
+  , QTextCodec *codec, QTextCodec *fallbackCodec, bool switchCodec, bool allowMemoryMapping
+  , bool compactLineStorage, int blockSize, int lineLengthLimit)
+  : m_buffer (buffer)
+  , m_filename (filename)
+  , m_proberType (proberType)
+  , m_codec (codec)
+  , m_fallbackCodec (fallbackCodec)
+  , m_switchCodec (switchCodec)
+  , m_allowMemoryMapping (allowMemoryMapping)
+  , m_compactLineStorage (compactLineStorage)
+  , m_blockSize (blockSize)
+  , m_lineLengthLimit (lineLengthLimit)
+  , m_abort (false)
+  , m_success (false)
+  , m_encodingErrors (false)
+  , m_tooLongLinesWrapped (false)
+  , m_textCodec (codec)
+  , m_bomFound (false)
+  , m_eol (TextBuffer::eolUnknown)
+  , m_bytesDecodedMoreThanOnce (0)
+{
+}
+
+TextLoaderThread::~TextLoaderThread ()
+{
+  // stop the thread, if still running
+  abort ();
+
+  // kill all blocks nobody did take
+  foreach (TextBlock *block, m_blocks) {
+    block->deleteBlockContent ();
+    delete block;
+  }
+}
+
+void TextLoaderThread::abort ()
+{
+  m_abort = true;
+  wait ();
+}
+
+QVector<TextBlock *> TextLoaderThread::takeBlocks ()
+{
+  QMutexLocker locker (&m_mutex);
+  QVector<TextBlock *> blocks = m_blocks;
+  m_blocks.clear ();
+  return blocks;
+}
+
+void TextLoaderThread::publishBlocks (QVector<TextBlock *> &blocks)
+{
+  if (blocks.isEmpty())
+    return;
+
+  // append to the list for the buffer, only notify if the buffer did take all old ones
+  bool notify = false;
+  {
+    QMutexLocker locker (&m_mutex);
+    notify = m_blocks.isEmpty ();
+    m_blocks += blocks;
+  }
+  blocks.clear ();
+
+  if (notify)
+    emit blocksAvailable ();
+}
+
+void TextLoaderThread::run ()
+{
+  /**
+   * construct the file loader for the given file, with correct prober type
+   */
+  Kate::TextLoader file (m_filename, m_proberType, m_allowMemoryMapping);
+  if (!file.open (m_codec, m_switchCodec ? m_fallbackCodec : 0))
+    return;
+
+  /**
+   * blocks not yet published + current block to fill
+   */
+  QVector<TextBlock *> blocks;
+  TextBlock *block = 0;
+  int lines = 0;
+  bool published = false;
+  QElapsedTimer publishTimer;
+  publishTimer.start ();
+
+  /**
+   * read in all lines, we have only one round, the codec was chosen by the detection stage
+   */
+  while (!file.eof() && !m_abort)
+  {
+    // read line
+    int offset = 0, length = 0;
+    const bool currentError = !file.readLine (offset, length);
+
+    /**
+     * neither byte order mark nor prober did find a codec, nothing was read until now
+     * retry with the fallback codec
+     */
+    if (!file.textCodec ()) {
+      if (!m_fallbackCodec || !file.open (m_fallbackCodec))
+        break;
+      continue;
+    }
+
+    m_encodingErrors = m_encodingErrors || currentError;
+
+    // get unicode data for this line
+    const QChar *unicodeData = file.unicode () + offset;
+
+    /**
+     * split lines, if too large
+     */
+    do {
+      const int lineLength = TextLoader::wrappedLineLength (unicodeData, length, m_lineLengthLimit);
+      if (lineLength < length)
+        m_tooLongLinesWrapped = true;
+      length -= lineLength;
+
+      // new block needed?
+      if (!block || block->lines() >= m_blockSize) {
+        if (block) {
+          block->finishAppending ();
+          blocks.append (block);
+        }
+        block = new TextBlock (m_buffer, lines);
+        block->m_lines.reserve (m_blockSize);
+      }
+
+      block->appendLine (unicodeData, lineLength, m_compactLineStorage);
+      unicodeData += lineLength;
+      ++lines;
+    } while (length > 0);
+
+    /**
+     * publish full blocks, the first one at once, to let the view show the start of the file
+     */
+    if (!blocks.isEmpty() && (!published || publishTimer.elapsed() >= KATE_LOADER_PUBLISH_INTERVAL)) {
+      publishBlocks (blocks);
+      published = true;
+      publishTimer.restart ();
+    }
+  }
+
+  /**
+   * aborted or failed, clean up, blocks are deleted by destructor
+   */
+  if (m_abort || !file.textCodec ()) {
+    if (block) {
+      block->deleteBlockContent ();
+      delete block;
+    }
+    foreach (TextBlock *pendingBlock, blocks) {
+      pendingBlock->deleteBlockContent ();
+      delete pendingBlock;
+    }
+    return;
+  }
+
+  /**
+   * publish the rest
+   */
+  if (block) {
+    block->finishAppending ();
+    blocks.append (block);
+  }
+  publishBlocks (blocks);
+
+  /**
+   * remember results
+   */
+  m_success = true;
+  m_textCodec = file.textCodec ();
+  m_bomFound = file.byteOrderMarkFound ();
+  m_eol = file.eol ();
+  m_mimeTypeForFilterDev = file.mimeTypeForFilterDev ();
+  m_digest = file.digest ();
+  m_bytesDecodedMoreThanOnce = file.bytesDecodedMoreThanOnce ();
+}
+
+}
@@ -0,0 +1,196 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_TEXTLOADERTHREAD_H
+#define KATE_TEXTLOADERTHREAD_H
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+#include <QtCore/QString>
+#include <QtCore/QTextCodec>
+
+#include <kencodingprober.h>
+
+#include "katetextbuffer.h"
+
+namespace Kate {
+
+class TextBlock;
+
+/**
+ * Thread to load a file in the background for a Kate::TextBuffer.
+ * The lines are decoded and split into detached blocks, not yet known to the buffer.
+ * Each time new blocks are ready, blocksAvailable() is emitted and the buffer
+ * takes them over in the gui thread with takeBlocks().
+ */
+class TextLoaderThread : public QThread
+{
+  Q_OBJECT
+
+  public:
+    /**
+     * Construct loader thread, call start() to begin loading.
+     * @param buffer buffer the blocks are created for, not touched by the thread
+     * @param filename file to load
+     * @param proberType prober type
+     * @param codec codec to use, 0 to use byte order mark or encoding prober
+     * @param fallbackCodec codec to use if the detection in the loader fails
+     * @param switchCodec allow the loader to switch to the fallback codec after an ascii only start
+     * @param allowMemoryMapping use memory mapping for uncompressed local files
+     * @param compactLineStorage store lines that fit into Latin-1 compact
+     * @param blockSize lines per block
+     * @param lineLengthLimit limit for line length, longer lines will be wrapped
+     */
+    TextLoaderThread (TextBuffer *buffer, const QString &filename, KEncodingProber::ProberType proberType
+      , QTextCodec *codec, QTextCodec *fallbackCodec, bool switchCodec, bool allowMemoryMapping
+      , bool compactLineStorage, int blockSize, int lineLengthLimit);
+
+    /**
+     * Destruct the thread, will abort loading and delete all not taken blocks.
+     */
+    ~TextLoaderThread ();
+
+    /**
+     * Abort loading, returns after the thread did stop.
+     */
+    void abort ();
+
+    /**
+     * Take all blocks loaded since the last call.
+     * The blocks are sorted and have the right start lines.
+     * @return loaded blocks, the caller takes ownership
+     */
+    QVector<TextBlock *> takeBlocks ();
+
+    /**
+     * File could be opened and read? Only valid after the thread is finished.
+     * @return success
+     */
+    bool success () const { return m_success; }
+
+    /**
+     * Encoding errors occurred? Only valid after the thread is finished.
+     * @return encoding errors
+     */
+    bool encodingErrors () const { return m_encodingErrors; }
+
+    /**
+     * Too long lines wrapped? Only valid after the thread is finished.
+     * @return too long lines wrapped
+     */
+    bool tooLongLinesWrapped () const { return m_tooLongLinesWrapped; }
+
+    /**
+     * Codec used for loading. Only valid after the thread is finished.
+     * @return used codec
+     */
+    QTextCodec *textCodec () const { return m_textCodec; }
+
+    /**
+     * Byte order mark found? Only valid after the thread is finished.
+     * @return bom found
+     */
+    bool byteOrderMarkFound () const { return m_bomFound; }
+
+    /**
+     * Detected end of line mode. Only valid after the thread is finished.
+     * @return eol mode
+     */
+    TextBuffer::EndOfLineMode eol () const { return m_eol; }
+
+    /**
+     * Mime type used to create filter dev. Only valid after the thread is finished.
+     * @return mime-type of filter device
+     */
+    const QString &mimeTypeForFilterDev () const { return m_mimeTypeForFilterDev; }
+
+    /**
+     * md5 digest of the file. Only valid after the thread is finished.
+     * @return digest
+     */
+    const QByteArray &digest () const { return m_digest; }
+
+    /**
+     * Bytes decoded more than once. Only valid after the thread is finished.
+     * @return bytes decoded in vain
+     */
+    qint64 bytesDecodedMoreThanOnce () const { return m_bytesDecodedMoreThanOnce; }
+
+  Q_SIGNALS:
+    /**
+     * New blocks are available, use takeBlocks() to get them.
+     * Emitted once per batch, not again before takeBlocks() was called.
+     */
+    void blocksAvailable ();
+
+  protected:
+    /**
+     * Do the loading.
+     */
+    void run ();
+
+  private:
+    /**
+     * Hand out the given blocks to the buffer, clears the list.
+     * @param blocks blocks to publish
+     */
+    void publishBlocks (QVector<TextBlock *> &blocks);
+
+  private:
+    TextBuffer *const m_buffer;
+    const QString m_filename;
+    const KEncodingProber::ProberType m_proberType;
+    QTextCodec *const m_codec;
+    QTextCodec *const m_fallbackCodec;
+    const bool m_switchCodec;
+    const bool m_allowMemoryMapping;
+    const bool m_compactLineStorage;
+    const int m_blockSize;
+    const int m_lineLengthLimit;
+
+    /**
+     * abort requested? checked once per line
+     */
+    volatile bool m_abort;
+
+    /**
+     * blocks ready for the buffer, protected by the mutex
+     */
+    QMutex m_mutex;
+    QVector<TextBlock *> m_blocks;
+
+    /**
+     * results, valid after thread finished
+     */
+    bool m_success;
+    bool m_encodingErrors;
+    bool m_tooLongLinesWrapped;
+    QTextCodec *m_textCodec;
+    bool m_bomFound;
+    TextBuffer::EndOfLineMode m_eol;
+    QString m_mimeTypeForFilterDev;
+    QByteArray m_digest;
+    qint64 m_bytesDecodedMoreThanOnce;
+};
+
+}
+
+#endif
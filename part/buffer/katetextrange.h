@@ -47,6 +47,9 @@ class KATEPART_TESTS_EXPORT TextRange : public KTextEditor::MovingRange {
   // this is a friend, block changes might invalidate ranges...
   friend class TextBlock;
 
+  // this is a friend, lines inserted or removed in one step might invalidate ranges, too
+  friend class TextBuffer;
+
   public:
     /**
      * Construct a text range.
@@ -0,0 +1,159 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+
+#include "config.h"
+
+#include "katetextsaver.h"
+
+#include <kde_file.h>
+#include <kfilterdev.h>
+
+namespace Kate {
+
+TextSaver::TextSaver (const QString &filename, const QString &mimeTypeForFilterDev, QTextCodec *codec
+  , bool generateByteOrderMark, TextBuffer::EndOfLineMode endOfLineMode)
+  : m_saveFile (filename)
+  , m_digestFile (&m_saveFile)
+  , m_file (0)
+  , m_deleteFile (false)
+  , m_mimeTypeForFilterDev (mimeTypeForFilterDev)
+  , m_codec (codec)
+  , m_generateByteOrderMark (generateByteOrderMark)
+  , m_eol ("\n")
+{
+  // our loved eol string ;)
+  if (endOfLineMode == TextBuffer::eolDos)
+    m_eol = QString ("\r\n");
+  else if (endOfLineMode == TextBuffer::eolMac)
+    m_eol = QString ("\r");
+}
+
+TextSaver::~TextSaver ()
+{
+  // not finished? don't let KSaveFile replace the old file with a partial one
+  if (m_file)
+    abort ();
+}
+
+bool TextSaver::open ()
+{
+  /**
+   * use KSaveFile for save write + rename
+   */
+  if (!m_saveFile.open()) {
+    m_errorString = m_saveFile.errorString ();
+    return false;
+  }
+
+  /**
+   * compute the digest of the bytes written to disk on the way, no need to read the file again afterwards
+   */
+  m_digestFile.open (QIODevice::WriteOnly | QIODevice::Unbuffered);
+
+  /**
+   * construct correct filter device and try to open
+   */
+  m_file = KFilterDev::device (&m_digestFile, m_mimeTypeForFilterDev, false);
+  m_deleteFile = m_file;
+  if (!m_file)
+    m_file = &m_digestFile;
+
+  /**
+   * try to open, if new file
+   */
+  if (m_deleteFile) {
+    if (!m_file->open (QIODevice::WriteOnly)) {
+      m_errorString = m_file->errorString ();
+      abort ();
+      return false;
+    }
+  }
+
+  /**
+   * construct stream + disable Unicode headers
+   */
+  m_stream.setDevice (m_file);
+  m_stream.setCodec (QTextCodec::codecForName("UTF-16"));
+
+  // set the correct codec
+  m_stream.setCodec (m_codec);
+
+  // generate byte order mark?
+  m_stream.setGenerateByteOrderMark (m_generateByteOrderMark);
+  return true;
+}
+
+bool TextSaver::finish ()
+{
+  // flush stream
+  m_stream.flush ();
+  const bool streamOk = (m_stream.status() == QTextStream::Ok);
+  if (!streamOk)
+    m_errorString = m_file->errorString ();
+
+  // close and delete filter device, this writes the rest of the compressed data
+  closeFilterDevice ();
+  m_file = 0;
+
+  // flush file
+  if (!streamOk || !m_saveFile.flush()) {
+    if (streamOk)
+      m_errorString = m_saveFile.errorString ();
+    m_saveFile.abort ();
+    return false;
+  }
+
+#ifndef Q_OS_WIN
+  // ensure that the file is written to disk
+#ifdef HAVE_FDATASYNC
+  fdatasync (m_saveFile.handle());
+#else
+  fsync (m_saveFile.handle());
+#endif
+#endif
+
+  // did save work?
+  if (!m_saveFile.finalize()) {
+    m_errorString = m_saveFile.errorString ();
+    return false;
+  }
+
+  return true;
+}
+
+void TextSaver::abort ()
+{
+  closeFilterDevice ();
+  m_file = 0;
+  m_saveFile.abort ();
+}
+
+void TextSaver::closeFilterDevice ()
+{
+  m_stream.setDevice (0);
+  if (m_deleteFile) {
+    m_file->close ();
+    delete m_file;
+    m_deleteFile = false;
+  }
+}
+
+}
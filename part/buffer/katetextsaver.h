@@ -0,0 +1,162 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_TEXTSAVER_H
+#define KATE_TEXTSAVER_H
+
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+#include <QtCore/QTextCodec>
+#include <QtCore/QTextStream>
+
+#include <kcodecs.h> // KMD5
+#include <KSaveFile>
+
+#include "katetextbuffer.h"
+
+namespace Kate {
+
+/**
+ * Device passing all written data through to another device, computing the md5 digest on the way.
+ * Used to get the digest of a saved file without reading it again.
+ */
+class TextDigestDevice : public QIODevice
+{
+  public:
+    /**
+     * Construct device, open it for writing before use.
+     * @param device device to write the data to, must be open
+     */
+    TextDigestDevice (QIODevice *device)
+      : m_device (device)
+    {
+    }
+
+    /**
+     * md5 digest of all data written so far.
+     * @return digest, like KMD5::hexDigest()
+     */
+    QByteArray digest () { return m_digest.hexDigest (); }
+
+  protected:
+    qint64 readData (char *, qint64)
+    {
+      return -1;
+    }
+
+    qint64 writeData (const char *data, qint64 length)
+    {
+      const qint64 written = m_device->write (data, length);
+      if (written > 0)
+        m_digest.update (data, written);
+      return written;
+    }
+
+  private:
+    QIODevice *m_device;
+    KMD5 m_digest;
+};
+
+/**
+ * File saver, will handle encoding, compression and the safe write + rename of files.
+ * Used by Kate::TextBuffer::save() and by Kate::TextSaverThread for saving in the background.
+ * Only the text is passed in, it doesn't touch the buffer.
+ */
+class TextSaver
+{
+  public:
+    /**
+     * Construct file saver for the given file, call open() to start writing.
+     * @param filename file to save
+     * @param mimeTypeForFilterDev mime type to choose the compression for, as found on load
+     * @param codec codec to encode the text with
+     * @param generateByteOrderMark write a byte order mark?
+     * @param endOfLineMode end of line mode to use
+     */
+    TextSaver (const QString &filename, const QString &mimeTypeForFilterDev, QTextCodec *codec
+      , bool generateByteOrderMark, TextBuffer::EndOfLineMode endOfLineMode);
+
+    /**
+     * Destruct the saver, a not finished file is dropped, the old one on disk stays.
+     */
+    ~TextSaver ();
+
+    /**
+     * Open the temporary file to write to.
+     * @return success
+     */
+    bool open ();
+
+    /**
+     * Write text of a line.
+     * @param text text to write
+     */
+    void write (const QString &text) { m_stream << text; }
+
+    /**
+     * Write an end of line, in the end of line mode of this saver.
+     */
+    void writeEndOfLine () { m_stream << m_eol; }
+
+    /**
+     * Flush all data to disk and replace the file with the written one.
+     * @return success, on failure the old file stays
+     */
+    bool finish ();
+
+    /**
+     * Drop the written data, the old file stays.
+     */
+    void abort ();
+
+    /**
+     * md5 digest of the written file. Only valid after finish() did succeed.
+     * @return digest
+     */
+    QByteArray digest () { return m_digestFile.digest (); }
+
+    /**
+     * Error of the last failed operation.
+     * @return human readable error
+     */
+    const QString &errorString () const { return m_errorString; }
+
+  private:
+    /**
+     * Close and delete the filter device, if any.
+     */
+    void closeFilterDevice ();
+
+  private:
+    KSaveFile m_saveFile;
+    TextDigestDevice m_digestFile;
+    QIODevice *m_file;
+    bool m_deleteFile;
+    QTextStream m_stream;
+    const QString m_mimeTypeForFilterDev;
+    QTextCodec *const m_codec;
+    const bool m_generateByteOrderMark;
+    QString m_eol;
+    QString m_errorString;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+
+#include "katetextsaverthread.h"
+#include "katetextsaver.h"
+
+#include <QtCore/QElapsedTimer>
+
+namespace Kate {
+
+/**
+ * report progress at most every 100 ms
+ */
+static const int KATE_SAVER_PROGRESS_INTERVAL = 100;
+
+TextSaverThread::TextSaverThread (const QString &filename, const QVector<TextLineSnapshot> &lines, bool newLineAtEof
+  , const QString &mimeTypeForFilterDev, QTextCodec *codec, bool generateByteOrderMark, TextBuffer::EndOfLineMode endOfLineMode)
+  : m_filename (filename)
+  , m_lines (lines)
+  , m_newLineAtEof (newLineAtEof)
+  , m_mimeTypeForFilterDev (mimeTypeForFilterDev)
+  , m_codec (codec)
+  , m_generateByteOrderMark (generateByteOrderMark)
+  , m_endOfLineMode (endOfLineMode)
+  , m_abort (false)
+  , m_success (false)
+{
+}
+
+TextSaverThread::~TextSaverThread ()
+{
+  // stop the thread, if still running
+  abort ();
+}
+
+void TextSaverThread::abort ()
+{
+  m_abort = true;
+  wait ();
+}
+
+void TextSaverThread::run ()
+{
+  /**
+   * construct the file saver for the given file, with the settings of the buffer at the time of the snapshot
+   */
+  TextSaver saver (m_filename, m_mimeTypeForFilterDev, m_codec, m_generateByteOrderMark, m_endOfLineMode);
+  if (!saver.open ()) {
+    m_errorString = saver.errorString ();
+    return;
+  }
+
+  QElapsedTimer progressTimer;
+  progressTimer.start ();
+
+  /**
+   * dump the lines out, the saver drops the written data if we abort in between
+   */
+  for (int i = 0; i < m_lines.size() && !m_abort; ++i) {
+    saver.write (m_lines.at(i).text());
+
+    // append correct end of line string
+    if ((i+1) < m_lines.size() || (m_newLineAtEof && m_lines.at(i).length() > 0))
+      saver.writeEndOfLine ();
+
+    if (progressTimer.elapsed() >= KATE_SAVER_PROGRESS_INTERVAL) {
+      emit progress (i + 1);
+      progressTimer.restart ();
+    }
+  }
+
+  if (m_abort)
+    return;
+
+  /**
+   * replace the file, remember results
+   */
+  m_success = saver.finish ();
+  if (!m_success) {
+    m_errorString = saver.errorString ();
+    return;
+  }
+
+  m_digest = saver.digest ();
+}
+
+}
@@ -0,0 +1,123 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KATE_TEXTSAVERTHREAD_H
+#define KATE_TEXTSAVERTHREAD_H
+
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtCore/QString>
+#include <QtCore/QTextCodec>
+
+#include "katetextbuffer.h"
+#include "katetextline.h"
+
+namespace Kate {
+
+/**
+ * Thread to save a file in the background for a Kate::TextBuffer.
+ * It writes a snapshot of the lines, the buffer can be changed meanwhile.
+ * Encoding, compression, syncing to disk and the final rename all happen in the thread.
+ */
+class TextSaverThread : public QThread
+{
+  Q_OBJECT
+
+  public:
+    /**
+     * Construct saver thread, call start() to begin saving.
+     * @param filename file to save
+     * @param lines snapshot of the text of all lines
+     * @param newLineAtEof write an end of line behind the last line?
+     * @param mimeTypeForFilterDev mime type to choose the compression for
+     * @param codec codec to encode the text with
+     * @param generateByteOrderMark write a byte order mark?
+     * @param endOfLineMode end of line mode to use
+     */
+    TextSaverThread (const QString &filename, const QVector<TextLineSnapshot> &lines, bool newLineAtEof
+      , const QString &mimeTypeForFilterDev, QTextCodec *codec, bool generateByteOrderMark, TextBuffer::EndOfLineMode endOfLineMode);
+
+    /**
+     * Destruct the thread, will abort saving, the old file on disk stays.
+     */
+    ~TextSaverThread ();
+
+    /**
+     * Abort saving, returns after the thread did stop. The old file on disk stays.
+     */
+    void abort ();
+
+    /**
+     * File could be written and replaced? Only valid after the thread is finished.
+     * @return success
+     */
+    bool success () const { return m_success; }
+
+    /**
+     * Error, if saving failed. Only valid after the thread is finished.
+     * @return human readable error
+     */
+    const QString &errorString () const { return m_errorString; }
+
+    /**
+     * md5 digest of the written file. Only valid after the thread is finished with success.
+     * @return digest
+     */
+    const QByteArray &digest () const { return m_digest; }
+
+  Q_SIGNALS:
+    /**
+     * More lines were written.
+     * @param lines number of lines written until now
+     */
+    void progress (int lines);
+
+  protected:
+    /**
+     * Do the saving.
+     */
+    void run ();
+
+  private:
+    const QString m_filename;
+    const QVector<TextLineSnapshot> m_lines;
+    const bool m_newLineAtEof;
+    const QString m_mimeTypeForFilterDev;
+    QTextCodec *const m_codec;
+    const bool m_generateByteOrderMark;
+    const TextBuffer::EndOfLineMode m_endOfLineMode;
+
+    /**
+     * abort requested? checked once per line
+     */
+    volatile bool m_abort;
+
+    /**
+     * results, valid after thread finished
+     */
+    bool m_success;
+    QString m_errorString;
+    QByteArray m_digest;
+};
+
+}
+
+#endif
@@ -162,6 +162,8 @@ KateCompletionWidget::KateCompletionWidget(KateView* parent)
    */
   connect(&view()->doc()->buffer(), SIGNAL(lineWrapped(KTextEditor::Cursor)), this, SLOT(wrapLine(KTextEditor::Cursor)));
   connect(&view()->doc()->buffer(), SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
+  connect(&view()->doc()->buffer(), SIGNAL(linesInserted(int,QStringList)), this, SLOT(insertLines(int,QStringList)));
+  connect(&view()->doc()->buffer(), SIGNAL(linesRemoved(int,int)), this, SLOT(removeLines(int,int)));
   connect(&view()->doc()->buffer(), SIGNAL(textInserted(KTextEditor::Cursor,QString)), this, SLOT(insertText(KTextEditor::Cursor,QString)));
   connect(&view()->doc()->buffer(), SIGNAL(textRemoved(KTextEditor::Range,QString)), this, SLOT(removeText(KTextEditor::Range)));
 
@@ -1249,6 +1251,24 @@ void KateCompletionWidget::unwrapLine (int)
   m_automaticInvocationTimer->stop();
 }
 
+void KateCompletionWidget::insertLines (int, const QStringList &)
+{
+  m_lastInsertionByUser = !m_completionEditRunning;
+
+  // whole lines inserted, be done
+  m_automaticInvocationLine.clear();
+  m_automaticInvocationTimer->stop();
+}
+
+void KateCompletionWidget::removeLines (int, int)
+{
+  m_lastInsertionByUser = !m_completionEditRunning;
+
+  // just removal
+  m_automaticInvocationLine.clear();
+  m_automaticInvocationTimer->stop();
+}
+
 void KateCompletionWidget::insertText (const KTextEditor::Cursor &position, const QString &text)
 {
   m_lastInsertionByUser = !m_completionEditRunning;
@@ -176,6 +176,8 @@ class KATEPART_TESTS_EXPORT KateCompletionWidget : public QFrame
     void unwrapLine (int line);
     void insertText (const KTextEditor::Cursor &position, const QString &text);
     void removeText (const KTextEditor::Range &range);
+    void insertLines (int line, const QStringList &texts);
+    void removeLines (int from, int to);
     
   private:
     void updateAndShow();
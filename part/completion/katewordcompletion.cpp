@@ -25,6 +25,7 @@
 #include "kateconfig.h"
 #include "katedocument.h"
 #include "kateglobal.h"
+#include "katewordindex.h"
 
 #include <ktexteditor/variableinterface.h>
 #include <ktexteditor/movingrange.h>
@@ -47,7 +48,8 @@
 
 #include <QtCore/QRegExp>
 #include <QtCore/QString>
-#include <QtCore/QSet>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
 #include <QtGui/QSpinBox>
 #include <QtGui/QLabel>
 #include <QtGui/QLayout>
@@ -56,6 +58,8 @@
 #include <QtGui/QCheckBox>
 
 #include <kdebug.h>
+
+#include <limits.h>
 //END
 
 //BEGIN KateWordCompletionModel
@@ -72,8 +76,8 @@ KateWordCompletionModel::~KateWordCompletionModel()
 void KateWordCompletionModel::saveMatches( KTextEditor::View* view,
                         const KTextEditor::Range& range)
 {
+  // already ranked, keep that order
   m_matches = allMatches( view, range );
-  m_matches.sort();
 }
 
 QVariant KateWordCompletionModel::data(const QModelIndex& index, int role) const
@@ -199,42 +203,114 @@ void KateWordCompletionModel::completionInvoked(KTextEditor::View* view, const K
 }
 
 
-// Scan throughout the entire document for possible completions,
-// ignoring any dublets
+namespace {
+
+/**
+ * a completion candidate with the values it is ranked by
+ */
+struct RankedWord
+{
+  QString word;
+  int distance;      // lines between cursor and nearest occurrence, INT_MAX if not near
+  int documentCount; // occurrences in the document of the view
+  int count;         // occurrences in all documents
+};
+
+/**
+ * near words first, then the words used most in the document, then in all documents
+ */
+bool rankedWordLessThan( const RankedWord &a, const RankedWord &b )
+{
+  if ( a.distance != b.distance )
+    return a.distance < b.distance;
+  if ( a.documentCount != b.documentCount )
+    return a.documentCount > b.documentCount;
+  if ( a.count != b.count )
+    return a.count > b.count;
+  return a.word < b.word;
+}
+
+}
+
+// Look up the possible completions in the word index of all open documents,
+// ranked by the distance to the cursor and by frequency
 const QStringList KateWordCompletionModel::allMatches( KTextEditor::View *view, const KTextEditor::Range &range ) const
 {
-  QStringList l;
-  QRegExp re( "\\b(" + view->document()->text( range ) + "\\w{1,})" );
-  QSet<QString> seen;
+  KateWordIndex *index = KateGlobal::self()->wordIndex();
+  KTextEditor::Document *doc = view->document();
+
+  const QString prefix = doc->text( range );
+  const QStringList words = index->wordsWithPrefix( prefix );
+  if ( words.isEmpty() )
+    return QStringList();
+
+  // typing in the middle of a word: the word itself is no completion, unless it is used elsewhere
+  const int cursorLine = range.start().line();
+  const int cursorColumn = range.start().column();
+  const QString line = doc->line( cursorLine );
+  int wordEnd = range.end().column();
+  while ( wordEnd < line.length() && KateWordIndex::isWordCharacter( line.at( wordEnd ) ) )
+    ++wordEnd;
+  const QString current = line.mid( cursorColumn, wordEnd - cursorColumn );
 
   /**
-   * scan only a range of the document to not die for LARGE files
+   * proximity: scan only a few lines around the cursor, the index did the rest
    */
-  const int lineLimit = 4096;
-  int start = qMax(0, range.start().line() - lineLimit);
-  int end = qMin(view->document()->lines(), range.start().line() + lineLimit);
-  for (int i = start; i < end; ++i)
+  const int lineLimit = 64;
+  QHash<QString, int> distances;
+  const int start = qMax( 0, cursorLine - lineLimit );
+  const int end = qMin( doc->lines(), cursorLine + lineLimit + 1 );
+  for ( int i = start; i < end; ++i )
   {
-    QString s = view->document()->line( i );
-    int pos = 0;
-    while ( pos >= 0 )
+    const QString s = ( i == cursorLine ) ? line : doc->line( i );
+    const int distance = qAbs( i - cursorLine );
+    int wordStart = -1;
+    for ( int pos = 0; pos <= s.length(); ++pos )
     {
-      pos = re.indexIn( s, pos );
-      if ( pos >= 0 )
+      if ( pos < s.length() && KateWordIndex::isWordCharacter( s.at( pos ) ) )
       {
-        // typing in the middle of a word
-        if ( ! ( i == range.start().line() && pos == range.start().column() ) )
-        {
-          QString m = re.cap( 1 );
-          if ( ! seen.contains( m ) ) {
-            seen.insert( m );
-            l << m;
-          }
-        }
-        pos += re.matchedLength();
+        if ( wordStart < 0 )
+          wordStart = pos;
+        continue;
+      }
+
+      if ( wordStart >= 0 && pos - wordStart > prefix.length()
+           && !( i == cursorLine && wordStart == cursorColumn )
+           && s.midRef( wordStart, prefix.length() ) == prefix )
+      {
+        const QString m = s.mid( wordStart, pos - wordStart );
+        QHash<QString, int>::iterator it = distances.find( m );
+        if ( it == distances.end() )
+          distances.insert( m, distance );
+        else if ( distance < it.value() )
+          it.value() = distance;
       }
+      wordStart = -1;
     }
   }
+
+  QVector<RankedWord> ranked;
+  ranked.reserve( words.size() );
+  foreach ( const QString &word, words )
+  {
+    RankedWord r;
+    r.word = word;
+    r.count = index->count( word );
+    r.documentCount = index->count( doc, word );
+    r.distance = distances.value( word, INT_MAX );
+
+    if ( word == current && r.count == 1 )
+      continue;
+
+    ranked.append( r );
+  }
+
+  qSort( ranked.begin(), ranked.end(), rankedWordLessThan );
+
+  QStringList l;
+  l.reserve( ranked.size() );
+  foreach ( const RankedWord &r, ranked )
+    l << r.word;
   return l;
 }
 
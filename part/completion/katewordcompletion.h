@@ -28,6 +28,7 @@
 #include <ktexteditor/codecompletionmodel.h>
 #include <ktexteditor/configpage.h>
 #include "codecompletionmodelcontrollerinterfacev4.h"
+#include "katepartprivate_export.h"
 #include <kxmlguiclient.h>
 
 #include <QtCore/QEvent>
@@ -37,7 +38,7 @@
 #include <kdebug.h>
 
 
-class KateWordCompletionModel : public KTextEditor::CodeCompletionModel2, public KTextEditor::CodeCompletionModelControllerInterface4
+class KATEPART_TESTS_EXPORT KateWordCompletionModel : public KTextEditor::CodeCompletionModel2, public KTextEditor::CodeCompletionModelControllerInterface4
 {
   Q_OBJECT
   Q_INTERFACES(KTextEditor::CodeCompletionModelControllerInterface4)
@@ -0,0 +1,298 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "katewordindex.h"
+#include "katewordindex.moc"
+
+#include "katedocument.h"
+
+/**
+ * lines counted per chunk, before the event loop gets control again
+ */
+static const int KATE_WORD_INDEX_CHUNK = 2048;
+
+KateWordIndex::KateWordIndex (QObject *parent)
+  : QObject (parent)
+{
+  m_countTimer.setSingleShot (true);
+  m_countTimer.setInterval (0);
+  connect (&m_countTimer, SIGNAL(timeout()), this, SLOT(countNextChunk()));
+}
+
+KateWordIndex::~KateWordIndex ()
+{
+}
+
+void KateWordIndex::addDocument (KateDocument *doc)
+{
+  if (m_documents.contains (doc))
+    return;
+
+  m_documents.insert (doc, WordCounts ());
+  countDocument (doc);
+
+  connect (doc, SIGNAL(textInserted(KTextEditor::Document*,KTextEditor::Range)),
+           this, SLOT(textInserted(KTextEditor::Document*,KTextEditor::Range)));
+  connect (doc, SIGNAL(textRemoved(KTextEditor::Document*,KTextEditor::Range,QString)),
+           this, SLOT(textRemoved(KTextEditor::Document*,KTextEditor::Range,QString)));
+}
+
+void KateWordIndex::removeDocument (KateDocument *doc)
+{
+  QHash<KTextEditor::Document *, WordCounts>::iterator it = m_documents.find (doc);
+  if (it == m_documents.end ())
+    return;
+
+  // the connections go away with the document
+  clearCounts (it.value ());
+  m_documents.erase (it);
+  m_pendingLines.remove (doc);
+}
+
+QStringList KateWordIndex::wordsWithPrefix (const QString &prefix) const
+{
+  QStringList words;
+
+  // binary search for the first word >= prefix, all words with the prefix follow it
+  QMap<QString, int>::const_iterator it = m_words.lowerBound (prefix);
+  if (it != m_words.constEnd () && it.key () == prefix)
+    ++it;
+
+  for (; it != m_words.constEnd () && it.key ().startsWith (prefix); ++it)
+    words.append (it.key ());
+
+  return words;
+}
+
+int KateWordIndex::count (KTextEditor::Document *doc, const QString &word) const
+{
+  QHash<KTextEditor::Document *, WordCounts>::const_iterator it = m_documents.constFind (doc);
+  if (it == m_documents.constEnd ())
+    return 0;
+
+  return it.value ().value (word);
+}
+
+void KateWordIndex::textInserted (KTextEditor::Document *document, const KTextEditor::Range &range)
+{
+  QHash<KTextEditor::Document *, WordCounts>::iterator it = m_documents.find (document);
+  if (it == m_documents.end ())
+    return;
+
+  KateDocument *doc = static_cast<KateDocument *> (document);
+  WordCounts &counts = it.value ();
+
+  // new text for the whole document, e.g. after loading: count again
+  if (!doc->isEditRunning ()) {
+    clearCounts (counts);
+    countDocument (doc);
+    return;
+  }
+
+  const int startLine = range.start ().line ();
+  const int endLine = range.end ().line ();
+
+  // insertion into the lines not yet counted? they are counted later, with the new text
+  QHash<KTextEditor::Document *, int>::iterator pending = m_pendingLines.find (document);
+  if (pending != m_pendingLines.end ()) {
+    if (startLine >= pending.value ())
+      return;
+
+    pending.value () += endLine - startLine;
+  }
+
+  const int startColumn = range.start ().column ();
+  const int endColumn = range.end ().column ();
+
+  const QString first = doc->line (startLine);
+  const QString last = (endLine == startLine) ? first : doc->line (endLine);
+
+  // extend the range to the words touching it
+  int start = startColumn;
+  while (start > 0 && isWordCharacter (first.at (start - 1)))
+    --start;
+
+  int end = endColumn;
+  while (end < last.size () && isWordCharacter (last.at (end)))
+    ++end;
+
+  // before the insertion, the parts left and right of the range were one word
+  countWords (counts, first.mid (start, startColumn - start) + last.mid (endColumn, end - endColumn), -1);
+
+  if (startLine == endLine) {
+    countWords (counts, first.mid (start, end - start), 1);
+    return;
+  }
+
+  countWords (counts, first.mid (start), 1);
+  for (int line = startLine + 1; line < endLine; ++line)
+    countWords (counts, doc->line (line), 1);
+  countWords (counts, last.left (end), 1);
+}
+
+void KateWordIndex::textRemoved (KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText)
+{
+  QHash<KTextEditor::Document *, WordCounts>::iterator it = m_documents.find (document);
+  if (it == m_documents.end ())
+    return;
+
+  KateDocument *doc = static_cast<KateDocument *> (document);
+  WordCounts &counts = it.value ();
+
+  // the whole document is about to be cleared, e.g. before loading: drop its words
+  if (!doc->isEditRunning ()) {
+    clearCounts (counts);
+    return;
+  }
+
+  // removal in the lines not yet counted? they are counted later, without the old text
+  QHash<KTextEditor::Document *, int>::iterator pending = m_pendingLines.find (document);
+  if (pending != m_pendingLines.end ()) {
+    const int startLine = range.start ().line ();
+    const int endLine = range.end ().line ();
+    if (startLine >= pending.value ())
+      return;
+
+    // removal ended in counted lines: they move up
+    if (endLine < pending.value ()) {
+      pending.value () -= endLine - startLine;
+    } else {
+      // the joined start line holds text not yet counted: uncount the counted part, count it again later
+      const QStringList oldLines = oldText.split (QLatin1Char ('\n'));
+      const int countedLines = pending.value () - startLine;
+      countWords (counts, doc->line (startLine).left (range.start ().column ()) + oldLines.at (0), -1);
+      for (int i = 1; i < countedLines && i < oldLines.size (); ++i)
+        countWords (counts, oldLines.at (i), -1);
+
+      pending.value () = startLine;
+      return;
+    }
+  }
+
+  // after the removal, the parts left and right of the range are joined on the start line
+  const QString line = doc->line (range.start ().line ());
+  const int column = qMin (range.start ().column (), line.size ());
+
+  int start = column;
+  while (start > 0 && isWordCharacter (line.at (start - 1)))
+    --start;
+
+  int end = column;
+  while (end < line.size () && isWordCharacter (line.at (end)))
+    ++end;
+
+  countWords (counts, line.mid (start, column - start) + oldText + line.mid (column, end - column), -1);
+  countWords (counts, line.mid (start, end - start), 1);
+}
+
+void KateWordIndex::countWords (WordCounts &counts, const QString &text, int delta)
+{
+  const QChar *unicode = text.unicode ();
+  const int size = text.size ();
+
+  int start = -1;
+  for (int i = 0; i <= size; ++i) {
+    if (i < size && isWordCharacter (unicode[i])) {
+      if (start < 0)
+        start = i;
+      continue;
+    }
+
+    if (start >= 0) {
+      countWord (counts, text.mid (start, i - start), delta);
+      start = -1;
+    }
+  }
+}
+
+void KateWordIndex::countWord (WordCounts &counts, const QString &word, int delta)
+{
+  WordCounts::iterator it = counts.find (word);
+
+  if (delta > 0) {
+    if (it == counts.end ())
+      counts.insert (word, delta);
+    else
+      it.value () += delta;
+
+    // the global index shares the key with the document table
+    m_words[word] += delta;
+    return;
+  }
+
+  // never count below zero, the tables stay consistent whatever the signals say
+  if (it == counts.end ())
+    return;
+
+  if ((it.value () += delta) <= 0)
+    counts.erase (it);
+
+  QMap<QString, int>::iterator global = m_words.find (word);
+  if (global != m_words.end () && (global.value () += delta) <= 0)
+    m_words.erase (global);
+}
+
+void KateWordIndex::clearCounts (WordCounts &counts)
+{
+  for (WordCounts::const_iterator it = counts.constBegin (); it != counts.constEnd (); ++it) {
+    QMap<QString, int>::iterator global = m_words.find (it.key ());
+    if (global != m_words.end () && (global.value () -= it.value ()) <= 0)
+      m_words.erase (global);
+  }
+
+  counts.clear ();
+}
+
+void KateWordIndex::countDocument (KateDocument *doc)
+{
+  // counted from the event loop, no long stall after loading a large file
+  m_pendingLines.insert (doc, 0);
+  m_countTimer.start ();
+}
+
+void KateWordIndex::countPending (int maxLines)
+{
+  QHash<KTextEditor::Document *, int>::iterator it = m_pendingLines.begin ();
+  while (it != m_pendingLines.end () && maxLines != 0) {
+    KateDocument *doc = static_cast<KateDocument *> (it.key ());
+    WordCounts &counts = m_documents[doc];
+
+    // textCopy keeps compact stored lines compact
+    int line = it.value ();
+    for (; line < doc->lines () && maxLines != 0; ++line, --maxLines)
+      countWords (counts, doc->plainKateTextLine (line)->textCopy (), 1);
+
+    if (line < doc->lines ()) {
+      it.value () = line;
+      break;
+    }
+
+    it = m_pendingLines.erase (it);
+  }
+}
+
+void KateWordIndex::countNextChunk ()
+{
+  countPending (KATE_WORD_INDEX_CHUNK);
+  if (hasPending ())
+    m_countTimer.start ();
+}
+
+// kate: space-indent on; indent-width 2; replace-tabs on;
@@ -0,0 +1,226 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_WORD_INDEX_H
+#define KATE_WORD_INDEX_H
+
+#include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+#include <ktexteditor/range.h>
+
+#include "katepartprivate_export.h"
+
+class KateDocument;
+
+namespace KTextEditor {
+  class Document;
+}
+
+/**
+ * Index of the words of all documents, used by the word completion.
+ *
+ * Each registered document has its own table of word frequencies, the sum of
+ * all tables is kept sorted by word, a prefix query is a binary search plus
+ * a walk over the k words with that prefix.
+ *
+ * The tables follow the edits of the documents: for each inserted or removed
+ * text only the words touching the changed range are counted again.
+ * The whole text of a document is counted in chunks from the event loop, queries
+ * only see the lines counted so far, edits of not yet counted lines are skipped.
+ * Words are runs of letters, numbers, marks and underscores, like for the
+ * completion range.
+ */
+class KATEPART_TESTS_EXPORT KateWordIndex : public QObject
+{
+  Q_OBJECT
+
+  public:
+    /**
+     * Construct an empty index.
+     * @param parent parent object
+     */
+    explicit KateWordIndex (QObject *parent = 0);
+
+    /**
+     * Destruct the index.
+     */
+    ~KateWordIndex ();
+
+    /**
+     * Start to index a document, its current text is counted in chunks, later
+     * changes are tracked through the textInserted/textRemoved signals.
+     * @param doc document to index
+     */
+    void addDocument (KateDocument *doc);
+
+    /**
+     * Stop to index a document, its words are removed from the index.
+     * Doesn't access the document, this is called by its destructor.
+     * @param doc document to remove
+     */
+    void removeDocument (KateDocument *doc);
+
+    /**
+     * All words starting with the prefix, excluding the prefix itself.
+     * @param prefix prefix to search, case sensitive
+     * @return words in sorted order
+     */
+    QStringList wordsWithPrefix (const QString &prefix) const;
+
+    /**
+     * Count not yet counted lines of the documents now.
+     * @param maxLines maximal number of lines to count, -1 for all
+     */
+    void countPending (int maxLines = -1);
+
+    /**
+     * Are there lines not yet counted?
+     * @return lines pending
+     */
+    bool hasPending () const
+    {
+      return !m_pendingLines.isEmpty ();
+    }
+
+    /**
+     * Number of occurrences of a word in all documents.
+     * @param word word to count
+     * @return number of occurrences
+     */
+    int count (const QString &word) const
+    {
+      return m_words.value (word);
+    }
+
+    /**
+     * Number of occurrences of a word in one document.
+     * @param doc document to look at
+     * @param word word to count
+     * @return number of occurrences, 0 for not indexed documents
+     */
+    int count (KTextEditor::Document *doc, const QString &word) const;
+
+    /**
+     * Number of different words in all documents.
+     * @return size of the index
+     */
+    int size () const
+    {
+      return m_words.size ();
+    }
+
+    /**
+     * Is this character part of a word?
+     * @param c character to check
+     * @return true for letters, numbers, marks and underscores
+     */
+    static bool isWordCharacter (const QChar &c)
+    {
+      return c.isLetterOrNumber () || c.isMark () || c == QLatin1Char ('_');
+    }
+
+  private Q_SLOTS:
+    /**
+     * Count the words touching the inserted text again.
+     * Insertions outside of an editing transaction replace the whole text,
+     * like after loading a file, then the document is counted again.
+     * @param document changed document
+     * @param range inserted range
+     */
+    void textInserted (KTextEditor::Document *document, const KTextEditor::Range &range);
+
+    /**
+     * Count the words touching the removed text again.
+     * Removals outside of an editing transaction clear the whole text,
+     * like before loading a file, then the words of the document are dropped.
+     * @param document changed document
+     * @param range removed range
+     * @param oldText removed text
+     */
+    void textRemoved (KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText);
+
+    /**
+     * Count the next chunk of pending lines, restart the timer if more are left.
+     */
+    void countNextChunk ();
+
+  private:
+    /**
+     * word frequencies of one document
+     */
+    typedef QHash<QString, int> WordCounts;
+
+    /**
+     * Add the words of a text to a document table and the global index.
+     * @param counts table of the document
+     * @param text text to split into words
+     * @param delta +1 to add the words, -1 to remove them
+     */
+    void countWords (WordCounts &counts, const QString &text, int delta);
+
+    /**
+     * Add or remove one occurrence of a word.
+     * @param counts table of the document
+     * @param word word to count
+     * @param delta +1 or -1
+     */
+    void countWord (WordCounts &counts, const QString &word, int delta);
+
+    /**
+     * Remove all words of a document table from the global index.
+     * @param counts table of the document, cleared afterwards
+     */
+    void clearCounts (WordCounts &counts);
+
+    /**
+     * Schedule counting all lines of a document.
+     * @param doc document to count, its table must be empty
+     */
+    void countDocument (KateDocument *doc);
+
+  private:
+    /**
+     * tables of all indexed documents
+     */
+    QHash<KTextEditor::Document *, WordCounts> m_documents;
+
+    /**
+     * sum of all tables, sorted by word
+     */
+    QMap<QString, int> m_words;
+
+    /**
+     * for documents not yet counted completely, the first line not yet counted
+     */
+    QHash<KTextEditor::Document *, int> m_pendingLines;
+
+    /**
+     * timer to count the pending lines in chunks
+     */
+    QTimer m_countTimer;
+};
+
+#endif
+
+// kate: space-indent on; indent-width 2; replace-tabs on;
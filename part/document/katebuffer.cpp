@@ -42,8 +42,10 @@
 #include <kmimetype.h>
 
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QTextStream>
 #include <QtCore/QTimer>
+#include <QtCore/QTime>
 #include <QtCore/QTextCodec>
 #include <QtCore/QDate>
 
@@ -54,6 +56,26 @@
  */
 static const int KATE_MAX_DYNAMIC_CONTEXTS = 512;
 
+/**
+ * Local files larger than this are loaded in the background, 16 MB per default
+ */
+static const qint64 KATE_BACKGROUND_LOADING_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Views get at most this many lines highlighted at once, more are done in the background
+ */
+static const int KATE_HL_SYNC_LINES = 4096;
+
+/**
+ * Lines highlighted per step of the background highlighting, the time is checked after each step
+ */
+static const int KATE_HL_BACKGROUND_STEP = 256;
+
+/**
+ * Time slice of the background highlighting in milliseconds, the event loop runs in between
+ */
+static const int KATE_HL_BACKGROUND_SLICE = 20;
+
 /**
  * Create an empty buffer. (with one block with one empty line)
  */
@@ -66,10 +88,24 @@ KateBuffer::KateBuffer(KateDocument *doc)
    m_regionTree (this),
    m_tabWidth (8),
    m_lineHighlighted (0),
+   m_lineHighlightedStale (0),
+   m_highlightTarget (-1),
    m_maxDynamicContexts (KATE_MAX_DYNAMIC_CONTEXTS)
 {
   // we need kate global to stay alive
   KateGlobal::incRef ();
+
+  // lines of loaded files are only converted to QString once they are needed
+  setCompactLineStorage (true);
+
+  // background loading, keep the folding tree in sync and adopt the settings of the file at the end
+  connect (this, SIGNAL(loadingProgress(QString,int)), this, SLOT(backgroundLoadingProgress()));
+  connect (this, SIGNAL(loadingFinished(QString,bool,bool,bool)), this, SLOT(backgroundLoadingFinished(QString,bool,bool,bool)));
+
+  // background highlighting, one time slice per timeout, events are handled in between
+  m_highlightTimer.setSingleShot (true);
+  m_highlightTimer.setInterval (0);
+  connect (&m_highlightTimer, SIGNAL(timeout()), this, SLOT(backgroundHighlighting()));
 }
 
 /**
@@ -120,9 +156,12 @@ void KateBuffer::editEnd ()
 
   /**
    * if we don't touch the highlighted area => fine
+   * the old highlighting of the changed lines can't be reused
    */
-  if (editingMinimalLineChanged() > m_lineHighlighted)
+  if (editingMinimalLineChanged() > m_lineHighlighted) {
+    m_lineHighlightedStale = qMin (m_lineHighlightedStale, editingMinimalLineChanged());
     return;
+  }
 
   /**
    * look one line too far, needed for linecontinue stuff
@@ -158,6 +197,9 @@ void KateBuffer::clear()
 
   // back to line 0 with hl
   m_lineHighlighted = 0;
+  m_lineHighlightedStale = 0;
+  m_highlightTarget = -1;
+  m_highlightTimer.stop ();
 }
 
 bool KateBuffer::openFile (const QString &m_file, bool enforceTextCodec)
@@ -179,9 +221,26 @@ bool KateBuffer::openFile (const QString &m_file, bool enforceTextCodec)
   // then, try to load the file
   m_brokenEncoding = false;
   m_tooLongLinesWrapped = false;
+
+  /**
+   * large files are loaded in the background, the document gets the first lines at once
+   * the settings of the file are taken over in backgroundLoadingFinished
+   */
+  if (QFileInfo (m_file).size() >= KATE_BACKGROUND_LOADING_SIZE)
+    return loadInBackground (m_file, enforceTextCodec);
+
   if (!load (m_file, m_brokenEncoding, m_tooLongLinesWrapped, enforceTextCodec))
     return false;
 
+  // take over settings found in the file
+  adoptLoadedFileSettings ();
+
+  // okay, loading did work
+  return true;
+}
+
+void KateBuffer::adoptLoadedFileSettings ()
+{
   // save back encoding
   m_doc->config()->setEncoding (textCodec()->name());
 
@@ -195,9 +254,22 @@ bool KateBuffer::openFile (const QString &m_file, bool enforceTextCodec)
 
   // fix region tree
   m_regionTree.fixRoot (lines ());
+}
 
-  // okay, loading did work
-  return true;
+void KateBuffer::backgroundLoadingProgress ()
+{
+  // more lines there, fix region tree
+  m_regionTree.fixRoot (lines ());
+}
+
+void KateBuffer::backgroundLoadingFinished (const QString &, bool success, bool encodingErrors, bool tooLongLinesWrapped)
+{
+  if (!success)
+    return;
+
+  m_brokenEncoding = encodingErrors;
+  m_tooLongLinesWrapped = tooLongLinesWrapped;
+  adoptLoadedFileSettings ();
 }
 
 bool KateBuffer::canEncode ()
@@ -269,6 +341,65 @@ void KateBuffer::ensureHighlighted (int line, int lookAhead)
   doHighlight ( m_lineHighlighted, end, false );
 }
 
+bool KateBuffer::requestHighlighting (int line, int lookAhead)
+{
+  // valid line at all?
+  if (line < 0 || line >= lines ())
+    return true;
+
+  // already hl up-to-date for this line?
+  if (line < m_lineHighlighted)
+    return true;
+
+  // only some lines missing, do them at once
+  if (line - m_lineHighlighted < KATE_HL_SYNC_LINES) {
+    ensureHighlighted (line, lookAhead);
+    return true;
+  }
+
+  // let the background highlighting go on until this line
+  m_highlightTarget = qMax (m_highlightTarget, qMin (line + lookAhead, lines () - 1));
+  if (!m_highlightTimer.isActive ())
+    m_highlightTimer.start ();
+
+  return false;
+}
+
+void KateBuffer::backgroundHighlighting ()
+{
+  // no hl or nothing more to do
+  m_highlightTarget = qMin (m_highlightTarget, lines () - 1);
+  if (!m_highlight || m_highlightTarget < m_lineHighlighted) {
+    m_highlightTarget = -1;
+    return;
+  }
+
+  // never highlight in the middle of some editing, try again later
+  if (editingTransactions () > 0) {
+    m_highlightTimer.start ();
+    return;
+  }
+
+  // highlight in steps until the time slice is used up
+  const int startLine = m_lineHighlighted;
+  QTime t;
+  t.start ();
+  while (m_lineHighlighted <= m_highlightTarget && t.elapsed () < KATE_HL_BACKGROUND_SLICE)
+    doHighlight (m_lineHighlighted, qMin (m_lineHighlighted + KATE_HL_BACKGROUND_STEP - 1, m_highlightTarget), false);
+
+  // publish the new highlighting to the views
+  if (m_lineHighlighted > startLine) {
+    emit tagLines (startLine, m_lineHighlighted - 1);
+    m_doc->repaintViews (true);
+  }
+
+  // more to do? continue after the pending events are handled
+  if (m_lineHighlighted <= m_highlightTarget)
+    m_highlightTimer.start ();
+  else
+    m_highlightTarget = -1;
+}
+
 void KateBuffer::wrapLine (const KTextEditor::Cursor &position)
 {
   // call original
@@ -277,35 +408,43 @@ void KateBuffer::wrapLine (const KTextEditor::Cursor &position)
   if (m_lineHighlighted > position.line()+1)
     m_lineHighlighted++;
 
+  if (m_lineHighlightedStale > position.line()+1)
+    m_lineHighlightedStale++;
+
   m_regionTree.lineHasBeenInserted (position.line(), position.column());
 
 }
 
-void KateBuffer::unwrapLines (int from, int to)
+void KateBuffer::insertLines (int line, const QStringList &texts)
 {
-  // catch out of range access, should never happen
-  Q_ASSERT(from >= 0);
-  Q_ASSERT(to + 1 <= lines());
-
-  for (int line = to; line >= from; --line) {
-      if (line + 1 < lines()) {
-          Kate::TextBuffer::unwrapLine (line + 1);
-        
-          if (m_lineHighlighted > (line + 1))
-            --m_lineHighlighted;
-      }
+  // call original
+  Kate::TextBuffer::insertLines (line, texts);
 
-      // Line "0" can't be unwraped
-      // This call is used to unwrap the last line (if last line != 0)
-      // This call was used in the previous version too and it looks like the last
-      // line can't be unwraped without it
-      else if (line) {
-          Kate::TextBuffer::unwrapLine (line);
-        
-          if (m_lineHighlighted > line)
-            --m_lineHighlighted;
-      }
-  }
+  if (m_lineHighlighted > line)
+    m_lineHighlighted += texts.size();
+
+  if (m_lineHighlightedStale > line)
+    m_lineHighlightedStale += texts.size();
+
+  m_regionTree.linesHaveBeenInserted (line, texts.size());
+}
+
+void KateBuffer::removeLines (int from, int to)
+{
+  // call original
+  Kate::TextBuffer::removeLines (from, to);
+
+  const int count = to - from + 1;
+
+  if (m_lineHighlighted > to)
+    m_lineHighlighted -= count;
+  else if (m_lineHighlighted > from)
+    m_lineHighlighted = from;
+
+  if (m_lineHighlightedStale > to)
+    m_lineHighlightedStale -= count;
+  else if (m_lineHighlightedStale > from)
+    m_lineHighlightedStale = from;
 
   m_regionTree.linesHaveBeenRemoved (from, to);
 }
@@ -318,6 +457,9 @@ void KateBuffer::unwrapLine (int line)
   if (m_lineHighlighted > line)
     --m_lineHighlighted;
 
+  if (m_lineHighlightedStale > line)
+    --m_lineHighlightedStale;
+
   m_regionTree.linesHaveBeenRemoved (line, line);
 }
 
@@ -371,6 +513,7 @@ void KateBuffer::setHighlight(int hlMode)
 void KateBuffer::invalidateHighlighting()
 {
   m_lineHighlighted = 0;
+  m_lineHighlightedStale = 0;
 }
 
 void KateBuffer::updatePreviousNotEmptyLine(int current_line,bool addindent,int deindent)
@@ -438,6 +581,97 @@ bool KateBuffer::isEmptyLine(Kate::TextLine textline)
   return false;
 }
 
+void KateBuffer::codeBrackets (const Kate::TextLine &textLine, QVector<int> &brackets) const
+{
+  const QVector<int> &attributes = textLine->attributesList ();
+  int run = 0;
+  for (int column = 0; column < textLine->length (); ++column) {
+    if (Kate::TextBracketSummary::kind (textLine->at (column)) < 0)
+      continue;
+
+    // skip the attribute runs in front of the bracket, text not covered by any run has attribute 0
+    while (run < attributes.size() && attributes.at(run) + attributes.at(run + 1) <= column)
+      run += 3;
+
+    const int attribute = (run < attributes.size() && attributes.at(run) <= column) ? attributes.at(run + 2) : 0;
+    if (!m_highlight || m_highlight->attributeIsCode (attribute))
+      brackets.append (column);
+  }
+}
+
+void KateBuffer::lineBrackets (const Kate::TextLine &textLine, QVector<int> &brackets) const
+{
+  // the text changed since the line got highlighted, look at it again
+  if (!textLine->bracketsValid ()) {
+    codeBrackets (textLine, brackets);
+    return;
+  }
+
+  brackets = textLine->bracketsList ();
+}
+
+KTextEditor::Cursor KateBuffer::findUnmatchedBracket (const KTextEditor::Cursor &position, QChar bracket, int minLine, int maxLine)
+{
+  const int kind = Kate::TextBracketSummary::kind (bracket);
+  if (kind < 0 || position.line() < 0 || position.line() >= lines())
+    return KTextEditor::Cursor::invalid ();
+
+  const bool forward = !Kate::TextBracketSummary::isOpening (bracket);
+  minLine = qMax (minLine, 0);
+  maxLine = qMin (maxLine, lines() - 1);
+
+  // nesting depth, the bracket is found once it drops to 0
+  int depth = 1;
+  ensureHighlighted (position.line());
+  QVector<int> brackets;
+  for (int line = position.line(); forward ? (line <= maxLine) : (line >= minLine); line += forward ? 1 : -1) {
+    // skip the whole block, if we are at its border and the depth can't drop to 0 inside
+    int firstLine, lastLine;
+    Kate::TextBracketSummary summary;
+    if (line != position.line()) {
+      // the brackets of the whole block must be up to date, highlighting may change them
+      blockBracketSummary (line, firstLine, lastLine, summary);
+      ensureHighlighted (forward ? lastLine : line);
+      if (blockBracketSummary (line, firstLine, lastLine, summary)
+          && line == (forward ? firstLine : lastLine)
+          && firstLine >= minLine && lastLine <= maxLine
+          && isHighlighted (lastLine)) {
+        if (forward && depth + summary.minForward[kind] > 0) {
+          depth += summary.depthChange[kind];
+          line = lastLine;
+          continue;
+        }
+
+        if (!forward && depth + summary.minBackward[kind] > 0) {
+          depth -= summary.depthChange[kind];
+          line = firstLine;
+          continue;
+        }
+      }
+    }
+
+    // look at the brackets of the line, on the line of the position only in front of or behind it
+    Kate::TextLine textLine = plainLine (line);
+    brackets.clear ();
+    lineBrackets (textLine, brackets);
+    for (int i = 0; i < brackets.size(); ++i) {
+      const int column = brackets.at(forward ? i : (brackets.size() - 1 - i));
+      if (line == position.line() && (forward ? (column < position.column()) : (column >= position.column())))
+        continue;
+
+      const QChar c = textLine->at (column);
+      if (Kate::TextBracketSummary::kind (c) != kind)
+        continue;
+
+      depth += (Kate::TextBracketSummary::isOpening (c) == forward) ? 1 : -1;
+      if (depth == 0)
+        return KTextEditor::Cursor (line, column);
+    }
+  }
+
+  return KTextEditor::Cursor::invalid ();
+}
+
 void KateBuffer::doHighlight (int startLine, int endLine, bool invalidate)
 {
   // no hl around, no stuff to do
@@ -505,6 +739,11 @@ void KateBuffer::doHighlight (int startLine, int endLine, bool invalidate)
   bool indentContinueWhitespace=false;
   bool indentContinueNextWhitespace=false;
   bool ctxChanged = false;
+
+  // lines below this one still carry their old highlighting, which is valid again
+  // once a line ends in the same state as before, only used if we don't need to tag the lines
+  const int convergenceEnd = invalidate ? -1 : qMin (m_lineHighlightedStale, lines ());
+
   // loop over the lines of the block, from startline to endline or end of block
   // if stillcontinue forces us to do so
   for (; current_line < qMin (endLine+1, lines()); ++current_line)
@@ -514,9 +753,18 @@ void KateBuffer::doHighlight (int startLine, int endLine, bool invalidate)
 
     QVector<int> foldingList;
     ctxChanged = false;
+    const bool oldLineContinue = textLine->hlLineContinue ();
 
     m_highlight->doHighlight (prevLine.data(), textLine.data(), foldingList, ctxChanged);
 
+    // remember the code brackets for bracket matching, the summary of the block is outdated if they changed
+    QVector<int> brackets;
+    codeBrackets (textLine, brackets);
+    if (!textLine->bracketsValid () || brackets != textLine->bracketsList ()) {
+      textLine->setBrackets (brackets);
+      invalidateBracketSummary (current_line);
+    }
+
 #ifdef BUFFER_DEBUGGING
     // debug stuff
     kDebug( 13020 ) << "current line to hl: " << current_line;
@@ -743,16 +991,31 @@ void KateBuffer::doHighlight (int startLine, int endLine, bool invalidate)
       last_line_spellchecking=current_line;
     }
 
+    // the state at the end of this line is the old one, the following stale lines need no work
+    if (!stillcontinue && current_line >= m_lineHighlighted && current_line + 1 < convergenceEnd
+        && oldLineContinue == textLine->hlLineContinue ()) {
+#ifdef BUFFER_DEBUGGING
+      kDebug (13020) << "HIGHLIGHTING CONVERGED AT LINE: " << current_line << " SKIPPING TO: " << convergenceEnd;
+#endif
+      current_line = convergenceEnd - 1;
+      prevLine = plainLine (current_line);
+      continue;
+    }
+
     // move around the lines
     prevLine = textLine;
   }
 
   /**
    * perhaps we need to adjust the maximal highlighed line
+   * lines up to the old maximum keep their old highlighting until they are done again
    */
   int oldHighlighted = m_lineHighlighted;
-  if (ctxChanged || current_line > m_lineHighlighted)
+  if (ctxChanged || current_line > m_lineHighlighted) {
+    m_lineHighlightedStale = qMax (m_lineHighlightedStale, m_lineHighlighted);
     m_lineHighlighted = current_line;
+  }
+  m_lineHighlightedStale = qMax (m_lineHighlightedStale, m_lineHighlighted);
 
   // tag the changed lines !
   if (invalidate) {
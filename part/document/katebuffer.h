@@ -26,6 +26,7 @@
 #include "katepartprivate_export.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 
 class KateLineInfo;
 class KateDocument;
@@ -97,6 +98,7 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
 
     /**
      * Open a file, use the given filename
+     * Large files are loaded in the background, check isLoading() and wait for loadingFinished()
      * @param m_file filename to open
      * @param enforceTextCodec enforce to use only the set text codec
      * @return success
@@ -153,18 +155,42 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
      */
     void ensureHighlighted(int line, int lookAhead = 64);
 
+    /**
+     * Request highlighting of given line @p line, without blocking for long.
+     * If only a few lines are missing up to @p line, they are highlighted at once,
+     * like ensureHighlighted() does. Otherwise the highlighting runs in the background
+     * in time slices and tagLines() is emitted for the lines done, until @p line + @p lookAhead is reached.
+     * @param line line which should be highlighted
+     * @param lookAhead also highlight these following lines
+     * @return is the highlighting of @p line up-to-date now?
+     */
+    bool requestHighlighting (int line, int lookAhead = 64);
+
+    /**
+     * Is the highlighting of given line up-to-date?
+     * @param line line to check
+     * @return highlighting of @p line up-to-date?
+     */
+    bool isHighlighted (int line) const { return line < m_lineHighlighted; }
+
     /**
      * Return the total number of lines in the buffer.
      */
     inline int count() const { return lines(); }
 
     /**
-     * Unwrap given lines.
-     * @param from - first line of the block
-     * @param to - last line of the block
-     * @param lastLine - last line of the document
+     * Insert whole lines in front of the given line.
+     * @param line line in front of which the new lines are inserted, lines() to append them
+     * @param texts text of the new lines
      */
-    void unwrapLines (int from, int to);
+    void insertLines (int line, const QStringList &texts);
+
+    /**
+     * Remove whole lines, at least one line must remain.
+     * @param from first line to remove
+     * @param to last line to remove
+     */
+    void removeLines (int from, int to);
 
     /**
      * Unwrap given line.
@@ -178,6 +204,32 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
      */
     void wrapLine (const KTextEditor::Cursor &position);
 
+  private:
+    /**
+     * Take over encoding, eol and bom of the loaded file into the document config.
+     */
+    void adoptLoadedFileSettings ();
+
+  private Q_SLOTS:
+    /**
+     * Background loading appended lines.
+     */
+    void backgroundLoadingProgress ();
+
+    /**
+     * Background loading is done.
+     * @param filename loaded file
+     * @param success file got loaded
+     * @param encodingErrors were there problems occurred while decoding the file?
+     * @param tooLongLinesWrapped were too long lines found and wrapped?
+     */
+    void backgroundLoadingFinished (const QString &filename, bool success, bool encodingErrors, bool tooLongLinesWrapped);
+
+    /**
+     * Highlight the next lines up to m_highlightTarget, runs one time slice.
+     */
+    void backgroundHighlighting ();
+
   private:
      inline void addIndentBasedFoldingInformation(QVector<int> &foldingList,int linelength,bool addindent,int deindent);
      inline void updatePreviousNotEmptyLine(int current_line,bool addindent,int deindent);
@@ -215,6 +267,20 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
 
     const KateDocument* getDocument () { return m_doc; }
 
+    /**
+     * Find the unmatched code bracket in front of or behind a position.
+     * An opening bracket is searched backward, it must not be closed in front of the position,
+     * a closing bracket is searched forward, it must not be opened behind the position.
+     * Brackets in comments, strings and the like are skipped. The code brackets found while
+     * highlighting are used, whole blocks of lines without the wanted bracket are skipped at once.
+     * @param position position to start at, backward the characters in front of it are looked at, forward the ones starting with it
+     * @param bracket bracket to find, an opening one is searched backward, a closing one forward
+     * @param minLine first line to look at
+     * @param maxLine last line to look at
+     * @return position of the bracket, invalid if none found
+     */
+    KTextEditor::Cursor findUnmatchedBracket (const KTextEditor::Cursor &position, QChar bracket, int minLine, int maxLine);
+
   private:
     /**
      * Highlight information needs to be updated.
@@ -226,6 +292,20 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
     void doHighlight (int from, int to, bool invalidate);
     bool isEmptyLine(Kate::TextLine textline);
 
+    /**
+     * Find the code brackets of a line, using its current highlighting.
+     * @param textLine line to look at
+     * @param brackets will be filled with the columns of the code brackets
+     */
+    void codeBrackets (const Kate::TextLine &textLine, QVector<int> &brackets) const;
+
+    /**
+     * Code brackets of a line, the ones found while highlighting, if they are up-to-date.
+     * @param textLine line to look at
+     * @param brackets will be filled with the columns of the code brackets
+     */
+    void lineBrackets (const Kate::TextLine &textLine, QVector<int> &brackets) const;
+
   Q_SIGNALS:
     /**
      * Emittend if codefolding returned with a changed list
@@ -276,6 +356,22 @@ class KATEPART_TESTS_EXPORT KateBuffer : public Kate::TextBuffer
      */
     int m_lineHighlighted;
 
+    /**
+     * lines from m_lineHighlighted up to this line are unchanged since their last highlighting,
+     * their highlighting is valid again as soon as the context of one of them converges to its old value
+     */
+    int m_lineHighlightedStale;
+
+    /**
+     * line the background highlighting shall reach
+     */
+    int m_highlightTarget;
+
+    /**
+     * timer driving the background highlighting
+     */
+    QTimer m_highlightTimer;
+
     /**
      * number of dynamic contexts causing a full invalidation
      */
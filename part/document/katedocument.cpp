@@ -119,6 +119,7 @@ KateDocument::KateDocument ( bool bSingleViewMode, bool bBrowserView,
   editIsRunning(false),
   m_undoMergeAllEdits(false),
   m_undoManager(new KateUndoManager(this)),
+  m_searchWindow(new KateLineWindow()),
   m_editableMarks(markType01),
   m_annotationModel(0),
   m_isasking(0),
@@ -138,7 +139,8 @@ KateDocument::KateDocument ( bool bSingleViewMode, bool bBrowserView,
   m_fileChangedDialogsActivated(false),
   m_onTheFlyChecker(0),
   m_documentState (DocumentIdle),
-  m_readWriteStateBeforeLoading (false)
+  m_readWriteStateBeforeLoading (false),
+  m_reloadStatePending (false)
 {
   setComponentData ( KateGlobal::self()->componentData () );
 
@@ -197,6 +199,13 @@ KateDocument::KateDocument ( bool bSingleViewMode, bool bBrowserView,
   connect (this, SIGNAL(completed()), this, SLOT(slotCompleted()));
   connect (this, SIGNAL(canceled(QString)), this, SLOT(slotCanceled()));
 
+  /**
+   * large files are loaded by the buffer in the background
+   * show the lines as they arrive and finish the opening at the end
+   */
+  connect (m_buffer, SIGNAL(loadingProgress(QString,int)), this, SLOT(slotBufferLoadingProgress()));
+  connect (m_buffer, SIGNAL(loadingFinished(QString,bool,bool,bool)), this, SLOT(slotBufferLoadingFinished(QString,bool)));
+
   // update doc name
   updateDocName ();
 
@@ -239,6 +248,8 @@ KateDocument::~KateDocument()
   delete m_onTheFlyChecker;
   m_onTheFlyChecker = NULL;
 
+  delete m_searchWindow;
+
   clearDictionaryRanges();
 
   // Tell the world that we're about to close (== destruct)
@@ -562,6 +573,22 @@ bool KateDocument::insertText( const KTextEditor::Cursor& position, const QStrin
   static const QChar tabChar('\t');
   static const QChar spaceChar(' ');
 
+  // many lines and no tabs to replace: insert the lines in between in one step, e.g. for large pastes
+  if (!block && !(replacetabs && text.contains(tabChar)))
+  {
+    const QStringList textLines = text.split(newLineChar);
+    if (textLines.size() > 2)
+    {
+      editInsertText(currentLine, insertColumn, textLines.first());
+      editWrapLine(currentLine, insertColumn + textLines.first().length());
+      editInsertLines(currentLine + 1, textLines.mid(1, textLines.size() - 2));
+      editInsertText(currentLine + textLines.size() - 1, 0, textLines.last());
+
+      editEnd();
+      return true;
+    }
+  }
+
   int insertColumnExpanded = insertColumn;
   Kate::TextLine l = kateTextLine( currentLine );
   if (l)
@@ -717,11 +744,7 @@ bool KateDocument::insertLines( int line, const QStringList & text )
   if (line < 0 || line > lines())
     return false;
 
-  bool success = true;
-  foreach (const QString &string, text)
-    success &= editInsertLine (line++, string);
-
-  return success;
+  return editInsertLines (line, text);
 }
 
 bool KateDocument::removeLine( int line )
@@ -1291,6 +1314,67 @@ bool KateDocument::editInsertLine ( int line, const QString &s )
   return true;
 }
 
+bool KateDocument::editInsertLines ( int line, const QStringList &s )
+{
+  // verbose debug
+  EDIT_DEBUG << "editInsertLines" << line << s.size();
+
+  if (line < 0)
+    return false;
+
+  if (!isReadWrite())
+    return false;
+
+  if ( line > lines() )
+    return false;
+
+  // nothing to do, do nothing!
+  if (s.isEmpty())
+    return true;
+
+  editStart ();
+
+  m_undoManager->slotLinesInserted(line, s);
+
+  // insert all lines at once
+  m_buffer->insertLines (line, s);
+
+  QList<KTextEditor::Mark*> list;
+  for (QHash<int, KTextEditor::Mark*>::const_iterator i = m_marks.constBegin(); i != m_marks.constEnd(); ++i)
+  {
+    if( i.value()->line >= line )
+      list.append( i.value() );
+  }
+
+  for( int i=0; i < list.size(); ++i )
+    m_marks.take( list.at(i)->line );
+
+  for( int i=0; i < list.size(); ++i )
+  {
+    list.at(i)->line += s.size();
+    m_marks.insert( list.at(i)->line, list.at(i) );
+  }
+
+  if( !list.isEmpty() )
+    emit marksChanged( this );
+
+  const int endLine = line + s.size() - 1;
+  KTextEditor::Range rangeInserted(line, 0, endLine, s.last().length());
+
+  if (line) {
+    Kate::TextLine prevLine = plainKateTextLine(line - 1);
+    rangeInserted.start().setPosition(line - 1, prevLine->length());
+  } else {
+    rangeInserted.end().setPosition(endLine + 1, 0);
+  }
+
+  emit KTextEditor::Document::textInserted(this, rangeInserted);
+
+  editEnd ();
+
+  return true;
+}
+
 bool KateDocument::editRemoveLine ( int line )
 {
   return editRemoveLines(line, line);
@@ -1311,17 +1395,22 @@ bool KateDocument::editRemoveLines ( int from, int to )
     return editRemoveText(0, 0, kateTextLine(0)->length());
 
   editStart();
-  QStringList oldText;
-
-  for (int line = to; line >= from; line--) {
-    Kate::TextLine tl = m_buffer->line (line);
-    oldText.prepend(this->line(line));
-    m_undoManager->slotLineRemoved(line, this->line(line));
 
-    m_buffer->removeText (KTextEditor::Range (KTextEditor::Cursor (line, 0), KTextEditor::Cursor (line, tl->text().size())));
+  // the buffer always keeps one line: if all lines go, the first one is only cleared
+  int firstLine = from;
+  if (from == 0 && to == lastLine()) {
+    editRemoveText(0, 0, kateTextLine(0)->length());
+    firstLine = 1;
   }
 
-  m_buffer->unwrapLines(from, to);
+  QStringList oldText;
+  for (int line = firstLine; line <= to; ++line)
+    oldText.append(this->line(line));
+
+  m_undoManager->slotLinesRemoved(firstLine, oldText);
+
+  // remove all lines at once
+  m_buffer->removeLines(firstLine, to);
 
   QList<int> rmark;
   QList<int> list;
@@ -1347,18 +1436,20 @@ bool KateDocument::editRemoveLines ( int from, int to )
   if (!list.isEmpty())
     emit marksChanged(this);
 
-  KTextEditor::Range rangeRemoved(from, 0, to + 1, 0);
+  KTextEditor::Range rangeRemoved(firstLine, 0, to + 1, 0);
+  QString removedText = oldText.join("\n") + '\n';
 
-  if (to == lastLine() + to - from + 1) {
+  if (firstLine > lastLine()) {
+    // the last lines were removed, the line feed before them went away, not the one after them
     rangeRemoved.end().setPosition(to, oldText.last().length());
-    if (from > 0) {
-      Kate::TextLine prevLine = plainKateTextLine(from - 1);
-      rangeRemoved.start().setPosition(from - 1, prevLine->length());
-    }
+    removedText.chop(1);
+    Kate::TextLine prevLine = plainKateTextLine(firstLine - 1);
+    rangeRemoved.start().setPosition(firstLine - 1, prevLine->length());
+    removedText.prepend('\n');
   }
 
   emit KTextEditor::Document::textRemoved(this, rangeRemoved);
-  emit KTextEditor::Document::textRemoved(this, rangeRemoved, oldText.join("\n") + '\n');
+  emit KTextEditor::Document::textRemoved(this, rangeRemoved, removedText);
 
   editEnd();
 
@@ -1408,7 +1499,7 @@ QVector<KTextEditor::Range> KateDocument::searchText(
   {
     // regexp search
     // escape sequences are supported by definition
-    KateRegExpSearch searcher(this, caseSensitivity);
+    KateRegExpSearch searcher(this, caseSensitivity, m_searchWindow);
     return searcher.search(pattern, range, backwards);
   }
 
@@ -1928,9 +2019,16 @@ bool KateDocument::openFile()
    */
   emit aboutToInvalidateMovingInterfaceContent (this);
 
+  // the revisions start again, the joined lines of the last search must not be taken for the new ones
+  m_searchWindow->invalidate ();
+
   // no open errors until now...
   setOpeningError(false);
 
+  // state of an older reload is meaningless for other files
+  if (!m_reloading)
+    m_reloadStatePending = false;
+
   // add new m_file to dirwatch
   activateDirWatch ();
 
@@ -1962,15 +2060,26 @@ bool KateDocument::openFile()
 
   bool success = m_buffer->openFile (localFilePath(), (m_reloading && m_userSetEncodingForNextReload));
 
+  //
+  // large file, still loading in the background?
+  // stay read-only until slotBufferLoadingFinished
+  //
+  const bool backgroundLoading = success && m_buffer->isLoading ();
+  if (backgroundLoading) {
+    if (m_documentState != DocumentLoading)
+      m_readWriteStateBeforeLoading = isReadWrite ();
+    setReadWrite (false);
+  }
+
   // disable view updates
   foreach (KateView * view, m_views)
     view->setUpdatesEnabled (false);
 
   //
   // yeah, success
-  // read variables
+  // read variables, if all lines are there
   //
-  if (success)
+  if (success && !backgroundLoading)
     readVariables ();
 
   //
@@ -1985,7 +2094,9 @@ bool KateDocument::openFile()
   }
 
   // emit all signals about new text after view updates
-  emit KTextEditor::Document::textInserted(this, documentRange());
+  // loading in the background? then this is done once all lines are there
+  if (!backgroundLoading)
+    emit KTextEditor::Document::textInserted(this, documentRange());
 
   // Inform that the text has changed (required as we're not inside the usual editStart/End stuff)
   emit textChanged (this);
@@ -2016,18 +2127,88 @@ bool KateDocument::openFile()
   //
   // display errors
   //
-  if (!success) {
-    QPointer<KTextEditor::Message> message
-      = new KTextEditor::Message(KTextEditor::Message::Error
-          , i18n ("The file %1 could not be loaded, as it was not possible to read from it.<br />Check if you have read access to this file.", this->url().pathOrUrl()));
-    message->setWordWrap(true);
-    postMessage(message);
+  if (!success)
+    showLoadingError ();
 
-    // remember error
-    setOpeningError(true);
-    setOpeningErrorMessage(i18n ("The file %1 could not be loaded, as it was not possible to read from it.\n\nCheck if you have read access to this file.",this->url().pathOrUrl()));
+  // warn: broken encoding or too long lines
+  showLoadingWarnings ();
+
+  //
+  // return the success
+  //
+  return success;
+}
+
+void KateDocument::slotBufferLoadingProgress ()
+{
+  //
+  // new lines arrived, the first batch did replace the initial empty line
+  //
+  foreach (KateView * view, m_views)
+  {
+    view->tagAll ();
+    view->updateView (true);
+  }
+}
+
+void KateDocument::slotBufferLoadingFinished (const QString &, bool success)
+{
+  //
+  // all lines are there, now we can read the variables
+  //
+  if (success)
+    readVariables ();
+
+  //
+  // editing is allowed again
+  //
+  setReadWrite (m_readWriteStateBeforeLoading);
+
+  foreach (KateView * view, m_views)
+  {
+    view->tagAll ();
+    view->updateView (true);
   }
 
+  // emit all signals about new text after view updates
+  emit KTextEditor::Document::textInserted(this, documentRange());
+
+  // Inform that the text has changed
+  emit textChanged (this);
+
+  //
+  // display errors
+  //
+  if (!success)
+    showLoadingError ();
+
+  // warn: broken encoding or too long lines
+  showLoadingWarnings ();
+
+  //
+  // reload of a large file: restore marks and cursors, now that all lines are there
+  //
+  if (m_reloadStatePending) {
+    restoreReloadState ();
+    emit reloaded (this);
+  }
+}
+
+void KateDocument::showLoadingError ()
+{
+  QPointer<KTextEditor::Message> message
+    = new KTextEditor::Message(KTextEditor::Message::Error
+        , i18n ("The file %1 could not be loaded, as it was not possible to read from it.<br />Check if you have read access to this file.", this->url().pathOrUrl()));
+  message->setWordWrap(true);
+  postMessage(message);
+
+  // remember error
+  setOpeningError(true);
+  setOpeningErrorMessage(i18n ("The file %1 could not be loaded, as it was not possible to read from it.\n\nCheck if you have read access to this file.",this->url().pathOrUrl()));
+}
+
+void KateDocument::showLoadingWarnings ()
+{
   // warn: broken encoding
   if (m_buffer->brokenEncoding()) {
     // this file can't be saved again without killing it
@@ -2066,11 +2247,6 @@ bool KateDocument::openFile()
     setOpeningErrorMessage(i18n ("The file %1 was opened and contained lines longer than the configured Line Length Limit (%2 characters)."
                 " Those lines were wrapped and the document is set to read-only mode, as saving will modify its content.", this->url().pathOrUrl(),config()->lineLengthLimit()));
   }
-
-  //
-  // return the success
-  //
-  return success;
 }
 
 bool KateDocument::saveFile()
@@ -2213,9 +2389,6 @@ bool KateDocument::saveFile()
     return false;
   }
 
-  // update the md5 digest
-  createDigest ();
-
   // add m_file again to dirwatch
   activateDirWatch ();
 
@@ -2380,6 +2553,7 @@ bool KateDocument::closeUrl()
    * we are about to invalidate all cursors/ranges/.. => m_buffer->clear will do so
    */
   emit aboutToInvalidateMovingInterfaceContent (this);
+  m_searchWindow->invalidate ();
 
   // remove file from dirwatch
   deactivateDirWatch ();
@@ -3592,6 +3766,25 @@ bool KateDocument::findMatchingBracket( KTextEditor::Range& range, int maxLines
   cursor.setPosition(range.start());
   int validAttr = kateTextLine(cursor.line())->attribute(cursor.column());
 
+  // brackets in code are looked up in the bracket index of the buffer, it skips comments and strings
+  if ( highlight()->attributeIsCode( validAttr ) ) {
+    if ( searchDir > 0 ) {
+      const KTextEditor::Cursor match = m_buffer->findUnmatchedBracket( KTextEditor::Cursor( range.start().line(), range.start().column() + 1 ), opposite, minLine, maxLine );
+      if ( !match.isValid() )
+        return false;
+
+      range.end() = match;
+    } else {
+      const KTextEditor::Cursor match = m_buffer->findUnmatchedBracket( range.start(), opposite, minLine, maxLine );
+      if ( !match.isValid() )
+        return false;
+
+      range.start() = match;
+    }
+
+    return true;
+  }
+
   while( cursor.line() >= minLine && cursor.line() <= maxLine ) {
 
     if (!cursor.move(searchDir))
@@ -3746,12 +3939,35 @@ void KateDocument::setModifiedOnDisk( ModifiedOnDiskReason reason )
   emit modifiedOnDisk( this, (reason != OnDiskUnmodified), reason );
 }
 
-class KateDocumentTmpMark
+void KateDocument::restoreReloadState ()
 {
-  public:
-    QString line;
-    KTextEditor::Mark mark;
-};
+  m_reloadStatePending = false;
+
+  // restore cursor positions for all views
+  KTextEditor::View* oldActiveView = activeView();
+  foreach (KateView *view, m_views) {
+    if (!m_reloadCursorPositions.contains (view))
+      continue;
+
+    setActiveView(view);
+    view->setCursorPositionInternal( m_reloadCursorPositions.value (view), m_config->tabWidth(), false );
+    if (view->isVisible()) {
+      view->repaintText(false);
+    }
+  }
+  setActiveView(oldActiveView);
+
+  // restore marks on lines with unchanged text
+  for (int z = 0; z < m_reloadMarks.size(); z++)
+  {
+    const KTextEditor::Mark &mark = m_reloadMarks.at(z).second;
+    if (mark.line < lines() && line(mark.line) == m_reloadMarks.at(z).first)
+      setMark (mark.line, mark.type);
+  }
+
+  m_reloadCursorPositions.clear ();
+  m_reloadMarks.clear ();
+}
 
 void KateDocument::setModifiedOnDiskWarning (bool on)
 {
@@ -3789,62 +4005,38 @@ bool KateDocument::documentReload()
 
     emit aboutToReload(this);
 
-    QList<KateDocumentTmpMark> tmp;
-
+    // remember marks together with the text of their lines
+    m_reloadMarks.clear ();
     for (QHash<int, KTextEditor::Mark*>::const_iterator i = m_marks.constBegin(); i != m_marks.constEnd(); ++i)
-    {
-      KateDocumentTmpMark m;
-
-      m.line = line (i.value()->line);
-      m.mark = *i.value();
-
-      tmp.append (m);
-    }
+      m_reloadMarks.append (qMakePair (line (i.value()->line), *i.value()));
 
     const QString oldMode = mode ();
     const bool byUser = m_fileTypeSetByUser;
     const QString hl_mode = highlightingMode ();
-    KTextEditor::View* oldActiveView = activeView();
 
     m_storedVariables.clear();
 
     // save cursor positions for all views
-    QVector<KTextEditor::Cursor> cursorPositions;
-    cursorPositions.reserve(m_views.size());
+    m_reloadCursorPositions.clear ();
     foreach (KateView *v, m_views)
-      cursorPositions.append( v->cursorPosition() );
+      m_reloadCursorPositions.insert( v, v->cursorPosition() );
 
     m_reloading = true;
+    m_reloadStatePending = true;
     KateDocument::openUrl( url() );
 
     // reset some flags only valid for one reload!
     m_userSetEncodingForNextReload = false;
 
-    // restore cursor positions for all views
-    QLinkedList<KateView*>::iterator it = m_views.begin();
-    for(int i = 0; i < m_views.size(); ++i, ++it) {
-      setActiveView(*it);
-      (*it)->setCursorPositionInternal( cursorPositions.at(i), m_config->tabWidth(), false );
-      if ((*it)->isVisible()) {
-        (*it)->repaintText(false);
-      }
-    }
-    setActiveView(oldActiveView);
-
-    for (int z=0; z < tmp.size(); z++)
-    {
-      if (z < (int)lines())
-      {
-        if (line(tmp.at(z).mark.line) == tmp.at(z).line)
-          setMark (tmp.at(z).mark.line, tmp.at(z).mark.type);
-      }
-    }
-
     if (byUser)
       setMode (oldMode);
     setHighlightingMode (hl_mode);
 
-    emit reloaded(this);
+    // large file still loading in the background? marks and cursors are restored once all lines are there
+    if (!m_buffer->isLoading ()) {
+      restoreReloadState ();
+      emit reloaded(this);
+    }
 
     return true;
   }
@@ -4761,6 +4953,11 @@ void KateDocument::transformRange (KTextEditor::Range &range, KTextEditor::Movin
   m_buffer->history().transformRange (range, insertBehaviors, emptyBehavior, fromRevision, toRevision);
 }
 
+void KateDocument::transformCursors (QVector<KTextEditor::Cursor> &cursors, KTextEditor::MovingCursor::InsertBehavior insertBehavior, qint64 fromRevision, qint64 toRevision)
+{
+  m_buffer->history().transformCursors (cursors, insertBehavior, fromRevision, toRevision);
+}
+
 //END
 
 bool KateDocument::simpleMode ()
@@ -4870,7 +5067,9 @@ void KateDocument::slotCompleted() {
    * and kill the possible loading message
    */
   if (m_documentState == DocumentLoading) {
-    setReadWrite (m_readWriteStateBeforeLoading);
+    // buffer still loading in the background? it will restore the state when done
+    if (!m_buffer->isLoading ())
+      setReadWrite (m_readWriteStateBeforeLoading);
     delete m_loadingMessage;
   }
 
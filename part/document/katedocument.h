@@ -67,6 +67,7 @@ class KateDocumentConfig;
 class KateHighlighting;
 class KateUndoManager;
 class KateOnTheFlyChecker;
+class KateLineWindow;
 
 class KateAutoIndent;
 
@@ -90,6 +91,7 @@ class KATEPART_TESTS_EXPORT KateDocument : public KTextEditor::Document,
                      private KTextEditor::MovingRangeFeedback
 {
   Q_OBJECT
+  Q_PROPERTY(QByteArray digest READ digest)
   Q_INTERFACES(KTextEditor::SessionConfigInterface)
   Q_INTERFACES(KTextEditor::ParameterizedSessionConfigInterface)
   Q_INTERFACES(KTextEditor::SearchInterface)
@@ -284,13 +286,27 @@ Q_SIGNALS:
      * @return true on success
      */
     bool editInsertLine ( int line, const QString &s );
+    /**
+     * Insert whole lines in front of the given line, in one step.
+     * The lines are spliced into the buffer at once and recorded as one undo item.
+     * @param line line number
+     * @param s strings to insert
+     * @return true on success
+     */
+    bool editInsertLines ( int line, const QStringList &s );
     /**
      * Remove a line
      * @param line line number
      * @return true on success
      */
     bool editRemoveLine ( int line );
-
+    /**
+     * Remove whole lines, in one step.
+     * The lines are removed from the buffer at once and recorded as one undo item.
+     * @param from first line to remove
+     * @param to last line to remove
+     * @return true on success
+     */
     bool editRemoveLines ( int from, int to );
 
     /**
@@ -357,6 +373,13 @@ Q_SIGNALS:
 
     virtual KTextEditor::Search::SearchOptions supportedSearchOptions() const;
 
+  private:
+    /**
+     * Joined lines of the last multi-line regexp search, reused by the next one
+     * as long as the document doesn't change, e.g. for find all.
+     */
+    KateLineWindow *const m_searchWindow;
+
   private:
     /**
      * Return a widget suitable to be used as a dialog parent.
@@ -619,6 +642,16 @@ Q_SIGNALS:
      */
     virtual void transformRange (KTextEditor::Range &range, KTextEditor::MovingRange::InsertBehaviors insertBehaviors, KTextEditor::MovingRange::EmptyBehavior emptyBehavior, qint64 fromRevision, qint64 toRevision = -1);
 
+    /**
+     * Transform many cursors from one revision to an other in one sweep over the history.
+     * Much faster than transforming them one by one, e.g. for stored matches after a replace all.
+     * @param cursors cursors to transform
+     * @param insertBehavior behavior of the cursors on insert of text at their position
+     * @param fromRevision from this revision we want to transform
+     * @param toRevision to this revision we want to transform, default of -1 is current revision
+     */
+    void transformCursors (QVector<KTextEditor::Cursor> &cursors, KTextEditor::MovingCursor::InsertBehavior insertBehavior, qint64 fromRevision, qint64 toRevision = -1);
+
   //
   // MovingInterface Signals
   //
@@ -927,6 +960,7 @@ Q_SIGNALS:
      * create a MD5 digest of the file, if it is a local file.
      * The result can be accessed through KateBuffer::digest().
      * This is using KMD5::hexDigest().
+     * Loading and saving compute the digest on the fly, this is only needed to check the file on disk.
      *
      * @return wheather the operation was attempted and succeeded.
      */
@@ -944,7 +978,7 @@ Q_SIGNALS:
 
   public:
     /**
-     * md5 digest of this document
+     * md5 digest of this document, the application reads it through the "digest" property
      * @return md5 digest for this document
      */
     const QByteArray &digest () const;
@@ -1202,6 +1236,34 @@ Q_SIGNALS:
      * Abort loading
      */
     void slotAbortLoading ();
+
+    /**
+     * buffer loading in the background appended lines, update the views
+     */
+    void slotBufferLoadingProgress ();
+
+    /**
+     * buffer loading in the background is done, finish what openFile did start
+     * @param filename loaded file
+     * @param success file got loaded
+     */
+    void slotBufferLoadingFinished (const QString &filename, bool success);
+
+  private:
+    /**
+     * show message about a file we could not read
+     */
+    void showLoadingError ();
+
+    /**
+     * restore cursors and marks remembered by documentReload(), done once all lines are loaded
+     */
+    void restoreReloadState ();
+
+    /**
+     * show messages about broken encoding or wrapped lines, set document read-only then
+     */
+    void showLoadingWarnings ();
     
   private:
     /**
@@ -1243,6 +1305,14 @@ Q_SIGNALS:
      * read-write state before loading started
      */
     bool m_readWriteStateBeforeLoading;
+
+    /**
+     * cursors of the views and marks with the text of their lines, remembered for a reload
+     * restored once the file is loaded, for large files this happens in slotBufferLoadingFinished
+     */
+    QHash<KateView *, KTextEditor::Cursor> m_reloadCursorPositions;
+    QList<QPair<QString, KTextEditor::Mark> > m_reloadMarks;
+    bool m_reloadStatePending;
     
     /**
      * loading job, we want to cancel with cancel in the loading message
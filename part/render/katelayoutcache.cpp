@@ -152,6 +152,8 @@ KateLayoutCache::KateLayoutCache(KateRenderer* renderer, QObject* parent)
    */
   connect(&m_renderer->doc()->buffer(), SIGNAL(lineWrapped(KTextEditor::Cursor)), this, SLOT(wrapLine(KTextEditor::Cursor)));
   connect(&m_renderer->doc()->buffer(), SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
+  connect(&m_renderer->doc()->buffer(), SIGNAL(linesInserted(int,QStringList)), this, SLOT(insertLines(int,QStringList)));
+  connect(&m_renderer->doc()->buffer(), SIGNAL(linesRemoved(int,int)), this, SLOT(removeLines(int,int)));
   connect(&m_renderer->doc()->buffer(), SIGNAL(textInserted(KTextEditor::Cursor,QString)), this, SLOT(insertText(KTextEditor::Cursor,QString)));
   connect(&m_renderer->doc()->buffer(), SIGNAL(textRemoved(KTextEditor::Range,QString)), this, SLOT(removeText(KTextEditor::Range)));
 }
@@ -507,6 +509,16 @@ void KateLayoutCache::removeText (const KTextEditor::Range &range)
    m_lineLayouts.slotEditDone(range.start().line(), range.start().line(), 0);
 }
 
+void KateLayoutCache::insertLines (int line, const QStringList &texts)
+{
+   m_lineLayouts.slotEditDone (line, line, texts.size());
+}
+
+void KateLayoutCache::removeLines (int from, int to)
+{
+   m_lineLayouts.slotEditDone (from, to, from - to - 1);
+}
+
 void KateLayoutCache::clear( )
 {
   m_textLayouts.clear();
@@ -23,6 +23,7 @@
 #define KATELAYOUTCACHE_H
 
 #include <QPair>
+#include <QStringList>
 
 #include <ktexteditor/range.h>
 
@@ -148,6 +149,8 @@ private Q_SLOTS:
     void unwrapLine (int line);
     void insertText (const KTextEditor::Cursor &position, const QString &text);
     void removeText (const KTextEditor::Range &range);
+    void insertLines (int line, const QStringList &texts);
+    void removeLines (int from, int to);
 
 private:
     KateRenderer* m_renderer;
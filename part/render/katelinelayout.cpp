@@ -25,6 +25,7 @@
 #include <kdebug.h>
 
 #include "katedocument.h"
+#include "katebuffer.h"
 
 KateLineLayout::KateLineLayout(KateDocument* doc)
   : m_doc(doc)
@@ -63,8 +64,13 @@ bool KateLineLayout::includesCursor(const KTextEditor::Cursor& realCursor) const
 
 const Kate::TextLine& KateLineLayout::textLine(bool reloadForce) const
 {
-  if (reloadForce || !m_textLine)
-    m_textLine = usePlainTextLine() ? m_doc->plainKateTextLine (line()) : m_doc->kateTextLine(line());
+  if (reloadForce || !m_textLine) {
+    // lines far behind the highlighted area are highlighted in the background, we get tagged once they are done
+    if (!usePlainTextLine())
+      m_doc->buffer().requestHighlighting (line());
+
+    m_textLine = m_doc->plainKateTextLine (line());
+  }
 
   Q_ASSERT(m_textLine);
 
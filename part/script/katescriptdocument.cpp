@@ -20,6 +20,7 @@
 #include "katescriptdocument.h"
 
 #include "katedocument.h"
+#include "katebuffer.h"
 #include "kateview.h"
 #include "katerenderer.h"
 #include "kateconfig.h"
@@ -185,8 +186,6 @@ KTextEditor::Cursor KateScriptDocument::rfind(int line, int column, const QStrin
 {
   QScopedPointer<KTextEditor::MovingCursor> cursor(document()->newMovingCursor(KTextEditor::Cursor(line, column)));
   const int start = cursor->line();
-  QList<KTextEditor::Attribute::Ptr> attributes =
-      m_document->highlight()->attributes(static_cast<KateView*>(m_document->activeView())->renderer()->config()->schema());
 
   do {
     Kate::TextLine textLine = m_document->plainKateTextLine(cursor->line());
@@ -199,12 +198,13 @@ KTextEditor::Cursor KateScriptDocument::rfind(int line, int column, const QStrin
       cursor->setColumn(qMax(textLine->length(), 0));
     }
 
+    // search in place, the match must end in front of the cursor, no copy of the line start needed
     int foundAt;
-    while ((foundAt = textLine->string().left(cursor->column()).lastIndexOf(text, -1, Qt::CaseSensitive)) >= 0) {
+    while (cursor->column() >= text.length()
+           && (foundAt = textLine->string().lastIndexOf(text, cursor->column() - text.length(), Qt::CaseSensitive)) >= 0) {
         bool hasStyle = true;
         if (attribute != -1) {
-          KTextEditor::Attribute::Ptr a = attributes[textLine->attribute(foundAt)];
-          const int ds = a->property(KateExtendedAttribute::AttributeDefaultStyleIndex).toInt();
+          const int ds = m_document->highlight()->defaultStyleForAttribute(textLine->attribute(foundAt));
           hasStyle = (ds == attribute);
         }
 
@@ -226,50 +226,20 @@ KTextEditor::Cursor KateScriptDocument::rfind(const KTextEditor::Cursor& cursor,
 
 KTextEditor::Cursor KateScriptDocument::anchor(int line, int column, QChar character)
 {
-  QList<KTextEditor::Attribute::Ptr> attributes =
-      m_document->highlight()->attributes(static_cast<KateView*>( m_document->activeView())->renderer()->config()->schema());
-  int count = 1;
   QChar lc;
-  QChar rc;
   if (character == '(' || character == ')') {
     lc = '(';
-    rc = ')';
   } else if (character == '{' || character == '}') {
     lc = '{';
-    rc = '}';
   } else if (character == '[' || character == ']') {
     lc = '[';
-    rc = ']';
   } else {
     kDebug(13060) << "invalid anchor character:" << character << " allowed are: (){}[]";
     return KTextEditor::Cursor::invalid();
   }
 
-  QScopedPointer<KTextEditor::MovingCursor> cursor(document()->newMovingCursor(KTextEditor::Cursor(line, column)));
-
-  // Move backwards char by char and find the opening character
-  while (cursor->move(-1)) {
-    QChar ch = document()->character(cursor->toCursor());
-    if (ch == lc) {
-      KTextEditor::Attribute::Ptr a = attributes[document()->plainKateTextLine(cursor->line())->attribute(cursor->column())];
-      const int ds = a->property(KateExtendedAttribute::AttributeDefaultStyleIndex).toInt();
-      if (_isCode(ds)) {
-        --count;
-      }
-    }
-    else if (ch == rc) {
-      KTextEditor::Attribute::Ptr a = attributes[document()->plainKateTextLine(cursor->line())->attribute(cursor->column())];
-      const int ds = a->property(KateExtendedAttribute::AttributeDefaultStyleIndex).toInt();
-      if (_isCode(ds)) {
-        ++count;
-      }
-    }
-
-    if (count == 0) {
-      return cursor->toCursor();
-    }
-  }
-  return KTextEditor::Cursor::invalid ();
+  // the bracket index of the buffer skips brackets in comments and strings and whole blocks without the anchor
+  return m_document->buffer().findUnmatchedBracket(KTextEditor::Cursor(line, column), lc, 0, line);
 }
 
 KTextEditor::Cursor KateScriptDocument::anchor(const KTextEditor::Cursor& cursor, QChar character)
@@ -713,11 +683,7 @@ QString KateScriptDocument::setVariable(const QString &s, const QString &v)
 
 bool KateScriptDocument::_isCode(int defaultStyle)
 {
-  return (defaultStyle != KTextEditor::HighlightInterface::dsComment
-       && defaultStyle != KTextEditor::HighlightInterface::dsString
-       && defaultStyle != KTextEditor::HighlightInterface::dsRegionMarker
-       && defaultStyle != KTextEditor::HighlightInterface::dsChar
-       && defaultStyle != KTextEditor::HighlightInterface::dsOthers);
+  return KateHighlighting::isCodeStyle(defaultStyle);
 }
 
 void KateScriptDocument::indent(KTextEditor::Range range, int change)
@@ -39,14 +39,29 @@ KTextEditor::Range KateMatch::searchText(const KTextEditor::Range &range, const
 }
 
 
-KTextEditor::Range KateMatch::replace(const QString &replacement, bool blockMode, int replacementCounter)
+void KateMatch::setResultRanges(const QVector<KTextEditor::Range> &resultRanges)
+{
+    m_resultRanges = resultRanges;
+
+    if (m_resultRanges.isEmpty())
+        m_resultRanges.append(KTextEditor::Range::invalid());
+}
+
+
+QString KateMatch::replacementText(const QString &replacement, bool blockMode, int replacementCounter) const
 {
     // Placeholders depending on search mode
     const bool usePlaceholders = m_options.testFlag(KTextEditor::Search::Regex) ||
                                  m_options.testFlag(KTextEditor::Search::EscapeSequences);
 
-    const QString finalReplacement = usePlaceholders ? buildReplacement(replacement, blockMode, replacementCounter)
-                                                     : replacement;
+    return usePlaceholders ? buildReplacement(replacement, blockMode, replacementCounter)
+                           : replacement;
+}
+
+
+KTextEditor::Range KateMatch::replace(const QString &replacement, bool blockMode, int replacementCounter)
+{
+    const QString finalReplacement = replacementText(replacement, blockMode, replacementCounter);
 
     // Track replacement operation
     KTextEditor::MovingRange *const afterReplace = m_document->newMovingRange(range(), KTextEditor::MovingRange::ExpandLeft | KTextEditor::MovingRange::ExpandRight);
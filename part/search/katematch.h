@@ -37,6 +37,16 @@ public:
     bool isEmpty() const;
     KTextEditor::Range range() const;
 
+    /**
+     * Take over the result of a search done before, the match followed by its captures.
+     */
+    void setResultRanges(const QVector<KTextEditor::Range> &resultRanges);
+
+    /**
+     * Text to replace the match with, references and escape sequences are resolved if the search mode uses them.
+     */
+    QString replacementText(const QString &replacement, bool blockMode, int replacementCounter = 1) const;
+
 private:
     /**
      * Resolve references and escape sequences.
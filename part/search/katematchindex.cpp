@@ -0,0 +1,306 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "katematchindex.h"
+#include "katematchindex.moc"
+
+#include "kateregexp.h"
+#include "kateregexpsearch.h"
+#include "katedocument.h"
+
+#include <ktexteditor/movingrange.h>
+
+using namespace KTextEditor;
+
+namespace {
+
+/**
+ * Position behind the given one, the start of the next line at the end of a line.
+ */
+Cursor nextPosition(KateDocument *document, const Cursor &position)
+{
+    if (position.column() < document->lineLength(position.line()))
+        return Cursor(position.line(), position.column() + 1);
+
+    return Cursor(position.line() + 1, 0);
+}
+
+} // anon namespace
+
+
+KateMatchIndex::KateMatchIndex(KateDocument *document)
+    : m_document(document)
+    , m_multiLine(false)
+    , m_blockMode(false)
+    , m_range(0)
+{
+}
+
+
+KateMatchIndex::~KateMatchIndex()
+{
+    delete m_range;
+}
+
+
+void KateMatchIndex::build(const Range &range, bool blockMode, const QString &pattern, Search::SearchOptions options)
+{
+    clear();
+
+    m_pattern = pattern;
+    m_options = options & ~Search::Backwards;
+    m_blockMode = blockMode;
+
+    // can the pattern match across lines?
+    if (m_options.testFlag(Search::Regex)) {
+        m_multiLine = KateRegExp(pattern).isMultiLine();
+    } else if (m_options.testFlag(Search::EscapeSequences)) {
+        m_multiLine = KateRegExpSearch::escapePlaintext(pattern).contains(QLatin1Char('\n'));
+    } else {
+        m_multiLine = pattern.contains(QLatin1Char('\n'));
+    }
+
+    // only a part of the document is searched, this part must move with the edits, too
+    if (range != m_document->documentRange())
+        m_range = m_document->newMovingRange(range);
+
+    m_matches = findAll(m_document, range, m_blockMode, m_pattern, m_options);
+
+    connectToDocument();
+}
+
+
+void KateMatchIndex::setRanges(const QVector<Range> &ranges)
+{
+    clear();
+
+    m_matches = ranges;
+
+    connectToDocument();
+}
+
+
+void KateMatchIndex::clear()
+{
+    disconnect(m_document, 0, this, 0);
+
+    delete m_range;
+    m_range = 0;
+
+    m_pattern.clear();
+    m_options = Search::Default;
+    m_multiLine = false;
+    m_blockMode = false;
+    m_matches.clear();
+}
+
+
+int KateMatchIndex::indexOf(const Range &range) const
+{
+    // binary search for the first match not starting before the range
+    int first = 0;
+    int count = m_matches.size();
+    while (count > 0) {
+        const int half = count / 2;
+        if (m_matches[first + half].start() < range.start()) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    if (first < m_matches.size() && m_matches[first] == range)
+        return first;
+
+    return -1;
+}
+
+
+int KateMatchIndex::firstMatchOnOrAfterLine(int line) const
+{
+    // matches don't overlap, therefore the ends are sorted, too
+    int first = 0;
+    int count = m_matches.size();
+    while (count > 0) {
+        const int half = count / 2;
+        if (m_matches[first + half].end().line() < line) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    return first;
+}
+
+
+QVector<Range> KateMatchIndex::findAll(KateDocument *document, const Range &range, bool blockMode,
+                                      const QString &pattern, Search::SearchOptions options,
+                                      QVector<QVector<Range> > *captures)
+{
+    options &= ~Search::Backwards;
+
+    const bool regexMode = options.testFlag(Search::Regex);
+    const bool multiLinePattern = regexMode ? KateRegExp(pattern).isMultiLine() : false;
+
+    QVector<Range> matches;
+    if (!range.isValid() || pattern.isEmpty())
+        return matches;
+
+    int line = range.start().line();
+    do {
+        Range workingRange = blockMode ? document->rangeOnLine(range, line) : range;
+
+        for (;;) {
+            const QVector<Range> resultRanges = document->searchText(workingRange, pattern, options);
+            const Range match = resultRanges.isEmpty() ? Range::invalid() : resultRanges[0];
+            if (!match.isValid())
+                break;
+
+            matches.append(match);
+            if (captures)
+                captures->append(resultRanges);
+
+            // Continue after match
+            if (match.end() >= workingRange.end())
+                break;
+
+            Cursor start = match.end();
+            if (match.isEmpty()) {
+                // Can happen for regex patterns like "^".
+                // If we don't advance here we will loop forever...
+                start = nextPosition(document, start);
+            } else if (regexMode && !multiLinePattern && start.column() >= document->lineLength(start.line())) {
+                // single-line regexps might match the naked line end
+                // therefore we better advance to the next line
+                start = nextPosition(document, start);
+            }
+
+            // Are we done?
+            if (start >= workingRange.end())
+                break;
+
+            workingRange.setRange(start, workingRange.end());
+        }
+    } while (blockMode && ++line <= range.end().line());
+
+    return matches;
+}
+
+
+void KateMatchIndex::textInserted(Document *, const Range &range)
+{
+    if (!m_pattern.isEmpty() && m_multiLine) {
+        // matches might start or end anywhere, search again
+        m_matches = findAll(m_document, searchRange(), m_blockMode, m_pattern, m_options);
+    } else {
+        // the lines of the inserted text changed, all behind are just moved
+        const int position = dropAndMoveMatches(range.start().line(), range.start().line(), range.end().line() - range.start().line());
+        rescanLines(range.start().line(), range.end().line(), position);
+    }
+
+    emit matchesChanged();
+}
+
+
+void KateMatchIndex::textRemoved(Document *, const Range &range)
+{
+    if (!m_pattern.isEmpty() && m_multiLine) {
+        // matches might start or end anywhere, search again
+        m_matches = findAll(m_document, searchRange(), m_blockMode, m_pattern, m_options);
+    } else {
+        // the removed lines are joined into the start line, all behind are just moved
+        const int position = dropAndMoveMatches(range.start().line(), range.end().line(), range.start().line() - range.end().line());
+        rescanLines(range.start().line(), range.start().line(), position);
+    }
+
+    emit matchesChanged();
+}
+
+
+Range KateMatchIndex::searchRange() const
+{
+    return m_range ? m_range->toRange() : m_document->documentRange();
+}
+
+
+int KateMatchIndex::dropAndMoveMatches(int startLine, int endLine, int lineDelta)
+{
+    const int first = firstMatchOnOrAfterLine(startLine);
+
+    int last = first;
+    while (last < m_matches.size() && m_matches[last].start().line() <= endLine)
+        ++last;
+
+    m_matches.remove(first, last - first);
+
+    if (lineDelta != 0) {
+        for (int i = first; i < m_matches.size(); ++i) {
+            Range &match = m_matches[i];
+            match.setRange(Cursor(match.start().line() + lineDelta, match.start().column()),
+                           Cursor(match.end().line() + lineDelta, match.end().column()));
+        }
+    }
+
+    return first;
+}
+
+
+void KateMatchIndex::rescanLines(int startLine, int endLine, int position)
+{
+    // ranges without pattern are only moved
+    if (m_pattern.isEmpty())
+        return;
+
+    // only search inside the search range
+    const Range range = searchRange();
+    startLine = qMax(startLine, range.start().line());
+    endLine = qMin(endLine, range.end().line());
+    if (!range.isValid() || startLine > endLine)
+        return;
+
+    Range lines;
+    if (m_blockMode) {
+        // keep the columns of the block on the first and last line, findAll maps them on the other lines
+        lines = Range(m_document->rangeOnLine(range, startLine).start(), m_document->rangeOnLine(range, endLine).end());
+    } else {
+        lines = Range(Cursor(startLine, 0), Cursor(endLine, m_document->lineLength(endLine))).intersect(range);
+    }
+
+    const QVector<Range> found = findAll(m_document, lines, m_blockMode, m_pattern, m_options);
+    if (found.isEmpty())
+        return;
+
+    m_matches.insert(position, found.size(), Range::invalid());
+    qCopy(found.constBegin(), found.constEnd(), m_matches.begin() + position);
+}
+
+
+void KateMatchIndex::connectToDocument()
+{
+    connect(m_document, SIGNAL(textInserted(KTextEditor::Document*,KTextEditor::Range)),
+            this, SLOT(textInserted(KTextEditor::Document*,KTextEditor::Range)));
+    connect(m_document, SIGNAL(textRemoved(KTextEditor::Document*,KTextEditor::Range)),
+            this, SLOT(textRemoved(KTextEditor::Document*,KTextEditor::Range)));
+}
+
+// kate: space-indent on; indent-width 4; replace-tabs on;
@@ -0,0 +1,202 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_MATCH_INDEX_H
+#define KATE_MATCH_INDEX_H
+
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+#include <ktexteditor/range.h>
+#include <ktexteditor/searchinterface.h>
+
+#include "katepartprivate_export.h"
+
+class KateDocument;
+
+namespace KTextEditor {
+    class Document;
+    class MovingRange;
+}
+
+/**
+ * Sorted index of all matches of a search pattern in a document or a part of it.
+ *
+ * The document is scanned once, afterwards the index follows the edits of the document:
+ * matches on the changed lines are searched again, all others are only moved.
+ * Patterns which can match across lines are searched again as a whole on changes.
+ *
+ * Without pattern, the index just holds the given ranges and moves them with the edits,
+ * ranges on changed lines are dropped. This is used for the results of a replace all.
+ */
+class KATEPART_TESTS_EXPORT KateMatchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Construct an empty index for the given document.
+     * @param document document to search in
+     */
+    explicit KateMatchIndex(KateDocument *document);
+
+    /**
+     * Destruct the index.
+     */
+    ~KateMatchIndex();
+
+    /**
+     * Find all matches of the pattern in the range and keep them up-to-date.
+     * @param range range to search in
+     * @param blockMode search only in the columns of the range in each line
+     * @param pattern pattern to search for
+     * @param options search options, the search direction is ignored
+     */
+    void build(const KTextEditor::Range &range, bool blockMode, const QString &pattern, KTextEditor::Search::SearchOptions options);
+
+    /**
+     * Hold the given ranges, sorted in document order, and move them with the edits of the document.
+     * @param ranges ranges to hold
+     */
+    void setRanges(const QVector<KTextEditor::Range> &ranges);
+
+    /**
+     * Drop all matches, the index will no longer follow the document.
+     */
+    void clear();
+
+    /**
+     * Pattern of the index, empty if it only holds ranges.
+     * @return pattern
+     */
+    const QString &pattern() const { return m_pattern; }
+
+    /**
+     * Search options of the index.
+     * @return search options
+     */
+    KTextEditor::Search::SearchOptions options() const { return m_options; }
+
+    /**
+     * All matches, in document order.
+     * @return matches
+     */
+    const QVector<KTextEditor::Range> &matches() const { return m_matches; }
+
+    /**
+     * Number of matches.
+     * @return number of matches
+     */
+    int count() const { return m_matches.size(); }
+
+    /**
+     * Position of the given range in the matches.
+     * @param range range to look up
+     * @return index of the match, -1 if the range is no match
+     */
+    int indexOf(const KTextEditor::Range &range) const;
+
+    /**
+     * First match which does not end before the given line, used to look up the matches of a line range.
+     * @param line line to look up
+     * @return index of the first match ending in or after the line, count() if none
+     */
+    int firstMatchOnOrAfterLine(int line) const;
+
+    /**
+     * Find all matches of the pattern in the range, in document order.
+     * @param document document to search in
+     * @param range range to search in
+     * @param blockMode search only in the columns of the range in each line
+     * @param pattern pattern to search for
+     * @param options search options, the search direction is ignored
+     * @param captures if not 0, filled with the ranges of the captures of each match, the first one is the whole match
+     * @return all matches
+     */
+    static QVector<KTextEditor::Range> findAll(KateDocument *document, const KTextEditor::Range &range, bool blockMode,
+                                               const QString &pattern, KTextEditor::Search::SearchOptions options,
+                                               QVector<QVector<KTextEditor::Range> > *captures = 0);
+
+Q_SIGNALS:
+    /**
+     * The matches changed because of edits of the document.
+     */
+    void matchesChanged();
+
+private Q_SLOTS:
+    void textInserted(KTextEditor::Document *document, const KTextEditor::Range &range);
+    void textRemoved(KTextEditor::Document *document, const KTextEditor::Range &range);
+
+private:
+    /**
+     * Range to search in, the whole document if no search range is set.
+     * @return current search range
+     */
+    KTextEditor::Range searchRange() const;
+
+    /**
+     * Drop all matches touching the lines [startLine, endLine] and move all matches behind by lineDelta lines.
+     * @return position of the first match behind the dropped ones
+     */
+    int dropAndMoveMatches(int startLine, int endLine, int lineDelta);
+
+    /**
+     * Search the lines [startLine, endLine] again and insert the matches at the given position.
+     */
+    void rescanLines(int startLine, int endLine, int position);
+
+    /**
+     * Start to follow the edits of the document.
+     */
+    void connectToDocument();
+
+private:
+    KateDocument *const m_document;
+
+    /**
+     * pattern and options of the search, empty pattern if only ranges are held
+     */
+    QString m_pattern;
+    KTextEditor::Search::SearchOptions m_options;
+
+    /**
+     * can the pattern match across lines? then changes need a search of the whole range
+     */
+    bool m_multiLine;
+
+    /**
+     * search only in the columns of the search range
+     */
+    bool m_blockMode;
+
+    /**
+     * search range, 0 for the whole document
+     */
+    KTextEditor::MovingRange *m_range;
+
+    /**
+     * all matches, sorted in document order
+     */
+    QVector<KTextEditor::Range> m_matches;
+};
+
+#endif // KATE_MATCH_INDEX_H
+
+// kate: space-indent on; indent-width 4; replace-tabs on;
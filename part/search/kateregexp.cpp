@@ -305,21 +305,21 @@ bool KateRegExp::isMultiLine() const
 
 
 
-int KateRegExp::indexIn(const QString &str, int start, int end) const
+int KateRegExp::indexIn(const QString &str, int start, int end, QRegExp::CaretMode caretMode) const
 {
-  return m_regExp.indexIn(str.left(end), start, QRegExp::CaretAtZero);
+  return m_regExp.indexIn(str.left(end), start, caretMode);
 }
 
 
 
-int KateRegExp::lastIndexIn(const QString &str, int start, int end) const
+int KateRegExp::lastIndexIn(const QString &str, int start, int end, QRegExp::CaretMode caretMode) const
 {
   const int index = m_regExp.lastIndexIn(str.mid(start, end-start), -1, QRegExp::CaretAtZero);
 
   if (index == -1)
     return -1;
 
-  const int index2 = m_regExp.indexIn(str.left(end), start+index, QRegExp::CaretAtZero);
+  const int index2 = m_regExp.indexIn(str.left(end), start+index, caretMode);
 
   return index2;
 }
@@ -38,7 +38,16 @@ class KateRegExp
     QString cap(int nth = 0) const { return m_regExp.cap(nth); }
     int matchedLength() const { return m_regExp.matchedLength(); }
 
-    int indexIn(const QString &str, int offset, int end) const;
+    /**
+     * Search forwards in str from offset, text from end on is not considered.
+     *
+     * \param str        Text to search in
+     * \param offset     Offset to start at
+     * \param end        End of the text to search in
+     * \param caretMode  Where '^' matches, CaretAtOffset to search in str like in the text from offset on
+     * \return           Index of match or -1 if no match is found
+     */
+    int indexIn(const QString &str, int offset, int end, QRegExp::CaretMode caretMode = QRegExp::CaretAtZero) const;
 
     /**
      * This function is a replacement for QRegExp.lastIndexIn that
@@ -49,9 +58,10 @@ class KateRegExp
      *
      * \param str        Text to search in
      * \param offset     Offset (-1 starts from end, -2 from one before the end)
+     * \param caretMode  Where '^' matches, see indexIn()
      * \return           Index of match or -1 if no match is found
      */
-    int lastIndexIn(const QString &str, int offset, int end) const;
+    int lastIndexIn(const QString &str, int offset, int end, QRegExp::CaretMode caretMode = QRegExp::CaretAtZero) const;
 
     /**
      * Repairs a regular Expression pattern.
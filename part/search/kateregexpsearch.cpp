@@ -24,6 +24,7 @@
 #include "kateregexp.h"
 
 #include <ktexteditor/document.h>
+#include <ktexteditor/movinginterface.h>
 //END  includes
 
 
@@ -161,13 +162,94 @@ KateRegExpSearch::ReplacementStream &KateRegExpSearch::ReplacementStream::operat
 }
 
 
+//BEGIN KateLineWindow
+KateLineWindow::KateLineWindow ()
+  : m_document (0)
+  , m_revision (-1)
+  , m_documentLines (0)
+  , m_firstLine (0)
+{
+}
+
+void KateLineWindow::invalidate ()
+{
+  m_document = 0;
+  m_text.clear ();
+  m_lineStarts.clear ();
+}
+
+bool KateLineWindow::cover (KTextEditor::Document *document, int from, int to)
+{
+  if (from < 0 || to < from || document->lines() <= to)
+    return false;
+
+  // without revisions, changes of the document can't be detected, don't reuse anything then
+  KTextEditor::MovingInterface *const moving = qobject_cast<KTextEditor::MovingInterface*> (document);
+  const qint64 revision = moving ? moving->revision () : -1;
+
+  const bool reuse = moving && (m_document == document) && (m_revision == revision)
+                     && (m_documentLines == document->lines())
+                     && (m_firstLine <= from) && (from <= lastLine ());
+
+  if (!reuse) {
+    m_document = document;
+    m_revision = revision;
+    m_documentLines = document->lines();
+    m_firstLine = from;
+    m_text.clear ();
+    m_lineStarts.clear ();
+  } else if (lineStart (from) > m_text.length () / 2) {
+    // slide: drop the lines in front of the search once they are the larger part of the text
+    const int offset = lineStart (from);
+    m_text.remove (0, offset);
+    m_lineStarts.remove (0, from - m_firstLine);
+    for (int i = 0; i < m_lineStarts.size(); ++i)
+      m_lineStarts[i] -= offset;
+    m_firstLine = from;
+  }
+
+  // cut lines behind the window, the search must not see them
+  if (lastLine () > to) {
+    m_text.truncate (lineStart (to + 1) - 1);
+    m_lineStarts.resize (to - m_firstLine + 1);
+  }
+
+  // append missing lines
+  for (int line = lastLine () + 1; line <= to; ++line) {
+    if (!m_lineStarts.isEmpty ())
+      m_text.append (QLatin1Char ('\n'));
+    m_lineStarts.append (m_text.length ());
+    m_text.append (document->line (line));
+  }
+
+  return true;
+}
+
+int KateLineWindow::lineLength (int line) const
+{
+  const int end = (line == lastLine ()) ? m_text.length () : (lineStart (line + 1) - 1);
+  return end - lineStart (line);
+}
+
+KTextEditor::Cursor KateLineWindow::cursor (int offset) const
+{
+  // last line starting at or in front of the offset
+  QVector<int>::const_iterator lineStart = qUpperBound (m_lineStarts.constBegin (), m_lineStarts.constEnd (), offset);
+  --lineStart;
+
+  return KTextEditor::Cursor (m_firstLine + (lineStart - m_lineStarts.constBegin ()), offset - *lineStart);
+}
+//END KateLineWindow
+
+
 //BEGIN d'tor, c'tor
 //
 // KateSearch Constructor
 //
-KateRegExpSearch::KateRegExpSearch ( KTextEditor::Document *document, Qt::CaseSensitivity caseSensitivity )
+KateRegExpSearch::KateRegExpSearch ( KTextEditor::Document *document, Qt::CaseSensitivity caseSensitivity, KateLineWindow *window )
 : m_document (document)
 , m_caseSensitivity (caseSensitivity)
+, m_window (window)
 {
 }
 
@@ -179,25 +261,6 @@ KateRegExpSearch::~KateRegExpSearch()
 }
 
 
-// helper structs for captures re-construction
-struct TwoViewCursor {
-  int index;
-  int openLine;
-  int openCol;
-  int closeLine;
-  int closeCol;
-  // note: open/close distinction does not seem needed
-  // anymore. i keep it to make a potential way back
-  // easier. overhead is minimal.
-};
-
-struct IndexPair {
-  int openIndex;
-  int closeIndex;
-};
-
-
-
 QVector<KTextEditor::Range> KateRegExpSearch::search(
     const QString &pattern,
     const KTextEditor::Range & inputRange,
@@ -231,57 +294,25 @@ QVector<KTextEditor::Range> KateRegExpSearch::search(
   if (isMultiLine)
   {
     // multi-line regex search (both forward and backward mode)
-    QString wholeDocument;
-    const int inputLineCount = inputRange.end().line() - inputRange.start().line() + 1;
-    FAST_DEBUG("multi line search (lines " << firstLineIndex << ".." << firstLineIndex + inputLineCount - 1 << ")");
-
-    // nothing to do...
-    if (firstLineIndex >= m_document->lines())
-    {
-      QVector<KTextEditor::Range> result;
-      result.append(KTextEditor::Range::invalid());
-      return result;
-    }
-
-    QVector<int> lineLens (inputLineCount);
+    // the lines are joined in a window, which is kept for the next search if possible
+    const int lastLineIndex = inputRange.end().line();
+    FAST_DEBUG("multi line search (lines " << firstLineIndex << ".." << lastLineIndex << ")");
 
-    // first line
-    if (firstLineIndex < 0 || m_document->lines() <= firstLineIndex)
+    KateLineWindow localWindow;
+    KateLineWindow &window = m_window ? *m_window : localWindow;
+    if (!window.cover (m_document, firstLineIndex, lastLineIndex))
     {
       QVector<KTextEditor::Range> result;
       result.append(KTextEditor::Range::invalid());
       return result;
     }
 
-    const QString firstLine = m_document->line(firstLineIndex);
-
-    const int firstLineLen = firstLine.length() - minColStart;
-    wholeDocument.append(firstLine.right(firstLineLen));
-    lineLens[0] = firstLineLen;
-    FAST_DEBUG("  line" << 0 << "has length" << lineLens[0]);
-
-    // second line and after
-    const QString sep("\n");
-    for (int i = 1; i < inputLineCount; i++)
-    {
-      const int lineNum = firstLineIndex + i;
-      if (lineNum < 0 || m_document->lines() <= lineNum)
-      {
-        QVector<KTextEditor::Range> result;
-        result.append(KTextEditor::Range::invalid());
-        return result;
-      }
-      const QString text = m_document->line(lineNum);
-
-      lineLens[i] = text.length();
-      wholeDocument.append(sep);
-      wholeDocument.append(text);
-      FAST_DEBUG("  line" << i << "has length" << lineLens[i]);
-    }
-
+    // search from the start column on, '^' matches there as if the text started there
+    const QString &text = window.text();
+    const int startIndex = window.lineStart(firstLineIndex) + qMin(minColStart, window.lineLength(firstLineIndex));
     const int pos = backwards
-        ? regexp.lastIndexIn(wholeDocument, 0, wholeDocument.length())
-        : regexp.indexIn(wholeDocument, 0, wholeDocument.length());
+        ? regexp.lastIndexIn(text, startIndex, text.length(), QRegExp::CaretAtOffset)
+        : regexp.indexIn(text, startIndex, text.length(), QRegExp::CaretAtOffset);
     if (pos == -1)
     {
       // no match
@@ -293,153 +324,27 @@ QVector<KTextEditor::Range> KateRegExpSearch::search(
       }
     }
 
-#ifdef FAST_DEBUG_ENABLE
-    const int matchLen = regexp.matchedLength();
-    FAST_DEBUG("found at relative pos " << pos << ", length " << matchLen);
-#endif
+    FAST_DEBUG("found at pos " << pos << ", length " << regexp.matchedLength());
 
-    // save opening and closing indices and build a map.
-    // the correct values will be written into it later.
-    QMap<int, TwoViewCursor *> indicesToCursors;
+    // build result array, map the capture offsets to document positions
     const int numCaptures = regexp.numCaptures();
-    QVector<IndexPair> indexPairs(1 + numCaptures);
-    for (int z = 0; z <= numCaptures; z++)
-    {
-      const int openIndex = regexp.pos(z);
-      IndexPair & pair = indexPairs[z];
-      if (openIndex == -1)
-      {
-        // empty capture gives invalid
-        pair.openIndex = -1;
-        pair.closeIndex = -1;
-        FAST_DEBUG("capture []");
-      }
-      else
-      {
-        const int closeIndex = openIndex + regexp.cap(z).length();
-        pair.openIndex = openIndex;
-        pair.closeIndex = closeIndex;
-        FAST_DEBUG("capture [" << pair.openIndex << ".." << pair.closeIndex << "]");
-
-        // each key no more than once
-        if (!indicesToCursors.contains(openIndex))
-        {
-          TwoViewCursor * twoViewCursor = new TwoViewCursor;
-          twoViewCursor->index = openIndex;
-          indicesToCursors.insert(openIndex, twoViewCursor);
-          FAST_DEBUG("  border index added: " << openIndex);
-        }
-        if (!indicesToCursors.contains(closeIndex))
-        {
-          TwoViewCursor * twoViewCursor = new TwoViewCursor;
-          twoViewCursor->index = closeIndex;
-          indicesToCursors.insert(closeIndex, twoViewCursor);
-          FAST_DEBUG("  border index added: " << closeIndex);
-        }
-      }
-    }
-
-    // find out where they belong
-    int curRelLine = 0;
-    int curRelCol = 0;
-    int curRelIndex = 0;
-    QMap<int, TwoViewCursor *>::const_iterator iter = indicesToCursors.constBegin();
-    while (iter != indicesToCursors.constEnd())
-    {
-      // forward to index, save line/col
-      const int index = (*iter)->index;
-      FAST_DEBUG("resolving position" << index);
-      TwoViewCursor & twoViewCursor = *(*iter);
-      while (curRelIndex <= index)
-      {
-        FAST_DEBUG("walk pos (" << curRelLine << "," << curRelCol << ") = "
-            << curRelIndex << "relative, steps more to go" << index - curRelIndex);
-        const int curRelLineLen = lineLens[curRelLine];
-        const int curLineRemainder = curRelLineLen - curRelCol;
-        const int lineFeedIndex = curRelIndex + curLineRemainder;
-        if (index <= lineFeedIndex) {
-            if (index == lineFeedIndex) {
-                // on this line _on_ line feed
-                FAST_DEBUG("  on line feed");
-                const int absLine = curRelLine + firstLineIndex;
-                twoViewCursor.openLine
-                    = twoViewCursor.closeLine
-                    = absLine;
-                twoViewCursor.openCol
-                    = twoViewCursor.closeCol
-                    = ((curRelLine == 0) ? minColStart : 0) + curRelLineLen;
-
-                // advance to next line
-                const int advance = (index - curRelIndex) + 1;
-                curRelLine++;
-                curRelCol = 0;
-                curRelIndex += advance;
-            } else { // index < lineFeedIndex
-                // on this line _before_ line feed
-                FAST_DEBUG("  before line feed");
-                const int diff = (index - curRelIndex);
-                const int absLine = curRelLine + firstLineIndex;
-                const int absCol = ((curRelLine == 0) ? minColStart : 0) + curRelCol + diff;
-                twoViewCursor.openLine
-                    = twoViewCursor.closeLine
-                    = absLine;
-                twoViewCursor.openCol
-                    = twoViewCursor.closeCol
-                    = absCol;
-
-                // advance on same line
-                const int advance = diff + 1;
-                curRelCol += advance;
-                curRelIndex += advance;
-            }
-            FAST_DEBUG("open(" << twoViewCursor.openLine << "," << twoViewCursor.openCol
-                << ")  close(" << twoViewCursor.closeLine << "," << twoViewCursor.closeCol << ")");
-        }
-        else // if (index > lineFeedIndex)
-        {
-          // not on this line
-          // advance to next line
-          FAST_DEBUG("  not on this line");
-          const int advance = curLineRemainder + 1;
-          curRelLine++;
-          curRelCol = 0;
-          curRelIndex += advance;
-        }
-      }
-
-      ++iter;
-    }
-
-    // build result array
     QVector<KTextEditor::Range> result(1 + numCaptures);
     for (int y = 0; y <= numCaptures; y++)
     {
-      IndexPair & pair = indexPairs[y];
-      if ((pair.openIndex == -1) || (pair.closeIndex == -1))
+      const int openIndex = regexp.pos(y);
+      if (openIndex == -1)
       {
+        // empty capture gives invalid
         result[y] = KTextEditor::Range::invalid();
+        FAST_DEBUG("capture []");
       }
       else
       {
-        const TwoViewCursor * const openCursors = indicesToCursors[pair.openIndex];
-        const TwoViewCursor * const closeCursors = indicesToCursors[pair.closeIndex];
-        const int startLine = openCursors->openLine;
-        const int startCol = openCursors->openCol;
-        const int endLine = closeCursors->closeLine;
-        const int endCol = closeCursors->closeCol;
-        FAST_DEBUG("range " << y << ": (" << startLine << ", " << startCol << ")..(" << endLine << ", " << endCol << ")");
-        result[y] = KTextEditor::Range(startLine, startCol, endLine, endCol);
+        const int closeIndex = openIndex + regexp.cap(y).length();
+        result[y] = KTextEditor::Range(window.cursor(openIndex), window.cursor(closeIndex));
+        FAST_DEBUG("capture [" << openIndex << ".." << closeIndex << "]");
       }
     }
-
-    // free structs allocated for indicesToCursors
-    iter = indicesToCursors.constBegin();
-    while (iter != indicesToCursors.constEnd())
-    {
-      TwoViewCursor * const twoViewCursor = *iter;
-      delete twoViewCursor;
-      ++iter;
-    }
     return result;
   }
   else
@@ -23,6 +23,7 @@
 #define _KATE_REGEXPSEARCH_H_
 
 #include <QtCore/QObject>
+#include <QtCore/QVector>
 
 #include <ktexteditor/range.h>
 
@@ -32,6 +33,77 @@ namespace KTextEditor {
   class Document;
 }
 
+/**
+ * Text of consecutive lines of a document, joined with '\n', for multi-line regexp searches.
+ *
+ * The window is kept between searches: as long as the document doesn't change, a search
+ * starting inside of it reuses the text, missing lines are appended at the end and lines far
+ * in front of the search are dropped. Offsets in the text are mapped back to document
+ * positions with the table of line start offsets.
+ */
+class KATEPART_TESTS_EXPORT KateLineWindow
+{
+  public:
+    KateLineWindow ();
+
+    /**
+     * Forget the text, e.g. if the document is reloaded.
+     */
+    void invalidate ();
+
+    /**
+     * Make the window hold the lines [from, to] of the document.
+     * Lines in front of @p from might be kept, if the text is reused.
+     * \param document document to take the lines from
+     * \param from first wanted line
+     * \param to last line of the window
+     * \return false if the lines are not inside of the document
+     */
+    bool cover (KTextEditor::Document *document, int from, int to);
+
+    /**
+     * \return joined text of all lines of the window
+     */
+    const QString &text () const { return m_text; }
+
+    /**
+     * \return first line of the window
+     */
+    int firstLine () const { return m_firstLine; }
+
+    /**
+     * \return last line of the window
+     */
+    int lastLine () const { return m_firstLine + m_lineStarts.size() - 1; }
+
+    /**
+     * \param line line inside of the window
+     * \return offset of the first character of the line in text()
+     */
+    int lineStart (int line) const { return m_lineStarts[line - m_firstLine]; }
+
+    /**
+     * \param line line inside of the window
+     * \return length of the line
+     */
+    int lineLength (int line) const;
+
+    /**
+     * Map an offset in text() to a document position, an offset on a line feed maps to the end of its line.
+     * \param offset offset in text()
+     * \return document position
+     */
+    KTextEditor::Cursor cursor (int offset) const;
+
+  private:
+    const KTextEditor::Document *m_document;
+    qint64 m_revision;
+    int m_documentLines;
+    int m_firstLine;
+    QString m_text;
+    QVector<int> m_lineStarts;
+};
+
 /**
  * Object to help to search for regexp.
  * This should be NO QObject, it is created to often!
@@ -40,7 +112,13 @@ namespace KTextEditor {
 class KATEPART_TESTS_EXPORT KateRegExpSearch
 {
   public:
-    explicit KateRegExpSearch (KTextEditor::Document *document, Qt::CaseSensitivity caseSensitivity);
+    /**
+     * \param document document to search in
+     * \param caseSensitivity case sensitivity of the search
+     * \param window text of multi-line searches to reuse, if 0 the lines are joined for each search
+     */
+    explicit KateRegExpSearch (KTextEditor::Document *document, Qt::CaseSensitivity caseSensitivity,
+                               KateLineWindow *window = 0);
     ~KateRegExpSearch ();
 
   //
@@ -99,6 +177,7 @@ class KATEPART_TESTS_EXPORT KateRegExpSearch
   private:
     KTextEditor::Document *const m_document;
     Qt::CaseSensitivity m_caseSensitivity;
+    KateLineWindow *const m_window;
     class ReplacementStream;
 };
 
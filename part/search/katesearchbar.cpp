@@ -24,6 +24,7 @@
 
 #include "kateregexp.h"
 #include "katematch.h"
+#include "katematchindex.h"
 #include "kateview.h"
 #include "katedocument.h"
 #include "kateundomanager.h"
@@ -123,6 +124,9 @@ public:
     }
 };
 
+// up to this number of matches all are highlighted, else only the ones around the visible lines
+const int MAX_HIGHLIGHTED_MATCHES = 1000;
+
 } // anon namespace
 
 
@@ -131,6 +135,7 @@ KateSearchBar::KateSearchBar(bool initAsPower, KateView* view, KateViewConfig *c
         : KateViewBarWidget(true, view),
         m_view(view),
         m_config(config),
+        m_matchIndex(new KateMatchIndex(view->doc())),
         m_layout(new QVBoxLayout()),
         m_widget(NULL),
         m_incUi(NULL),
@@ -150,6 +155,12 @@ KateSearchBar::KateSearchBar(bool initAsPower, KateView* view, KateViewConfig *c
     connect(view, SIGNAL(cursorPositionChanged(KTextEditor::View*,KTextEditor::Cursor)),
             this, SLOT(updateIncInitCursor()));
 
+    // the highlighting follows the match index after edits and the visible lines after scrolling
+    m_updateHighlightsTimer.setSingleShot(true);
+    connect(&m_updateHighlightsTimer, SIGNAL(timeout()), this, SLOT(updateHighlights()));
+    connect(m_matchIndex, SIGNAL(matchesChanged()), &m_updateHighlightsTimer, SLOT(start()));
+    connect(view, SIGNAL(displayRangeChanged(KateView*)), this, SLOT(onDisplayRangeChanged()));
+
     // init match attribute
     Attribute::Ptr mouseInAttribute(new Attribute());
     mouseInAttribute->setFontBold(true);
@@ -202,6 +213,7 @@ KateSearchBar::KateSearchBar(bool initAsPower, KateView* view, KateViewConfig *c
 
 KateSearchBar::~KateSearchBar() {
     clearHighlights();
+    delete m_matchIndex;
     delete m_layout;
     delete m_widget;
 
@@ -325,6 +337,56 @@ void KateSearchBar::highlightReplacement(const Range & range) {
     m_hlRanges.append(highlight);
 }
 
+void KateSearchBar::updateHighlights() {
+    const QVector<Range> &matches = m_matchIndex->matches();
+    const bool replacements = m_matchIndex->pattern().isEmpty();
+
+    // Highlight all matches if there are only a few, else the ones on and around the visible lines
+    int first = 0;
+    int last = matches.size();
+    if (matches.size() > MAX_HIGHLIGHTED_MATCHES) {
+        const Range visibleRange = m_view->visibleRange();
+        const int margin = visibleRange.numberOfLines() + 1;
+        first = m_matchIndex->firstMatchOnOrAfterLine(visibleRange.start().line() - margin);
+        last = m_matchIndex->firstMatchOnOrAfterLine(visibleRange.end().line() + margin + 1);
+    }
+
+    // Reuse the existing highlights, only create or delete the difference
+    while (m_hlRanges.size() > last - first) {
+        delete m_hlRanges.takeLast();
+    }
+    for (int i = first; i < last; ++i) {
+        if (i - first < m_hlRanges.size()) {
+            KTextEditor::MovingRange* const highlight = m_hlRanges[i - first];
+            highlight->setRange(matches[i]);
+            highlight->setAttribute(replacements ? highlightReplacementAttribute : highlightMatchAttribute);
+        } else if (replacements) {
+            highlightReplacement(matches[i]);
+        } else {
+            highlightMatch(matches[i]);
+        }
+    }
+}
+
+void KateSearchBar::onDisplayRangeChanged() {
+    // Only a part of the matches is highlighted, follow the visible lines
+    if (m_matchIndex->count() > MAX_HIGHLIGHTED_MATCHES) {
+        m_updateHighlightsTimer.start();
+    }
+}
+
+void KateSearchBar::updateMatchCounter(const Range & match) {
+    const int index = match.isValid() ? m_matchIndex->indexOf(match) : -1;
+    const QString text = (index >= 0) ? i18n("Match %1 of %2", index + 1, m_matchIndex->count())
+                                      : QString();
+
+    if (isPower()) {
+        m_powerUi->matchCounter->setText(text);
+    } else if (!text.isEmpty()) {
+        m_incUi->status->setText(text);
+    }
+}
+
 void KateSearchBar::indicateMatch(MatchResult matchResult) {
     QLineEdit * const lineEdit = isPower() ? m_powerUi->pattern->lineEdit()
                                            : m_incUi->pattern->lineEdit();
@@ -645,6 +707,16 @@ bool KateSearchBar::find(SearchDirection searchDirection, const QString * replac
                                                                        MatchWrappedBackward;
     indicateMatch(matchResult);
 
+    // Keep the highlighting of all matches while stepping through them, tell which one is selected
+    const bool sameMatches = (replacement == 0) && (m_matchIndex->count() > 0)
+                             && !m_matchIndex->pattern().isEmpty()
+                             && (m_matchIndex->pattern() == searchPattern())
+                             && (m_matchIndex->options() == searchOptions(SearchForward));
+    if (sameMatches) {
+        updateMatchCounter(match.range());
+        return true; // == No pattern error
+    }
+
     // Reset highlighting for all matches and highlight replacement if there is one
     clearHighlights();
     if (afterReplace.isValid()) {
@@ -802,92 +874,66 @@ void KateSearchBar::replaceNext() {
 int KateSearchBar::findAll(Range inputRange, const QString * replacement)
 {
     const Search::SearchOptions enabledOptions = searchOptions(SearchForward);
+    const bool block = m_view->selection() && m_view->blockSelection();
 
-    const bool regexMode = enabledOptions.testFlag(Search::Regex);
-    const bool multiLinePattern = regexMode ? KateRegExp(searchPattern()).isMultiLine() : false;
-
-    KTextEditor::MovingRange * workingRange = m_view->doc()->newMovingRange(inputRange);
-    QList<Range> highlightRanges;
-    int matchCounter = 0;
-
-    bool block = m_view->selection() && m_view->blockSelection();
-    int line = inputRange.start().line();
-    do {
-        if (block)
-            workingRange = m_view->doc()->newMovingRange(m_view->doc()->rangeOnLine(inputRange, line));
-
-        for (;;) {
-            KateMatch match(m_view->doc(), enabledOptions);
-            match.searchText(*workingRange, searchPattern());
-            if (!match.isValid()) {
-                break;
-            }
-            bool const originalMatchEmpty = match.isEmpty();
-
-            // Work with the match
-            if (replacement != NULL) {
-                if (matchCounter == 0) {
-                    m_view->document()->startEditing();
-                }
-
-                // Replace
-                const Range afterReplace = match.replace(*replacement, false, ++matchCounter);
-
-                // Highlight and continue after adjusted match
-                //highlightReplacement(*afterReplace);
-                highlightRanges << afterReplace;
-            } else {
-                // Highlight and continue after original match
-                //highlightMatch(match);
-                highlightRanges << match.range();
-                matchCounter++;
-            }
-
-            // Continue after match
-            if (highlightRanges.last().end() >= workingRange->end())
-                break;
-            KTextEditor::MovingCursor* workingStart =
-                static_cast<KateDocument*>(m_view->document())->newMovingCursor(highlightRanges.last().end());
-            if (originalMatchEmpty) {
-                // Can happen for regex patterns like "^".
-                // If we don't advance here we will loop forever...
-                workingStart->move(1);
-            } else if (regexMode && !multiLinePattern && workingStart->atEndOfLine()) {
-                // single-line regexps might match the naked line end
-                // therefore we better advance to the next line
-                workingStart->move(1);
-            }
-            workingRange->setRange(*workingStart, workingRange->end());
-
-            const bool atEndOfDocument = workingStart->atEndOfDocument();
-            delete workingStart;
-            // Are we done?
-            if (!workingRange->toRange().isValid() || atEndOfDocument) {
-                break;
-            }
-        }
+    if (replacement == NULL) {
+        // Highlight all matches, the index keeps them up-to-date while editing
+        m_matchIndex->build(inputRange, block, searchPattern(), enabledOptions);
+        updateHighlights();
+        return m_matchIndex->count();
+    }
 
-    } while (block && ++line <= inputRange.end().line());
+    // Find all matches first, replacing them one after the other would search each replacement again
+    QVector<QVector<Range> > captures;
+    const QVector<Range> matches = KateMatchIndex::findAll(m_view->doc(), inputRange, block, searchPattern(), enabledOptions, &captures);
+    if (matches.isEmpty()) {
+        return 0;
+    }
 
-    // After last match
-    if (matchCounter > 0) {
-        if (replacement != NULL) {
-            m_view->document()->endEditing();
-        }
+    // Resolve the placeholders while the captured texts are still in place
+    QVector<QString> replacements;
+    replacements.reserve(matches.size());
+    for (int i = 0; i < matches.size(); ++i) {
+        KateMatch match(m_view->doc(), enabledOptions);
+        match.setResultRanges(captures[i]);
+        replacements.append(match.replacementText(*replacement, false, i + 1));
     }
 
-    if (replacement == NULL)
-        foreach (const Range &r, highlightRanges) {
-            highlightMatch(r);
-        }
-    else
-        foreach (const Range &r, highlightRanges) {
-            highlightReplacement(r);
-        }
+    // Replace front to back, each replacement moves the following matches:
+    // by the change of the line count, and on the line it ends on by the change of the column
+    QVector<Range> afterReplace;
+    afterReplace.reserve(matches.size());
+    int lineDelta = 0;
+    int columnDeltaLine = -1;
+    int columnDelta = 0;
+
+    m_view->document()->startEditing();
+    for (int i = 0; i < matches.size(); ++i) {
+        const Range &match = matches[i];
+        const QString &text = replacements[i];
+
+        const Cursor start(match.start().line() + lineDelta,
+                           match.start().column() + (match.start().line() == columnDeltaLine ? columnDelta : 0));
+        const Cursor end(match.end().line() + lineDelta,
+                         match.end().column() + (match.end().line() == columnDeltaLine ? columnDelta : 0));
+        m_view->doc()->replaceText(Range(start, end), text, false);
+
+        const int newLines = text.count(QLatin1Char('\n'));
+        const Cursor replacedEnd = (newLines == 0) ? Cursor(start.line(), start.column() + text.length())
+                                                   : Cursor(start.line() + newLines, text.length() - text.lastIndexOf(QLatin1Char('\n')) - 1);
+        afterReplace.append(Range(start, replacedEnd));
+
+        lineDelta += newLines - match.numberOfLines();
+        columnDeltaLine = match.end().line();
+        columnDelta = replacedEnd.column() - match.end().column();
+    }
+    m_view->document()->endEditing();
 
-    delete workingRange;
+    // Highlight the replacements, moved along with later edits
+    m_matchIndex->setRanges(afterReplace);
+    updateHighlights();
 
-    return matchCounter;
+    return matches.size();
 }
 
 
@@ -1531,6 +1577,12 @@ bool KateSearchBar::clearHighlights()
     if (m_infoMessage)
         delete m_infoMessage;
 
+    m_matchIndex->clear();
+    m_updateHighlightsTimer.stop();
+    if (m_powerUi) {
+        m_powerUi->matchCounter->clear();
+    }
+
     if (m_hlRanges.isEmpty()) {
         return false;
     }
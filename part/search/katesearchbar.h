@@ -28,8 +28,11 @@
 #include <ktexteditor/attribute.h>
 #include <ktexteditor/searchinterface.h>
 
+#include <QtCore/QTimer>
+
 class KateView;
 class KateViewConfig;
+class KateMatchIndex;
 class QVBoxLayout;
 class QComboBox;
 
@@ -147,6 +150,9 @@ private Q_SLOTS:
 
     void keepHighlights();
 
+    void updateHighlights();
+    void onDisplayRangeChanged();
+
 private:
     // Helpers
     bool find(SearchDirection searchDirection = SearchForward, const QString * replacement = 0);
@@ -158,6 +164,7 @@ private:
 
     void highlightMatch(const KTextEditor::Range & range);
     void highlightReplacement(const KTextEditor::Range & range);
+    void updateMatchCounter(const KTextEditor::Range & match);
     void indicateMatch(MatchResult matchResult);
     static void selectRange(KateView * view, const KTextEditor::Range & range);
     void selectRange2(const KTextEditor::Range & range);
@@ -179,6 +186,10 @@ private:
     QList<KTextEditor::MovingRange*> m_hlRanges;
     QPointer<KTextEditor::Message> m_infoMessage;
 
+    // all matches of the last find all or replace all, m_hlRanges highlights them
+    KateMatchIndex * m_matchIndex;
+    QTimer m_updateHighlightsTimer;
+
     // Shared by both dialogs
     QVBoxLayout *const m_layout;
     QWidget * m_widget;
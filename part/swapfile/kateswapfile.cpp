@@ -34,21 +34,52 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QApplication>
+#include <QThreadPool>
+#include <QRunnable>
 
 
 // swap file version header
-const static char * const swapFileVersionString = "Kate Swap File 2.0";
+const static char * const swapFileVersionString = "Kate Swap File 3.0";
 
-// tokens for swap files
+// header of the swap files without batches, still recovered
+const static char * const swapFileVersion2String = "Kate Swap File 2.0";
+
+// a batch is written at the latest after this time or once it is that large
+const static int batchInterval = 1000;
+const static int batchSize = 64 * 1024;
+
+// tokens for swap files, version 2.0 marks the transactions
 const static qint8 EA_StartEditing  = 'S';
 const static qint8 EA_FinishEditing = 'E';
 const static qint8 EA_WrapLine      = 'W';
 const static qint8 EA_UnwrapLine    = 'U';
 const static qint8 EA_InsertText    = 'I';
 const static qint8 EA_RemoveText    = 'R';
+const static qint8 EA_InsertLines   = 'L';
+const static qint8 EA_RemoveLines   = 'D';
 
 namespace Kate {
 
+/**
+ * Writes the queued batches of a swap file in the global thread pool.
+ */
+class SwapFileWriteTask : public QRunnable
+{
+  public:
+    SwapFileWriteTask (SwapFile *swapFile)
+      : m_swapFile (swapFile)
+    {
+    }
+
+    void run ()
+    {
+      m_swapFile->writeQueued ();
+    }
+
+  private:
+    SwapFile *const m_swapFile;
+};
+
 QTimer* SwapFile::s_timer = 0;
 
 SwapFile::SwapFile(KateDocument *document)
@@ -57,12 +88,24 @@ SwapFile::SwapFile(KateDocument *document)
   , m_trackingEnabled(false)
   , m_recovered(false)
   , m_needSync(false)
+  , m_batchBuffer(&m_batch)
+  , m_editing(false)
+  , m_pendingText(NoPendingText)
+  , m_pendingLine(0)
+  , m_pendingStartColumn(0)
+  , m_pendingEndColumn(0)
+  , m_writeSync(false)
+  , m_writeScheduled(false)
 {
   // fixed version of serialisation
   m_stream.setVersion (QDataStream::Qt_4_6);
 
-  // conect the timer
+  // conect the timers
   connect(syncTimer(), SIGNAL(timeout()), this, SLOT(writeFileToDisk()), Qt::DirectConnection);
+
+  m_batchTimer.setSingleShot(true);
+  m_batchTimer.setInterval(batchInterval);
+  connect(&m_batchTimer, SIGNAL(timeout()), this, SLOT(commitBatch()));
   
   // connecting the signals
   connect(&m_document->buffer(), SIGNAL(saved(QString)), this, SLOT(fileSaved(QString)));
@@ -79,6 +122,9 @@ SwapFile::~SwapFile()
   if (!shouldRecover()) {
     removeSwapFile();
   }
+
+  // the worker must be done with us
+  waitForWrites();
 }
 
 void SwapFile::configChanged()
@@ -104,6 +150,8 @@ void SwapFile::setTrackingEnabled(bool enable)
     connect(&buffer, SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
     connect(&buffer, SIGNAL(textInserted(KTextEditor::Cursor,QString)), this, SLOT(insertText(KTextEditor::Cursor,QString)));
     connect(&buffer, SIGNAL(textRemoved(KTextEditor::Range,QString)), this, SLOT(removeText(KTextEditor::Range)));
+    connect(&buffer, SIGNAL(linesInserted(int,QStringList)), this, SLOT(insertLines(int,QStringList)));
+    connect(&buffer, SIGNAL(linesRemoved(int,int)), this, SLOT(removeLines(int,int)));
   } else {
     disconnect(&buffer, SIGNAL(editingStarted()), this, SLOT(startEditing()));
     disconnect(&buffer, SIGNAL(editingFinished()), this, SLOT(finishEditing()));
@@ -113,6 +161,8 @@ void SwapFile::setTrackingEnabled(bool enable)
     disconnect(&buffer, SIGNAL(lineUnwrapped(int)), this, SLOT(unwrapLine(int)));
     disconnect(&buffer, SIGNAL(textInserted(KTextEditor::Cursor,QString)), this, SLOT(insertText(KTextEditor::Cursor,QString)));
     disconnect(&buffer, SIGNAL(textRemoved(KTextEditor::Range,QString)), this, SLOT(removeText(KTextEditor::Range)));
+    disconnect(&buffer, SIGNAL(linesInserted(int,QStringList)), this, SLOT(insertLines(int,QStringList)));
+    disconnect(&buffer, SIGNAL(linesRemoved(int,int)), this, SLOT(removeLines(int,int)));
   }
 }
 
@@ -134,13 +184,22 @@ KateDocument* SwapFile::document()
   return m_document;
 }
 
-bool SwapFile::isValidSwapFile(QDataStream& stream, bool checkDigest) const
+bool SwapFile::isValidSwapFile(QDataStream& stream, bool checkDigest, int *version) const
 {
   // read and check header
   QByteArray header;
   stream >> header;
 
-  if (header != swapFileVersionString) {
+  int headerVersion = 0;
+  if (header == swapFileVersionString)
+    headerVersion = 3;
+  else if (header == swapFileVersion2String)
+    headerVersion = 2;
+
+  if (version)
+    *version = headerVersion;
+
+  if (headerVersion == 0) {
     kWarning( 13020 ) << "Can't open swap file, wrong version";
     return false;
   }
@@ -179,8 +238,13 @@ void SwapFile::fileLoaded(const QString&)
   QFile peekFile(fileName());
   if (peekFile.open(QIODevice::ReadOnly)) {
     QDataStream stream(&peekFile);
-    if (!isValidSwapFile(stream, true)) {
-      removeSwapFile();
+    int version = 0;
+    if (!isValidSwapFile(stream, true, &version)) {
+      // a swap file of an unknown version, e.g. of a newer Kate, is not ours: neither delete nor append to it
+      if (version == 0)
+        m_swapfile.setFileName(QString());
+      else
+        removeSwapFile();
       return;
     }
     peekFile.close();
@@ -207,11 +271,11 @@ void SwapFile::recover()
 {
   m_document->setReadWrite(true);
 
-  // if isOpen() returns true, the swap file likely changed already (appended data)
+  // if we are tracking, the swap file likely changed already (appended data)
   // Example: The document was falsely marked as writable and the user changed
   // text even though the recover bar was visible. In this case, a replay of
   // the swap file across wrong document content would happen -> certainly wrong
-  if (m_swapfile.isOpen()) {
+  if (isTracking()) {
     kWarning( 13020 ) << "Attempt to recover an already modified document. Aborting";
     removeSwapFile();
     return;
@@ -228,17 +292,23 @@ void SwapFile::recover()
   m_recovered = true;
   
   // open data stream
-  m_stream.setDevice(&m_swapfile);
+  QDataStream stream(&m_swapfile);
+  stream.setVersion (QDataStream::Qt_4_6);
 
   // replay the swap file
-  bool success = recover(m_stream);
+  int version = 0;
+  QList<QByteArray> batches;
+  bool success = readSwapFile(stream, true, &version, batches);
+  if (success)
+    replayBatches(batches);
 
   // close swap file
-  m_stream.setDevice(0);
   m_swapfile.close();
 
   if (!success)
     removeSwapFile();
+  else if (version == 2)
+    upgradeSwapFile(batches);
 
   // recover can also be called through the KTE::RecoveryInterface.
   // Make sure, the message is hidden in this case as well.
@@ -248,39 +318,188 @@ void SwapFile::recover()
 
 bool SwapFile::recover(QDataStream& stream, bool checkDigest)
 {
-  if (!isValidSwapFile(stream, checkDigest)) {
+  QList<QByteArray> batches;
+  if (!readSwapFile(stream, checkDigest, 0, batches)) {
     return false;
   }
 
-  // disconnect current signals
-  setTrackingEnabled(false);
+  replayBatches(batches);
+  return true;
+}
+
+bool SwapFile::readSwapFile(QDataStream& stream, bool checkDigest, int *version, QList<QByteArray> &batches) const
+{
+  int headerVersion = 0;
+  if (!isValidSwapFile(stream, checkDigest, &headerVersion)) {
+    return false;
+  }
+
+  if (version)
+    *version = headerVersion;
 
-  // replay swapfile
-  bool editStarted = false;
   bool brokenSwapFile = false;
-  while (!stream.atEnd()) {
-    if (brokenSwapFile)
-      break;
+  if (headerVersion == 2) {
+    brokenSwapFile = !readVersion2Batches(stream, batches);
+  } else {
+    while (!stream.atEnd()) {
+      QByteArray batch;
+      quint16 checksum = 0;
+      stream >> batch >> checksum;
+
+      // the last batch might be incomplete, if we crashed while writing it
+      if (stream.status() != QDataStream::Ok || checksum != qChecksum(batch.constData(), batch.size())) {
+        brokenSwapFile = true;
+        break;
+      }
 
+      batches.append(batch);
+    }
+  }
+
+  // warn the user if the swap file is not complete
+  if (brokenSwapFile) {
+    kWarning ( 13020 ) << "Some data might be lost";
+  }
+
+  return true;
+}
+
+bool SwapFile::readVersion2Batches(QDataStream& stream, QList<QByteArray> &batches) const
+{
+  // the edit actions of version 2.0 are the ones of the batches, framed by tokens
+  const QByteArray data = stream.device()->readAll();
+  QDataStream actions(data);
+  actions.setVersion (QDataStream::Qt_4_6);
+
+  int start = -1;
+  while (!actions.atEnd()) {
+    const int position = actions.device()->pos();
     qint8 type;
-    stream >> type;
+    actions >> type;
+
+    // all edit actions belong to a transaction
+    if (type != EA_StartEditing && start < 0)
+      return false;
+
     switch (type) {
       case EA_StartEditing: {
-        m_document->editStart();
-        editStarted = true;
+        if (start >= 0)
+          return false;
+        start = actions.device()->pos();
         break;
       }
       case EA_FinishEditing: {
-        m_document->editEnd();
-        editStarted = false;
+        batches.append(data.mid(start, position - start));
+        start = -1;
         break;
       }
       case EA_WrapLine: {
-        if (!editStarted) {
-          brokenSwapFile = true;
-          break;
+        int line, column;
+        actions >> line >> column;
+        break;
+      }
+      case EA_UnwrapLine: {
+        int line;
+        actions >> line;
+        break;
+      }
+      case EA_InsertText: {
+        int line, column;
+        QByteArray text;
+        actions >> line >> column >> text;
+        break;
+      }
+      case EA_RemoveText: {
+        int line, startColumn, endColumn;
+        actions >> line >> startColumn >> endColumn;
+        break;
+      }
+      case EA_InsertLines: {
+        int line, count;
+        actions >> line >> count;
+        for (int i = 0; i < count && actions.status() == QDataStream::Ok; ++i) {
+          QByteArray text;
+          actions >> text;
         }
+        break;
+      }
+      case EA_RemoveLines: {
+        int from, to;
+        actions >> from >> to;
+        break;
+      }
+      default: {
+        kWarning( 13020 ) << "Unknown type:" << type;
+        return false;
+      }
+    }
+
+    // the last action might be incomplete, if we crashed while writing it
+    if (actions.status() != QDataStream::Ok) {
+      if (start >= 0)
+        batches.append(data.mid(start, position - start));
+      return false;
+    }
+  }
+
+  // the last transaction was not finished, replay it as far as written
+  if (start >= 0) {
+    batches.append(data.mid(start));
+    return false;
+  }
+
+  return true;
+}
+
+void SwapFile::replayBatches(const QList<QByteArray> &batches)
+{
+  // disconnect current signals
+  setTrackingEnabled(false);
+
+  // replay swapfile, one editing transaction per batch
+  foreach (const QByteArray &batch, batches) {
+    m_document->editStart();
+    const bool brokenBatch = !replayBatch(batch);
+    m_document->editEnd();
 
+    if (brokenBatch) {
+      kWarning ( 13020 ) << "Some data might be lost";
+      break;
+    }
+  }
+
+  // reconnect the signals
+  setTrackingEnabled(true);
+}
+
+void SwapFile::upgradeSwapFile(const QList<QByteArray> &batches)
+{
+  // further edits are appended as batches, write the recovered ones the same way
+  if (!m_swapfile.open(QIODevice::WriteOnly)) {
+    kWarning( 13020 ) << "Can't write swap file:" << fileName();
+    return;
+  }
+
+  QDataStream stream(&m_swapfile);
+  stream.setVersion (QDataStream::Qt_4_6);
+  stream << QByteArray (swapFileVersionString);
+  stream << m_document->digest ();
+  foreach (const QByteArray &batch, batches)
+    stream << batch << qChecksum(batch.constData(), batch.size());
+
+  m_swapfile.close();
+}
+
+bool SwapFile::replayBatch(const QByteArray &batch)
+{
+  QDataStream stream(batch);
+  stream.setVersion (QDataStream::Qt_4_6);
+
+  while (!stream.atEnd()) {
+    qint8 type;
+    stream >> type;
+    switch (type) {
+      case EA_WrapLine: {
         int line = 0, column = 0;
         stream >> line >> column;
         
@@ -289,11 +508,6 @@ bool SwapFile::recover(QDataStream& stream, bool checkDigest)
         break;
       }
       case EA_UnwrapLine: {
-        if (!editStarted) {
-          brokenSwapFile = true;
-          break;
-        }
-
         int line = 0;
         stream >> line;
         
@@ -305,11 +519,6 @@ bool SwapFile::recover(QDataStream& stream, bool checkDigest)
         break;
       }
       case EA_InsertText: {
-        if (!editStarted) {
-          brokenSwapFile = true;
-          break;
-        }
-
         int line, column;
         QByteArray text;
         stream >> line >> column >> text;
@@ -317,36 +526,36 @@ bool SwapFile::recover(QDataStream& stream, bool checkDigest)
         break;
       }
       case EA_RemoveText: {
-        if (!editStarted) {
-          brokenSwapFile = true;
-          break;
-        }
-
         int line, startColumn, endColumn;
         stream >> line >> startColumn >> endColumn;
         m_document->removeText (KTextEditor::Range(KTextEditor::Cursor(line, startColumn), KTextEditor::Cursor(line, endColumn)));
         break;
       }
+      case EA_InsertLines: {
+        int line, count;
+        stream >> line >> count;
+        QStringList texts;
+        for (int i = 0; i < count; ++i) {
+          QByteArray text;
+          stream >> text;
+          texts.append (QString::fromUtf8 (text.data (), text.size()));
+        }
+        m_document->editInsertLines (line, texts);
+        break;
+      }
+      case EA_RemoveLines: {
+        int from, to;
+        stream >> from >> to;
+        m_document->editRemoveLines (from, to);
+        break;
+      }
       default: {
         kWarning( 13020 ) << "Unknown type:" << type;
+        return false;
       }
     }
   }
 
-  // balance editStart and editEnd
-  if (editStarted) {
-    brokenSwapFile = true;
-    m_document->editEnd();
-  }
-
-  // warn the user if the swap file is not complete
-  if (brokenSwapFile) {
-    kWarning ( 13020 ) << "Some data might be lost";
-  }
-  
-  // reconnect the signals
-  setTrackingEnabled(true);
-  
   return true;
 }
 
@@ -363,6 +572,12 @@ void SwapFile::fileSaved(const QString&)
 
 void SwapFile::startEditing ()
 {
+  // already open, the worker thread might write to m_swapfile, don't touch it
+  if (isTracking()) {
+    m_editing = true;
+    return;
+  }
+
   // no swap file, no work
   if (m_swapfile.fileName().isEmpty())
     return;
@@ -373,44 +588,58 @@ void SwapFile::startEditing ()
   if (!m_swapfile.exists()) {
     // TODO set file as read-only
     m_swapfile.open(QIODevice::WriteOnly);
-    m_stream.setDevice(&m_swapfile);
-
-    // write file header
-    m_stream << QByteArray (swapFileVersionString);
-    
-    // write md5 digest
-    m_stream << m_document->digest ();
-  } else if (m_stream.device() == 0) {
+
+    // write file header and md5 digest, the worker is idle as the file was closed
+    QDataStream header(&m_swapfile);
+    header.setVersion (QDataStream::Qt_4_6);
+    header << QByteArray (swapFileVersionString);
+    header << m_document->digest ();
+    m_swapfile.flush();
+
+    m_batchBuffer.open(QIODevice::WriteOnly);
+    m_stream.setDevice(&m_batchBuffer);
+  } else {
     m_swapfile.open(QIODevice::Append);
-    m_stream.setDevice(&m_swapfile);
+    m_batchBuffer.open(QIODevice::WriteOnly);
+    m_stream.setDevice(&m_batchBuffer);
   }
-  
-  // format: qint8  
-  m_stream << EA_StartEditing;
+
+  // the batch is only written between transactions
+  m_editing = true;
 }
 
 void SwapFile::finishEditing ()
 {
+  m_editing = false;
+
   // skip if not open
-  if (!m_swapfile.isOpen ())
+  if (!isTracking ())
+    return;
+
+  // nothing changed
+  if (m_batch.isEmpty() && m_pendingText == NoPendingText)
     return;
 
   // write the file to the disk every 15 seconds
   // skip this if we disabled forced syncing 
   if (!m_document->config()->swapFileNoSync() && !syncTimer()->isActive())
     syncTimer()->start(15000);
-  
-  // format: qint8
-  m_stream << EA_FinishEditing;
-  m_swapfile.flush();
+
+  // large batches are written at once, else wait for more edits to merge
+  if (m_batch.size() >= batchSize)
+    commitBatch();
+  else if (!m_batchTimer.isActive())
+    m_batchTimer.start();
 }
 
 void SwapFile::wrapLine (const KTextEditor::Cursor &position)
 {
   // skip if not open
-  if (!m_swapfile.isOpen ())
+  if (!isTracking ())
     return;
   
+  writePendingText();
+
   // format: qint8, int, int
   m_stream << EA_WrapLine << position.line() << position.column();
 
@@ -420,9 +649,11 @@ void SwapFile::wrapLine (const KTextEditor::Cursor &position)
 void SwapFile::unwrapLine (int line)
 {
   // skip if not open
-  if (!m_swapfile.isOpen ())
+  if (!isTracking ())
     return;
   
+  writePendingText();
+
   // format: qint8, int
   m_stream << EA_UnwrapLine << line;
 
@@ -432,37 +663,191 @@ void SwapFile::unwrapLine (int line)
 void SwapFile::insertText (const KTextEditor::Cursor &position, const QString &text)
 {
   // skip if not open
-  if (!m_swapfile.isOpen ())
+  if (!isTracking ())
     return;
   
-  // format: qint8, int, int, bytearray
-  m_stream << EA_InsertText << position.line() << position.column() << text.toUtf8 ();
-
   m_needSync = true;
+
+  // typing: append to the last insertion
+  if (m_pendingText == PendingInsert && position.line() == m_pendingLine
+      && position.column() == m_pendingStartColumn + m_pendingInsertion.size()) {
+    m_pendingInsertion += text;
+    return;
+  }
+
+  writePendingText();
+
+  m_pendingText = PendingInsert;
+  m_pendingLine = position.line();
+  m_pendingStartColumn = position.column();
+  m_pendingInsertion = text;
 }
 
 void SwapFile::removeText (const KTextEditor::Range &range)
 {
   // skip if not open
-  if (!m_swapfile.isOpen ())
+  if (!isTracking ())
     return;
   
-  // format: qint8, int, int, int
   Q_ASSERT (range.start().line() == range.end().line());
-  m_stream << EA_RemoveText
-            << range.start().line() << range.start().column()
-            << range.end().column();
+  m_needSync = true;
+
+  if (m_pendingText == PendingRemove && range.start().line() == m_pendingLine) {
+    // backspace: the removal ends where the last one started
+    if (range.end().column() == m_pendingStartColumn) {
+      m_pendingStartColumn = range.start().column();
+      return;
+    }
+
+    // delete: the removal starts where the last one started
+    if (range.start().column() == m_pendingStartColumn) {
+      m_pendingEndColumn += range.columnWidth();
+      return;
+    }
+  }
+
+  writePendingText();
+
+  m_pendingText = PendingRemove;
+  m_pendingLine = range.start().line();
+  m_pendingStartColumn = range.start().column();
+  m_pendingEndColumn = range.end().column();
+}
+
+void SwapFile::insertLines (int line, const QStringList &texts)
+{
+  // skip if not open
+  if (!isTracking ())
+    return;
+
+  writePendingText();
+
+  // format: qint8, int, int, bytearray for each line
+  m_stream << EA_InsertLines << line << texts.size();
+  foreach (const QString &text, texts)
+    m_stream << text.toUtf8 ();
+
+  m_needSync = true;
+}
+
+void SwapFile::removeLines (int from, int to)
+{
+  // skip if not open
+  if (!isTracking ())
+    return;
+
+  writePendingText();
+
+  // format: qint8, int, int
+  m_stream << EA_RemoveLines << from << to;
 
   m_needSync = true;
 }
 
+void SwapFile::writePendingText ()
+{
+  if (m_pendingText == PendingInsert) {
+    // format: qint8, int, int, bytearray
+    m_stream << EA_InsertText << m_pendingLine << m_pendingStartColumn << m_pendingInsertion.toUtf8 ();
+    m_pendingInsertion.clear();
+  } else if (m_pendingText == PendingRemove) {
+    // format: qint8, int, int, int
+    m_stream << EA_RemoveText << m_pendingLine << m_pendingStartColumn << m_pendingEndColumn;
+  }
+
+  m_pendingText = NoPendingText;
+}
+
+void SwapFile::commitBatch ()
+{
+  // a batch is one editing transaction on recovery, never split one
+  if (m_editing || !isTracking ())
+    return;
+
+  m_batchTimer.stop();
+  writePendingText();
+
+  if (m_batch.isEmpty())
+    return;
+
+  // format: bytearray, quint16 checksum of it
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion (QDataStream::Qt_4_6);
+  stream << m_batch << qChecksum(m_batch.constData(), m_batch.size());
+
+  m_batch.clear();
+  m_batchBuffer.seek(0);
+
+  queueWrite(data, false);
+}
+
+void SwapFile::queueWrite (const QByteArray &data, bool sync)
+{
+  QMutexLocker locker(&m_writeMutex);
+
+  m_writeQueue += data;
+  m_writeSync = m_writeSync || sync;
+
+  // one worker at a time per swap file, it takes all queued data
+  if (!m_writeScheduled) {
+    m_writeScheduled = true;
+    QThreadPool::globalInstance()->start(new SwapFileWriteTask(this));
+  }
+}
+
+void SwapFile::writeQueued ()
+{
+  QMutexLocker locker(&m_writeMutex);
+
+  while (!m_writeQueue.isEmpty() || m_writeSync) {
+    const QByteArray data = m_writeQueue;
+    const bool sync = m_writeSync;
+    m_writeQueue.clear();
+    m_writeSync = false;
+
+    // the gui thread doesn't touch the open file, it waits for us before closing it
+    locker.unlock();
+
+    if (!data.isEmpty()) {
+      m_swapfile.write(data);
+      m_swapfile.flush();
+    }
+
+    if (sync) {
+      #ifndef Q_OS_WIN
+      // ensure that the file is written to disk
+      #ifdef HAVE_FDATASYNC
+      fdatasync (m_swapfile.handle());
+      #else
+      fsync (m_swapfile.handle());
+      #endif
+      #endif
+    }
+
+    locker.relock();
+  }
+
+  m_writeScheduled = false;
+  m_writeDone.wakeAll();
+}
+
+void SwapFile::waitForWrites ()
+{
+  QMutexLocker locker(&m_writeMutex);
+
+  while (m_writeScheduled)
+    m_writeDone.wait(&m_writeMutex);
+}
+
 bool SwapFile::shouldRecover() const
 {
   // should not recover if the file has already recovered in another view
   if (m_recovered)
     return false;
 
-  return !m_swapfile.fileName().isEmpty() && m_swapfile.exists() && m_stream.device() == 0;
+  // while tracking, the worker thread might write to m_swapfile, don't touch it
+  return !isTracking() && !m_swapfile.fileName().isEmpty() && m_swapfile.exists();
 }
 
 void SwapFile::discard()
@@ -478,7 +863,17 @@ void SwapFile::discard()
 
 void SwapFile::removeSwapFile()
 {
+  // the worker must be done before we touch m_swapfile
+  waitForWrites();
+
   if (!m_swapfile.fileName().isEmpty() && m_swapfile.exists()) {
+    // drop the edit actions not yet written
+    m_batchTimer.stop();
+    m_pendingText = NoPendingText;
+    m_pendingInsertion.clear();
+    m_batch.clear();
+    m_batchBuffer.close();
+
     m_stream.setDevice(0);
     m_swapfile.close();
     m_swapfile.remove();
@@ -525,17 +920,13 @@ QTimer* SwapFile::syncTimer()
 
 void SwapFile::writeFileToDisk()
 {
-  if (m_needSync) {
+  // inside a transaction, finishEditing() starts the timer again
+  if (m_needSync && !m_editing && isTracking()) {
     m_needSync = false;
 
-    #ifndef Q_OS_WIN
-    // ensure that the file is written to disk
-    #ifdef HAVE_FDATASYNC
-    fdatasync (m_swapfile.handle());
-    #else
-    fsync (m_swapfile.handle());
-    #endif
-    #endif
+    // write what we have and let the worker sync it
+    commitBatch();
+    queueWrite(QByteArray(), true);
   }
 }
 
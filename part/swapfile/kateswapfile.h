@@ -24,6 +24,9 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QDataStream>
+#include <QtCore/QBuffer>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include <QFile>
 #include <QTimer>
 
@@ -35,6 +38,7 @@
 #include <messageinterface.h>
 
 class KateView;
+class SwapFileTest;
 
 namespace Kate {
 
@@ -42,11 +46,25 @@ namespace Kate {
  * Class for tracking editing actions.
  * In case Kate crashes, this can be used to replay all edit actions to
  * recover the lost data.
+ *
+ * The edit actions are collected in a batch in memory, adjacent insertions
+ * and removals of text are merged. A worker thread appends the batch with a
+ * checksum to the swap file, at the latest one second after its first edit
+ * or once it is larger than 64 kB, so this is all a crash of Kate can lose.
+ * The worker syncs the file to the disk 15 seconds after the first unsynced
+ * edit, unless syncing is disabled in the config.
+ * A batch is replayed in one editing transaction, a batch with a wrong
+ * checksum, e.g. written partially, stops the recovery.
+ * Swap files of version 2.0 are still recovered, their transactions become
+ * the batches; swap files of unknown versions are left alone.
  */
 class KATEPART_TESTS_EXPORT SwapFile : public QObject
 {
   Q_OBJECT
 
+  friend class SwapFileWriteTask;
+  friend class ::SwapFileTest;
+
   public:
     explicit SwapFile(KateDocument* document);
     ~SwapFile();
@@ -61,7 +79,69 @@ class KATEPART_TESTS_EXPORT SwapFile : public QObject
     void setTrackingEnabled(bool trackingEnabled);
     void removeSwapFile();
     bool updateFileName();
-    bool isValidSwapFile(QDataStream& stream, bool checkDigest) const;
+    bool isValidSwapFile(QDataStream& stream, bool checkDigest, int *version = 0) const;
+
+    /**
+     * Read the batches of a swap file, version 3.0 or 2.0.
+     * @param version set to the major version of the swap file, if not null
+     * @param batches the complete batches, the ones after a broken one are skipped
+     * @return false if the swap file is not valid
+     */
+    bool readSwapFile(QDataStream& stream, bool checkDigest, int *version, QList<QByteArray> &batches) const;
+
+    /**
+     * Convert the transactions of a swap file of version 2.0 into batches.
+     * @return false if the swap file is broken, batches holds what could be read
+     */
+    bool readVersion2Batches(QDataStream& stream, QList<QByteArray> &batches) const;
+
+    /**
+     * Replay the batches, one editing transaction each, without tracking them.
+     */
+    void replayBatches(const QList<QByteArray> &batches);
+
+    /**
+     * Write the recovered batches of a swap file of version 2.0 as version 3.0,
+     * edits after the recovery are appended to it.
+     */
+    void upgradeSwapFile(const QList<QByteArray> &batches);
+
+    /**
+     * Are the edit actions written to the swap file? This doesn't touch
+     * m_swapfile, which the worker thread writes meanwhile.
+     */
+    bool isTracking() const
+    {
+      return m_stream.device() != 0;
+    }
+
+    /**
+     * Replay the edit actions of one batch, an editing transaction must be running.
+     * @return false if the batch contains unknown actions
+     */
+    bool replayBatch(const QByteArray &batch);
+
+    /**
+     * Write the merged text insertion or removal to the batch.
+     */
+    void writePendingText();
+
+    /**
+     * Queue data for the worker thread.
+     * @param data data to append to the swap file
+     * @param sync sync the swap file to disk after writing
+     */
+    void queueWrite(const QByteArray &data, bool sync);
+
+    /**
+     * Called by the worker thread, writes all queued data.
+     */
+    void writeQueued();
+
+    /**
+     * Wait for the worker thread, e.g. before closing the swap file.
+     */
+    void waitForWrites();
 
   private:
     KateDocument *m_document;
@@ -79,6 +159,8 @@ class KATEPART_TESTS_EXPORT SwapFile : public QObject
     void unwrapLine (int line);
     void insertText (const KTextEditor::Cursor &position, const QString &text);
     void removeText (const KTextEditor::Range &range);
+    void insertLines (int line, const QStringList &texts);
+    void removeLines (int from, int to);
 
   public Q_SLOTS:
     void discard();
@@ -93,9 +175,41 @@ class KATEPART_TESTS_EXPORT SwapFile : public QObject
     bool m_needSync;
     static QTimer *s_timer;
 
+    /**
+     * edit actions not yet written to the swap file, m_stream writes to it
+     */
+    QByteArray m_batch;
+    QBuffer m_batchBuffer;
+    QTimer m_batchTimer;
+    bool m_editing;
+
+    /**
+     * text insertion or removal which might still be merged with the next one
+     */
+    enum PendingText { NoPendingText, PendingInsert, PendingRemove };
+    PendingText m_pendingText;
+    int m_pendingLine;
+    int m_pendingStartColumn;
+    int m_pendingEndColumn;
+    QString m_pendingInsertion;
+
+    /**
+     * data for the worker thread, protected by m_writeMutex
+     */
+    QMutex m_writeMutex;
+    QWaitCondition m_writeDone;
+    QByteArray m_writeQueue;
+    bool m_writeSync;
+    bool m_writeScheduled;
+
   protected Q_SLOTS:
     void writeFileToDisk();
 
+    /**
+     * Hand the collected edit actions over to the worker thread.
+     */
+    void commitBatch();
+
   private:
     QTimer* syncTimer();
 
@@ -1193,6 +1193,34 @@ void KateCodeFoldingTree::lineHasBeenInserted(int line, int column)
   }
 }
 
+// called when whole lines have been inserted in front of "line", e.g. by a paste
+void KateCodeFoldingTree::linesHaveBeenInserted(int line, int count)
+{
+  QMap <int, QVector <KateCodeFoldingNode*> > tempMap = m_lineMapping;
+  QMapIterator <int, QVector <KateCodeFoldingNode*> > iterator(tempMap);
+  QVector <KateCodeFoldingNode*> tempVector;
+  m_lineMapping.clear();
+
+  // Coppy the lines before "line"
+  while (iterator.hasNext() && iterator.peekNext().key() < line) {
+    int key = iterator.peekNext().key();
+    tempVector = iterator.peekNext().value();
+    Q_ASSERT(!tempVector.isEmpty());
+    m_lineMapping.insert(key,tempVector);
+    iterator.next();
+  }
+
+  // All the other lines are moved behind the inserted ones
+  while (iterator.hasNext()) {
+    int key = iterator.peekNext().key();
+    tempVector = iterator.peekNext().value();
+    addDeltaToLine(tempVector, count);
+    Q_ASSERT(!tempVector.isEmpty());
+    m_lineMapping.insert(key + count,tempVector);
+    iterator.next();
+  }
+}
+
 // Called when a line was removed from the document
 void KateCodeFoldingTree::linesHaveBeenRemoved(int from, int to)
 {
@@ -240,6 +240,7 @@ class KATEPART_TESTS_EXPORT KateCodeFoldingTree : public QObject
     void addDeltaToLine (QVector <KateCodeFoldingNode*> &nodesLine, int delta);
 
     void lineHasBeenInserted (int line, int column);
+    void linesHaveBeenInserted (int line, int count);
     void linesHaveBeenRemoved  (int from, int to);
 
   // Makes clear what KateLineInfo contains
@@ -218,6 +218,7 @@ int KateHighlighting::makeDynamicContext(KateHlContext *model, const QStringList
 #endif
 
     KateHlContext *newctx = model->clone(args);
+    newctx->compileDispatchTable();
 
     m_contexts.push_back (newctx);
 
@@ -341,7 +342,8 @@ void KateHighlighting::doHighlight ( Kate::TextLineData *prevLine,
       bool anItemMatched = false;
       bool customStartEnableDetermined = false;
 
-      foreach (item, context->items)
+      // only the items that can start with the current char, in rule order
+      foreach (item, context->itemsForChar (text[offset]))
       {
         // does we only match if we are firstNonSpace?
         if (item->firstNonSpace && (offset > startNonSpace))
@@ -1002,6 +1004,24 @@ int KateHighlighting::attribute(int ctx) const
   return m_contexts[ctx]->attr;
 }
 
+int KateHighlighting::defaultStyleForAttribute( int attrib ) const
+{
+  // without highlighting or for unknown attributes, all is normal text
+  if ( attrib < 0 || attrib >= internalIDList.size() )
+    return KTextEditor::HighlightInterface::dsNormal;
+
+  return internalIDList.at( attrib )->defaultStyleIndex();
+}
+
+bool KateHighlighting::isCodeStyle( int defaultStyle )
+{
+  return ( defaultStyle != KTextEditor::HighlightInterface::dsComment
+        && defaultStyle != KTextEditor::HighlightInterface::dsString
+        && defaultStyle != KTextEditor::HighlightInterface::dsRegionMarker
+        && defaultStyle != KTextEditor::HighlightInterface::dsChar
+        && defaultStyle != KTextEditor::HighlightInterface::dsOthers );
+}
+
 bool KateHighlighting::attributeRequiresSpellchecking( int attr )
 {
   QList<KTextEditor::Attribute::Ptr> attributeList = attributes("");
@@ -1636,6 +1656,10 @@ void KateHighlighting::makeContextList()
   // belongs to
   handleKateHlIncludeRules();
 
+  // now the items of all contexts are known, compile the dispatch tables
+  foreach (KateHlContext *context, m_contexts)
+    context->compileDispatchTable();
+
   embeddedHighlightingModes = embeddedHls.keys();
   embeddedHighlightingModes.removeOne(iName);
 
@@ -228,6 +228,21 @@ class KateHighlighting
 
     int defaultStyleForAttribute( int attrib ) const;
 
+    /**
+     * Is the given default style one of code?
+     * Comments, strings, chars, region markers and others are no code.
+     * @param defaultStyle default style to check
+     * @return code style?
+     */
+    static bool isCodeStyle( int defaultStyle );
+
+    /**
+     * Does the given attribute highlight code, is its default style one of code?
+     * @param attrib attribute to check
+     * @return code attribute?
+     */
+    bool attributeIsCode( int attrib ) const { return isCodeStyle( defaultStyleForAttribute( attrib ) ); }
+
     void clearAttributeArrays ();
 
     QList<KTextEditor::Attribute::Ptr> attributes (const QString &schema);
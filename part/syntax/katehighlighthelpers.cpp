@@ -83,6 +83,25 @@ void KateHlItem::dynamicSubstitute(QString &str, const QStringList *args)
     }
   }
 }
+
+// all latin-1 characters which are equal to one of the given ones, ignoring case
+// characters >= 256 might match, too, their case mapping is not checked here
+static void addCaseInsensitiveStartChars(QSet<QChar> &chars, bool &nonLatin1, const QSet<QChar> &firstChars)
+{
+  QSet<QChar> upperChars;
+  QSet<QChar> lowerChars;
+  foreach (const QChar &c, firstChars)
+  {
+    upperChars << c.toUpper();
+    lowerChars << c.toLower();
+  }
+
+  for (int c = 0; c < 256; ++c)
+    if (upperChars.contains(QChar(c).toUpper()) || lowerChars.contains(QChar(c).toLower()))
+      chars << QChar(c);
+
+  nonLatin1 = true;
+}
 //END
 
 //BEGIN KateHlCharDetect
@@ -100,6 +119,17 @@ int KateHlCharDetect::checkHgl(const QString& text, int offset, int /*len*/)
   return 0;
 }
 
+bool KateHlCharDetect::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  // char might still be a placeholder
+  if (dynamic)
+    return false;
+
+  chars << sChar;
+  nonLatin1 = sChar.unicode() >= 256;
+  return true;
+}
+
 KateHlItem *KateHlCharDetect::clone(const QStringList *args)
 {
   char c = sChar.toLatin1();
@@ -129,6 +159,16 @@ int KateHl2CharDetect::checkHgl(const QString& text, int offset, int len)
   return 0;
 }
 
+bool KateHl2CharDetect::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  if (dynamic)
+    return false;
+
+  chars << sChar1;
+  nonLatin1 = sChar1.unicode() >= 256;
+  return true;
+}
+
 KateHlItem *KateHl2CharDetect::clone(const QStringList *args)
 {
   char c1 = sChar1.toLatin1();
@@ -180,6 +220,22 @@ int KateHlStringDetect::checkHgl(const QString& text, int offset, int len)
   return 0;
 }
 
+bool KateHlStringDetect::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  if (dynamic || str.isEmpty())
+    return false;
+
+  if (_inSensitive)
+    addCaseInsensitiveStartChars(chars, nonLatin1, QSet<QChar>() << str[0]);
+  else
+  {
+    chars << str[0];
+    nonLatin1 = str[0].unicode() >= 256;
+  }
+
+  return true;
+}
+
 KateHlItem *KateHlStringDetect::clone(const QStringList *args)
 {
   QString newstr = str;
@@ -267,6 +323,13 @@ int KateHlRangeDetect::checkHgl(const QString& text, int offset, int len)
   }
   return 0;
 }
+
+bool KateHlRangeDetect::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << sChar1;
+  nonLatin1 = sChar1.unicode() >= 256;
+  return true;
+}
 //END
 
 //BEGIN KateHlKeyword
@@ -346,6 +409,29 @@ int KateHlKeyword::checkHgl(const QString& text, int offset, int len)
 
   return 0;
 }
+
+bool KateHlKeyword::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  // first characters of all keywords
+  QSet<QChar> firstChars;
+  foreach (QSet<QString> *words, dict)
+    if (words)
+      foreach (const QString &word, *words)
+        if (!word.isEmpty())
+          firstChars << word[0];
+
+  if (_insensitive)
+    addCaseInsensitiveStartChars(chars, nonLatin1, firstChars);
+  else
+  {
+    chars += firstChars;
+    nonLatin1 = false;
+    foreach (const QChar &c, firstChars)
+      nonLatin1 = nonLatin1 || c.unicode() >= 256;
+  }
+
+  return true;
+}
 //END
 
 //BEGIN KateHlInt
@@ -355,6 +441,22 @@ KateHlInt::KateHlInt(int attribute, KateHlContextModification context, signed ch
   alwaysStartEnable = false;
 }
 
+// all latin-1 digits, other unicode digits start a number, too
+static void addDigitStartChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  for (int c = 0; c < 256; ++c)
+    if (QChar(c).isDigit())
+      chars << QChar(c);
+
+  nonLatin1 = true;
+}
+
+bool KateHlInt::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  addDigitStartChars(chars, nonLatin1);
+  return true;
+}
+
 int KateHlInt::checkHgl(const QString& text, int offset, int len)
 {
   int offset2 = offset;
@@ -390,6 +492,13 @@ KateHlFloat::KateHlFloat(int attribute, KateHlContextModification context, signe
   alwaysStartEnable = false;
 }
 
+bool KateHlFloat::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  addDigitStartChars(chars, nonLatin1);
+  chars << QChar('.');
+  return true;
+}
+
 int KateHlFloat::checkHgl(const QString& text, int offset, int len)
 {
   bool b = false;
@@ -486,6 +595,13 @@ KateHlCOct::KateHlCOct(int attribute, KateHlContextModification context, signed
   alwaysStartEnable = false;
 }
 
+bool KateHlCOct::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << QChar('0');
+  nonLatin1 = false;
+  return true;
+}
+
 int KateHlCOct::checkHgl(const QString& text, int offset, int len)
 {
   if (text[offset].toAscii() == '0')
@@ -521,6 +637,13 @@ KateHlCHex::KateHlCHex(int attribute, KateHlContextModification context,signed c
   alwaysStartEnable = false;
 }
 
+bool KateHlCHex::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << QChar('0');
+  nonLatin1 = false;
+  return true;
+}
+
 int KateHlCHex::checkHgl(const QString& text, int offset, int len)
 {
   if ((len > 1) && (text[offset++].toAscii() == '0') && ((text[offset++].toAscii() & 0xdf) == 'X' ))
@@ -607,6 +730,18 @@ int KateHlAnyChar::checkHgl(const QString& text, int offset, int)
 
   return 0;
 }
+
+bool KateHlAnyChar::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  nonLatin1 = false;
+  foreach (const QChar &c, _charList)
+  {
+    chars << c;
+    nonLatin1 = nonLatin1 || c.unicode() >= 256;
+  }
+
+  return true;
+}
 //END
 
 //BEGIN KateHlRegExpr
@@ -695,6 +830,13 @@ int KateHlLineContinue::checkHgl(const QString& text, int offset, int len)
 
   return 0;
 }
+
+bool KateHlLineContinue::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << QChar('\\');
+  nonLatin1 = false;
+  return true;
+}
 //END
 
 //BEGIN KateHlCStringChar
@@ -776,6 +918,13 @@ int KateHlCStringChar::checkHgl(const QString& text, int offset, int len)
 {
   return checkEscapedChar(text, offset, len);
 }
+
+bool KateHlCStringChar::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << QChar('\\');
+  nonLatin1 = false;
+  return true;
+}
 //END
 
 //BEGIN KateHlCChar
@@ -813,6 +962,13 @@ int KateHlCChar::checkHgl(const QString& text, int offset, int len)
 
   return 0;
 }
+
+bool KateHlCChar::startChars(QSet<QChar> &chars, bool &nonLatin1)
+{
+  chars << QChar('\'');
+  nonLatin1 = false;
+  return true;
+}
 //END
 
 //BEGIN KateHl2CharDetect
@@ -860,6 +1016,43 @@ KateHlContext *KateHlContext::clone(const QStringList *args)
   return ret;
 }
 
+void KateHlContext::compileDispatchTable()
+{
+  // start characters of all items, empty set for items which can start with anything
+  QVector<QSet<QChar> > itemChars (items.size());
+  QVector<bool> itemAnyChar (items.size());
+  QVector<bool> itemNonLatin1 (items.size());
+  QSet<QChar> boundChars;
+  for (int i = 0; i < items.size(); ++i)
+  {
+    bool nonLatin1 = false;
+    itemAnyChar[i] = !items[i]->startChars(itemChars[i], nonLatin1);
+    itemNonLatin1[i] = nonLatin1;
+    boundChars += itemChars[i];
+  }
+
+  // items for characters no item is bound to
+  QVector<KateHlItem*> anyCharItems;
+  for (int i = 0; i < items.size(); ++i)
+    if (itemAnyChar[i])
+      anyCharItems.append(items[i]);
+
+  // one list per latin-1 character, shared if nothing special is bound to it, one for all others
+  dispatchTable.fill(anyCharItems, 257);
+  for (int c = 0; c <= 256; ++c)
+  {
+    if (c < 256 && !boundChars.contains(QChar(c)))
+      continue;
+
+    QVector<KateHlItem*> charItems;
+    for (int i = 0; i < items.size(); ++i)
+      if (itemAnyChar[i] || (c < 256 ? itemChars[i].contains(QChar(c)) : itemNonLatin1[i]))
+        charItems.append(items[i]);
+
+    dispatchTable[c] = charItems;
+  }
+}
+
 KateHlContext::~KateHlContext()
 {
   if (dynamicChild)
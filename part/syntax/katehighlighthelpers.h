@@ -39,6 +39,11 @@ class KateHlItem
 
     virtual bool lineContinue(){return false;}
 
+    // characters a match of this item can start with, used to compile the dispatch tables of the contexts
+    // nonLatin1 is set if a match can start with some character >= 256, too
+    // returns false if this is not known, the item is then checked at each offset
+    virtual bool startChars(QSet<QChar> &, bool &) { return false; }
+
     virtual void capturedTexts (QStringList &) { }
     virtual KateHlItem *clone(const QStringList *) {return this;}
 
@@ -79,7 +84,31 @@ class KateHlContext
     virtual ~KateHlContext();
     KateHlContext *clone(const QStringList *args);
 
+    /**
+     * Build the dispatch table from the items, must be called after the items are complete.
+     */
+    void compileDispatchTable();
+
+    /**
+     * Items that might match at a position starting with the given character, in rule order.
+     * All items, if the dispatch table is not compiled.
+     */
+    const QVector<KateHlItem*> &itemsForChar(QChar c) const
+    {
+      if (dispatchTable.isEmpty())
+        return items;
+
+      return dispatchTable[qMin (c.unicode(), (ushort) 256)];
+    }
+
     QVector<KateHlItem*> items;
+
+    /**
+     * items per start character, 0..255 for latin-1, 256 for all others
+     * characters no item is bound to share the list of the items that can start with any
+     */
+    QVector<QVector<KateHlItem*> > dispatchTable;
+
     QString hlId; ///< A unique highlight identifier. Used to look up correct properties.
     int attr;
     KateHlContextModification lineEndContext;
@@ -126,6 +155,7 @@ class KateHlCharDetect : public KateHlItem
     KateHlCharDetect(int attribute, KateHlContextModification context,signed char regionId,signed char regionId2, QChar);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
     virtual KateHlItem *clone(const QStringList *args);
 
   private:
@@ -139,6 +169,7 @@ class KateHl2CharDetect : public KateHlItem
     KateHl2CharDetect(int attribute, KateHlContextModification context,signed char regionId,signed char regionId2,  const QChar *ch);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
     virtual KateHlItem *clone(const QStringList *args);
 
   private:
@@ -152,6 +183,7 @@ class KateHlStringDetect : public KateHlItem
     KateHlStringDetect(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2, const QString &, bool inSensitive=false);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
     virtual KateHlItem *clone(const QStringList *args);
 
   protected:
@@ -175,6 +207,7 @@ class KateHlRangeDetect : public KateHlItem
     KateHlRangeDetect(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2, QChar ch1, QChar ch2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 
   private:
     QChar sChar1;
@@ -189,6 +222,7 @@ class KateHlKeyword : public KateHlItem
 
     void addList(const QStringList &);
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 
   private:
     QVector< QSet<QString>* > dict;
@@ -204,6 +238,7 @@ class KateHlInt : public KateHlItem
     KateHlInt(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlFloat : public KateHlItem
@@ -213,6 +248,7 @@ class KateHlFloat : public KateHlItem
     virtual ~KateHlFloat () {}
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlCFloat : public KateHlFloat
@@ -230,6 +266,7 @@ class KateHlCOct : public KateHlItem
     KateHlCOct(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlCHex : public KateHlItem
@@ -238,6 +275,7 @@ class KateHlCHex : public KateHlItem
     KateHlCHex(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlLineContinue : public KateHlItem
@@ -247,6 +285,7 @@ class KateHlLineContinue : public KateHlItem
 
     virtual bool endEnable(QChar c) {return c == '\0';}
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
     virtual bool lineContinue(){return true;}
 };
 
@@ -256,6 +295,7 @@ class KateHlCStringChar : public KateHlItem
     KateHlCStringChar(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlCChar : public KateHlItem
@@ -264,6 +304,7 @@ class KateHlCChar : public KateHlItem
     KateHlCChar(int attribute, KateHlContextModification context,signed char regionId,signed char regionId2);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 };
 
 class KateHlAnyChar : public KateHlItem
@@ -272,6 +313,7 @@ class KateHlAnyChar : public KateHlItem
     KateHlAnyChar(int attribute, KateHlContextModification context, signed char regionId,signed char regionId2, const QString& charList);
 
     virtual int checkHgl(const QString& text, int offset, int len);
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1);
 
   private:
     const QString _charList;
@@ -315,6 +357,15 @@ class KateHlDetectSpaces : public KateHlItem
       while ((offset < len2) && text[offset].isSpace()) offset++;
       return offset;
     }
+
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1)
+    {
+      for (int c = 0; c < 256; ++c)
+        if (QChar (c).isSpace())
+          chars << QChar (c);
+      nonLatin1 = true;
+      return true;
+    }
 };
 
 class KateHlDetectIdentifier : public KateHlItem
@@ -346,6 +397,15 @@ class KateHlDetectIdentifier : public KateHlItem
 
       return 0;
     }
+
+    virtual bool startChars(QSet<QChar> &chars, bool &nonLatin1)
+    {
+      for (int c = 0; c < 256; ++c)
+        if (QChar (c).isLetter() || c == '_')
+          chars << QChar (c);
+      nonLatin1 = true;
+      return true;
+    }
 };
 
 //END
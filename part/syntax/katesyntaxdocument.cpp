@@ -31,15 +31,344 @@
 #include <kmessagebox.h>
 #include <kconfiggroup.h>
 #include <kde_file.h>
+#include <ksavefile.h>
 
 #include <QtGui/QApplication>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QVector>
+#include <QtXml/QDomDocument>
+
+#include <string.h>
 
 // use this to turn on over verbose debug output...
 #undef KSD_OVER_VERBOSE
 
+/**
+ * Version of the binary cache format, increase it on any change of the layout
+ */
+static const quint32 KATE_SYNTAX_CACHE_VERSION = 1;
+
+/**
+ * Magic number at the start of each cache file
+ */
+static const quint32 KATE_SYNTAX_CACHE_MAGIC = 0x4b535943; // KSYC
+
+/**
+ * Compact element tree of a syntax definition xml file.
+ * All data lives in one flat buffer, which is either built from the parsed xml file
+ * or is the memory mapped cache file written for it before.
+ * Elements are stored in document order, the children of an element and its next sibling
+ * always have higher indices, the root element is 0. Comments and text nodes are no elements,
+ * the text of elements without child elements is kept.
+ */
+class KateSyntaxTree
+{
+  private:
+    struct Header
+    {
+      quint32 magic;
+      quint32 version;
+      qint64 lastModified;
+      qint64 fileSize;
+      qint32 elements;
+      qint32 attributes;
+      qint32 strings;
+      qint32 stringData;
+    };
+
+    struct Element
+    {
+      qint32 tagName;
+      qint32 text;
+      qint32 firstAttribute;
+      qint32 attributeCount;
+      qint32 firstChild;
+      qint32 nextSibling;
+    };
+
+    struct Attribute
+    {
+      qint32 name;
+      qint32 value;
+    };
+
+    struct String
+    {
+      qint32 offset;
+      qint32 length;
+    };
+
+  public:
+    /**
+     * Build the tree for a parsed xml file.
+     * @param document parsed xml file
+     * @param lastModified modification time of the xml file
+     * @param fileSize size of the xml file
+     */
+    KateSyntaxTree (const QDomDocument &document, qint64 lastModified, qint64 fileSize)
+      : m_header (0)
+    {
+      QVector<Element> elements;
+      QVector<Attribute> attributes;
+      QVector<String> strings;
+      QString stringData;
+      QHash<QString, int> stringIndex;
+
+      if (!document.documentElement().isNull())
+        addElement (document.documentElement(), elements, attributes, strings, stringData, stringIndex);
+
+      Header header;
+      header.magic = KATE_SYNTAX_CACHE_MAGIC;
+      header.version = KATE_SYNTAX_CACHE_VERSION;
+      header.lastModified = lastModified;
+      header.fileSize = fileSize;
+      header.elements = elements.size();
+      header.attributes = attributes.size();
+      header.strings = strings.size();
+      header.stringData = stringData.size();
+
+      m_buffer.reserve (sizeof (Header) + elements.size() * sizeof (Element) + attributes.size() * sizeof (Attribute)
+          + strings.size() * sizeof (String) + stringData.size() * sizeof (QChar));
+      m_buffer.append ((const char *) &header, sizeof (Header));
+      m_buffer.append ((const char *) elements.constData(), elements.size() * sizeof (Element));
+      m_buffer.append ((const char *) attributes.constData(), attributes.size() * sizeof (Attribute));
+      m_buffer.append ((const char *) strings.constData(), strings.size() * sizeof (String));
+      m_buffer.append ((const char *) stringData.constData(), stringData.size() * sizeof (QChar));
+
+      const bool valid = setData ((const uchar *) m_buffer.constData(), m_buffer.size());
+      Q_ASSERT (valid);
+      Q_UNUSED (valid);
+    }
+
+    /**
+     * Load the tree from a cache file.
+     * Use isValid() to check if the cache file was usable.
+     * @param fileName cache file
+     * @param lastModified modification time the xml file must have
+     * @param fileSize size the xml file must have
+     */
+    KateSyntaxTree (const QString &fileName, qint64 lastModified, qint64 fileSize)
+      : m_file (fileName)
+      , m_header (0)
+    {
+      if (!m_file.open (QIODevice::ReadOnly))
+        return;
+
+      // map the file, if that is not possible, read it
+      const uchar *data = m_file.map (0, m_file.size());
+      qint64 size = m_file.size();
+      if (!data) {
+        m_buffer = m_file.readAll ();
+        data = (const uchar *) m_buffer.constData();
+        size = m_buffer.size();
+      }
+
+      if (!setData (data, size) || m_header->lastModified != lastModified || m_header->fileSize != fileSize)
+        m_header = 0;
+    }
+
+    /**
+     * Is the tree usable?
+     * @return tree valid?
+     */
+    bool isValid () const { return m_header; }
+
+    /**
+     * Was the tree built for the xml file as it is now?
+     * @param lastModified modification time of the xml file
+     * @param fileSize size of the xml file
+     * @return tree up-to-date?
+     */
+    bool isUpToDate (qint64 lastModified, qint64 fileSize) const
+    {
+      return m_header && m_header->lastModified == lastModified && m_header->fileSize == fileSize;
+    }
+
+    /**
+     * Write the tree to a cache file.
+     * @param fileName cache file
+     * @return success
+     */
+    bool save (const QString &fileName) const
+    {
+      KSaveFile file (fileName);
+      if (!file.open ())
+        return false;
+
+      if (file.write (m_buffer) != m_buffer.size()) {
+        file.abort ();
+        return false;
+      }
+
+      return file.finalize ();
+    }
+
+    int root () const { return (m_header && m_header->elements > 0) ? 0 : -1; }
+
+    int firstChild (int element) const { return (element < 0) ? -1 : m_elements[element].firstChild; }
+
+    int nextSibling (int element) const { return (element < 0) ? -1 : m_elements[element].nextSibling; }
+
+    QString tagName (int element) const { return string (m_elements[element].tagName); }
+
+    QString text (int element) const { return string (m_elements[element].text); }
+
+    QString attribute (int element, const QString &name) const
+    {
+      const Element &e = m_elements[element];
+      for (int i = e.firstAttribute; i < e.firstAttribute + e.attributeCount; ++i)
+        if (stringEquals (m_attributes[i].name, name))
+          return string (m_attributes[i].value);
+
+      return QString ();
+    }
+
+  private:
+    QString string (int index) const
+    {
+      if (index < 0)
+        return QString ();
+
+      return QString (m_stringData + m_strings[index].offset, m_strings[index].length);
+    }
+
+    bool stringEquals (int index, const QString &other) const
+    {
+      return m_strings[index].length == other.size()
+          && !memcmp (m_stringData + m_strings[index].offset, other.unicode(), other.size() * sizeof (QChar));
+    }
+
+    static int addString (const QString &string, QVector<String> &strings, QString &stringData, QHash<QString, int> &stringIndex)
+    {
+      QHash<QString, int>::const_iterator it = stringIndex.constFind (string);
+      if (it != stringIndex.constEnd())
+        return it.value();
+
+      String s;
+      s.offset = stringData.size();
+      s.length = string.size();
+      stringData.append (string);
+      strings.append (s);
+      stringIndex.insert (string, strings.size() - 1);
+      return strings.size() - 1;
+    }
+
+    static int addElement (const QDomElement &element, QVector<Element> &elements, QVector<Attribute> &attributes
+        , QVector<String> &strings, QString &stringData, QHash<QString, int> &stringIndex)
+    {
+      const int index = elements.size();
+      Element e;
+      e.tagName = addString (element.tagName(), strings, stringData, stringIndex);
+      e.text = -1;
+      e.firstAttribute = attributes.size();
+      e.attributeCount = 0;
+      e.firstChild = -1;
+      e.nextSibling = -1;
+
+      const QDomNamedNodeMap attributeMap = element.attributes();
+      for (int i = 0; i < attributeMap.count(); ++i) {
+        const QDomAttr attribute = attributeMap.item(i).toAttr();
+        Attribute a;
+        a.name = addString (attribute.name(), strings, stringData, stringIndex);
+        a.value = addString (attribute.value(), strings, stringData, stringIndex);
+        attributes.append (a);
+        ++e.attributeCount;
+      }
+
+      elements.append (e);
+
+      // children, elements is changed by the recursion, no references into it are kept
+      int previous = -1;
+      for (QDomElement child = element.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+        const int childIndex = addElement (child, elements, attributes, strings, stringData, stringIndex);
+        if (previous == -1)
+          elements[index].firstChild = childIndex;
+        else
+          elements[previous].nextSibling = childIndex;
+        previous = childIndex;
+      }
+
+      // only leaves need their text, it is the content of keyword list items
+      if (previous == -1) {
+        const QString text = element.text();
+        if (!text.isEmpty())
+          elements[index].text = addString (text, strings, stringData, stringIndex);
+      }
+
+      return index;
+    }
+
+    /**
+     * Set the data of the tree and check it, a broken cache file must not crash us.
+     * @param data tree data
+     * @param size size of the data
+     * @return data valid?
+     */
+    bool setData (const uchar *data, qint64 size)
+    {
+      if (size < qint64 (sizeof (Header)))
+        return false;
+
+      const Header *header = (const Header *) data;
+      if (header->magic != KATE_SYNTAX_CACHE_MAGIC || header->version != KATE_SYNTAX_CACHE_VERSION
+          || header->elements < 0 || header->attributes < 0 || header->strings < 0 || header->stringData < 0)
+        return false;
+
+      const qint64 expectedSize = sizeof (Header) + qint64 (header->elements) * sizeof (Element)
+          + qint64 (header->attributes) * sizeof (Attribute) + qint64 (header->strings) * sizeof (String)
+          + qint64 (header->stringData) * sizeof (QChar);
+      if (size != expectedSize)
+        return false;
+
+      m_elements = (const Element *) (data + sizeof (Header));
+      m_attributes = (const Attribute *) (m_elements + header->elements);
+      m_strings = (const String *) (m_attributes + header->attributes);
+      m_stringData = (const QChar *) (m_strings + header->strings);
+
+      for (int i = 0; i < header->strings; ++i)
+        if (m_strings[i].offset < 0 || m_strings[i].length < 0 || m_strings[i].offset > header->stringData - m_strings[i].length)
+          return false;
+
+      for (int i = 0; i < header->attributes; ++i)
+        if (m_attributes[i].name < 0 || m_attributes[i].name >= header->strings
+            || m_attributes[i].value < 0 || m_attributes[i].value >= header->strings)
+          return false;
+
+      // children and siblings only point forward, no loops possible
+      for (int i = 0; i < header->elements; ++i) {
+        const Element &e = m_elements[i];
+        if (e.tagName < 0 || e.tagName >= header->strings || e.text < -1 || e.text >= header->strings
+            || e.firstAttribute < 0 || e.attributeCount < 0 || e.firstAttribute > header->attributes - e.attributeCount
+            || (e.firstChild != -1 && (e.firstChild <= i || e.firstChild >= header->elements))
+            || (e.nextSibling != -1 && (e.nextSibling <= i || e.nextSibling >= header->elements)))
+          return false;
+      }
+
+      m_header = header;
+      return true;
+    }
+
+  private:
+    /**
+     * cache file, if loaded from one, keeps the mapping alive
+     */
+    QFile m_file;
+
+    /**
+     * tree data, if built from the xml file or if the cache file could not be mapped
+     */
+    QByteArray m_buffer;
+
+    const Header *m_header;
+    const Element *m_elements;
+    const Attribute *m_attributes;
+    const String *m_strings;
+    const QChar *m_stringData;
+};
+
 KateSyntaxDocument::KateSyntaxDocument(KConfig *config, bool force)
-  : QDomDocument()
+  : m_tree (0)
   , m_config (config)
 {
   // Let's build the Mode List (katesyntaxhighlightingrc)
@@ -50,6 +379,9 @@ KateSyntaxDocument::~KateSyntaxDocument()
 {
   for (int i=0; i < myModeList.size(); i++)
     delete myModeList[i];
+
+  qDeleteAll (m_trees);
+  qDeleteAll (m_oldTrees);
 }
 
 /** If the open hl file is different from the one needed, it opens
@@ -58,42 +390,91 @@ KateSyntaxDocument::~KateSyntaxDocument()
 */
 bool KateSyntaxDocument::setIdentifier(const QString& identifier)
 {
-  // if the current file is the same as the new one don't do anything.
-  if(currentFile != identifier)
-  {
-    // let's open the new file
-    QFile f( identifier );
+  // stat the file, trees are only valid for the same modification time and size
+  KDE_struct_stat sbuf;
+  memset (&sbuf, 0, sizeof(sbuf));
+  KDE::stat(identifier, &sbuf);
+  const QPair<qint64, qint64> fileStamp (sbuf.st_mtime, sbuf.st_size);
+
+  // if the current file is the same as the new one and unchanged, don't do anything.
+  if (m_tree && currentFile == identifier && m_tree->isUpToDate (fileStamp.first, fileStamp.second))
+    return true;
+
+  // Ok, now the current file is the pretended one (identifier)
+  currentFile = identifier;
+
+  // each file is only loaded once, switching between the files of included highlightings is cheap
+  // a tree of a changed file is replaced, context data handed out before might still point into it
+  KateSyntaxTree *tree = m_trees.value (identifier);
+  if (tree && !tree->isUpToDate (fileStamp.first, fileStamp.second)) {
+    m_trees.remove (identifier);
+    m_oldTrees.append (tree);
+    tree = 0;
+  }
 
-    if ( f.open(QIODevice::ReadOnly) )
-    {
-      // Let's parse the contets of the xml file
-      /* The result of this function should be check for robustness,
-         a false returned means a parse error */
-      QString errorMsg;
-      int line, col;
-      bool success=setContent(&f,&errorMsg,&line,&col);
+  // a broken file is only tried and reported again once it changed
+  if (!tree && (!m_brokenFiles.contains (identifier) || m_brokenFiles.value (identifier) != fileStamp)) {
+    tree = loadTree (identifier, fileStamp.first, fileStamp.second);
+    if (tree) {
+      m_trees.insert (identifier, tree);
+      m_brokenFiles.remove (identifier);
+    } else {
+      m_brokenFiles.insert (identifier, fileStamp);
+    }
+  }
 
-      // Ok, now the current file is the pretended one (identifier)
-      currentFile = identifier;
+  m_tree = tree;
+  return m_tree;
+}
 
-      // Close the file, is not longer needed
-      f.close();
+KateSyntaxTree *KateSyntaxDocument::loadTree (const QString &identifier, qint64 lastModified, qint64 fileSize)
+{
+  // one cache file per xml file, the hash of the full path tells apart files of the same name in different dirs
+  const QString cacheFile = KStandardDirs::locateLocal ("cache", QString ("katepart/syntax/%1-%2.cache")
+      .arg (QFileInfo (identifier).fileName()).arg (qHash (identifier), 8, 16, QChar ('0')));
 
-      if (!success)
-      {
-        KMessageBox::error(QApplication::activeWindow(),i18n("<qt>The error <b>%4</b><br /> has been detected in the file %1 at %2/%3</qt>", identifier,
-             line, col, i18nc("QXml",errorMsg.toUtf8())));
-        return false;
-      }
-    }
-    else
-    {
-      // Oh o, we couldn't open the file.
-      KMessageBox::error(QApplication::activeWindow(), i18n("Unable to open %1", identifier) );
-      return false;
-    }
+  KateSyntaxTree *tree = new KateSyntaxTree (cacheFile, lastModified, fileSize);
+  if (tree->isValid())
+    return tree;
+
+  delete tree;
+
+#ifdef KSD_OVER_VERBOSE
+  kDebug(13010) << "UPDATE binary cache for: " << identifier;
+#endif
+
+  // let's open the xml file
+  QFile f( identifier );
+
+  if ( !f.open(QIODevice::ReadOnly) )
+  {
+    // Oh o, we couldn't open the file.
+    KMessageBox::error(QApplication::activeWindow(), i18n("Unable to open %1", identifier) );
+    return 0;
+  }
+
+  // Let's parse the contets of the xml file
+  QDomDocument document;
+  QString errorMsg;
+  int line, col;
+  bool success=document.setContent(&f,&errorMsg,&line,&col);
+
+  // Close the file, is not longer needed
+  f.close();
+
+  if (!success)
+  {
+    KMessageBox::error(QApplication::activeWindow(),i18n("<qt>The error <b>%4</b><br /> has been detected in the file %1 at %2/%3</qt>", identifier,
+         line, col, i18nc("QXml",errorMsg.toUtf8())));
+    return 0;
   }
-  return true;
+
+  // build the tree and store it for the next time
+  tree = new KateSyntaxTree (document, lastModified, fileSize);
+  if (!tree->save (cacheFile))
+    kDebug(13010) << "Unable to write the binary cache" << cacheFile << "for" << identifier;
+
+  return tree;
 }
 
 /**
@@ -101,30 +482,16 @@ bool KateSyntaxDocument::setIdentifier(const QString& identifier)
  */
 bool KateSyntaxDocument::nextGroup( KateSyntaxContextData* data)
 {
-  if(!data)
+  if(!data || !data->tree)
     return false;
 
-  // No group yet so go to first child
-  if (data->currentGroup.isNull())
-  {
-    // Skip over non-elements. So far non-elements are just comments
-    QDomNode node = data->parent.firstChild();
-    while (node.isComment())
-      node = node.nextSibling();
-
-    data->currentGroup = node.toElement();
-  }
+  // No group yet so go to first child, else iterate over siblings
+  if (data->currentGroup == -1)
+    data->currentGroup = data->tree->firstChild (data->parent);
   else
-  {
-    // common case, iterate over siblings, skipping comments as we go
-    QDomNode node = data->currentGroup.nextSibling();
-    while (node.isComment())
-      node = node.nextSibling();
-
-    data->currentGroup = node.toElement();
-  }
+    data->currentGroup = data->tree->nextSibling (data->currentGroup);
 
-  return !data->currentGroup.isNull();
+  return data->currentGroup != -1;
 }
 
 /**
@@ -132,65 +499,38 @@ bool KateSyntaxDocument::nextGroup( KateSyntaxContextData* data)
  */
 bool KateSyntaxDocument::nextItem( KateSyntaxContextData* data)
 {
-  if(!data)
+  if(!data || !data->tree)
     return false;
 
-  if (data->item.isNull())
-  {
-    QDomNode node = data->currentGroup.firstChild();
-    while (node.isComment())
-      node = node.nextSibling();
-
-    data->item = node.toElement();
-  }
+  if (data->item == -1)
+    data->item = data->tree->firstChild (data->currentGroup);
   else
-  {
-    QDomNode node = data->item.nextSibling();
-    while (node.isComment())
-      node = node.nextSibling();
+    data->item = data->tree->nextSibling (data->item);
 
-    data->item = node.toElement();
-  }
-
-  return !data->item.isNull();
+  return data->item != -1;
 }
 
 /**
  * This function is used to fetch the atributes of the tags of the item in a KateSyntaxContextData.
  */
 QString KateSyntaxDocument::groupItemData( const KateSyntaxContextData* data, const QString& name){
-  if(!data)
+  if(!data || !data->tree || data->item == -1)
     return QString();
 
   // If there's no name just return the tag name of data->item
-  if ( (!data->item.isNull()) && (name.isEmpty()))
-  {
-    return data->item.tagName();
-  }
+  if (name.isEmpty())
+    return data->tree->tagName (data->item);
 
   // if name is not empty return the value of the attribute name
-  if (!data->item.isNull())
-  {
-    return data->item.attribute(name);
-  }
-
-  return QString();
-
+  return data->tree->attribute (data->item, name);
 }
 
 QString KateSyntaxDocument::groupData( const KateSyntaxContextData* data,const QString& name)
 {
-  if(!data)
+  if(!data || !data->tree || data->currentGroup == -1)
     return QString();
 
-  if (!data->currentGroup.isNull())
-  {
-    return data->currentGroup.attribute(name);
-  }
-  else
-  {
-    return QString();
-  }
+  return data->tree->attribute (data->currentGroup, name);
 }
 
 void KateSyntaxDocument::freeGroupInfo( KateSyntaxContextData* data)
@@ -204,6 +544,7 @@ KateSyntaxContextData* KateSyntaxDocument::getSubItems(KateSyntaxContextData* da
 
   if (data != 0)
   {
+    retval->tree = data->tree;
     retval->parent = data->currentGroup;
     retval->currentGroup = data->item;
   }
@@ -211,28 +552,24 @@ KateSyntaxContextData* KateSyntaxDocument::getSubItems(KateSyntaxContextData* da
   return retval;
 }
 
-bool KateSyntaxDocument::getElement (QDomElement &element, const QString &mainGroupName, const QString &config)
+bool KateSyntaxDocument::getElement (int &element, const QString &mainGroupName, const QString &config)
 {
 #ifdef KSD_OVER_VERBOSE
   kDebug(13010) << "Looking for \"" << mainGroupName << "\" -> \"" << config << "\".";
 #endif
 
-  QDomNodeList nodes = documentElement().childNodes();
+  if (!m_tree)
+    return false;
 
-  // Loop over all these child nodes looking for mainGroupName
-  for (int i=0; i<nodes.count(); i++)
+  // Loop over all child elements looking for mainGroupName
+  for (int elem = m_tree->firstChild (m_tree->root()); elem != -1; elem = m_tree->nextSibling (elem))
   {
-    QDomElement elem = nodes.item(i).toElement();
-    if (elem.tagName() == mainGroupName)
+    if (m_tree->tagName (elem) == mainGroupName)
     {
-      // Found mainGroupName ...
-      QDomNodeList subNodes = elem.childNodes();
-
-      // ... so now loop looking for config
-      for (int j=0; j<subNodes.count(); j++)
+      // Found mainGroupName so now loop looking for config
+      for (int subElem = m_tree->firstChild (elem); subElem != -1; subElem = m_tree->nextSibling (subElem))
       {
-        QDomElement subElem = subNodes.item(j).toElement();
-        if (subElem.tagName() == config)
+        if (m_tree->tagName (subElem) == config)
         {
           // Found it!
           element = subElem;
@@ -256,15 +593,16 @@ bool KateSyntaxDocument::getElement (QDomElement &element, const QString &mainGr
 }
 
 /**
- * Get the KateSyntaxContextData of the QDomElement Config inside mainGroupName
- * KateSyntaxContextData::item will contain the QDomElement found
+ * Get the KateSyntaxContextData of the element Config inside mainGroupName
+ * KateSyntaxContextData::item will contain the element found
  */
 KateSyntaxContextData* KateSyntaxDocument::getConfig(const QString& mainGroupName, const QString &config)
 {
-  QDomElement element;
+  int element;
   if (getElement(element, mainGroupName, config))
   {
     KateSyntaxContextData *data = new KateSyntaxContextData;
+    data->tree = m_tree;
     data->item = element;
     return data;
   }
@@ -272,21 +610,40 @@ KateSyntaxContextData* KateSyntaxDocument::getConfig(const QString& mainGroupNam
 }
 
 /**
- * Get the KateSyntaxContextData of the QDomElement Config inside mainGroupName
- * KateSyntaxContextData::parent will contain the QDomElement found
+ * Get the KateSyntaxContextData of the element Config inside mainGroupName
+ * KateSyntaxContextData::parent will contain the element found
  */
 KateSyntaxContextData* KateSyntaxDocument::getGroupInfo(const QString& mainGroupName, const QString &group)
 {
-  QDomElement element;
+  int element;
   if (getElement(element, mainGroupName, group+'s'))
   {
     KateSyntaxContextData *data = new KateSyntaxContextData;
+    data->tree = m_tree;
     data->parent = element;
     return data;
   }
   return 0;
 }
 
+/**
+ * Find the first list element with the given name below the given element, in document order.
+ */
+static int findList (const KateSyntaxTree *tree, int element, const QString &type)
+{
+  for (int child = tree->firstChild (element); child != -1; child = tree->nextSibling (child))
+  {
+    if (tree->tagName (child) == "list" && tree->attribute (child, "name") == type)
+      return child;
+
+    const int list = findList (tree, child, type);
+    if (list != -1)
+      return list;
+  }
+
+  return -1;
+}
+
 /**
  * Returns a list with all the keywords inside the list type
  */
@@ -299,48 +656,31 @@ QStringList& KateSyntaxDocument::finddata(const QString& mainGroup, const QStrin
   if (clearList)
     m_data.clear();
 
-  for(QDomNode node = documentElement().firstChild(); !node.isNull(); node = node.nextSibling())
+  if (!m_tree)
+    return m_data;
+
+  for (int elem = m_tree->firstChild (m_tree->root()); elem != -1; elem = m_tree->nextSibling (elem))
   {
-    QDomElement elem = node.toElement();
-    if (elem.tagName() == mainGroup)
+    if (m_tree->tagName (elem) == mainGroup)
     {
 #ifdef KSD_OVER_VERBOSE
       kDebug(13010)<<"\""<<mainGroup<<"\" found.";
 #endif
 
-      QDomNodeList nodelist1 = elem.elementsByTagName("list");
-
-      for (int l=0; l<nodelist1.count(); l++)
+      const int list = findList (m_tree, elem, type);
+      if (list != -1)
       {
-        if (nodelist1.item(l).toElement().attribute("name") == type)
-        {
 #ifdef KSD_OVER_VERBOSE
-          kDebug(13010)<<"List with attribute name=\""<<type<<"\" found.";
+        kDebug(13010)<<"List with attribute name=\""<<type<<"\" found.";
 #endif
 
-          QDomNodeList childlist = nodelist1.item(l).toElement().childNodes();
-
-          for (int i=0; i<childlist.count(); i++)
-          {
-            QString element = childlist.item(i).toElement().text().trimmed();
-            if (element.isEmpty())
-              continue;
-
-#ifdef KSD_OVER_VERBOSE
-            if (i<6)
-            {
-              kDebug(13010)<<"\""<<element<<"\" added to the list \""<<type<<"\"";
-            }
-            else if(i==6)
-            {
-              kDebug(13010)<<"... The list continues ...";
-            }
-#endif
-
-            m_data += element;
-          }
+        for (int item = m_tree->firstChild (list); item != -1; item = m_tree->nextSibling (item))
+        {
+          QString element = m_tree->text (item).trimmed();
+          if (element.isEmpty())
+            continue;
 
-          break;
+          m_data += element;
         }
       }
       break;
@@ -448,13 +788,14 @@ void KateSyntaxDocument::setupModeList (bool force)
         QString errMsg;
         int line, col;
 
-        bool success = setContent(&f,&errMsg,&line,&col);
+        QDomDocument document;
+        bool success = document.setContent(&f,&errMsg,&line,&col);
 
         f.close();
 
         if (success)
         {
-          QDomElement root = documentElement();
+          QDomElement root = document.documentElement();
 
           if (!root.isNull())
           {
@@ -21,10 +21,12 @@
 #define __KATE_SYNTAXDOCUMENT_H__
 
 #include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
 #include <QtCore/QStringList>
-#include <QtXml/QDomDocument>
 
 class KConfig;
+class KateSyntaxTree;
 
 /**
  * Information about each syntax hl Mode. This is documented in Kate's
@@ -57,20 +59,32 @@ class KateSyntaxModeListItem
 typedef QList<KateSyntaxModeListItem*> KateSyntaxModeList;
 
 /**
- * Class holding the data around the current QDomElement
+ * Class holding the data around the current element.
+ * Elements are indices into the element tree of a syntax definition, -1 is no element.
  */
 class KateSyntaxContextData
 {
   public:
-    QDomElement parent;
-    QDomElement currentGroup;
-    QDomElement item;
+    KateSyntaxContextData ()
+      : tree (0), parent (-1), currentGroup (-1), item (-1)
+    {
+    }
+
+    const KateSyntaxTree *tree;
+    int parent;
+    int currentGroup;
+    int item;
 };
 
 /**
  * Store and manage the information about Syntax Highlighting.
+ *
+ * The xml files are only parsed if needed, their element trees are stored
+ * in binary cache files, which are memory mapped on the next use.
+ * The cache files are keyed by modification time and size of the xml files,
+ * loaded trees are checked against them on each setIdentifier().
  */
-class KateSyntaxDocument : public QDomDocument
+class KateSyntaxDocument
 {
   public:
     /**
@@ -150,7 +164,17 @@ class KateSyntaxDocument : public QDomDocument
      * Used by getConfig and getGroupInfo to traverse the xml nodes and
      * evenually return the found element
      */
-    bool getElement (QDomElement &element, const QString &mainGroupName, const QString &config);
+    bool getElement (int &element, const QString &mainGroupName, const QString &config);
+
+    /**
+     * Load the element tree for the given xml file, from the cache if up-to-date,
+     * else the xml file is parsed and the cache is written.
+     * @param identifier file name and path of the xml file
+     * @param lastModified modification time of the xml file
+     * @param fileSize size of the xml file
+     * @return element tree or 0 on errors
+     */
+    KateSyntaxTree *loadTree (const QString &identifier, qint64 lastModified, qint64 fileSize);
 
     /**
      * List of mode items
@@ -162,6 +186,27 @@ class KateSyntaxDocument : public QDomDocument
      */
     QString currentFile;
 
+    /**
+     * element tree of the current file, 0 if it could not be loaded
+     */
+    const KateSyntaxTree *m_tree;
+
+    /**
+     * all element trees loaded up to now, keyed by file name
+     */
+    QHash<QString, KateSyntaxTree *> m_trees;
+
+    /**
+     * trees replaced as their file changed, kept as context data might still use them
+     */
+    QList<KateSyntaxTree *> m_oldTrees;
+
+    /**
+     * files that could not be loaded, with their modification time and size,
+     * the error is only reported again once the file changed
+     */
+    QHash<QString, QPair<qint64, qint64> > m_brokenFiles;
+
     /**
      * last found data out of the xml
      */
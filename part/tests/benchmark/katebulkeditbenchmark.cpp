@@ -0,0 +1,129 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "kateview.h"
+
+#include <QtCore/QObject>
+
+/**
+ * Bulk edit benchmark, pastes and deletes many lines in the middle of a
+ * document with a view, like a user does it, with undo and folding active.
+ *
+ * Usage:
+ *   katebulkeditbenchmark [QTest options] [paste:<row>] [remove:<row>]
+ */
+class KateBulkEditBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void paste_data();
+    void paste();
+
+    void remove_data();
+    void remove();
+
+  private:
+    /**
+     * text of the given number of lines, each one ends with a line feed
+     */
+    static QString linesText (int lines);
+
+    KateDocument *m_doc;
+    KateView *m_view;
+};
+
+QTEST_KDEMAIN(KateBulkEditBenchmark, GUI)
+
+void KateBulkEditBenchmark::initTestCase()
+{
+  m_doc = new KateDocument (false, false, false);
+  m_doc->setHighlightingMode ("C++");
+  m_view = static_cast<KateView *> (m_doc->createView (0));
+}
+
+void KateBulkEditBenchmark::cleanupTestCase()
+{
+  delete m_view;
+  delete m_doc;
+}
+
+QString KateBulkEditBenchmark::linesText (int lines)
+{
+  QString text;
+  text.reserve (lines * 40);
+  for (int i = 0; i < lines; ++i)
+    text += QString ("int function%1(int x) { return x + 1; }\n").arg (i);
+  return text;
+}
+
+void KateBulkEditBenchmark::paste_data()
+{
+  QTest::addColumn<int>("lines");
+
+  QTest::newRow("10k lines") << 10000;
+  QTest::newRow("100k lines") << 100000;
+  QTest::newRow("1M lines") << 1000000;
+}
+
+void KateBulkEditBenchmark::paste()
+{
+  QFETCH(int, lines);
+
+  const QString text = linesText (lines);
+  m_doc->setText ("{\n}");
+  m_view->setCursorPosition (KTextEditor::Cursor (1, 0));
+
+  QBENCHMARK_ONCE {
+    m_doc->insertText (KTextEditor::Cursor (1, 0), text);
+  }
+
+  QCOMPARE (m_doc->lines (), lines + 2);
+  QCOMPARE (m_doc->line (lines + 1), QString ("}"));
+  QCOMPARE (m_view->cursorPosition (), KTextEditor::Cursor (lines + 1, 0));
+}
+
+void KateBulkEditBenchmark::remove_data()
+{
+  paste_data();
+}
+
+void KateBulkEditBenchmark::remove()
+{
+  QFETCH(int, lines);
+
+  m_doc->setText ("{\n" + linesText (lines) + "}");
+  m_view->setCursorPosition (KTextEditor::Cursor (lines / 2, 0));
+
+  QBENCHMARK_ONCE {
+    m_doc->removeText (KTextEditor::Range (1, 0, lines + 1, 0));
+  }
+
+  QCOMPARE (m_doc->text (), QString ("{\n}"));
+  QCOMPARE (m_view->cursorPosition (), KTextEditor::Cursor (1, 0));
+}
+
+#include "katebulkeditbenchmark.moc"
@@ -0,0 +1,92 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "katebuffer.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QElapsedTimer>
+
+#include <stdio.h>
+
+/**
+ * Highlighting benchmark, highlights each file of the tests/hl corpus
+ * with the highlighting picked by its file name.
+ *
+ * Usage:
+ *   katehighlightbenchmark [QTest options] [highlightFile:<file name>]
+ *     prints lines/second per file and syntax, run it on two builds to compare them
+ */
+class KateHighlightBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void highlightFile_data();
+    void highlightFile();
+};
+
+QTEST_KDEMAIN(KateHighlightBenchmark, GUI)
+
+void KateHighlightBenchmark::highlightFile_data()
+{
+  QTest::addColumn<QString>("fileName");
+
+  QDir corpus (KDESRCDIR "../hl");
+  foreach (const QString &file, corpus.entryList (QDir::Files, QDir::Name))
+    QTest::newRow(file.toLatin1().constData()) << corpus.filePath (file);
+}
+
+void KateHighlightBenchmark::highlightFile()
+{
+  QFETCH(QString, fileName);
+
+  KateDocument doc (false, false, false);
+  QVERIFY (doc.openUrl (KUrl (fileName)));
+
+  // make the file large enough to get meaningful numbers
+  const QString text = doc.text ();
+  while (doc.lines () < 10000)
+    doc.insertText (doc.documentEnd (), QString ("\n") + text);
+
+  KateBuffer &buffer = doc.buffer ();
+  const int lastLine = buffer.lines () - 1;
+
+  QBENCHMARK {
+    buffer.invalidateHighlighting ();
+    buffer.ensureHighlighted (lastLine, 0);
+  }
+
+  // one more timed run for the lines per second
+  QElapsedTimer timer;
+  timer.start ();
+  buffer.invalidateHighlighting ();
+  buffer.ensureHighlighted (lastLine, 0);
+  const qint64 elapsed = qMax (timer.elapsed (), qint64 (1));
+
+  printf ("%-30s %-20s %10lld lines/s\n", qPrintable (QFileInfo (fileName).fileName ()), qPrintable (doc.highlightingMode ())
+    , qint64 (buffer.lines ()) * 1000 / elapsed);
+}
+
+#include "katehighlightbenchmark.moc"
@@ -0,0 +1,88 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "katematchindex.h"
+
+#include <QtCore/QObject>
+
+/**
+ * Search benchmark, finds all matches of multi-line regular expressions
+ * in a document of 200k lines, like find all of the search bar does.
+ *
+ * Usage:
+ *   katesearchbenchmark [QTest options] [findAllMultiLine:<row>]
+ */
+class KateSearchBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+
+    void findAllMultiLine_data();
+    void findAllMultiLine();
+
+  private:
+    QString m_text;
+};
+
+QTEST_KDEMAIN(KateSearchBenchmark, GUI)
+
+void KateSearchBenchmark::initTestCase()
+{
+  // 50k functions of four lines each
+  QStringList lines;
+  for (int i = 0; i < 50000; ++i)
+    lines << QString ("int f%1(int a)").arg (i) << "{" << "  return a;" << "}";
+  m_text = lines.join ("\n");
+}
+
+void KateSearchBenchmark::findAllMultiLine_data()
+{
+  QTest::addColumn<QString>("pattern");
+  QTest::addColumn<int>("matches");
+
+  QTest::newRow("dense") << "\\{\\n  return" << 50000;
+  QTest::newRow("dense, two lines feeds") << "a\\)\\n\\{\\n" << 50000;
+  QTest::newRow("sparse") << "\\}\\nint f4999[0-9]\\(" << 10;
+  QTest::newRow("none") << "\\}\\n\\}" << 0;
+}
+
+void KateSearchBenchmark::findAllMultiLine()
+{
+  QFETCH(QString, pattern);
+  QFETCH(int, matches);
+
+  KateDocument doc (false, false, false);
+  doc.setText (m_text);
+  QCOMPARE (doc.lines (), 200000);
+
+  QVector<KTextEditor::Range> result;
+  QBENCHMARK {
+    result = KateMatchIndex::findAll (&doc, doc.documentRange (), false, pattern, KTextEditor::Search::Regex);
+  }
+
+  QCOMPARE (result.size (), matches);
+}
+
+#include "katesearchbenchmark.moc"
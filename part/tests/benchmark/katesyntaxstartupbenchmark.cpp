@@ -0,0 +1,93 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "katebuffer.h"
+
+#include <kstandarddirs.h>
+
+#include <QtCore/QObject>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QElapsedTimer>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Startup benchmark for the syntax definitions, opens one file of each of 20 languages
+ * of the tests/hl corpus. Each highlighting is only loaded once per process, therefore
+ * the times are those of a fresh start, don't use QBENCHMARK here.
+ *
+ * Usage:
+ *   katesyntaxstartupbenchmark
+ *     uses the binary syntax cache, run it twice, the first run writes the cache
+ *   KATE_SYNTAX_CACHE=cold katesyntaxstartupbenchmark
+ *     removes the binary syntax cache before, all xml files are parsed
+ */
+class KateSyntaxStartupBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void openLanguages();
+};
+
+QTEST_KDEMAIN(KateSyntaxStartupBenchmark, GUI)
+
+void KateSyntaxStartupBenchmark::openLanguages()
+{
+  // PHP, JSP and ASP include HTML, CSS and JavaScript
+  static const char * const files[] = {
+    "highlight.php", "highlight.jsp", "highlight.asp", "highlight.sh", "highlight.rb",
+    "highlight.pl", "highlight.tex", "highlight.xml", "highlight.xsl", "highlight.css",
+    "test.js", "highlight.cmake", "highlight.hs", "highlight.lisp", "highlight.d",
+    "highlight.f90", "highlight.erl", "highlight.tcl", "highlight.glsl", "verilog.v"
+  };
+
+  if (qgetenv ("KATE_SYNTAX_CACHE") == "cold") {
+    QDir cache (KGlobal::dirs()->saveLocation ("cache", "katepart/syntax/"));
+    foreach (const QString &file, cache.entryList (QStringList () << "*.cache", QDir::Files))
+      cache.remove (file);
+  }
+
+  const QDir corpus (KDESRCDIR "../hl");
+
+  QElapsedTimer total;
+  total.start ();
+
+  for (size_t i = 0; i < sizeof (files) / sizeof (files[0]); ++i) {
+    QElapsedTimer timer;
+    timer.start ();
+
+    // open the file and highlight the first screen, this loads the highlighting
+    KateDocument doc (false, false, false);
+    QVERIFY (doc.openUrl (KUrl (corpus.filePath (files[i]))));
+    doc.buffer().ensureHighlighted (qMin (doc.lines (), 50) - 1, 0);
+
+    printf ("%-20s %-20s %6lld ms\n", files[i], qPrintable (doc.highlightingMode ()), timer.elapsed ());
+  }
+
+  printf ("%-41s %6lld ms\n", "total", total.elapsed ());
+}
+
+#include "katesyntaxstartupbenchmark.moc"
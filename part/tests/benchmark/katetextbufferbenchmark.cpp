@@ -0,0 +1,127 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katetextbuffer.h"
+
+#include <ktemporaryfile.h>
+
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+/**
+ * Text buffer benchmark, line lookup and edits at the top of a file
+ * of 1M lines, for some block sizes.
+ *
+ * Usage:
+ *   katetextbufferbenchmark [QTest options] [lineLookup:<block size>] [topOfFileEdit:<block size>]
+ */
+class KateTextBufferBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void lineLookup_data();
+    void lineLookup();
+
+    void topOfFileEdit_data();
+    void topOfFileEdit();
+};
+
+QTEST_KDEMAIN_CORE(KateTextBufferBenchmark)
+
+/**
+ * Load a file with the given number of lines into the given buffer.
+ */
+static void loadLines (Kate::TextBuffer &buffer, int lines)
+{
+  KTemporaryFile file;
+  QVERIFY (file.open ());
+  for (int i = 0; i < lines; ++i)
+    file.write (QByteArray ("line ") + QByteArray::number (i) + '\n');
+  file.close ();
+
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  QVERIFY (buffer.load (file.fileName(), encodingErrors, tooLongLines, false));
+}
+
+void KateTextBufferBenchmark::lineLookup_data()
+{
+  QTest::addColumn<int>("blockSize");
+
+  QTest::newRow("16") << 16;
+  QTest::newRow("64") << 64;
+  QTest::newRow("256") << 256;
+  QTest::newRow("1024") << 1024;
+}
+
+void KateTextBufferBenchmark::lineLookup()
+{
+  QFETCH(int, blockSize);
+
+  Kate::TextBuffer buffer (0, blockSize);
+  loadLines (buffer, 1000000);
+  QCOMPARE (buffer.lines (), 1000001);
+
+  // random lines, the last used block shortcut won't help
+  qsrand (42);
+  QVector<int> lines (10000);
+  for (int i = 0; i < lines.size (); ++i)
+    lines[i] = qrand () % buffer.lines ();
+
+  int length = 0;
+  QBENCHMARK {
+    foreach (int line, lines)
+      length += buffer.line (line)->length ();
+  }
+  QVERIFY (length > 0);
+}
+
+void KateTextBufferBenchmark::topOfFileEdit_data()
+{
+  lineLookup_data ();
+}
+
+void KateTextBufferBenchmark::topOfFileEdit()
+{
+  QFETCH(int, blockSize);
+
+  Kate::TextBuffer buffer (0, blockSize);
+  loadLines (buffer, 1000000);
+
+  // each wrap and unwrap changes the start line of all blocks behind the first one
+  QBENCHMARK {
+    buffer.startEditing ();
+    for (int i = 0; i < 100; ++i) {
+      buffer.wrapLine (KTextEditor::Cursor (0, 2));
+      buffer.unwrapLine (1);
+    }
+    buffer.finishEditing ();
+  }
+
+  QCOMPARE (buffer.lines (), 1000001);
+  QCOMPARE (buffer.line (999999)->string (), QString ("line 999999"));
+}
+
+#include "katetextbufferbenchmark.moc"
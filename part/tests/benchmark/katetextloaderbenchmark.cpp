@@ -0,0 +1,151 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "katetextbuffer.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QProcess>
+#include <QtCore/QFile>
+#include <QtCore/QDir>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <utime.h>
+#include <time.h>
+
+#include <stdio.h>
+
+/**
+ * Load benchmark for Kate::TextBuffer.
+ *
+ * Usage:
+ *   katetextloaderbenchmark [sizeInMB...]
+ *     creates a log like file for each size (default: 100 1024 2048) and loads it
+ *     once with the streaming loader, once with the memory mapped loader and once
+ *     with the memory mapped loader and compact line storage,
+ *     each in an own process, to get a meaningful peak + current RSS
+ *
+ *   katetextloaderbenchmark --load <stream|mmap|compact> <file>
+ *     loads the given file once and prints time + peak + current RSS
+ */
+
+/**
+ * Current RSS in kb, from /proc, 0 if not available.
+ */
+static long currentRss ()
+{
+  QFile status ("/proc/self/status");
+  if (!status.open (QIODevice::ReadOnly))
+    return 0;
+
+  QByteArray line;
+  while (!(line = status.readLine ()).isEmpty()) {
+    if (line.startsWith ("VmRSS:"))
+      return line.mid (6).trimmed().split (' ').first().toLong ();
+  }
+
+  return 0;
+}
+
+static int loadFile (const QString &mode, const QString &fileName)
+{
+  Kate::TextBuffer buffer (0);
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  buffer.setAllowMemoryMapping (mode != "stream");
+  buffer.setCompactLineStorage (mode == "compact");
+
+  // time the load
+  QElapsedTimer timer;
+  timer.start ();
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  if (!buffer.load (fileName, encodingErrors, tooLongLines, true))
+    return 1;
+  const qint64 elapsed = timer.elapsed ();
+
+  // peak rss in kb
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  printf ("%-7s lines: %10d time: %8lld ms peak rss: %8ld kb rss: %8ld kb\n", qPrintable (mode)
+    , buffer.lines(), elapsed, usage.ru_maxrss, currentRss ());
+  return 0;
+}
+
+static bool createFile (const QString &fileName, qint64 sizeInMB)
+{
+  QFile file (fileName);
+  if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  // log like lines with varying length
+  const qint64 size = sizeInMB * 1024 * 1024;
+  qint64 written = 0;
+  for (qint64 i = 0; written < size; ++i) {
+    const QByteArray line = QByteArray ("2013-04-01 12:00:00 [worker ") + QByteArray::number (i % 97)
+      + "] processing request " + QByteArray::number (i) + QByteArray (i % 61, 'x') + '\n';
+    if (file.write (line) != line.size())
+      return false;
+    written += line.size();
+  }
+  file.close ();
+
+  // recently modified files are not memory mapped, make it an old one
+  struct utimbuf times;
+  times.actime = times.modtime = time (0) - 3600;
+  return utime (QFile::encodeName (fileName).constData (), &times) == 0;
+}
+
+int main (int argc, char *argv[])
+{
+  // construct core app
+  QCoreApplication app (argc, argv);
+  QStringList args = app.arguments();
+  args.removeFirst ();
+
+  // load mode, used by the child processes
+  if (args.size() == 3 && args.at(0) == "--load")
+    return loadFile (args.at(1), args.at(2));
+
+  // default sizes
+  if (args.isEmpty())
+    args << "100" << "1024" << "2048";
+
+  foreach (const QString &size, args) {
+    const QString fileName = QDir::temp().filePath (QString ("katetextloaderbenchmark-%1.log").arg (size));
+    printf ("%s MB:\n", qPrintable (size));
+    fflush (stdout);
+    if (!createFile (fileName, size.toLongLong())) {
+      printf ("failed to create %s\n", qPrintable (fileName));
+      QFile::remove (fileName);
+      return 1;
+    }
+
+    QProcess::execute (app.applicationFilePath(), QStringList () << "--load" << "stream" << fileName);
+    QProcess::execute (app.applicationFilePath(), QStringList () << "--load" << "mmap" << fileName);
+    QProcess::execute (app.applicationFilePath(), QStringList () << "--load" << "compact" << fileName);
+    QFile::remove (fileName);
+  }
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "kateview.h"
+#include "kateglobal.h"
+#include "kateviglobal.h"
+#include "kateviinputmodemanager.h"
+#include "katevikeyparser.h"
+
+#include <QtCore/QObject>
+
+/**
+ * Vi mode benchmark, replays 10k key presses in normal mode like the
+ * repetition of a change does, with and without many mappings defined.
+ *
+ * Usage:
+ *   katevimodebenchmark [QTest options] [replay:<row>]
+ */
+class KateViModeBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void replay_data();
+    void replay();
+
+  private:
+    KateDocument *m_doc;
+    KateView *m_view;
+};
+
+QTEST_KDEMAIN(KateViModeBenchmark, GUI)
+
+void KateViModeBenchmark::initTestCase()
+{
+  QStringList lines;
+  for (int i = 0; i < 1000; ++i)
+    lines << QString ("int function%1(int x) { return x + 1; }").arg (i);
+
+  m_doc = new KateDocument (false, false, false);
+  m_doc->setText (lines.join ("\n"));
+  m_view = new KateView (m_doc, 0);
+  m_view->toggleViInputMode ();
+  QVERIFY (m_view->viInputMode ());
+}
+
+void KateViModeBenchmark::cleanupTestCase()
+{
+  delete m_view;
+  delete m_doc;
+}
+
+void KateViModeBenchmark::replay_data()
+{
+  QTest::addColumn<QString>("keys");
+  QTest::addColumn<int>("mappings");
+
+  // every sequence is repeated to 10k key presses, none of them changes the text
+  QTest::newRow("motions") << "wbjk0$hlWB" << 0;
+  QTest::newRow("find character") << "fxFxtxTx;," << 0;
+  QTest::newRow("operators") << "yyywybyeyl" << 0;
+  QTest::newRow("text objects") << "yiwyawyi(l" << 0;
+  QTest::newRow("motions, 1000 mappings") << "wbjk0$hlWB" << 1000;
+}
+
+void KateViModeBenchmark::replay()
+{
+  QFETCH(QString, keys);
+  QFETCH(int, mappings);
+
+  KateViGlobal *viGlobal = KateGlobal::self()->viInputModeGlobal ();
+  viGlobal->clearMappings (NormalMode);
+  for (int i = 0; i < mappings; ++i)
+    viGlobal->addMapping (NormalMode, QString ("'%1").arg (i), "l");
+
+  const QString keyPresses = KateViKeyParser::self ()->encodeKeySequence (keys.repeated (10000 / keys.size ()));
+
+  KateViInputModeManager *manager = m_view->getViInputModeManager ();
+  const QString text = m_doc->text ();
+  QBENCHMARK {
+    m_view->setCursorPosition (KTextEditor::Cursor (0, 0));
+    manager->feedKeyPresses (keyPresses);
+  }
+
+  viGlobal->clearMappings (NormalMode);
+  QCOMPARE (manager->getCurrentViMode (), NormalMode);
+  QCOMPARE (m_doc->text (), text);
+}
+
+#include "katevimodebenchmark.moc"
@@ -0,0 +1,121 @@
+/*  This file is part of the Kate project.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include <qtest_kde.h>
+
+#include "katedocument.h"
+#include "kateview.h"
+#include "kateglobal.h"
+#include "katewordindex.h"
+#include "katewordcompletion.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
+
+#include <stdio.h>
+
+/**
+ * Word completion benchmark, measures the latency of one keystroke in a
+ * document of 1M lines: the index update for the typed character plus
+ * the lookup and ranking of the completions.
+ *
+ * Usage:
+ *   katewordcompletionbenchmark [QTest options] [keystroke:<row>]
+ */
+class KateWordCompletionBenchmark : public QObject
+{
+  Q_OBJECT
+
+  private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void keystroke_data();
+    void keystroke();
+
+  private:
+    KateDocument *m_doc;
+    KateView *m_view;
+};
+
+QTEST_KDEMAIN(KateWordCompletionBenchmark, GUI)
+
+void KateWordCompletionBenchmark::initTestCase()
+{
+  // 250k functions of four lines each, an empty line to type in at the end
+  QStringList lines;
+  for (int i = 0; i < 250000; ++i)
+    lines << QString ("int function%1(int value)").arg (i) << "{" << "  return value + commonValue;" << "}";
+  lines << QString ();
+  const QString text = lines.join ("\n");
+
+  m_doc = new KateDocument (false, false, false);
+  m_view = static_cast<KateView *> (m_doc->createView (0));
+
+  QElapsedTimer timer;
+  timer.start ();
+  m_doc->setText (text);
+  KateGlobal::self()->wordIndex()->countPending ();
+  printf ("index: %d lines, %d words in %lld ms\n", m_doc->lines (), KateGlobal::self()->wordIndex()->size (), timer.elapsed ());
+
+  QCOMPARE (m_doc->lines (), 1000001);
+}
+
+void KateWordCompletionBenchmark::cleanupTestCase()
+{
+  delete m_view;
+  delete m_doc;
+}
+
+void KateWordCompletionBenchmark::keystroke_data()
+{
+  QTest::addColumn<QString>("prefix");
+  QTest::addColumn<int>("matches");
+
+  QTest::newRow("one match") << "comm" << 1;
+  QTest::newRow("few matches") << "function12345" << 10;
+  QTest::newRow("11k matches") << "function24" << 11110;
+  QTest::newRow("111k matches") << "function1" << 111110;
+  QTest::newRow("no match") << "uncommon" << 0;
+}
+
+void KateWordCompletionBenchmark::keystroke()
+{
+  QFETCH(QString, prefix);
+  QFETCH(int, matches);
+
+  KateWordCompletionModel *model = KateGlobal::self()->wordCompletionModel();
+  const int line = m_doc->lastLine ();
+  const int column = prefix.size () - 1;
+  m_doc->insertText (KTextEditor::Cursor (line, 0), prefix.left (column));
+
+  QStringList result;
+  QBENCHMARK {
+    // type the last character of the prefix, complete, take it back
+    m_doc->insertText (KTextEditor::Cursor (line, column), prefix.right (1));
+    result = model->allMatches (m_view, KTextEditor::Range (line, 0, line, prefix.size ()));
+    m_doc->removeText (KTextEditor::Range (line, column, line, prefix.size ()));
+  }
+
+  m_doc->removeText (KTextEditor::Range (line, 0, line, column));
+  QCOMPARE (result.size (), matches);
+}
+
+#include "katewordcompletionbenchmark.moc"
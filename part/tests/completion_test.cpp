@@ -33,6 +33,10 @@
 #include <katecompletionmodel.h>
 #include <katerenderer.h>
 #include <kateconfig.h>
+#include <kateglobal.h>
+#include <katedocument.h>
+#include <katewordindex.h>
+#include <katewordcompletion.h>
 
 QTEST_KDEMAIN(CompletionTest, GUI)
 
@@ -362,4 +366,99 @@ void CompletionTest::testAbortImmideatelyAfterStart()
     QVERIFY(!m_view->completionWidget()->isCompletionActive());
 }
 
+static void verifyWordIndex(KateWordIndex *index, KateDocument *doc)
+{
+    // a fresh index counts the document from scratch
+    KateWordIndex fresh;
+    fresh.addDocument(doc);
+    fresh.countPending();
+    index->countPending();
+
+    const QStringList words = fresh.wordsWithPrefix(QString());
+    QCOMPARE(index->wordsWithPrefix(QString()), words);
+    foreach (const QString &word, words)
+        QCOMPARE(index->count(doc, word), fresh.count(doc, word));
+}
+
+void CompletionTest::testWordIndex()
+{
+    KateDocument *doc = static_cast<KateDocument*>(m_doc);
+    KateWordIndex index;
+    index.addDocument(doc);
+    verifyWordIndex(&index, doc);
+
+    doc->insertText(Cursor(0, 1), "xx\nyy zz");
+    verifyWordIndex(&index, doc);
+
+    doc->removeText(Range(0, 2, 1, 3));
+    verifyWordIndex(&index, doc);
+
+    doc->insertLine(0, "first line");
+    doc->insertLine(doc->lines(), "last line");
+    verifyWordIndex(&index, doc);
+
+    doc->removeLine(doc->lines() - 1);
+    doc->removeLine(0);
+    verifyWordIndex(&index, doc);
+
+    doc->editWrapLine(0, 2);
+    doc->editUnWrapLine(0);
+    verifyWordIndex(&index, doc);
+
+    doc->undo();
+    doc->undo();
+    doc->redo();
+    verifyWordIndex(&index, doc);
+
+    doc->setText("alpha beta\nalphabet");
+    verifyWordIndex(&index, doc);
+    QCOMPARE(index.wordsWithPrefix("alp"), QStringList() << "alpha" << "alphabet");
+    QCOMPARE(index.wordsWithPrefix("alpha"), QStringList() << "alphabet");
+
+    doc->clear();
+    verifyWordIndex(&index, doc);
+    QCOMPARE(index.size(), 0);
+}
+
+void CompletionTest::testWordIndexPending()
+{
+    KateDocument *doc = static_cast<KateDocument*>(m_doc);
+    doc->setText("one two\nthree four\nfive six\nseven eight\nnine ten");
+
+    // edits while only the first two lines are counted
+    KateWordIndex index;
+    index.addDocument(doc);
+    index.countPending(2);
+    QVERIFY(index.hasPending());
+
+    doc->insertText(Cursor(0, 3), "\nnew");
+    doc->insertText(Cursor(4, 0), "late ");
+    doc->removeText(Range(1, 2, 3, 2));
+    doc->insertText(Cursor(1, 0), "x\ny");
+    verifyWordIndex(&index, doc);
+    QVERIFY(!index.hasPending());
+}
+
+void CompletionTest::testWordCompletionMatches()
+{
+    KateWordCompletionModel *model = KateGlobal::self()->wordCompletionModel();
+
+    // the far word is the most frequent one, the near word comes first anyway
+    QString text = "valueFar valueFar valueFar\n";
+    for (int i = 0; i < 100; ++i)
+        text += "\n";
+    text += "valueNear\nval";
+    m_doc->setText(text);
+
+    const int line = m_doc->lines() - 1;
+    QCOMPARE(model->allMatches(m_view, Range(line, 0, line, 3)), QStringList() << "valueNear" << "valueFar");
+
+    // the words of other documents are offered, too
+    KTextEditor::Document *other = EditorChooser::editor()->createDocument(this);
+    other->setText("valueOther");
+    QCOMPARE(model->allMatches(m_view, Range(line, 0, line, 3)), QStringList() << "valueNear" << "valueFar" << "valueOther");
+    delete other;
+    QCOMPARE(model->allMatches(m_view, Range(line, 0, line, 3)), QStringList() << "valueNear" << "valueFar");
+}
+
 #include "completion_test.moc"
@@ -52,6 +52,9 @@ class CompletionTest : public QObject
     void testCustomStartCompl();
     void testKateCompletionModel();
     void testAbortImmideatelyAfterStart(); 
+    void testWordIndex();
+    void testWordIndexPending();
+    void testWordCompletionMatches();
 
   private:
     KTextEditor::Document* m_doc;
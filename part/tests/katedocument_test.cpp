@@ -23,9 +23,13 @@
 #include <qtest_kde.h>
 
 #include <katedocument.h>
+#include <katebuffer.h>
 #include <ktexteditor/movingcursor.h>
 #include <kateconfig.h>
 #include <ktemporaryfile.h>
+#include <kcodecs.h>
+
+#include <QtCore/QTime>
 
 ///TODO: is there a FindValgrind cmake command we could use to
 ///      define this automatically?
@@ -325,9 +329,10 @@ void KateDocumentTest::testInsertNewline()
     doc.editWrapLine(1, 4);
 }
 
-// we have two different ways of creating the md5 checksum:
-// in KateFileLoader and KateDocument::createDigest. Make
-// sure, these two implementations result in the same checksum.
+// we have three different ways of creating the md5 checksum:
+// in KateFileLoader, while saving in Kate::TextBuffer and in
+// KateDocument::createDigest. Make sure, these implementations
+// result in the same checksum.
 void KateDocumentTest::testDigest()
 {
   // md5sum of data/bug309093.cpp: ff6e0fddece03adeb8f902e8c540735a
@@ -342,6 +347,70 @@ void KateDocumentTest::testDigest()
 
   QCOMPARE(bufferDigest, fileDigest);
   QCOMPARE(docDigest, fileDigest);
+
+  // saving a changed document computes the digest of the written file
+  doc.insertText(KTextEditor::Cursor(0, 0), "// changed\n");
+  KTemporaryFile f;
+  QVERIFY(f.open());
+  QVERIFY(doc.buffer().saveFile(f.fileName()));
+  const QByteArray savedDigest(doc.digest());
+  QVERIFY(savedDigest != fileDigest);
+
+  QFile savedFile(f.fileName());
+  QVERIFY(savedFile.open(QIODevice::ReadOnly));
+  KMD5 md5;
+  md5.update(savedFile);
+  QCOMPARE(savedDigest, md5.hexDigest());
+}
+
+void KateDocumentTest::testBackgroundHighlighting()
+{
+  // enough lines to not get highlighted at once for a view
+  KateDocument doc(false, false, false);
+  QStringList text;
+  for (int i = 0; i < 20000; ++i)
+    text << "int a; // foo";
+  doc.setText(text);
+  doc.setHighlightingMode("C++");
+
+  KateBuffer &buffer = doc.buffer();
+  const int last = doc.lines() - 1;
+
+  // far away lines are done in the background
+  QVERIFY(!buffer.requestHighlighting(last));
+  QVERIFY(!buffer.isHighlighted(last));
+
+  QTime t;
+  t.start();
+  while (!buffer.isHighlighted(last) && t.elapsed() < 30000)
+    QTest::qWait(10);
+  QVERIFY(buffer.isHighlighted(last));
+
+  const int normalAttribute = doc.kateTextLine(0)->attribute(0);
+  QCOMPARE(doc.plainKateTextLine(last)->attribute(0), normalAttribute);
+
+  // open a comment, everything below gets a comment
+  doc.insertText(Cursor(10, 0), "/*");
+  const int commentAttribute = doc.kateTextLine(10)->attribute(0);
+  QVERIFY(commentAttribute != normalAttribute);
+  QCOMPARE(doc.kateTextLine(last)->attribute(0), commentAttribute);
+
+  // close it again, highlighting of the lines below is redone
+  doc.removeText(Range(10, 0, 10, 2));
+  QCOMPARE(doc.kateTextLine(last)->attribute(0), normalAttribute);
+
+  // open and close before the lines below are highlighted again, their old highlighting stays valid
+  doc.insertText(Cursor(10, 0), "/*");
+  doc.removeText(Range(10, 0, 10, 2));
+  QCOMPARE(doc.kateTextLine(5000)->attribute(0), normalAttribute);
+  QCOMPARE(doc.kateTextLine(last)->attribute(0), normalAttribute);
+
+  // lines changed behind the highlighted area must not keep their old highlighting
+  doc.insertText(Cursor(10, 0), "/*");
+  doc.insertText(Cursor(15000, 0), "*/");
+  QCOMPARE(doc.kateTextLine(14999)->attribute(0), commentAttribute);
+  QCOMPARE(doc.kateTextLine(15001)->attribute(0), normalAttribute);
+  QCOMPARE(doc.kateTextLine(last)->attribute(0), normalAttribute);
 }
 
 #include "katedocument_test.moc"
@@ -44,6 +44,8 @@ private Q_SLOTS:
   void testInsertNewline();
 
   void testDigest();
+
+  void testBackgroundHighlighting();
 };
 
 #endif // KATE_DOCUMENT_TEST_H
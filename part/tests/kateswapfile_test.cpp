@@ -0,0 +1,227 @@
+/* This file is part of the KDE libraries
+   Copyright (C) 2026 agent <agent@local>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "kateswapfile_test.h"
+#include "moc_kateswapfile_test.cpp"
+
+#include <qtest_kde.h>
+
+#include <katedocument.h>
+#include <kateswapfile.h>
+#include <ktexteditor/cursor.h>
+#include <ktexteditor/range.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
+
+using namespace KTextEditor;
+
+QTEST_KDEMAIN(SwapFileTest, GUI)
+
+SwapFileTest::SwapFileTest()
+  : QObject()
+{
+}
+
+SwapFileTest::~SwapFileTest()
+{
+}
+
+QString SwapFileTest::writeFile(const QString &name, const QByteArray &content)
+{
+  QFile file(m_dir.name() + name);
+  if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+    return QString();
+  return file.fileName();
+}
+
+QByteArray SwapFileTest::writtenSwapFile(KateDocument &doc)
+{
+  // hand the pending edits to the worker and wait until it wrote them
+  Kate::SwapFile *swapFile = doc.swapFile();
+  swapFile->commitBatch();
+  swapFile->waitForWrites();
+
+  QFile file(swapFile->fileName());
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+  return file.readAll();
+}
+
+QString SwapFileTest::recoveredText(const QString &original, const QByteArray &swapFile)
+{
+  KateDocument doc(false, false, false);
+  doc.setText(original);
+
+  QDataStream stream(swapFile);
+  stream.setVersion(QDataStream::Qt_4_6);
+  if (!doc.swapFile()->recover(stream, false))
+    return QString("<not recovered>");
+  return doc.text();
+}
+
+QByteArray SwapFileTest::version2SwapFile(const QByteArray &digest)
+{
+  // "hello" -> "hello world" -> "hello\n world" -> "hello\nworld", the last transaction is not finished
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_4_6);
+  stream << QByteArray("Kate Swap File 2.0") << digest;
+  stream << qint8('S') << qint8('I') << 0 << 5 << QByteArray(" world") << qint8('E');
+  stream << qint8('S') << qint8('W') << 0 << 5 << qint8('E');
+  stream << qint8('S') << qint8('R') << 1 << 0 << 1;
+  return data;
+}
+
+void SwapFileTest::testRecoverEdits()
+{
+  const QString original("line one\nline two\n");
+  const QString fileName = writeFile("edits.txt", original.toUtf8());
+  QVERIFY(!fileName.isEmpty());
+
+  KateDocument doc(false, false, false);
+  QVERIFY(doc.openUrl(KUrl(fileName)));
+  QCOMPARE(doc.text(), original);
+
+  // typing, merged into one insertion
+  doc.insertText(Cursor(0, 8), "a");
+  doc.insertText(Cursor(0, 9), "b");
+  doc.insertText(Cursor(0, 10), "c");
+
+  // backspace, merged into one removal
+  doc.removeText(Range(0, 10, 0, 11));
+  doc.removeText(Range(0, 9, 0, 10));
+
+  // delete, merged into one removal
+  doc.removeText(Range(1, 0, 1, 1));
+  doc.removeText(Range(1, 0, 1, 1));
+
+  // paste of several lines
+  doc.insertText(Cursor(1, 2), "pasted\ntext ");
+
+  // typing on another line ends the merge
+  doc.insertText(Cursor(0, 0), "x");
+
+  QCOMPARE(doc.text(), QString("xline onea\nnepasted\ntext  two\n"));
+
+  const QByteArray swapFile = writtenSwapFile(doc);
+  QVERIFY(!swapFile.isEmpty());
+  QCOMPARE(recoveredText(original, swapFile), doc.text());
+}
+
+void SwapFileTest::testBrokenLastBatch()
+{
+  const QString original("first\nsecond\n");
+  const QString fileName = writeFile("broken.txt", original.toUtf8());
+  QVERIFY(!fileName.isEmpty());
+
+  KateDocument doc(false, false, false);
+  QVERIFY(doc.openUrl(KUrl(fileName)));
+
+  // two batches, the second one gets broken
+  doc.insertText(Cursor(0, 5), " batch");
+  const QByteArray firstBatch = writtenSwapFile(doc);
+  const QString firstText = doc.text();
+
+  doc.insertText(Cursor(1, 0), "another ");
+  doc.removeText(Range(0, 0, 0, 1));
+  const QByteArray bothBatches = writtenSwapFile(doc);
+  QVERIFY(bothBatches.size() > firstBatch.size());
+  QCOMPARE(recoveredText(original, bothBatches), doc.text());
+
+  // truncated while writing the last batch
+  for (int size = firstBatch.size(); size < bothBatches.size(); ++size)
+    QCOMPARE(recoveredText(original, bothBatches.left(size)), firstText);
+
+  // bad checksum, in the data of the batch or in the checksum itself
+  for (int i = firstBatch.size() + 4; i < bothBatches.size(); ++i) {
+    QByteArray corrupted = bothBatches;
+    corrupted[i] = corrupted[i] ^ 0x20;
+    QCOMPARE(recoveredText(original, corrupted), firstText);
+  }
+}
+
+void SwapFileTest::testVersion2()
+{
+  const QByteArray swapFile = version2SwapFile(QByteArray());
+  QCOMPARE(recoveredText("hello", swapFile), QString("hello\nworld"));
+
+  // the last action is cut off, the transaction is replayed up to it
+  QCOMPARE(recoveredText("hello", swapFile.left(swapFile.size() - 2)), QString("hello\n world"));
+
+  // an edit action outside of a transaction makes it broken, what was read before is replayed
+  QByteArray outside = swapFile;
+  outside.chop(4 + 4 + 4 + 1 + 1);
+  QDataStream stream(&outside, QIODevice::Append);
+  stream.setVersion(QDataStream::Qt_4_6);
+  stream << qint8('I') << 0 << 0 << QByteArray("lost");
+  QCOMPARE(recoveredText("hello", outside), QString("hello\n world"));
+
+  // unknown versions are not recovered
+  QByteArray unknown = swapFile;
+  unknown.replace("Kate Swap File 2.0", "Kate Swap File 9.0");
+  QCOMPARE(recoveredText("hello", unknown), QString("<not recovered>"));
+}
+
+void SwapFileTest::testUpgradeVersion2()
+{
+  const QString fileName = writeFile("upgrade.txt", "hello");
+  QVERIFY(!fileName.isEmpty());
+
+  // the digest of the file and the name of its swap file
+  QByteArray digest;
+  QString swapFileName;
+  {
+    KateDocument doc(false, false, false);
+    QVERIFY(doc.openUrl(KUrl(fileName)));
+    digest = doc.digest();
+    swapFileName = doc.swapFile()->fileName();
+  }
+  QVERIFY(!swapFileName.isEmpty());
+
+  // Kate crashed with a swap file of version 2.0
+  QFile file(swapFileName);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(version2SwapFile(digest));
+  file.close();
+
+  KateDocument doc(false, false, false);
+  QVERIFY(doc.openUrl(KUrl(fileName)));
+  QVERIFY(doc.swapFile()->shouldRecover());
+  doc.swapFile()->recover();
+  QCOMPARE(doc.text(), QString("hello\nworld"));
+
+  // the swap file is rewritten as version 3.0 with the same edits
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray upgraded = file.readAll();
+  file.close();
+
+  QDataStream stream(upgraded);
+  stream.setVersion(QDataStream::Qt_4_6);
+  int version = 0;
+  QList<QByteArray> batches;
+  QVERIFY(doc.swapFile()->readSwapFile(stream, true, &version, batches));
+  QCOMPARE(version, 3);
+  QCOMPARE(batches.size(), 3);
+  QCOMPARE(recoveredText("hello", upgraded), QString("hello\nworld"));
+
+  // further edits are appended to it
+  doc.insertText(Cursor(1, 5), "!");
+  QCOMPARE(recoveredText("hello", writtenSwapFile(doc)), QString("hello\nworld!"));
+}
@@ -0,0 +1,53 @@
+/* This file is part of the KDE libraries
+   Copyright (C) 2026 agent <agent@local>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KATE_SWAPFILE_TEST_H
+#define KATE_SWAPFILE_TEST_H
+
+#include <QtCore/QObject>
+
+#include <ktempdir.h>
+
+class KateDocument;
+
+class SwapFileTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  SwapFileTest();
+  ~SwapFileTest();
+
+private Q_SLOTS:
+  void testRecoverEdits();
+  void testBrokenLastBatch();
+  void testVersion2();
+  void testUpgradeVersion2();
+
+private:
+  QString writeFile(const QString &name, const QByteArray &content);
+  QByteArray writtenSwapFile(KateDocument &doc);
+  QString recoveredText(const QString &original, const QByteArray &swapFile);
+  QByteArray version2SwapFile(const QByteArray &digest);
+
+private:
+  KTempDir m_dir;
+};
+
+#endif // KATE_SWAPFILE_TEST_H
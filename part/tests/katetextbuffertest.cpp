@@ -22,6 +22,13 @@
 #include "katetextbuffertest.h"
 #include "katetextbuffer.h"
 #include "katetextcursor.h"
+#include "katetextrange.h"
+#include "katetextloader.h"
+
+#include <ktemporaryfile.h>
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QCryptographicHash>
 
 QTEST_MAIN(KateTextBufferTest)
 
@@ -205,3 +212,431 @@ void KateTextBufferTest::cursorTest()
     lastBufferContent = buffer.text ();
   }
 }
+
+void KateTextBufferTest::loadCodecSwitchTest()
+{
+  // ascii start, larger than the detection stage and read chunks, latin-15 in between the detection samples
+  KTemporaryFile file;
+  QVERIFY (file.open ());
+  const QByteArray asciiLine ("just some plain ascii text in this line\n");
+  for (int i = 0; i < 32768; ++i) {
+    if (i == 12000)
+      file.write ("latin-15 \xe4\xf6\xfc\n");
+    file.write (asciiLine);
+  }
+  file.close ();
+
+  // read in chunks, a mapped file would be decoded in one go
+  Kate::TextBuffer buffer (0);
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  buffer.setAllowMemoryMapping (false);
+
+  // no encoding errors, the utf-8 start is no reason to fail
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  QVERIFY (buffer.load (file.fileName(), encodingErrors, tooLongLines, false));
+  QVERIFY (!encodingErrors);
+  QCOMPARE (buffer.lines (), 32770);
+  QCOMPARE (buffer.line (12000)->string (), QString::fromUtf8 ("latin-15 \xc3\xa4\xc3\xb6\xc3\xbc"));
+  QCOMPARE (buffer.textCodec (), QTextCodec::codecForName ("ISO 8859-15"));
+
+  // the file must not have been decoded completely again
+  QVERIFY (buffer.bytesDecodedMoreThanOnce () < 32768 * asciiLine.size());
+
+  // the detection did choose utf-8, the loader itself switched the codec
+  Kate::TextLoader loader (file.fileName(), KEncodingProber::Universal, false);
+  QCOMPARE (loader.detectFirstRound (QTextCodec::codecForName ("UTF-8"), QTextCodec::codecForName ("ISO 8859-15")), 0);
+  QVERIFY (loader.open (QTextCodec::codecForName ("UTF-8"), QTextCodec::codecForName ("ISO 8859-15")));
+  bool lineErrors = false;
+  while (!loader.eof ()) {
+    int offset = 0, length = 0;
+    lineErrors = !loader.readLine (offset, length) || lineErrors;
+  }
+  QVERIFY (!lineErrors);
+  QCOMPARE (loader.textCodec (), QTextCodec::codecForName ("ISO 8859-15"));
+}
+
+void KateTextBufferTest::loadInBackgroundTest()
+{
+  // enough lines for a lot of blocks
+  KTemporaryFile file;
+  QVERIFY (file.open ());
+  for (int i = 0; i < 100000; ++i)
+    file.write (QByteArray ("line ") + QByteArray::number (i) + '\n');
+  file.close ();
+
+  // load once synchronous, as reference
+  Kate::TextBuffer reference (0);
+  reference.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  reference.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  QVERIFY (reference.load (file.fileName(), encodingErrors, tooLongLines, false));
+
+  // load in the background, wait for the end
+  Kate::TextBuffer buffer (0);
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  QSignalSpy progressSpy (&buffer, SIGNAL(loadingProgress(QString,int)));
+  QSignalSpy finishedSpy (&buffer, SIGNAL(loadingFinished(QString,bool,bool,bool)));
+  QEventLoop loop;
+  connect (&buffer, SIGNAL(loadingFinished(QString,bool,bool,bool)), &loop, SLOT(quit()));
+  QVERIFY (buffer.loadInBackground (file.fileName(), false));
+  QVERIFY (buffer.isLoading ());
+  if (finishedSpy.isEmpty())
+    loop.exec ();
+
+  // same content, each batch did only add lines
+  QVERIFY (!buffer.isLoading ());
+  QCOMPARE (finishedSpy.count (), 1);
+  QVERIFY (finishedSpy.first().at(1).toBool ());
+  QVERIFY (!progressSpy.isEmpty ());
+  QCOMPARE (buffer.lines (), reference.lines ());
+  QCOMPARE (buffer.text (), reference.text ());
+}
+
+void KateTextBufferTest::saveInBackgroundTest()
+{
+  // enough lines for a lot of blocks, compact stored
+  KTemporaryFile file;
+  QVERIFY (file.open ());
+  for (int i = 0; i < 100000; ++i)
+    file.write (QByteArray ("line ") + QByteArray::number (i) + '\n');
+  file.close ();
+
+  Kate::TextBuffer buffer (0);
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  buffer.setCompactLineStorage (true);
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  QVERIFY (buffer.load (file.fileName(), encodingErrors, tooLongLines, false));
+  const qint64 savedRevision = buffer.revision ();
+
+  // save in the background, change the buffer meanwhile
+  KTemporaryFile target;
+  QVERIFY (target.open ());
+  QSignalSpy savedSpy (&buffer, SIGNAL(saved(QString)));
+  QSignalSpy finishedSpy (&buffer, SIGNAL(savingFinished(QString,bool,QString)));
+  QEventLoop loop;
+  connect (&buffer, SIGNAL(savingFinished(QString,bool,QString)), &loop, SLOT(quit()));
+  QVERIFY (buffer.saveInBackground (target.fileName()));
+  QVERIFY (buffer.isSaving ());
+  QVERIFY (!buffer.saveInBackground (target.fileName()));
+
+  buffer.startEditing ();
+  buffer.insertText (KTextEditor::Cursor (0, 0), "changed ");
+  buffer.insertText (KTextEditor::Cursor (50000, 4), " changed");
+  buffer.wrapLine (KTextEditor::Cursor (99999, 2));
+  buffer.finishEditing ();
+
+  if (finishedSpy.isEmpty())
+    loop.exec ();
+
+  // the snapshot is on disk, the buffer is not
+  QVERIFY (!buffer.isSaving ());
+  QCOMPARE (finishedSpy.count (), 1);
+  QVERIFY (finishedSpy.first().at(1).toBool ());
+  QCOMPARE (savedSpy.count (), 0);
+  QCOMPARE (buffer.history().lastSavedRevision (), savedRevision);
+  QCOMPARE (buffer.line (0)->string (), QString ("changed line 0"));
+
+  QFile original (file.fileName());
+  QVERIFY (original.open (QIODevice::ReadOnly));
+  QFile saved (target.fileName());
+  QVERIFY (saved.open (QIODevice::ReadOnly));
+  const QByteArray savedData = saved.readAll ();
+  QCOMPARE (savedData, original.readAll ());
+  QCOMPARE (buffer.digest (), QCryptographicHash::hash (savedData, QCryptographicHash::Md5).toHex ());
+
+  // aborted save leaves the file alone, unless the thread was already done
+  finishedSpy.clear ();
+  QVERIFY (buffer.saveInBackground (target.fileName()));
+  buffer.abortSaving ();
+  QVERIFY (!buffer.isSaving ());
+  QCOMPARE (finishedSpy.count (), 1);
+  saved.close ();
+  QVERIFY (saved.open (QIODevice::ReadOnly));
+  if (finishedSpy.first().at(1).toBool ())
+    QCOMPARE (saved.readAll (), buffer.text ().toUtf8 ());
+  else
+    QCOMPARE (saved.readAll (), savedData);
+
+  // deleting the buffer aborts saving, the file is the old one or the complete new one
+  KTemporaryFile otherTarget;
+  QVERIFY (otherTarget.open ());
+  otherTarget.write ("old content\n");
+  otherTarget.close ();
+
+  Kate::TextBuffer *deleted = new Kate::TextBuffer (0);
+  deleted->setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  deleted->setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  QVERIFY (deleted->load (file.fileName(), encodingErrors, tooLongLines, false));
+  QVERIFY (deleted->saveInBackground (otherTarget.fileName()));
+  delete deleted;
+
+  QFile other (otherTarget.fileName());
+  QVERIFY (other.open (QIODevice::ReadOnly));
+  const QByteArray otherData = other.readAll ();
+  QVERIFY (otherData == "old content\n" || otherData == savedData);
+}
+
+void KateTextBufferTest::blockIndexTest()
+{
+  // small blocks, to get a lot of splits and merges
+  Kate::TextBuffer buffer (0, 4);
+  QStringList reference;
+  reference << QString ();
+
+  // wrap lines at pseudo random positions, in front of the buffer too
+  qsrand (42);
+  buffer.startEditing ();
+  for (int i = 0; i < 500; ++i) {
+    const int line = qrand () % reference.size ();
+    buffer.insertText (KTextEditor::Cursor (line, 0), QString::number (i));
+    reference[line].prepend (QString::number (i));
+    buffer.wrapLine (KTextEditor::Cursor (line, 0));
+    reference.insert (line, QString ());
+  }
+  buffer.finishEditing ();
+
+  // unwrap half of them again
+  buffer.startEditing ();
+  for (int i = 0; i < 250; ++i) {
+    const int line = 1 + qrand () % (reference.size () - 1);
+    buffer.unwrapLine (line);
+    reference[line - 1].append (reference.takeAt (line));
+  }
+  buffer.finishEditing ();
+
+  // each line must be found in the right block, in order and in reverse order
+  QCOMPARE (buffer.lines (), reference.size ());
+  for (int line = 0; line < reference.size (); ++line)
+    QCOMPARE (buffer.line (line)->string (), reference.at (line));
+  for (int line = reference.size () - 1; line >= 0; --line)
+    QCOMPARE (buffer.line (line)->string (), reference.at (line));
+}
+
+void KateTextBufferTest::insertRemoveLinesTest()
+{
+  // small blocks, the inserted and removed lines span many of them
+  Kate::TextBuffer buffer (0, 4);
+  QStringList reference;
+  reference << QString ();
+
+  QStringList texts;
+  for (int i = 1; i < 30; ++i)
+    texts << QString ("line %1").arg (i);
+
+  // append lines
+  buffer.startEditing ();
+  buffer.insertLines (1, texts);
+  buffer.finishEditing ();
+  reference += texts;
+  QCOMPARE (buffer.text (), reference.join ("\n"));
+
+  Kate::TextCursor *front = new Kate::TextCursor (buffer, KTextEditor::Cursor (1, 0), Kate::TextCursor::MoveOnInsert);
+  Kate::TextCursor *behind = new Kate::TextCursor (buffer, KTextEditor::Cursor (5, 1), Kate::TextCursor::MoveOnInsert);
+  Kate::TextRange *range = new Kate::TextRange (buffer, KTextEditor::Range (2, 1, 6, 1), Kate::TextRange::DoNotExpand);
+
+  // insert lines in the middle, cursors on and behind the line move down
+  const qint64 revision = buffer.revision ();
+  buffer.history ().lockRevision (revision);
+  buffer.startEditing ();
+  buffer.insertLines (5, texts.mid (0, 10));
+  buffer.finishEditing ();
+  for (int i = 0; i < 10; ++i)
+    reference.insert (5 + i, texts.at (i));
+  QCOMPARE (buffer.text (), reference.join ("\n"));
+  QCOMPARE (front->toCursor (), KTextEditor::Cursor (1, 0));
+  QCOMPARE (behind->toCursor (), KTextEditor::Cursor (15, 1));
+
+  // the history transforms the same way
+  int cursorLine = 5, cursorColumn = 1;
+  buffer.history ().transformCursor (cursorLine, cursorColumn, KTextEditor::MovingCursor::MoveOnInsert, revision);
+  QCOMPARE (KTextEditor::Cursor (cursorLine, cursorColumn), behind->toCursor ());
+
+  // the range spans the inserted lines and is found for all of them
+  QCOMPARE (range->toRange (), KTextEditor::Range (2, 1, 16, 1));
+  for (int i = 2; i <= 16; ++i)
+    QVERIFY (buffer.rangesForLine (i, 0, false).contains (range));
+
+  // remove lines in the middle, cursors on them move to the start of the line behind them
+  buffer.startEditing ();
+  buffer.removeLines (3, 20);
+  buffer.finishEditing ();
+  reference.erase (reference.begin () + 3, reference.begin () + 21);
+  QCOMPARE (buffer.text (), reference.join ("\n"));
+  QCOMPARE (front->toCursor (), KTextEditor::Cursor (1, 0));
+  QCOMPARE (behind->toCursor (), KTextEditor::Cursor (3, 0));
+  QCOMPARE (range->toRange (), KTextEditor::Range (2, 1, 3, 0));
+
+  cursorLine = 5, cursorColumn = 1;
+  buffer.history ().transformCursor (cursorLine, cursorColumn, KTextEditor::MovingCursor::MoveOnInsert, revision);
+  QCOMPARE (KTextEditor::Cursor (cursorLine, cursorColumn), behind->toCursor ());
+  buffer.history ().unlockRevision (revision);
+
+  // remove the last lines, cursors on them move to the end of the line in front of them
+  buffer.startEditing ();
+  buffer.removeLines (2, buffer.lines () - 1);
+  buffer.finishEditing ();
+  reference.erase (reference.begin () + 2, reference.end ());
+  QCOMPARE (buffer.text (), reference.join ("\n"));
+  QCOMPARE (behind->toCursor (), KTextEditor::Cursor (1, reference.at (1).size ()));
+  QCOMPARE (range->toRange (), KTextEditor::Range (1, reference.at (1).size (), 1, reference.at (1).size ()));
+
+  delete range;
+  delete behind;
+  delete front;
+
+  // insert and remove at pseudo random positions, check the block index
+  qsrand (42);
+  for (int i = 0; i < 200; ++i) {
+    buffer.startEditing ();
+    if (reference.size () < 2 || qrand () % 2) {
+      const int at = qrand () % (reference.size () + 1);
+      const QStringList newTexts = texts.mid (0, 1 + qrand () % texts.size ());
+      buffer.insertLines (at, newTexts);
+      for (int j = 0; j < newTexts.size (); ++j)
+        reference.insert (at + j, newTexts.at (j));
+    } else {
+      const int from = qrand () % reference.size ();
+      const int to = qMin (from + qrand () % 10, reference.size () - 1);
+      if (to - from + 1 < reference.size ()) {
+        buffer.removeLines (from, to);
+        reference.erase (reference.begin () + from, reference.begin () + to + 1);
+      }
+    }
+    buffer.finishEditing ();
+  }
+
+  QCOMPARE (buffer.lines (), reference.size ());
+  for (int line = 0; line < reference.size (); ++line)
+    QCOMPARE (buffer.line (line)->string (), reference.at (line));
+  for (int line = reference.size () - 1; line >= 0; --line)
+    QCOMPARE (buffer.line (line)->string (), reference.at (line));
+}
+
+void KateTextBufferTest::wrapUnwrapRangeTest()
+{
+  // small blocks, the range is the only one with cursors, the other blocks have none
+  Kate::TextBuffer buffer (0, 4);
+  QStringList texts;
+  for (int i = 1; i < 12; ++i)
+    texts << QString ("line %1").arg (i);
+  buffer.startEditing ();
+  buffer.insertText (KTextEditor::Cursor (0, 0), "line 0");
+  buffer.insertLines (1, texts);
+  buffer.finishEditing ();
+  const QString text = buffer.text ();
+
+  Kate::TextRange *range = new Kate::TextRange (buffer, KTextEditor::Range (5, 1, 5, 4), Kate::TextRange::DoNotExpand);
+  QVERIFY (buffer.rangesForLine (5, 0, false).contains (range));
+
+  // wrap the line of the range in front of it, the range moves to the next line
+  buffer.startEditing ();
+  buffer.wrapLine (KTextEditor::Cursor (5, 0));
+  buffer.finishEditing ();
+  QCOMPARE (range->toRange (), KTextEditor::Range (6, 1, 6, 4));
+  QVERIFY (!buffer.rangesForLine (5, 0, false).contains (range));
+  QVERIFY (buffer.rangesForLine (6, 0, false).contains (range));
+
+  buffer.startEditing ();
+  buffer.unwrapLine (6);
+  buffer.finishEditing ();
+  QCOMPARE (range->toRange (), KTextEditor::Range (5, 1, 5, 4));
+  QVERIFY (buffer.rangesForLine (5, 0, false).contains (range));
+  QVERIFY (!buffer.rangesForLine (6, 0, false).contains (range));
+
+  // wrap inside of the range, it spans both lines
+  buffer.startEditing ();
+  buffer.wrapLine (KTextEditor::Cursor (5, 2));
+  buffer.finishEditing ();
+  QCOMPARE (range->toRange (), KTextEditor::Range (5, 1, 6, 2));
+  QVERIFY (buffer.rangesForLine (5, 0, false).contains (range));
+  QVERIFY (buffer.rangesForLine (6, 0, false).contains (range));
+
+  buffer.startEditing ();
+  buffer.unwrapLine (6);
+  buffer.finishEditing ();
+  QCOMPARE (range->toRange (), KTextEditor::Range (5, 1, 5, 4));
+  QVERIFY (!buffer.rangesForLine (6, 0, false).contains (range));
+
+  // wrap and unwrap lines in front of the range, in blocks without cursors, the range moves across blocks
+  for (int i = 1; i <= 10; ++i) {
+    buffer.startEditing ();
+    buffer.wrapLine (KTextEditor::Cursor (0, 0));
+    buffer.finishEditing ();
+    QCOMPARE (range->toRange (), KTextEditor::Range (5 + i, 1, 5 + i, 4));
+    QVERIFY (buffer.rangesForLine (5 + i, 0, false).contains (range));
+    QVERIFY (!buffer.rangesForLine (4 + i, 0, false).contains (range));
+  }
+
+  for (int i = 9; i >= 0; --i) {
+    buffer.startEditing ();
+    buffer.unwrapLine (1);
+    buffer.finishEditing ();
+    QCOMPARE (range->toRange (), KTextEditor::Range (5 + i, 1, 5 + i, 4));
+    QVERIFY (buffer.rangesForLine (5 + i, 0, false).contains (range));
+    QVERIFY (!buffer.rangesForLine (6 + i, 0, false).contains (range));
+  }
+
+  // wrap and unwrap lines behind the range, the range stays
+  buffer.startEditing ();
+  buffer.wrapLine (KTextEditor::Cursor (9, 2));
+  buffer.unwrapLine (10);
+  buffer.finishEditing ();
+  QCOMPARE (range->toRange (), KTextEditor::Range (5, 1, 5, 4));
+  QVERIFY (buffer.rangesForLine (5, 0, false).contains (range));
+
+  QCOMPARE (buffer.text (), text);
+  delete range;
+}
+
+void KateTextBufferTest::compactLineStorageTest()
+{
+  // ascii, latin-1 and a line that needs utf-16
+  KTemporaryFile file;
+  QVERIFY (file.open ());
+  file.write ("  plain ascii\n");
+  file.write ("latin-1 \xc3\xa4\xc3\xb6\xc3\xbc\n");
+  file.write ("euro \xe2\x82\xac\n");
+  file.close ();
+
+  Kate::TextBuffer buffer (0);
+  buffer.setFallbackTextCodec (QTextCodec::codecForName ("ISO 8859-15"));
+  buffer.setTextCodec (QTextCodec::codecForName ("UTF-8"));
+  buffer.setCompactLineStorage (true);
+  bool encodingErrors = false;
+  bool tooLongLines = false;
+  QVERIFY (buffer.load (file.fileName(), encodingErrors, tooLongLines, true));
+  QCOMPARE (buffer.lines (), 4);
+
+  // only the lines that fit into latin-1 are compact
+  QVERIFY (buffer.line (0)->isCompact ());
+  QVERIFY (buffer.line (1)->isCompact ());
+  QVERIFY (!buffer.line (2)->isCompact ());
+
+  // simple queries don't need the QString
+  QCOMPARE (buffer.line (0)->length (), 13);
+  QCOMPARE (buffer.line (0)->firstChar (), 2);
+  QCOMPARE (buffer.line (1)->at (8), QChar (0xe4));
+  QVERIFY (buffer.line (1)->isCompact ());
+
+  // whole text is the same as without compact storage
+  QCOMPARE (buffer.text (), QString::fromUtf8 ("  plain ascii\nlatin-1 \xc3\xa4\xc3\xb6\xc3\xbc\neuro \xe2\x82\xac\n"));
+  QVERIFY (buffer.line (1)->isCompact ());
+
+  // access to the string converts the line
+  QCOMPARE (buffer.line (1)->string (), QString::fromUtf8 ("latin-1 \xc3\xa4\xc3\xb6\xc3\xbc"));
+  QVERIFY (!buffer.line (1)->isCompact ());
+
+  // editing a compact line works
+  buffer.startEditing ();
+  buffer.wrapLine (KTextEditor::Cursor (0, 7));
+  buffer.insertText (KTextEditor::Cursor (1, 0), "x");
+  buffer.finishEditing ();
+  QCOMPARE (buffer.line (0)->string (), QString ("  plain"));
+  QCOMPARE (buffer.line (1)->string (), QString ("x ascii"));
+}
@@ -37,6 +37,13 @@ class KateTextBufferTest : public QObject
     void wrapLineTest();
     void insertRemoveTextTest();
     void cursorTest();
+    void loadCodecSwitchTest();
+    void loadInBackgroundTest();
+    void saveInBackgroundTest();
+    void blockIndexTest();
+    void insertRemoveLinesTest();
+    void wrapUnwrapRangeTest();
+    void compactLineStorageTest();
 };
 
 #endif // KATEBUFFERTEST_H
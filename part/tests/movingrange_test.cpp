@@ -23,8 +23,12 @@
 #include <qtest_kde.h>
 #include <qtestmouse.h>
 
+#include <QtCore/QDebug>
+
 #include <katedocument.h>
 #include <kateview.h>
+#include <katebuffer.h>
+#include <katetextrange.h>
 #include <ktexteditor/movingrange.h>
 #include <ktexteditor/movingrangefeedback.h>
 
@@ -32,6 +36,43 @@ using namespace KTextEditor;
 
 QTEST_KDEMAIN(MovingRangeTest, GUI)
 
+/**
+ * Create the given number of ranges at pseudo random positions, most of them short,
+ * some of them spanning up to 200 lines, like search or spell check highlights and diagnostics.
+ */
+static QList<MovingRange *> createRanges (KateDocument &doc, int count)
+{
+  qsrand (42);
+  QList<MovingRange *> ranges;
+  for (int i = 0; i < count; ++i) {
+    const int startLine = qrand () % doc.lines ();
+    const int length = (i % 10 == 0) ? (qrand () % 200) : (qrand () % 3);
+    const int endLine = qMin (startLine + length, doc.lines () - 1);
+    ranges.append (doc.newMovingRange (Range (startLine, 0, endLine, 1)));
+  }
+  return ranges;
+}
+
+/**
+ * Check the ranges found for each line are exactly the ones intersecting it.
+ */
+static bool verifyRangesForLine (KateDocument &doc, const QList<MovingRange *> &ranges)
+{
+  for (int line = 0; line < doc.lines (); ++line) {
+    QSet<Kate::TextRange *> expected;
+    foreach (MovingRange *range, ranges)
+      if (range->start ().line () <= line && line <= range->end ().line ())
+        expected.insert (static_cast<Kate::TextRange *> (range));
+
+    const QList<Kate::TextRange *> found = doc.buffer ().rangesForLine (line, 0, false);
+    if (found.size () != expected.size () || found.toSet () != expected) {
+      qWarning () << "wrong ranges for line" << line << found.size () << expected.size ();
+      return false;
+    }
+  }
+  return true;
+}
+
 namespace QTest {
     template<>
     char *toString(const KTextEditor::Cursor &cursor)
@@ -423,3 +464,75 @@ void MovingRangeTest::testFeedbackMouse()
   QVERIFY(!rf.mouseEnteredRangeCalled());
   QVERIFY(rf.mouseExitedRangeCalled());
 }
+
+// tests:
+// - TextBuffer::rangesForLine returns exactly the ranges intersecting the line, after edits moving them
+void MovingRangeTest::testRangesForLine()
+{
+  KateDocument doc (false, false, false);
+  doc.setText (QString ("xx\n").repeated (1000));
+
+  QList<MovingRange *> ranges = createRanges (doc, 2000);
+  QVERIFY (verifyRangesForLine (doc, ranges));
+
+  // wrap lines, in the middle of blocks and at their borders, the blocks get split
+  for (int i = 0; i < 200; ++i)
+    doc.insertText (Cursor ((i * 37) % doc.lines (), i % 3), "\n");
+  QVERIFY (verifyRangesForLine (doc, ranges));
+
+  // unwrap lines again, the blocks get merged
+  for (int i = 0; i < 300; ++i) {
+    const int line = 1 + (i * 53) % (doc.lines () - 1);
+    doc.removeText (Range (line - 1, doc.lineLength (line - 1), line, 0));
+  }
+  QVERIFY (verifyRangesForLine (doc, ranges));
+
+  // insert and remove many lines at once
+  doc.insertText (Cursor (100, 0), QString ("yy\n").repeated (500));
+  QVERIFY (verifyRangesForLine (doc, ranges));
+  doc.removeText (Range (50, 1, 700, 0));
+  QVERIFY (verifyRangesForLine (doc, ranges));
+
+  // move ranges around
+  for (int i = 0; i < ranges.size (); i += 7)
+    ranges[i]->setRange (Range (i % doc.lines (), 0, (i + i % 100) % doc.lines (), 0));
+  QVERIFY (verifyRangesForLine (doc, ranges));
+
+  qDeleteAll (ranges);
+}
+
+// benchmark: lookup of the ranges of each line like painting does it, 100k ranges in 10k lines
+void MovingRangeTest::benchmarkRangesForLine()
+{
+  KateDocument doc (false, false, false);
+  doc.setText (QString ("int x = 0;\n").repeated (10000));
+  QList<MovingRange *> ranges = createRanges (doc, 100000);
+
+  int found = 0;
+  QBENCHMARK {
+    for (int line = 0; line < doc.lines (); ++line)
+      found += doc.buffer ().rangesForLine (line, 0, false).size ();
+  }
+  QVERIFY (found > 0);
+
+  qDeleteAll (ranges);
+}
+
+// benchmark: typing return and backspace with 100k ranges in 10k lines
+void MovingRangeTest::benchmarkWrapLine()
+{
+  KateDocument doc (false, false, false);
+  doc.setText (QString ("int x = 0;\n").repeated (10000));
+  QList<MovingRange *> ranges = createRanges (doc, 100000);
+
+  QBENCHMARK {
+    for (int i = 0; i < 1000; ++i) {
+      const Cursor position ((i * 97) % 10000, 5);
+      doc.insertText (position, "\n");
+      doc.removeText (Range (position, Cursor (position.line () + 1, 0)));
+    }
+  }
+  QCOMPARE (doc.lines (), 10001);
+
+  qDeleteAll (ranges);
+}
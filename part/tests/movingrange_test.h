@@ -35,6 +35,9 @@ private Q_SLOTS:
   void testFeedbackInvalidRange();
   void testFeedbackCaret();
   void testFeedbackMouse();
+  void testRangesForLine();
+  void benchmarkRangesForLine();
+  void benchmarkWrapLine();
 };
 
 #endif // KATE_MOVINGRANGE_TEST_H
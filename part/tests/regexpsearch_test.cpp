@@ -281,6 +281,42 @@ void RegExpSearchTest::testSearchBackwardInSelection()
   QCOMPARE(result, Range(0, 7, 0, 10));
 }
 
+void RegExpSearchTest::testMultiLineWindow()
+{
+  KateDocument doc(false, false, false);
+  doc.setText("a\nb\na\nb\nc");
+
+  KateLineWindow window;
+  KateRegExpSearch search(&doc, Qt::CaseSensitive, &window);
+
+  QVector<Range> result = search.search("(a)\\n(b)", doc.documentRange());
+  QCOMPARE(result.size(), 3);
+  QCOMPARE(result[0], Range(0, 0, 1, 1));
+  QCOMPARE(result[1], Range(0, 0, 0, 1));
+  QCOMPARE(result[2], Range(1, 0, 1, 1));
+
+  // continuing behind the match reuses the joined lines
+  result = search.search("(a)\\n(b)", Range(Cursor(1, 1), doc.documentEnd()));
+  QCOMPARE(result[0], Range(2, 0, 3, 1));
+  QCOMPARE(window.firstLine(), 0);
+  QCOMPARE(window.lastLine(), 4);
+
+  result = search.search("(a)\\n(b)", Range(Cursor(3, 1), doc.documentEnd()));
+  QCOMPARE(result[0], Range::invalid());
+
+  // a line feed at the end of a line maps to the line end
+  result = search.search("c|\\n", Range(Cursor(1, 1), doc.documentEnd()), true);
+  QCOMPARE(result[0], Range(4, 0, 4, 1));
+  result = search.search("\\n", Range(Cursor(1, 0), doc.documentEnd()));
+  QCOMPARE(result[0], Range(1, 1, 2, 0));
+
+  // after changes the lines are joined again
+  doc.insertText(Cursor(2, 0), "x");
+  result = search.search("(a)\\n(b)", Range(Cursor(1, 1), doc.documentEnd()));
+  QCOMPARE(result[0], Range(2, 1, 3, 1));
+  QCOMPARE(window.firstLine(), 1);
+}
+
 void RegExpSearchTest::test()
 {
   KateDocument doc(false, false, false);
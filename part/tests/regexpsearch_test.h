@@ -50,6 +50,8 @@ class RegExpSearchTest : public QObject
 
     void testSearchBackwardInSelection();
 
+    void testMultiLineWindow();
+
     void test();
 };
 
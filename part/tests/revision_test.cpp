@@ -178,3 +178,103 @@ void RevisionTest::testTransformRange()
     QCOMPARE(r2, Range(Cursor(1, 2), Cursor(1, 2)));
     QCOMPARE(invalidOnEmpty, Range::invalid());
 }
+
+/**
+ * Do the given number of pseudo random edits, covering all editing primitives of the buffer.
+ */
+static void randomEdits(KateDocument &doc, int count)
+{
+    qsrand(42);
+    for (int i = 0; i < count; ++i) {
+        const int line = qrand() % doc.lines();
+        const int column = qrand() % (doc.lineLength(line) + 1);
+        switch (i % 6) {
+            case 0:
+                doc.insertText(Cursor(line, column), "\n");
+                break;
+            case 1:
+                if (line > 0)
+                    doc.removeText(Range(line - 1, doc.lineLength(line - 1), line, 0));
+                break;
+            case 2:
+                doc.insertText(Cursor(line, column), "xyz");
+                break;
+            case 3:
+                doc.removeText(Range(line, column / 2, line, column));
+                break;
+            case 4:
+                if (i % 60 == 4)
+                    doc.editInsertLines(line, QStringList() << "a" << "b" << "c" << "d");
+                else
+                    doc.insertText(Cursor(line, column), "x\ny");
+                break;
+            case 5:
+                if (i % 60 == 5 && line + 4 < doc.lines())
+                    doc.editRemoveLines(line, line + 3);
+                else
+                    doc.insertText(Cursor(line, 0), "\n");
+                break;
+        }
+    }
+}
+
+// tests:
+// - transformCursors() gives the same as transformCursor() for each cursor
+void RevisionTest::testTransformCursors()
+{
+    KateDocument doc (false, false, false);
+    doc.setText(QString("0123456789\n").repeated(100));
+
+    qint64 rev = doc.revision();
+    doc.lockRevision(rev);
+
+    QVector<Cursor> cursors;
+    for (int i = 0; i < 1000; ++i)
+        cursors.append(Cursor(qrand() % doc.lines(), qrand() % 11));
+    const QVector<Cursor> original = cursors;
+
+    randomEdits(doc, 500);
+
+    foreach (MovingCursor::InsertBehavior insertBehavior, QList<MovingCursor::InsertBehavior>() << MovingCursor::MoveOnInsert << MovingCursor::StayOnInsert) {
+        cursors = original;
+        doc.transformCursors(cursors, insertBehavior, rev, -1);
+        for (int i = 0; i < cursors.size(); ++i) {
+            Cursor expected = original.at(i);
+            doc.transformCursor(expected, insertBehavior, rev, -1);
+            QCOMPARE(cursors.at(i), expected);
+        }
+    }
+
+    doc.unlockRevision(rev);
+}
+
+// benchmark: transform 100k cursors over 10k edits in one batch
+void RevisionTest::benchmarkTransformCursors()
+{
+    KateDocument doc (false, false, false);
+    doc.setText(QString("0123456789\n").repeated(10000));
+
+    qint64 rev = doc.revision();
+    doc.lockRevision(rev);
+
+    QVector<Cursor> original;
+    for (int i = 0; i < 100000; ++i)
+        original.append(Cursor(i % doc.lines(), i % 11));
+
+    randomEdits(doc, 10000);
+
+    QVector<Cursor> cursors;
+    QBENCHMARK {
+        cursors = original;
+        doc.transformCursors(cursors, MovingCursor::MoveOnInsert, rev, -1);
+    }
+
+    // spot check against transforming one by one
+    for (int i = 0; i < cursors.size(); i += 1000) {
+        Cursor expected = original.at(i);
+        doc.transformCursor(expected, MovingCursor::MoveOnInsert, rev, -1);
+        QCOMPARE(cursors.at(i), expected);
+    }
+
+    doc.unlockRevision(rev);
+}
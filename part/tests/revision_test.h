@@ -33,6 +33,8 @@ public:
 private Q_SLOTS:
   void testTransformCursor();
   void testTransformRange();
+  void testTransformCursors();
+  void benchmarkTransformCursors();
 };
 
 #endif // KATE_REVISION_TEST_H
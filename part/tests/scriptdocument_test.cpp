@@ -137,3 +137,58 @@ void ScriptDocumentTest::testRfind()
 
   QCOMPARE(m_scriptDoc->rfind(searchStart.line(), searchStart.column(), "a a a"), result);
 }
+
+void ScriptDocumentTest::testAnchor_data()
+{
+  QTest::addColumn<QString>("text");
+  QTest::addColumn<KTextEditor::Cursor>("searchStart");
+  QTest::addColumn<QChar>("character");
+  QTest::addColumn<KTextEditor::Cursor>("result");
+
+  QTest::newRow("nested") << "f(a, (b), c)" << KTextEditor::Cursor(0, 11) << QChar('(') << KTextEditor::Cursor(0, 1);
+  QTest::newRow("closing character") << "f(a, (b), c)" << KTextEditor::Cursor(0, 11) << QChar(')') << KTextEditor::Cursor(0, 1);
+  QTest::newRow("in string") << "f(\"(\", x" << KTextEditor::Cursor(0, 9) << QChar('(') << KTextEditor::Cursor(0, 1);
+  QTest::newRow("in comment") << "{ // }\n  x" << KTextEditor::Cursor(1, 3) << QChar('{') << KTextEditor::Cursor(0, 0);
+  QTest::newRow("previous lines") << "if (a) {\n  b();\n  c();" << KTextEditor::Cursor(2, 5) << QChar('{') << KTextEditor::Cursor(0, 7);
+  QTest::newRow("other kinds") << "[ ( { ) }" << KTextEditor::Cursor(0, 9) << QChar('[') << KTextEditor::Cursor(0, 0);
+  QTest::newRow("unmatched") << "a)" << KTextEditor::Cursor(0, 2) << QChar('(') << KTextEditor::Cursor::invalid();
+}
+
+void ScriptDocumentTest::testAnchor()
+{
+  QFETCH(QString, text);
+  QFETCH(KTextEditor::Cursor, searchStart);
+  QFETCH(QChar, character);
+  QFETCH(KTextEditor::Cursor, result);
+
+  m_doc->setHighlightingMode("C++");
+  m_scriptDoc->setText(text);
+
+  QCOMPARE(m_scriptDoc->anchor(searchStart, character), result);
+}
+
+void ScriptDocumentTest::testAnchorAcrossBlocks()
+{
+  // enough lines for many blocks of the buffer, all of them balanced or hidden in strings and comments
+  QStringList lines;
+  lines << "void f() {";
+  for (int i = 0; i < 1000; ++i)
+    lines << "  g(\"}\"); { h(); } // }";
+  lines << "";
+
+  m_doc->setHighlightingMode("C++");
+  m_scriptDoc->setText(lines.join("\n"));
+
+  QCOMPARE(m_scriptDoc->anchor(KTextEditor::Cursor(1001, 0), '{'), KTextEditor::Cursor(0, 9));
+
+  // an edit in the middle changes the answer and back again
+  m_doc->insertText(KTextEditor::Cursor(500, 0), "{");
+  QCOMPARE(m_scriptDoc->anchor(KTextEditor::Cursor(1001, 0), '{'), KTextEditor::Cursor(500, 0));
+
+  m_doc->removeText(KTextEditor::Range(500, 0, 500, 1));
+  QCOMPARE(m_scriptDoc->anchor(KTextEditor::Cursor(1001, 0), '{'), KTextEditor::Cursor(0, 9));
+
+  // opening a comment hides all brackets behind it
+  m_doc->insertText(KTextEditor::Cursor(0, 0), "/*");
+  QCOMPARE(m_scriptDoc->anchor(KTextEditor::Cursor(1001, 0), '{'), KTextEditor::Cursor::invalid());
+}
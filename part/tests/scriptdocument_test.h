@@ -47,6 +47,10 @@ class ScriptDocumentTest : public QObject
     void testRfind_data();
     void testRfind();
 
+    void testAnchor_data();
+    void testAnchor();
+    void testAnchorAcrossBlocks();
+
   private:
     KateDocument *m_doc;
     KTextEditor::View *m_view;
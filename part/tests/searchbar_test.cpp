@@ -29,6 +29,7 @@
 #include <kateview.h>
 #include <kateconfig.h>
 #include <katesearchbar.h>
+#include <katematchindex.h>
 #include <ktexteditor/movingrange.h>
 
 QTEST_KDEMAIN(SearchBarTest, GUI)
@@ -352,6 +353,69 @@ void SearchBarTest::testReplaceAll()
   QCOMPARE(bar.m_hlRanges.at(1)->toRange(), Range(0, 1, 0, 2));
 }
 
+void SearchBarTest::testFindAllFollowsEdits()
+{
+  KateDocument doc(false, false, false);
+  KateView view(&doc, 0);
+  KateViewConfig config(&view);
+
+  doc.setText("a a\nb\na");
+  KateSearchBar bar(true, &view, &config);
+
+  bar.setSearchPattern("a");
+  bar.findAll();
+
+  QCOMPARE(bar.m_matchIndex->count(), 3);
+
+  // matches on the edited line are searched again, the ones behind are moved
+  doc.insertText(Cursor(0, 1), "a");
+  QCOMPARE(bar.m_matchIndex->matches(), QVector<Range>() << Range(0, 0, 0, 1) << Range(0, 1, 0, 2)
+                                                         << Range(0, 3, 0, 4) << Range(2, 0, 2, 1));
+
+  doc.insertText(Cursor(1, 0), "a\n");
+  QCOMPARE(bar.m_matchIndex->matches(), QVector<Range>() << Range(0, 0, 0, 1) << Range(0, 1, 0, 2)
+                                                         << Range(0, 3, 0, 4) << Range(1, 0, 1, 1)
+                                                         << Range(3, 0, 3, 1));
+
+  doc.removeText(Range(0, 2, 2, 1));
+  QCOMPARE(doc.text(), QString("aa\na"));
+  QCOMPARE(bar.m_matchIndex->matches(), QVector<Range>() << Range(0, 0, 0, 1) << Range(0, 1, 0, 2)
+                                                         << Range(1, 0, 1, 1));
+
+  // the highlighting follows once the events are processed
+  QTest::qWait(0);
+  QCOMPARE(bar.m_hlRanges.size(), 3);
+  QCOMPARE(bar.m_hlRanges.at(2)->toRange(), Range(1, 0, 1, 1));
+}
+
+
+void SearchBarTest::testMatchCounter()
+{
+  KateDocument doc(false, false, false);
+  KateView view(&doc, 0);
+  KateViewConfig config(&view);
+
+  doc.setText("a a a");
+  KateSearchBar bar(true, &view, &config);
+
+  bar.setSearchPattern("a");
+  bar.findAll();
+  QCOMPARE(bar.m_hlRanges.size(), 3);
+
+  // stepping through the matches keeps their highlighting
+  view.setCursorPosition(Cursor(0, 1));
+  bar.findNext();
+  QCOMPARE(view.selectionRange(), Range(0, 2, 0, 3));
+  QCOMPARE(bar.m_hlRanges.size(), 3);
+  QCOMPARE(bar.m_powerUi->matchCounter->text(), QString("Match 2 of 3"));
+
+  bar.setSearchPattern("a ");
+  bar.findNext();
+  QCOMPARE(bar.m_hlRanges.size(), 0);
+  QVERIFY(bar.m_powerUi->matchCounter->text().isEmpty());
+}
+
+
 void SearchBarTest::testFindSelectionForward_data()
 {
   QTest::addColumn<QString>("text");
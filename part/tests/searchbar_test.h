@@ -49,6 +49,9 @@ private Q_SLOTS:
 
   void testReplaceAll();
 
+  void testFindAllFollowsEdits();
+  void testMatchCounter();
+
   void testFindSelectionForward_data();
   void testFindSelectionForward();
 
@@ -26,6 +26,8 @@
 #include <katedocument.h>
 #include <kateview.h>
 #include <kateundomanager.h>
+#include <kateconfig.h>
+#include <ktemporaryfile.h>
 
 QTEST_KDEMAIN(UndoManagerTest, GUI)
 
@@ -229,4 +231,109 @@ void UndoManagerTest::testUndoWordWrapBug301367()
   delete view;
 }
 
+void UndoManagerTest::testSpillUndoGroups()
+{
+  TestDocument doc;
+  doc.config()->setUndoMemoryLimit(1);
+  KateUndoManager *undoManager = doc.undoManager();
+
+  // ten undo groups of 512 kB each, most of them don't fit into the limit
+  const QString line(256 * 1024, QChar('x'));
+  for (int i = 0; i < 10; ++i) {
+    undoManager->undoSafePoint();
+    doc.insertText(Cursor(i, 0), line + '\n');
+  }
+
+  QCOMPARE(undoManager->undoCount(), 10u);
+  const QString text = doc.text();
+
+  // simulate a save, the spilled groups must not be touched
+  doc.setModified(false);
+  undoManager->updateLineModifications();
+
+  // spilled groups are read back one after the other
+  while (doc.undoCount() > 0)
+    doc.undo();
+
+  QCOMPARE(doc.text(), QString());
+  QCOMPARE(undoManager->redoCount(), 10u);
+
+  while (doc.redoCount() > 0)
+    doc.redo();
+
+  QCOMPARE(doc.text(), text);
+
+  // undo half of it, new edits still work on top of spilled groups
+  for (int i = 0; i < 5; ++i)
+    doc.undo();
+
+  doc.insertText(Cursor(5, 0), "a");
+  QCOMPARE(undoManager->undoCount(), 6u);
+  QCOMPARE(undoManager->redoCount(), 0u);
+
+  while (doc.undoCount() > 0)
+    doc.undo();
+
+  QCOMPARE(doc.text(), QString());
+}
+
+void UndoManagerTest::testBrokenSpillFile()
+{
+  TestDocument doc;
+  doc.config()->setUndoMemoryLimit(1);
+  KateUndoManager *undoManager = doc.undoManager();
+
+  const QString line(256 * 1024, QChar('x'));
+  for (int i = 0; i < 10; ++i) {
+    undoManager->undoSafePoint();
+    doc.insertText(Cursor(i, 0), line + '\n');
+  }
+
+  const QString text = doc.text();
+  const int spilled = undoManager->m_spilledUndoCount;
+  QVERIFY(spilled > 0);
+  QVERIFY(spilled < 10);
+
+  // overwrite the spill file with garbage
+  QFile *spillFile = undoManager->m_spillFile;
+  const qint64 size = spillFile->size();
+  QVERIFY(spillFile->seek(0));
+  QCOMPARE(spillFile->write(QByteArray(size, '\xff')), size);
+  QVERIFY(spillFile->flush());
+
+  // the groups in memory are undone, the broken ones are dropped without touching the text
+  while (doc.undoCount() > 0)
+    doc.undo();
+
+  QString spilledText;
+  for (int i = 0; i < spilled; ++i)
+    spilledText += line + '\n';
+
+  QCOMPARE(doc.text(), spilledText);
+  QCOMPARE(undoManager->undoCount(), 0u);
+  QCOMPARE(undoManager->redoCount(), uint(10 - spilled));
+  QCOMPARE(undoManager->m_spilledUndoCount, 0);
+
+  // the rest of the history still works
+  while (doc.redoCount() > 0)
+    doc.redo();
+
+  QCOMPARE(doc.text(), text);
+
+  // a removed spill file can't be read either
+  for (int i = 0; i < 10; ++i) {
+    undoManager->undoSafePoint();
+    doc.insertText(Cursor(0, 0), line + '\n');
+  }
+  QVERIFY(undoManager->m_spilledUndoCount > 0);
+  spillFile->resize(0);
+
+  const uint inMemory = undoManager->undoCount() - undoManager->m_spilledUndoCount;
+  for (uint i = 0; i <= inMemory; ++i)
+    doc.undo();
+
+  QCOMPARE(undoManager->undoCount(), 0u);
+  QCOMPARE(undoManager->redoCount(), inMemory);
+}
+
 // kate: space-indent on; indent-width 2; replace-tabs on;
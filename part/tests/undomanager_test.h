@@ -33,6 +33,8 @@ class UndoManagerTest : public QObject
     void testCursorPosition();
     void testSelectionUndo();
     void testUndoWordWrapBug301367();
+    void testSpillUndoGroups();
+    void testBrokenSpillFile();
 
   private:
     class TestDocument;
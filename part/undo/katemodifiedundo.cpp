@@ -26,6 +26,8 @@
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/view.h>
 
+#include <QtCore/QDataStream>
+
 KateModifiedInsertText::KateModifiedInsertText (KateDocument *document, int line, int col, const QString &text)
   : KateEditInsertTextUndo (document, line, col, text)
 {
@@ -39,6 +41,11 @@ KateModifiedInsertText::KateModifiedInsertText (KateDocument *document, int line
   }
 }
 
+KateModifiedInsertText::KateModifiedInsertText (KateDocument *document, QDataStream &stream)
+  : KateEditInsertTextUndo (document, stream)
+{
+}
+
 KateModifiedRemoveText::KateModifiedRemoveText (KateDocument *document, int line, int col, const QString &text)
   : KateEditRemoveTextUndo (document, line, col, text)
 {
@@ -52,6 +59,11 @@ KateModifiedRemoveText::KateModifiedRemoveText (KateDocument *document, int line
   }
 }
 
+KateModifiedRemoveText::KateModifiedRemoveText (KateDocument *document, QDataStream &stream)
+  : KateEditRemoveTextUndo (document, stream)
+{
+}
+
 KateModifiedWrapLine::KateModifiedWrapLine (KateDocument *document, int line, int col, int len, bool newLine)
   : KateEditWrapLineUndo (document, line, col, len, newLine)
 {
@@ -76,6 +88,11 @@ KateModifiedWrapLine::KateModifiedWrapLine (KateDocument *document, int line, in
   }
 }
 
+KateModifiedWrapLine::KateModifiedWrapLine (KateDocument *document, QDataStream &stream)
+  : KateEditWrapLineUndo (document, stream)
+{
+}
+
 KateModifiedUnWrapLine::KateModifiedUnWrapLine (KateDocument *document, int line, int col, int len, bool removeLine)
   : KateEditUnWrapLineUndo (document, line, col, len, removeLine)
 {
@@ -140,12 +157,22 @@ KateModifiedUnWrapLine::KateModifiedUnWrapLine (KateDocument *document, int line
   }
 }
 
+KateModifiedUnWrapLine::KateModifiedUnWrapLine (KateDocument *document, QDataStream &stream)
+  : KateEditUnWrapLineUndo (document, stream)
+{
+}
+
 KateModifiedInsertLine::KateModifiedInsertLine (KateDocument *document, int line, const QString &text)
   : KateEditInsertLineUndo (document, line, text)
 {
   setFlag(RedoLine1Modified);
 }
 
+KateModifiedInsertLine::KateModifiedInsertLine (KateDocument *document, QDataStream &stream)
+  : KateEditInsertLineUndo (document, stream)
+{
+}
+
 KateModifiedRemoveLine::KateModifiedRemoveLine (KateDocument *document, int line, const QString &text)
   : KateEditRemoveLineUndo (document, line, text)
 {
@@ -158,6 +185,69 @@ KateModifiedRemoveLine::KateModifiedRemoveLine (KateDocument *document, int line
   }
 }
 
+KateModifiedRemoveLine::KateModifiedRemoveLine (KateDocument *document, QDataStream &stream)
+  : KateEditRemoveLineUndo (document, stream)
+{
+}
+
+KateModifiedInsertLines::KateModifiedInsertLines (KateDocument *document, int line, const QStringList &texts)
+  : KateEditInsertLinesUndo (document, line, texts)
+  , m_redoSaved (texts.size())
+{
+}
+
+KateModifiedInsertLines::KateModifiedInsertLines (KateDocument *document, QDataStream &stream)
+  : KateEditInsertLinesUndo (document, stream)
+{
+  stream >> m_redoSaved;
+}
+
+KateModifiedRemoveLines::KateModifiedRemoveLines (KateDocument *document, int line, const QStringList &texts)
+  : KateEditRemoveLinesUndo (document, line, texts)
+  , m_undoModified (texts.size())
+  , m_undoSaved (texts.size())
+{
+  for (int i = 0; i < texts.size(); ++i) {
+    Kate::TextLine tl = document->plainKateTextLine(line + i);
+    Q_ASSERT(tl);
+    if (tl->markedAsModified()) {
+      m_undoModified.setBit(i);
+    } else {
+      m_undoSaved.setBit(i);
+    }
+  }
+}
+
+KateModifiedRemoveLines::KateModifiedRemoveLines (KateDocument *document, QDataStream &stream)
+  : KateEditRemoveLinesUndo (document, stream)
+{
+  stream >> m_undoModified >> m_undoSaved;
+}
+
+void KateModifiedInsertLines::save (QDataStream &stream) const
+{
+  KateEditInsertLinesUndo::save (stream);
+  stream << m_redoSaved;
+}
+
+void KateModifiedRemoveLines::save (QDataStream &stream) const
+{
+  KateEditRemoveLinesUndo::save (stream);
+  stream << m_undoModified << m_undoSaved;
+}
+
+void KateModifiedInsertLines::flagSavedAsModified ()
+{
+  // lines not saved on disk are modified after redo
+  m_redoSaved.fill (false);
+}
+
+void KateModifiedRemoveLines::flagSavedAsModified ()
+{
+  m_undoModified |= m_undoSaved;
+  m_undoSaved.fill (false);
+}
+
 void KateModifiedInsertText::undo ()
 {
   KateEditInsertTextUndo::undo();
@@ -230,6 +320,27 @@ void KateModifiedRemoveLine::undo ()
   tl->markAsSavedOnDisk(isFlagSet(UndoLine1Saved));
 }
 
+void KateModifiedInsertLines::undo ()
+{
+  KateEditInsertLinesUndo::undo();
+
+  // no line modification needed, since the lines are removed
+}
+
+void KateModifiedRemoveLines::undo ()
+{
+  KateEditRemoveLinesUndo::undo();
+
+  KateDocument *doc = document();
+  for (int i = 0; i < count(); ++i) {
+    Kate::TextLine tl = doc->plainKateTextLine(line() + i);
+    Q_ASSERT(tl);
+
+    tl->markAsModified(m_undoModified.testBit(i));
+    tl->markAsSavedOnDisk(m_undoSaved.testBit(i));
+  }
+}
+
 
 void KateModifiedRemoveText::redo ()
 {
@@ -304,6 +415,27 @@ void KateModifiedInsertLine::redo ()
   tl->markAsSavedOnDisk(isFlagSet(RedoLine1Saved));
 }
 
+void KateModifiedRemoveLines::redo ()
+{
+  KateEditRemoveLinesUndo::redo();
+
+  // no line modification needed, since the lines are removed
+}
+
+void KateModifiedInsertLines::redo ()
+{
+  KateEditInsertLinesUndo::redo();
+
+  KateDocument *doc = document();
+  for (int i = 0; i < count(); ++i) {
+    Kate::TextLine tl = doc->plainKateTextLine(line() + i);
+    Q_ASSERT(tl);
+
+    tl->markAsModified(!m_redoSaved.testBit(i));
+    tl->markAsSavedOnDisk(m_redoSaved.testBit(i));
+  }
+}
+
 void KateModifiedInsertText::updateRedoSavedOnDiskFlag(QBitArray & lines)
 {
   if (line() >= lines.size()) {
@@ -458,4 +590,35 @@ void KateModifiedRemoveLine::updateUndoSavedOnDiskFlag(QBitArray & lines)
   }
 }
 
+void KateModifiedInsertLines::updateRedoSavedOnDiskFlag(QBitArray & lines)
+{
+  if (line() + count() > lines.size()) {
+    lines.resize(line() + count());
+  }
+
+  for (int i = 0; i < count(); ++i) {
+    if (!lines.testBit(line() + i)) {
+      lines.setBit(line() + i);
+
+      m_redoSaved.setBit(i);
+    }
+  }
+}
+
+void KateModifiedRemoveLines::updateUndoSavedOnDiskFlag(QBitArray & lines)
+{
+  if (line() + count() > lines.size()) {
+    lines.resize(line() + count());
+  }
+
+  for (int i = 0; i < count(); ++i) {
+    if (!lines.testBit(line() + i)) {
+      lines.setBit(line() + i);
+
+      m_undoModified.clearBit(i);
+      m_undoSaved.setBit(i);
+    }
+  }
+}
+
 // kate: space-indent on; indent-width 2; replace-tabs on;
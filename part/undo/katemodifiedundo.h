@@ -27,6 +27,7 @@ class KateModifiedInsertText : public KateEditInsertTextUndo
 {
   public:
     KateModifiedInsertText (KateDocument *document, int line, int col, const QString &text);
+    KateModifiedInsertText (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -46,6 +47,7 @@ class KateModifiedRemoveText : public KateEditRemoveTextUndo
 {
   public:
     KateModifiedRemoveText (KateDocument *document, int line, int col, const QString &text);
+    KateModifiedRemoveText (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -65,6 +67,7 @@ class KateModifiedWrapLine : public KateEditWrapLineUndo
 {
   public:
     KateModifiedWrapLine (KateDocument *document, int line, int col, int len, bool newLine);
+    KateModifiedWrapLine (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -84,6 +87,7 @@ class KateModifiedUnWrapLine : public KateEditUnWrapLineUndo
 {
   public:
     KateModifiedUnWrapLine (KateDocument *document, int line, int col, int len, bool removeLine);
+    KateModifiedUnWrapLine (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -103,6 +107,7 @@ class KateModifiedInsertLine : public KateEditInsertLineUndo
 {
   public:
     KateModifiedInsertLine (KateDocument *document, int line, const QString &text);
+    KateModifiedInsertLine (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -121,6 +126,7 @@ class KateModifiedRemoveLine : public KateEditRemoveLineUndo
 {
   public:
     KateModifiedRemoveLine (KateDocument *document, int line, const QString &text);
+    KateModifiedRemoveLine (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -135,6 +141,69 @@ class KateModifiedRemoveLine : public KateEditRemoveLineUndo
     void updateUndoSavedOnDiskFlag(QBitArray & lines);
 };
 
+class KateModifiedInsertLines : public KateEditInsertLinesUndo
+{
+  public:
+    KateModifiedInsertLines (KateDocument *document, int line, const QStringList &texts);
+    KateModifiedInsertLines (KateDocument *document, QDataStream &stream);
+
+    /**
+     * @copydoc KateUndo::undo()
+     */
+    void undo();
+
+    /**
+     * @copydoc KateUndo::redo()
+     */
+    void redo();
+
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    void flagSavedAsModified();
+    void updateRedoSavedOnDiskFlag(QBitArray & lines);
+
+  private:
+    /**
+     * inserted lines which are saved on disk after redo, the others are modified
+     */
+    QBitArray m_redoSaved;
+};
+
+class KateModifiedRemoveLines : public KateEditRemoveLinesUndo
+{
+  public:
+    KateModifiedRemoveLines (KateDocument *document, int line, const QStringList &texts);
+    KateModifiedRemoveLines (KateDocument *document, QDataStream &stream);
+
+    /**
+     * @copydoc KateUndo::undo()
+     */
+    void undo();
+
+    /**
+     * @copydoc KateUndo::redo()
+     */
+    void redo();
+
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    void flagSavedAsModified();
+    void updateUndoSavedOnDiskFlag(QBitArray & lines);
+
+  private:
+    /**
+     * removed lines which are modified or saved on disk after undo
+     */
+    QBitArray m_undoModified;
+    QBitArray m_undoSaved;
+};
+
 #endif // KATE_MODIFIED_UNDO_H
 
 // kate: space-indent on; indent-width 2; replace-tabs on;
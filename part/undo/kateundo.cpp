@@ -23,17 +23,28 @@
 #include "kateundo.h"
 
 #include "kateundomanager.h"
+#include "katemodifiedundo.h"
 #include "katedocument.h"
 
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/view.h>
 
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+
 KateUndo::KateUndo (KateDocument *document)
 : m_document (document)
 , m_lineModFlags(0x00)
 {
 }
 
+KateUndo::KateUndo (KateDocument *document, QDataStream &stream)
+: m_document (document)
+, m_lineModFlags(0x00)
+{
+  stream >> m_lineModFlags;
+}
+
 KateUndo::~KateUndo ()
 {
 }
@@ -46,6 +57,12 @@ KateEditInsertTextUndo::KateEditInsertTextUndo (KateDocument *document, int line
 {
 }
 
+KateEditInsertTextUndo::KateEditInsertTextUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_col >> m_text;
+}
+
 KateEditRemoveTextUndo::KateEditRemoveTextUndo (KateDocument *document, int line, int col, const QString &text)
   : KateUndo (document)
   , m_line (line)
@@ -54,6 +71,12 @@ KateEditRemoveTextUndo::KateEditRemoveTextUndo (KateDocument *document, int line
 {
 }
 
+KateEditRemoveTextUndo::KateEditRemoveTextUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_col >> m_text;
+}
+
 KateEditWrapLineUndo::KateEditWrapLineUndo (KateDocument *document, int line, int col, int len, bool newLine)
   : KateUndo (document)
   , m_line (line)
@@ -63,6 +86,12 @@ KateEditWrapLineUndo::KateEditWrapLineUndo (KateDocument *document, int line, in
 {
 }
 
+KateEditWrapLineUndo::KateEditWrapLineUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_col >> m_len >> m_newLine;
+}
+
 KateEditUnWrapLineUndo::KateEditUnWrapLineUndo (KateDocument *document, int line, int col, int len, bool removeLine)
   : KateUndo (document)
   , m_line (line)
@@ -72,6 +101,12 @@ KateEditUnWrapLineUndo::KateEditUnWrapLineUndo (KateDocument *document, int line
 {
 }
 
+KateEditUnWrapLineUndo::KateEditUnWrapLineUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_col >> m_len >> m_removeLine;
+}
+
 KateEditInsertLineUndo::KateEditInsertLineUndo (KateDocument *document, int line, const QString &text)
   : KateUndo (document)
   , m_line (line)
@@ -79,6 +114,12 @@ KateEditInsertLineUndo::KateEditInsertLineUndo (KateDocument *document, int line
 {
 }
 
+KateEditInsertLineUndo::KateEditInsertLineUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_text;
+}
+
 KateEditRemoveLineUndo::KateEditRemoveLineUndo (KateDocument *document, int line, const QString &text)
   : KateUndo (document)
   , m_line (line)
@@ -86,6 +127,143 @@ KateEditRemoveLineUndo::KateEditRemoveLineUndo (KateDocument *document, int line
 {
 }
 
+KateEditRemoveLineUndo::KateEditRemoveLineUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_text;
+}
+
+KateEditInsertLinesUndo::KateEditInsertLinesUndo (KateDocument *document, int line, const QStringList &texts)
+  : KateUndo (document)
+  , m_line (line)
+  , m_texts (texts)
+{
+}
+
+KateEditMarkLineAutoWrappedUndo::KateEditMarkLineAutoWrappedUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_autowrapped;
+}
+
+KateEditInsertLinesUndo::KateEditInsertLinesUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_texts;
+}
+
+KateEditRemoveLinesUndo::KateEditRemoveLinesUndo (KateDocument *document, int line, const QStringList &texts)
+  : KateUndo (document)
+  , m_line (line)
+  , m_texts (texts)
+{
+}
+
+KateEditRemoveLinesUndo::KateEditRemoveLinesUndo (KateDocument *document, QDataStream &stream)
+  : KateUndo (document, stream)
+{
+  stream >> m_line >> m_texts;
+}
+
+void KateUndo::save (QDataStream &stream) const
+{
+  stream << m_lineModFlags;
+}
+
+void KateEditInsertTextUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_col << m_text;
+}
+
+void KateEditRemoveTextUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_col << m_text;
+}
+
+void KateEditMarkLineAutoWrappedUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_autowrapped;
+}
+
+void KateEditWrapLineUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_col << m_len << m_newLine;
+}
+
+void KateEditUnWrapLineUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_col << m_len << m_removeLine;
+}
+
+void KateEditInsertLineUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_text;
+}
+
+void KateEditRemoveLineUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_text;
+}
+
+void KateEditInsertLinesUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_texts;
+}
+
+void KateEditRemoveLinesUndo::save (QDataStream &stream) const
+{
+  KateUndo::save (stream);
+  stream << m_line << m_texts;
+}
+
+int KateEditInsertLinesUndo::memoryUsage () const
+{
+  int size = sizeof (*this);
+  foreach (const QString &text, m_texts)
+    size += sizeof (QString) + text.length() * sizeof (QChar);
+
+  return size;
+}
+
+int KateEditRemoveLinesUndo::memoryUsage () const
+{
+  int size = sizeof (*this);
+  foreach (const QString &text, m_texts)
+    size += sizeof (QString) + text.length() * sizeof (QChar);
+
+  return size;
+}
+
+void KateUndo::flagSavedAsModified ()
+{
+  if (isFlagSet(UndoLine1Saved)) {
+    unsetFlag(UndoLine1Saved);
+    setFlag(UndoLine1Modified);
+  }
+
+  if (isFlagSet(UndoLine2Saved)) {
+    unsetFlag(UndoLine2Saved);
+    setFlag(UndoLine2Modified);
+  }
+
+  if (isFlagSet(RedoLine1Saved)) {
+    unsetFlag(RedoLine1Saved);
+    setFlag(RedoLine1Modified);
+  }
+
+  if (isFlagSet(RedoLine2Saved)) {
+    unsetFlag(RedoLine2Saved);
+    setFlag(RedoLine2Modified);
+  }
+}
 
 bool KateUndo::isEmpty() const
 {
@@ -179,6 +357,20 @@ void KateEditRemoveLineUndo::undo ()
   doc->editInsertLine (m_line, m_text);
 }
 
+void KateEditInsertLinesUndo::undo ()
+{
+  KateDocument *doc = document();
+
+  doc->editRemoveLines (m_line, m_line + m_texts.size() - 1);
+}
+
+void KateEditRemoveLinesUndo::undo ()
+{
+  KateDocument *doc = document();
+
+  doc->editInsertLines (m_line, m_texts);
+}
+
 void KateEditMarkLineAutoWrappedUndo::undo ()
 {
   KateDocument *doc = document();
@@ -228,6 +420,20 @@ void KateEditInsertLineUndo::redo ()
   doc->editInsertLine (m_line, m_text);
 }
 
+void KateEditRemoveLinesUndo::redo ()
+{
+  KateDocument *doc = document();
+
+  doc->editRemoveLines (m_line, m_line + m_texts.size() - 1);
+}
+
+void KateEditInsertLinesUndo::redo ()
+{
+  KateDocument *doc = document();
+
+  doc->editInsertLines (m_line, m_texts);
+}
+
 void KateEditMarkLineAutoWrappedUndo::redo ()
 {
   KateDocument *doc = document();
@@ -238,6 +444,9 @@ void KateEditMarkLineAutoWrappedUndo::redo ()
 KateUndoGroup::KateUndoGroup (KateUndoManager *manager, const KTextEditor::Cursor &cursorPosition, const KTextEditor::Range &selectionRange)
   : m_manager (manager)
   , m_safePoint(false)
+  , m_memoryUsage(0)
+  , m_spillOffset(-1)
+  , m_saveCount(manager->saveCount())
   , m_undoSelection(selectionRange)
   , m_redoSelection(-1, -1, -1, -1)
   , m_undoCursor(cursorPosition)
@@ -255,6 +464,8 @@ void KateUndoGroup::undo (KTextEditor::View *view)
   if (m_items.isEmpty())
     return;
 
+  flagSavedAsModified();
+
   m_manager->startUndo ();
 
   for (int i=m_items.size()-1; i >= 0; --i)
@@ -278,6 +489,8 @@ void KateUndoGroup::redo (KTextEditor::View *view)
   if (m_items.isEmpty())
     return;
 
+  flagSavedAsModified();
+
   m_manager->startUndo ();
 
   for (int i=0; i < m_items.size(); ++i)
@@ -304,9 +517,15 @@ void KateUndoGroup::editEnd(const KTextEditor::Cursor &cursorPosition, const KTe
 
 void KateUndoGroup::addItem(KateUndo* u)
 {
-  if (u->isEmpty())
+  if (u->isEmpty()) {
     delete u;
-  else if (!m_items.isEmpty() && m_items.last()->mergeWith(u))
+    return;
+  }
+
+  // a merged item takes over the text, count it in any case
+  m_memoryUsage += u->memoryUsage();
+
+  if (!m_items.isEmpty() && m_items.last()->mergeWith(u))
     delete u;
   else
     m_items.append(u);
@@ -314,16 +533,20 @@ void KateUndoGroup::addItem(KateUndo* u)
 
 bool KateUndoGroup::merge (KateUndoGroup* newGroup,bool complex)
 {
-  if (m_safePoint)
+  // spilled groups are read only, the history continues in a new group
+  if (m_safePoint || isSpilled())
     return false;
 
   if (newGroup->isOnlyType(singleType()) || complex) {
+    flagSavedAsModified();
+
     // Take all of its items first -> last
     KateUndo* u = newGroup->m_items.isEmpty() ? 0 : newGroup->m_items.takeFirst ();
     while (u) {
       addItem(u);
       u = newGroup->m_items.isEmpty() ? 0 : newGroup->m_items.takeFirst ();
     }
+    newGroup->m_memoryUsage = 0;
 
     if (newGroup->m_safePoint)
       safePoint();
@@ -344,31 +567,20 @@ void KateUndoGroup::safePoint (bool safePoint)
 
 void KateUndoGroup::flagSavedAsModified()
 {
-  foreach (KateUndo *item, m_items) {
-    if (item->isFlagSet(KateUndo::UndoLine1Saved)) {
-      item->unsetFlag(KateUndo::UndoLine1Saved);
-      item->setFlag(KateUndo::UndoLine1Modified);
-    }
-
-    if (item->isFlagSet(KateUndo::UndoLine2Saved)) {
-      item->unsetFlag(KateUndo::UndoLine2Saved);
-      item->setFlag(KateUndo::UndoLine2Modified);
-    }
+  // spilled groups catch up once they are loaded again
+  if (m_saveCount == m_manager->saveCount() || isSpilled())
+    return;
 
-    if (item->isFlagSet(KateUndo::RedoLine1Saved)) {
-      item->unsetFlag(KateUndo::RedoLine1Saved);
-      item->setFlag(KateUndo::RedoLine1Modified);
-    }
+  foreach (KateUndo *item, m_items)
+    item->flagSavedAsModified();
 
-    if (item->isFlagSet(KateUndo::RedoLine2Saved)) {
-      item->unsetFlag(KateUndo::RedoLine2Saved);
-      item->setFlag(KateUndo::RedoLine2Modified);
-    }
-  }
+  m_saveCount = m_manager->saveCount();
 }
 
 void KateUndoGroup::markUndoAsSaved(QBitArray & lines)
 {
+  flagSavedAsModified();
+
   for (int i = m_items.size() - 1; i >= 0; --i) {
     KateUndo* item = m_items[i];
     item->updateUndoSavedOnDiskFlag(lines);
@@ -377,12 +589,117 @@ void KateUndoGroup::markUndoAsSaved(QBitArray & lines)
 
 void KateUndoGroup::markRedoAsSaved(QBitArray & lines)
 {
+  flagSavedAsModified();
+
   for (int i = m_items.size() - 1; i >= 0; --i) {
     KateUndo* item = m_items[i];
     item->updateRedoSavedOnDiskFlag(lines);
   }
 }
 
+bool KateUndoGroup::spill(QFile *file)
+{
+  Q_ASSERT(!isSpilled());
+
+  // the spill file is append only, space of loaded groups is reused once all are loaded
+  const qint64 offset = file->size();
+  if (!file->seek(offset))
+    return false;
+
+  QDataStream stream(file);
+  stream << qint32(m_items.size());
+  foreach (const KateUndo *item, m_items) {
+    stream << qint8(item->type());
+    item->save(stream);
+  }
+
+  // the items are only freed once they are on disk, else the group stays in memory
+  if (stream.status() != QDataStream::Ok || !file->flush() || file->size() <= offset) {
+    file->resize(offset);
+    return false;
+  }
+
+  qDeleteAll(m_items);
+  m_items.clear();
+  m_memoryUsage = 0;
+  m_spillOffset = offset;
+
+  return true;
+}
+
+bool KateUndoGroup::load(QFile *file)
+{
+  Q_ASSERT(isSpilled());
+
+  // on failure the group stays spilled, nothing of it is in memory
+  if (!file->seek(m_spillOffset))
+    return false;
+
+  KateDocument *doc = static_cast<KateDocument*>(document());
+  QDataStream stream(file);
+  qint32 count = 0;
+  stream >> count;
+
+  for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+    qint8 type = KateUndo::editInvalid;
+    stream >> type;
+
+    KateUndo *item = 0;
+    switch (type) {
+      case KateUndo::editInsertText:
+        item = new KateModifiedInsertText(doc, stream);
+        break;
+      case KateUndo::editRemoveText:
+        item = new KateModifiedRemoveText(doc, stream);
+        break;
+      case KateUndo::editWrapLine:
+        item = new KateModifiedWrapLine(doc, stream);
+        break;
+      case KateUndo::editUnWrapLine:
+        item = new KateModifiedUnWrapLine(doc, stream);
+        break;
+      case KateUndo::editInsertLine:
+        item = new KateModifiedInsertLine(doc, stream);
+        break;
+      case KateUndo::editRemoveLine:
+        item = new KateModifiedRemoveLine(doc, stream);
+        break;
+      case KateUndo::editInsertLines:
+        item = new KateModifiedInsertLines(doc, stream);
+        break;
+      case KateUndo::editRemoveLines:
+        item = new KateModifiedRemoveLines(doc, stream);
+        break;
+      case KateUndo::editMarkLineAutoWrapped:
+        item = new KateEditMarkLineAutoWrappedUndo(doc, stream);
+        break;
+      default:
+        break;
+    }
+
+    // unknown type, the file is broken
+    if (!item)
+      break;
+
+    m_memoryUsage += item->memoryUsage();
+    m_items.append(item);
+  }
+
+  if (stream.status() != QDataStream::Ok || m_items.size() != count) {
+    qDeleteAll(m_items);
+    m_items.clear();
+    m_memoryUsage = 0;
+    return false;
+  }
+
+  m_spillOffset = -1;
+
+  // the document might have been saved meanwhile
+  flagSavedAsModified();
+
+  return true;
+}
+
 KTextEditor::Document *KateUndoGroup::document()
 {
   return m_manager->document();
@@ -24,12 +24,15 @@
 #define kate_undo_h
 
 #include <QtCore/QList>
+#include <QtCore/QStringList>
 
 #include <ktexteditor/range.h>
 #include <QtCore/QBitArray>
 
 class KateUndoManager;
 class KateDocument;
+class QDataStream;
+class QFile;
 
 namespace KTextEditor {
   class View;
@@ -47,6 +50,13 @@ class KateUndo
      */
     KateUndo (KateDocument *document);
 
+    /**
+     * Constructor for an item read back from the undo spill file
+     * @param document the document the undo item belongs to
+     * @param stream stream written by save()
+     */
+    KateUndo (KateDocument *document, QDataStream &stream);
+
     /**
      * Destructor
      */
@@ -64,6 +74,8 @@ class KateUndo
       editUnWrapLine,
       editInsertLine,
       editRemoveLine,
+      editInsertLines,
+      editRemoveLines,
       editMarkLineAutoWrapped,
       editInvalid
     };
@@ -100,6 +112,19 @@ class KateUndo
      */
     virtual KateUndo::UndoType type() const = 0;
 
+    /**
+     * write the item to the undo spill file, the constructor of each item
+     * taking a stream reads it back
+     * @param stream stream to write to
+     */
+    virtual void save (QDataStream &stream) const;
+
+    /**
+     * approximate memory used by this item
+     * @return size in bytes, including the text
+     */
+    virtual int memoryUsage () const { return sizeof (KateUndo); }
+
   protected:
     /**
      * Return the document the undo item belongs to.
@@ -140,6 +165,11 @@ class KateUndo
       return m_lineModFlags & flag;
     }
 
+    /**
+     * Change all LineSaved flags to LineModified, the document was saved again.
+     */
+    virtual void flagSavedAsModified();
+
     virtual void updateUndoSavedOnDiskFlag(QBitArray & lines) { Q_UNUSED(lines) }
     virtual void updateRedoSavedOnDiskFlag(QBitArray & lines) { Q_UNUSED(lines) }
 
@@ -151,6 +181,7 @@ class KateEditInsertTextUndo : public KateUndo
 {
   public:
     KateEditInsertTextUndo (KateDocument *document, int line, int col, const QString &text);
+    KateEditInsertTextUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::isEmpty()
@@ -177,13 +208,23 @@ class KateEditInsertTextUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editInsertText; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const { return sizeof (*this) + len() * sizeof (QChar); }
+
   protected:
     inline int len() const { return m_text.length(); }
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
-    const int m_col;
+    int m_line;
+    int m_col;
     QString m_text;
 };
 
@@ -191,6 +232,7 @@ class KateEditRemoveTextUndo : public KateUndo
 {
   public:
     KateEditRemoveTextUndo (KateDocument *document, int line, int col, const QString &text);
+    KateEditRemoveTextUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::isEmpty()
@@ -217,12 +259,22 @@ class KateEditRemoveTextUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editRemoveText; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const { return sizeof (*this) + len() * sizeof (QChar); }
+
   protected:
     inline int len() const { return m_text.length(); }
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
+    int m_line;
     int m_col;
     QString m_text;
 };
@@ -236,6 +288,8 @@ class KateEditMarkLineAutoWrappedUndo : public KateUndo
       , m_autowrapped (autowrapped)
     {}
 
+    KateEditMarkLineAutoWrappedUndo (KateDocument *document, QDataStream &stream);
+
     /**
      * @copydoc KateUndo::undo()
      */
@@ -251,15 +305,21 @@ class KateEditMarkLineAutoWrappedUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editMarkLineAutoWrapped; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
   private:
-    const int m_line;
-    const bool m_autowrapped;
+    int m_line;
+    bool m_autowrapped;
 };
 
 class KateEditWrapLineUndo : public KateUndo
 {
   public:
     KateEditWrapLineUndo (KateDocument *document, int line, int col, int len, bool newLine);
+    KateEditWrapLineUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -276,20 +336,26 @@ class KateEditWrapLineUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editWrapLine; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
   protected:
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
-    const int m_col;
-    const int m_len;
-    const bool m_newLine;
+    int m_line;
+    int m_col;
+    int m_len;
+    bool m_newLine;
 };
 
 class KateEditUnWrapLineUndo : public KateUndo
 {
   public:
     KateEditUnWrapLineUndo (KateDocument *document, int line, int col, int len, bool removeLine);
+    KateEditUnWrapLineUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -306,20 +372,26 @@ class KateEditUnWrapLineUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editUnWrapLine; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
   protected:
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
-    const int m_col;
-    const int m_len;
-    const bool m_removeLine;
+    int m_line;
+    int m_col;
+    int m_len;
+    bool m_removeLine;
 };
 
 class KateEditInsertLineUndo : public KateUndo
 {
   public:
     KateEditInsertLineUndo (KateDocument *document, int line, const QString &text);
+    KateEditInsertLineUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -336,18 +408,29 @@ class KateEditInsertLineUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editInsertLine; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const { return sizeof (*this) + m_text.length() * sizeof (QChar); }
+
   protected:
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
-    const QString m_text;
+    int m_line;
+    QString m_text;
 };
 
 class KateEditRemoveLineUndo : public KateUndo
 {
   public:
     KateEditRemoveLineUndo (KateDocument *document, int line, const QString &text);
+    KateEditRemoveLineUndo (KateDocument *document, QDataStream &stream);
 
     /**
      * @copydoc KateUndo::undo()
@@ -364,12 +447,102 @@ class KateEditRemoveLineUndo : public KateUndo
      */
     KateUndo::UndoType type() const { return KateUndo::editRemoveLine; }
 
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const { return sizeof (*this) + m_text.length() * sizeof (QChar); }
+
   protected:
     inline int line() const { return m_line; }
 
   private:
-    const int m_line;
-    const QString m_text;
+    int m_line;
+    QString m_text;
+};
+
+class KateEditInsertLinesUndo : public KateUndo
+{
+  public:
+    KateEditInsertLinesUndo (KateDocument *document, int line, const QStringList &texts);
+    KateEditInsertLinesUndo (KateDocument *document, QDataStream &stream);
+
+    /**
+     * @copydoc KateUndo::undo()
+     */
+    void undo();
+
+    /**
+     * @copydoc KateUndo::redo()
+     */
+    void redo();
+
+    /**
+     * @copydoc KateUndo::type()
+     */
+    KateUndo::UndoType type() const { return KateUndo::editInsertLines; }
+
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const;
+
+  protected:
+    inline int line() const { return m_line; }
+    inline int count() const { return m_texts.size(); }
+
+  private:
+    int m_line;
+    QStringList m_texts;
+};
+
+class KateEditRemoveLinesUndo : public KateUndo
+{
+  public:
+    KateEditRemoveLinesUndo (KateDocument *document, int line, const QStringList &texts);
+    KateEditRemoveLinesUndo (KateDocument *document, QDataStream &stream);
+
+    /**
+     * @copydoc KateUndo::undo()
+     */
+    void undo();
+
+    /**
+     * @copydoc KateUndo::redo()
+     */
+    void redo();
+
+    /**
+     * @copydoc KateUndo::type()
+     */
+    KateUndo::UndoType type() const { return KateUndo::editRemoveLines; }
+
+    /**
+     * @copydoc KateUndo::save()
+     */
+    void save (QDataStream &stream) const;
+
+    /**
+     * @copydoc KateUndo::memoryUsage()
+     */
+    int memoryUsage () const;
+
+  protected:
+    inline int line() const { return m_line; }
+    inline int count() const { return m_texts.size(); }
+
+  private:
+    int m_line;
+    QStringList m_texts;
 };
 
 /**
@@ -418,16 +591,43 @@ class KateUndoGroup
     /**
      * is this undogroup empty?
      */
-    bool isEmpty() const { return m_items.isEmpty(); }
+    bool isEmpty() const { return m_items.isEmpty() && !isSpilled(); }
 
     /**
-     * Change all LineSaved flags to LineModified of the line modification system.
+     * Change all LineSaved flags to LineModified of the line modification system,
+     * if the document was saved since the flags of this group were updated.
+     * Saving only bumps a counter in the manager, the groups catch up lazily.
      */
     void flagSavedAsModified();
 
     void markUndoAsSaved(QBitArray & lines);
     void markRedoAsSaved(QBitArray & lines);
 
+    /**
+     * approximate memory used by the items of this group
+     * @return size in bytes, 0 if the group is spilled to disk
+     */
+    qint64 memoryUsage() const { return m_memoryUsage; }
+
+    /**
+     * is this group written to the undo spill file?
+     */
+    bool isSpilled() const { return m_spillOffset >= 0; }
+
+    /**
+     * Append the items to the undo spill file and free them.
+     * @param file open spill file
+     * @return success, on failure the items stay in memory
+     */
+    bool spill(QFile *file);
+
+    /**
+     * Read the items back from the undo spill file.
+     * @param file open spill file
+     * @return success, on failure the group stays spilled
+     */
+    bool load(QFile *file);
+
   private:
     KTextEditor::Document *document();
 
@@ -464,6 +664,21 @@ class KateUndoGroup
      */
     bool m_safePoint;
 
+    /**
+     * approximate memory used by the items
+     */
+    qint64 m_memoryUsage;
+
+    /**
+     * position of the items in the undo spill file, -1 if they are in memory
+     */
+    qint64 m_spillOffset;
+
+    /**
+     * save count of the manager the line modification flags are up to date with
+     */
+    int m_saveCount;
+
     /**
      * the text selection of the active view before the edit step
      */
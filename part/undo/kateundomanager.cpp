@@ -21,6 +21,11 @@
 
 #include "katedocument.h"
 #include "katemodifiedundo.h"
+#include "kateconfig.h"
+
+#include <kdebug.h>
+#include <klocale.h>
+#include <ktemporaryfile.h>
 
 #include <QBitArray>
 
@@ -34,6 +39,10 @@ KateUndoManager::KateUndoManager (KateDocument *doc)
   , lastRedoGroupWhenSaved(0)
   , docWasSavedWhenUndoWasEmpty(true)
   , docWasSavedWhenRedoWasEmpty(true)
+  , m_spillFile(0)
+  , m_spilledUndoCount(0)
+  , m_memoryUsage(0)
+  , m_saveCount(0)
 {
   connect(this, SIGNAL(undoEnd(KTextEditor::Document*)), this, SIGNAL(undoChanged()));
   connect(this, SIGNAL(redoEnd(KTextEditor::Document*)), this, SIGNAL(undoChanged()));
@@ -50,6 +59,8 @@ KateUndoManager::~KateUndoManager()
   undoItems.clear();
   qDeleteAll(redoItems);
   redoItems.clear();
+
+  delete m_spillFile;
 }
 
 KTextEditor::Document *KateUndoManager::document()
@@ -94,6 +105,9 @@ void KateUndoManager::editEnd()
 
     bool changedUndo = false;
 
+    // merged or not, the history grows by the items of the group
+    m_memoryUsage += m_editCurrentUndo->memoryUsage();
+
     if (m_editCurrentUndo->isEmpty()) {
       delete m_editCurrentUndo;
     } else if (!undoItems.isEmpty()
@@ -106,6 +120,8 @@ void KateUndoManager::editEnd()
 
     m_editCurrentUndo = 0L;
 
+    spillUndoGroups();
+
     if (changedUndo)
       emit undoChanged();
 
@@ -178,6 +194,18 @@ void KateUndoManager::slotLineRemoved(int line, const QString &s)
     addUndoItem(new KateModifiedRemoveLine(m_document, line, s));
 }
 
+void KateUndoManager::slotLinesInserted(int line, const QStringList &texts)
+{
+  if (m_editCurrentUndo != 0) // do we care about notifications?
+    addUndoItem(new KateModifiedInsertLines(m_document, line, texts));
+}
+
+void KateUndoManager::slotLinesRemoved(int line, const QStringList &texts)
+{
+  if (m_editCurrentUndo != 0) // do we care about notifications?
+    addUndoItem(new KateModifiedRemoveLines(m_document, line, texts));
+}
+
 void KateUndoManager::undoCancel()
 {
   // Don't worry about this when an edit is in progress
@@ -207,6 +235,9 @@ void KateUndoManager::addUndoItem(KateUndo *undo)
   m_editCurrentUndo->addItem(undo);
 
   // Clear redo buffer
+  foreach (KateUndoGroup* undoGroup, redoItems)
+    m_memoryUsage -= undoGroup->memoryUsage();
+
   qDeleteAll(redoItems);
   redoItems.clear();
 }
@@ -237,6 +268,10 @@ void KateUndoManager::undo()
 
   if (undoItems.count() > 0)
   {
+    // the group couldn't be read back, nothing is undone
+    if (!loadLastUndoGroup())
+      return;
+
     emit undoStart(document());
 
     undoItems.last()->undo(activeView());
@@ -245,6 +280,8 @@ void KateUndoManager::undo()
     updateModified();
 
     emit undoEnd(document());
+
+    spillUndoGroups();
   }
 }
 
@@ -342,9 +379,16 @@ void KateUndoManager::updateModified()
 
 void KateUndoManager::clearUndo()
 {
+  foreach (KateUndoGroup* undoGroup, undoItems)
+    m_memoryUsage -= undoGroup->memoryUsage();
+
   qDeleteAll(undoItems);
   undoItems.clear ();
 
+  m_spilledUndoCount = 0;
+  if (m_spillFile)
+    m_spillFile->resize(0);
+
   lastUndoGroupWhenSaved = 0;
   docWasSavedWhenUndoWasEmpty = false;
 
@@ -353,6 +397,9 @@ void KateUndoManager::clearUndo()
 
 void KateUndoManager::clearRedo()
 {
+  foreach (KateUndoGroup* undoGroup, redoItems)
+    m_memoryUsage -= undoGroup->memoryUsage();
+
   qDeleteAll(redoItems);
   redoItems.clear ();
 
@@ -381,16 +428,14 @@ void KateUndoManager::setModified(bool modified)
 
 void KateUndoManager::updateLineModifications()
 {
-  // change LineSaved flag of all undo & redo items to LineModified
-  foreach (KateUndoGroup* undoGroup, undoItems)
-    undoGroup->flagSavedAsModified();
-
-  foreach (KateUndoGroup* undoGroup, redoItems)
-    undoGroup->flagSavedAsModified();
+  // change LineSaved flag of all undo & redo items to LineModified,
+  // each group does this itself the next time it is used
+  ++m_saveCount;
 
-  // iterate all undo/redo items to find out, which item sets the flag LineSaved
+  // iterate the undo/redo items in memory to find out, which item sets the flag LineSaved,
+  // lines only touched by spilled groups stay LineModified
   QBitArray lines(document()->lines(), false);
-  for (int i = undoItems.size() - 1; i >= 0; --i) {
+  for (int i = undoItems.size() - 1; i >= m_spilledUndoCount; --i) {
     undoItems[i]->markRedoAsSaved(lines);
   }
 
@@ -402,6 +447,9 @@ void KateUndoManager::updateLineModifications()
 
 void KateUndoManager::updateConfig ()
 {
+  // the memory limit might be lower now
+  spillUndoGroups ();
+
   emit undoChanged ();
 }
 
@@ -415,4 +463,80 @@ KTextEditor::View* KateUndoManager::activeView()
   return m_document->activeView();
 }
 
+void KateUndoManager::spillUndoGroups()
+{
+  const qint64 memoryLimit = qint64(m_document->config()->undoMemoryLimit()) * 1024 * 1024;
+  if (memoryLimit <= 0 || m_memoryUsage <= memoryLimit)
+    return;
+
+  if (!m_spillFile) {
+    m_spillFile = new KTemporaryFile ();
+    if (!m_spillFile->open())
+      kWarning() << "can't create undo spill file, the undo history stays in memory";
+  }
+
+  if (!m_spillFile->isOpen())
+    return;
+
+  // spill oldest first, the newest group stays in memory as the next edit might merge into it
+  while (m_memoryUsage > memoryLimit && m_spilledUndoCount < undoItems.size() - 1) {
+    KateUndoGroup *undoGroup = undoItems[m_spilledUndoCount];
+    const qint64 memoryUsage = undoGroup->memoryUsage();
+
+    if (!undoGroup->spill(m_spillFile)) {
+      kWarning() << "can't write undo spill file" << m_spillFile->fileName();
+      break;
+    }
+
+    m_memoryUsage -= memoryUsage;
+    ++m_spilledUndoCount;
+  }
+}
+
+bool KateUndoManager::loadLastUndoGroup()
+{
+  KateUndoGroup *undoGroup = undoItems.last();
+  if (!undoGroup->isSpilled())
+    return true;
+
+  // spilled groups are always the oldest ones, so this was the last one
+  Q_ASSERT(m_spilledUndoCount == undoItems.size());
+
+  if (!undoGroup->load(m_spillFile)) {
+    kWarning() << "can't read undo spill file" << m_spillFile->fileName();
+    discardSpilledUndoGroups();
+    return false;
+  }
+
+  m_memoryUsage += undoGroup->memoryUsage();
+
+  // no group left on disk, the file can start over
+  if (--m_spilledUndoCount == 0)
+    m_spillFile->resize(0);
+
+  return true;
+}
+
+void KateUndoManager::discardSpilledUndoGroups()
+{
+  // the spilled groups are the oldest ones and use no memory
+  for (int i = 0; i < m_spilledUndoCount; ++i) {
+    if (undoItems[i] == lastUndoGroupWhenSaved)
+      lastUndoGroupWhenSaved = 0;
+    delete undoItems[i];
+  }
+  undoItems.erase(undoItems.begin(), undoItems.begin() + m_spilledUndoCount);
+
+  m_spilledUndoCount = 0;
+  m_spillFile->resize(0);
+
+  KTextEditor::Message *message
+    = new KTextEditor::Message(KTextEditor::Message::Warning
+        , i18n ("The older part of the undo history could not be read back from disk and was discarded."));
+  message->setWordWrap(true);
+  m_document->postMessage(message);
+
+  emit undoChanged ();
+}
+
 // kate: space-indent on; indent-width 2; replace-tabs on;
@@ -24,10 +24,12 @@
 #include "katepartprivate_export.h"
 
 #include <QtCore/QList>
+#include <QtCore/QStringList>
 
 class KateDocument;
 class KateUndo;
 class KateUndoGroup;
+class KTemporaryFile;
 
 namespace KTextEditor {
   class Document;
@@ -40,11 +42,16 @@ namespace KTextEditor {
  * @li a state in which a new element is being added to the history.
  *
  * The state of the KateUndomanager can be switched using editStart() and editEnd().
+ *
+ * If the history uses more memory than KateDocumentConfig::undoMemoryLimit() allows,
+ * the oldest undo groups are moved to a temporary file and read back once they are undone.
  */
 class KATEPART_TESTS_EXPORT KateUndoManager : public QObject
 {
   Q_OBJECT
 
+  friend class UndoManagerTest;
+
   public:
     /**
      * Creates a clean undo history.
@@ -92,6 +99,12 @@ class KATEPART_TESTS_EXPORT KateUndoManager : public QObject
     void updateConfig ();
     void updateLineModifications();
 
+    /**
+     * How often updateLineModifications() was called, undo groups compare this
+     * to find out whether their LineSaved flags are outdated.
+     */
+    int saveCount() const { return m_saveCount; }
+
   public Q_SLOTS:
     /**
      * Undo the latest undo group.
@@ -161,6 +174,16 @@ class KATEPART_TESTS_EXPORT KateUndoManager : public QObject
      */
     void slotLineRemoved(int line, const QString &s);
 
+    /**
+     * Notify KateUndoManager that whole lines were inserted in one step.
+     */
+    void slotLinesInserted(int line, const QStringList &texts);
+
+    /**
+     * Notify KateUndoManager that whole lines were removed in one step.
+     */
+    void slotLinesRemoved(int line, const QStringList &texts);
+
   Q_SIGNALS:
     void undoChanged ();
     void undoStart (KTextEditor::Document*);
@@ -187,6 +210,24 @@ class KATEPART_TESTS_EXPORT KateUndoManager : public QObject
   private:
     KTextEditor::View *activeView();
 
+    /**
+     * Move the oldest undo groups to the spill file until the history
+     * fits into the memory limit again.
+     */
+    void spillUndoGroups();
+
+    /**
+     * Read the last undo group back from the spill file, if it is there.
+     * If the spill file can't be read, the spilled groups are discarded.
+     * @return false if the last undo group is gone
+     */
+    bool loadLastUndoGroup();
+
+    /**
+     * Drop the undo groups in the spill file and tell the user the history is shorter now.
+     */
+    void discardSpilledUndoGroups();
+
   private:
     KateDocument *m_document;
     bool m_undoComplexMerge;
@@ -200,6 +241,26 @@ class KATEPART_TESTS_EXPORT KateUndoManager : public QObject
     KateUndoGroup* lastRedoGroupWhenSaved;
     bool docWasSavedWhenUndoWasEmpty;
     bool docWasSavedWhenRedoWasEmpty;
+
+    /**
+     * temporary file for undo groups exceeding the memory limit, created on demand
+     */
+    KTemporaryFile *m_spillFile;
+
+    /**
+     * the first m_spilledUndoCount undo groups are in the spill file
+     */
+    int m_spilledUndoCount;
+
+    /**
+     * approximate memory used by the undo and redo groups, without the spilled ones
+     */
+    qint64 m_memoryUsage;
+
+    /**
+     * see saveCount()
+     */
+    int m_saveCount;
 };
 
 #endif
@@ -191,6 +191,7 @@ KateDocumentConfig::KateDocumentConfig ()
    m_swapFileNoSyncSet (true),
    m_onTheFlySpellCheckSet (true),
    m_lineLengthLimitSet (true),
+   m_undoMemoryLimitSet (true),
    m_doc (0)
 {
   s_global = this;
@@ -235,6 +236,7 @@ KateDocumentConfig::KateDocumentConfig (const KConfigGroup &cg)
    m_swapFileNoSyncSet (true),
    m_onTheFlySpellCheckSet (true),
    m_lineLengthLimitSet (true),
+   m_undoMemoryLimitSet (true),
    m_doc (0)
 {
   // init with defaults from config or really hardcoded ones
@@ -273,6 +275,7 @@ KateDocumentConfig::KateDocumentConfig (KateDocument *doc)
    m_swapFileNoSyncSet (false),
    m_onTheFlySpellCheckSet (false),
    m_lineLengthLimitSet (false),
+   m_undoMemoryLimitSet (false),
    m_doc (doc)
 {
 }
@@ -332,6 +335,8 @@ void KateDocumentConfig::readConfig (const KConfigGroup &config)
 
   setLineLengthLimit(config.readEntry("Line Length Limit", 4096));
 
+  setUndoMemoryLimit(config.readEntry("Undo Memory Limit", 256));
+
   configEnd ();
 }
 
@@ -383,6 +388,8 @@ void KateDocumentConfig::writeConfig (KConfigGroup &config)
   config.writeEntry("On-The-Fly Spellcheck", onTheFlySpellCheck());
 
   config.writeEntry("Line Length Limit", lineLengthLimit());
+
+  config.writeEntry("Undo Memory Limit", undoMemoryLimit());
 }
 
 void KateDocumentConfig::updateConfig ()
@@ -1007,6 +1014,24 @@ void KateDocumentConfig::setLineLengthLimit(int lineLengthLimit)
   configEnd();
 }
 
+int KateDocumentConfig::undoMemoryLimit() const
+{
+  if (m_undoMemoryLimitSet || isGlobal())
+    return m_undoMemoryLimit;
+
+  return s_global->undoMemoryLimit();
+}
+
+void KateDocumentConfig::setUndoMemoryLimit(int limit)
+{
+  configStart();
+
+  m_undoMemoryLimitSet = true;
+  m_undoMemoryLimit = limit;
+
+  configEnd();
+}
+
 
 
 //END
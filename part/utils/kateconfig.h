@@ -307,6 +307,14 @@ class KATEPART_TESTS_EXPORT KateDocumentConfig : public KateConfig
     int lineLengthLimit() const;
     void setLineLengthLimit(int limit);
 
+    /**
+     * Memory the undo history of a document may use, older undo steps
+     * are moved to a temporary file if it grows larger.
+     * @return limit in MB (<= 0 no limit)
+     */
+    int undoMemoryLimit() const;
+    void setUndoMemoryLimit(int limit);
+
 
   private:
     QString m_indentationMode;
@@ -329,6 +337,7 @@ class KATEPART_TESTS_EXPORT KateDocumentConfig : public KateConfig
     bool m_swapFileNoSync;
     bool m_onTheFlySpellCheck;
     int m_lineLengthLimit;
+    int m_undoMemoryLimit;
 
     bool m_tabWidthSet : 1;
     bool m_indentationWidthSet : 1;
@@ -372,6 +381,7 @@ class KATEPART_TESTS_EXPORT KateDocumentConfig : public KateConfig
     bool m_swapFileNoSyncSet : 1;
     bool m_onTheFlySpellCheckSet : 1;
     bool m_lineLengthLimitSet : 1;
+    bool m_undoMemoryLimitSet : 1;
 
   private:
     static KateDocumentConfig *s_global;
@@ -36,6 +36,7 @@
 #include "katepartpluginmanager.h"
 #include "kateviglobal.h"
 #include "katewordcompletion.h"
+#include "katewordindex.h"
 #include "spellcheck/spellcheck.h"
 #include "snippet/katesnippetglobal.h"
 
@@ -188,7 +189,8 @@ KateGlobal::KateGlobal ()
   for ( QList<KTextEditor::Command *>::iterator it = m_cmds.begin(); it != m_cmds.end(); ++it )
     m_cmdManager->registerCommand (*it);
 
-  // global word completion model
+  // global word index and word completion model
+  m_wordIndex = new KateWordIndex (this);
   m_wordCompletionModel = new KateWordCompletionModel (this);
 
   //
@@ -229,6 +231,7 @@ KateGlobal::~KateGlobal()
 
   // cu model
   delete m_wordCompletionModel;
+  delete m_wordIndex;
 
   s_self = 0;
 }
@@ -473,10 +476,12 @@ void KateGlobal::registerDocument ( KateDocument *doc )
   KateGlobal::incRef ();
   m_documents.append( doc );
   m_docs.append (doc);
+  m_wordIndex->addDocument (doc);
 }
 
 void KateGlobal::deregisterDocument ( KateDocument *doc )
 {
+  m_wordIndex->removeDocument (doc);
   m_docs.removeAll (doc);
   m_documents.removeAll( doc );
   KateGlobal::decRef ();
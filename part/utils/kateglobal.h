@@ -52,6 +52,7 @@ class KatePartPluginManager;
 class KateSpellCheckManager;
 class KateViGlobal;
 class KateWordCompletionModel;
+class KateWordIndex;
 class KateSnippetGlobal;
 
 namespace Kate {
@@ -349,6 +350,12 @@ class KATEPART_TESTS_EXPORT KateGlobal : public KTextEditor::Editor, public KTex
      */
     KateWordCompletionModel *wordCompletionModel () { return m_wordCompletionModel; }
 
+    /**
+     * global index of the words of all documents, used by the word completion
+     * @return global word index
+     */
+    KateWordIndex *wordIndex () { return m_wordIndex; }
+
     /**
      * global instance of the snippet handling
      * lazy constructed on first use to allow it to use the session config
@@ -547,6 +554,11 @@ class KATEPART_TESTS_EXPORT KateGlobal : public KTextEditor::Editor, public KTex
      */
     KateWordCompletionModel *m_wordCompletionModel;
 
+    /**
+     * global index of the words of all documents
+     */
+    KateWordIndex *m_wordIndex;
+
     /**
      * global instance of the snippet handling
      */
@@ -27,6 +27,10 @@ KateViCommand::KateViCommand( KateViNormalMode *parent, QString pattern,
   m_pattern = KateViKeyParser::self()->encodeKeySequence( pattern );
   m_flags = flags;
   m_ptr2commandMethod = commandMethod;
+
+  if ( m_flags & REGEX_PATTERN ) {
+    m_regExp = QRegExp( m_pattern );
+  }
 }
 
 KateViCommand::~KateViCommand()
@@ -43,9 +47,8 @@ bool KateViCommand::matches( const QString &pattern ) const
   if ( !( m_flags & REGEX_PATTERN ) )
     return m_pattern.startsWith( pattern );
   else {
-    QRegExp re( m_pattern );
-    re.exactMatch( pattern );
-    return ( re.matchedLength() == pattern.length() );
+    m_regExp.exactMatch( pattern );
+    return ( m_regExp.matchedLength() == pattern.length() );
   }
 }
 
@@ -54,7 +57,29 @@ bool KateViCommand::matchesExact( const QString &pattern ) const
   if ( !( m_flags & REGEX_PATTERN ) )
     return ( m_pattern == pattern );
   else {
-    QRegExp re( m_pattern );
-    return re.exactMatch( pattern );
+    return m_regExp.exactMatch( pattern );
   }
 }
+
+QString KateViCommand::literalPrefix() const
+{
+  if ( !( m_flags & REGEX_PATTERN ) )
+    return m_pattern;
+
+  // with alternatives, there is no common start
+  if ( m_pattern.contains( '|' ) )
+    return QString();
+
+  // stop at the first character with a special meaning in a regex
+  const QString special = QLatin1String( "\\.[]()^$*+?{}" );
+  int i = 0;
+  while ( i < m_pattern.length() && !special.contains( m_pattern.at( i ) ) )
+    ++i;
+
+  // a quantifier allowing zero repetitions applies to the character before it
+  if ( i > 0 && i < m_pattern.length()
+      && ( m_pattern.at( i ) == '*' || m_pattern.at( i ) == '?' || m_pattern.at( i ) == '{' ) )
+    --i;
+
+  return m_pattern.left( i );
+}
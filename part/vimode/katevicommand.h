@@ -23,6 +23,8 @@
 #include "katevikeyparser.h"
 #include "katepartprivate_export.h"
 
+#include <QtCore/QRegExp>
+
 #ifndef KATE_VI_COMMAND_H
 #define KATE_VI_COMMAND_H
 
@@ -42,6 +44,9 @@ class KATEPART_TESTS_EXPORT KateViCommand {
         bool ( KateViNormalMode::*pt2Func)(), unsigned int flags = 0 );
     ~KateViCommand();
 
+    /**
+     * @return true if the keys are the beginning of this command
+     */
     bool matches( const QString &pattern ) const;
     bool matchesExact( const QString &pattern ) const;
     bool execute() const;
@@ -52,12 +57,20 @@ class KATEPART_TESTS_EXPORT KateViCommand {
     bool isChange() const { return m_flags & IS_CHANGE; }
     bool isLineWise() const { return !(m_flags & IS_NOT_LINEWISE); }
 
+    /**
+     * the keys every match of the pattern starts with, all of it for non-regex patterns
+     */
+    QString literalPrefix() const;
+
   protected:
     KateViNormalMode *m_parent;
     QString m_pattern;
     unsigned int m_flags;
     bool ( KateViNormalMode::*m_ptr2commandMethod)();
     KateViKeyParser *m_keyParser;
+
+    // compiled once, matching against it is done for each key press
+    mutable QRegExp m_regExp;
 };
 
 #endif
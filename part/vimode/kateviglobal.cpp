@@ -143,10 +143,14 @@ void KateViGlobal::addMapping( ViMode mode, const QString &from, const QString &
 {
   if ( !from.isEmpty() ) {
     switch ( mode ) {
-    case NormalMode:
-      m_normalModeMappings[ KateViKeyParser::self()->encodeKeySequence( from ) ]
-        = KateViKeyParser::self()->encodeKeySequence( to );
+    case NormalMode: {
+      const QString encodedFrom = KateViKeyParser::self()->encodeKeySequence( from );
+      if ( !m_normalModeMappings.contains( encodedFrom ) ) {
+        m_normalModeMappingTrie.insert( encodedFrom, 0 );
+      }
+      m_normalModeMappings[ encodedFrom ] = KateViKeyParser::self()->encodeKeySequence( to );
       break;
+    }
     default:
       kDebug( 13070 ) << "Mapping not supported for given mode";
     }
@@ -191,11 +195,24 @@ const QStringList KateViGlobal::getMappings( ViMode mode, bool decode ) const
   return l;
 }
 
+const KateViKeyTrie &KateViGlobal::getMappingTrie( ViMode mode ) const
+{
+  static const KateViKeyTrie noMappings;
+
+  switch ( mode ) {
+  case NormalMode:
+    return m_normalModeMappingTrie;
+  default:
+    return noMappings;
+  }
+}
+
 void KateViGlobal::clearMappings( ViMode mode )
 {
   switch (mode ) {
   case NormalMode:
     m_normalModeMappings.clear();
+    m_normalModeMappingTrie.clear();
     break;
   default:
     kDebug( 13070 ) << "Mapping not supported for given mode";
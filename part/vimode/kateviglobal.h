@@ -29,6 +29,7 @@
 
 #include "katevimodebase.h"
 #include "kateviinputmodemanager.h"
+#include "katevikeytrie.h"
 #include "katepartprivate_export.h"
 
 class QString;
@@ -61,6 +62,11 @@ public:
     const QString getMapping( ViMode mode, const QString &from, bool decode = false ) const;
     const QStringList getMappings( ViMode mode, bool decode = false ) const;
 
+    /**
+     * the encoded mapping keys of a mode as trie, to check typed keys against all mappings at once
+     */
+    const KateViKeyTrie &getMappingTrie( ViMode mode ) const;
+
 private:
     // registers
     QList<KateViRegister> m_numberedRegisters;
@@ -71,6 +77,7 @@ private:
 
     // mappings
     QHash <QString, QString> m_normalModeMappings;
+    KateViKeyTrie m_normalModeMappingTrie;
 
 };
 
@@ -0,0 +1,99 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "katevikeytrie.h"
+
+KateViKeyTrie::KateViKeyTrie()
+{
+  clear();
+}
+
+void KateViKeyTrie::clear()
+{
+  // the root node is always there
+  m_nodes.clear();
+  m_nodes.resize( 1 );
+}
+
+void KateViKeyTrie::insert( const QString &keys, int value )
+{
+  int node = 0;
+  m_nodes[ node ].subtreeValues.append( value );
+
+  foreach ( const QChar &key, keys ) {
+    int child = m_nodes.at( node ).children.value( key, -1 );
+    if ( child < 0 ) {
+      child = m_nodes.size();
+      m_nodes[ node ].children.insert( key, child );
+      m_nodes.resize( child + 1 );
+    }
+
+    node = child;
+    m_nodes[ node ].subtreeValues.append( value );
+  }
+
+  m_nodes[ node ].values.append( value );
+}
+
+bool KateViKeyTrie::contains( const QString &keys ) const
+{
+  const int node = findNode( keys );
+  return node >= 0 && !m_nodes.at( node ).values.isEmpty();
+}
+
+bool KateViKeyTrie::hasLongerSequence( const QString &keys ) const
+{
+  const int node = findNode( keys );
+  return node >= 0 && !m_nodes.at( node ).children.isEmpty();
+}
+
+QVector<int> KateViKeyTrie::valuesWithPrefix( const QString &keys ) const
+{
+  const int node = findNode( keys );
+  return ( node >= 0 ) ? m_nodes.at( node ).subtreeValues : QVector<int>();
+}
+
+QVector<int> KateViKeyTrie::valuesOfPrefixes( const QString &keys ) const
+{
+  QVector<int> values = m_nodes.at( 0 ).values;
+
+  int node = 0;
+  foreach ( const QChar &key, keys ) {
+    node = m_nodes.at( node ).children.value( key, -1 );
+    if ( node < 0 )
+      break;
+
+    values += m_nodes.at( node ).values;
+  }
+
+  return values;
+}
+
+int KateViKeyTrie::findNode( const QString &keys ) const
+{
+  int node = 0;
+  foreach ( const QChar &key, keys ) {
+    node = m_nodes.at( node ).children.value( key, -1 );
+    if ( node < 0 )
+      return -1;
+  }
+
+  return node;
+}
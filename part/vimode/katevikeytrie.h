@@ -0,0 +1,93 @@
+/*  This file is part of the KDE libraries and the Kate part.
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KATE_VI_KEY_TRIE_H
+#define KATE_VI_KEY_TRIE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "katepartprivate_export.h"
+
+/**
+ * Trie of encoded key sequences, used to find the commands, motions and
+ * mappings for the typed keys without looking at all of them.
+ *
+ * Each key sequence has an integer value, e.g. the index of its command.
+ * Every node knows the values of all sequences below it, in insertion order,
+ * so all sequences starting with some keys are found in O(number of keys).
+ */
+class KATEPART_TESTS_EXPORT KateViKeyTrie
+{
+  public:
+    KateViKeyTrie();
+
+    /**
+     * remove all key sequences
+     */
+    void clear();
+
+    /**
+     * add a key sequence
+     * @param keys encoded key sequence
+     * @param value value of the sequence, e.g. a command index
+     */
+    void insert( const QString &keys, int value );
+
+    /**
+     * @return true if the exact key sequence was inserted
+     */
+    bool contains( const QString &keys ) const;
+
+    /**
+     * @return true if a longer key sequence starting with keys was inserted
+     */
+    bool hasLongerSequence( const QString &keys ) const;
+
+    /**
+     * values of all sequences starting with keys, including keys itself
+     * @return values in insertion order
+     */
+    QVector<int> valuesWithPrefix( const QString &keys ) const;
+
+    /**
+     * values of all sequences keys starts with, including keys itself
+     * @return values, the shortest sequences first
+     */
+    QVector<int> valuesOfPrefixes( const QString &keys ) const;
+
+  private:
+    /**
+     * find the node of a key sequence
+     * @return node index or -1 if no sequence starts with keys
+     */
+    int findNode( const QString &keys ) const;
+
+    struct Node {
+      QHash<QChar, int> children; // node index for each next key
+      QVector<int> values;        // values of the sequences ending here
+      QVector<int> subtreeValues; // values of the sequences ending here or below
+    };
+
+    QVector<Node> m_nodes;
+};
+
+#endif
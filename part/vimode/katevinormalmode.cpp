@@ -37,6 +37,8 @@
 #include <QApplication>
 #include <QList>
 
+#include <algorithm>
+
 using KTextEditor::Cursor;
 using KTextEditor::Range;
 
@@ -146,18 +148,12 @@ bool KateViNormalMode::handleKeypress( const QKeyEvent *e )
   if ( !m_mappingKeyPress && !m_ignoreMapping) {
     m_mappingKeys.append( key );
 
-    bool isPartialMapping = false;
-    bool isFullMapping = false;
+    const KateViKeyTrie &mappings = KateGlobal::self()->viInputModeGlobal()->getMappingTrie( NormalMode );
+    const bool isPartialMapping = mappings.hasLongerSequence( m_mappingKeys );
+    const bool isFullMapping = mappings.contains( m_mappingKeys );
     m_fullMappingMatch.clear();
-    foreach ( const QString &mapping, getMappings() ) {
-      if ( mapping.startsWith( m_mappingKeys ) ) {
-        if ( mapping == m_mappingKeys ) {
-          isFullMapping = true;
-          m_fullMappingMatch = mapping;
-        } else {
-          isPartialMapping = true;
-        }
-      }
+    if ( isFullMapping ) {
+      m_fullMappingMatch = m_mappingKeys;
     }
     if (isFullMapping && !isPartialMapping)
     {
@@ -291,13 +287,11 @@ bool KateViNormalMode::handleKeypress( const QKeyEvent *e )
       }
     }
   } else {
-    // go through all registered commands and put possible matches in m_matchingCommands
-    for ( int i = 0; i < m_commands.size(); i++ ) {
-      if ( m_commands.at( i )->matches( m_keys ) ) {
-        m_matchingCommands.push_back( i );
-        if ( m_commands.at( i )->needsMotion() && m_commands.at( i )->pattern().length() == m_keys.size() ) {
-          m_awaitingMotionOrTextObject.push( m_keys.size() );
-        }
+    // look up the possible matches of all registered commands and put them in m_matchingCommands
+    m_matchingCommands = findMatchingCommands( m_keys );
+    foreach ( int i, m_matchingCommands ) {
+      if ( m_commands.at( i )->needsMotion() && m_commands.at( i )->pattern().length() == m_keys.size() ) {
+        m_awaitingMotionOrTextObject.push( m_keys.size() );
       }
     }
   }
@@ -319,100 +313,98 @@ bool KateViNormalMode::handleKeypress( const QKeyEvent *e )
   // FIXME: if checkFrom hasn't changed, only motions whose index is in
   // m_matchingMotions should be checked
   if ( checkFrom < m_keys.size() ) {
-    for ( int i = 0; i < m_motions.size(); i++ ) {
-      //kDebug( 13070 )  << "\tchecking " << m_keys.mid( checkFrom )  << " against " << m_motions.at( i )->pattern();
-      if ( m_motions.at( i )->matches( m_keys.mid( checkFrom ) ) ) {
-        //kDebug( 13070 )  << m_keys.mid( checkFrom ) << " matches!";
-        m_matchingMotions.push_back( i );
-
-        // if it matches exact, we have found the motion command to execute
-        if ( m_motions.at( i )->matchesExact( m_keys.mid( checkFrom ) ) ) {
-          if ( checkFrom == 0 ) {
-            // no command given before motion, just move the cursor to wherever
-            // the motion says it should go to
-            KateViRange r = m_motions.at( i )->execute();
-
-            // jump over folding regions since we are just moving the cursor
-            int currLine = m_view->cursorPosition().line();
-            int delta = r.endLine - currLine;
-            int vline = doc()->foldingTree()->getVirtualLine( currLine );
-            r.endLine = doc()->foldingTree()->getRealLine( vline+delta );
-            if ( r.endLine >= doc()->lines() ) r.endLine = doc()->lines()-1;
-
-            // make sure the position is valid before moving the cursor there
-            // TODO: can this be simplified? :/
-            if ( r.valid
-                && r.endLine >= 0
-                && ( r.endLine == 0 || r.endLine <= doc()->lines()-1 )
-                && r.endColumn >= 0 ) {
-               if ( r.endColumn >= doc()->lineLength( r.endLine )
-                   && doc()->lineLength( r.endLine ) > 0 ) {
-                   r.endColumn = doc()->lineLength( r.endLine ) - 1;
-               }
-
-              kDebug( 13070 ) << "No command given, going to position ("
-                << r.endLine << "," << r.endColumn << ")";
-              goToPos( r );
-              m_viInputModeManager->clearLog();
-            } else {
-              kDebug( 13070 ) << "Invalid position: (" << r.endLine << "," << r.endColumn << ")";
-            }
-
-            resetParser();
-
-            // if normal mode was started by using Ctrl-O in insert mode,
-            // it's time to go back to insert mode.
-            if (m_viInputModeManager->getTemporaryNormalMode()) {
-                startInsertMode();
-                m_viewInternal->repaint();
-            }
-
-            return true;
+    const QString motionKeys = m_keys.mid( checkFrom );
+    foreach ( int i, findMatchingMotions( motionKeys ) ) {
+      //kDebug( 13070 )  << motionKeys << " matches " << m_motions.at( i )->pattern();
+      m_matchingMotions.push_back( i );
+
+      // if it matches exact, we have found the motion command to execute
+      if ( m_motions.at( i )->matchesExact( motionKeys ) ) {
+        if ( checkFrom == 0 ) {
+          // no command given before motion, just move the cursor to wherever
+          // the motion says it should go to
+          KateViRange r = m_motions.at( i )->execute();
+
+          // jump over folding regions since we are just moving the cursor
+          int currLine = m_view->cursorPosition().line();
+          int delta = r.endLine - currLine;
+          int vline = doc()->foldingTree()->getVirtualLine( currLine );
+          r.endLine = doc()->foldingTree()->getRealLine( vline+delta );
+          if ( r.endLine >= doc()->lines() ) r.endLine = doc()->lines()-1;
+
+          // make sure the position is valid before moving the cursor there
+          // TODO: can this be simplified? :/
+          if ( r.valid
+              && r.endLine >= 0
+              && ( r.endLine == 0 || r.endLine <= doc()->lines()-1 )
+              && r.endColumn >= 0 ) {
+             if ( r.endColumn >= doc()->lineLength( r.endLine )
+                 && doc()->lineLength( r.endLine ) > 0 ) {
+                 r.endColumn = doc()->lineLength( r.endLine ) - 1;
+             }
+
+            kDebug( 13070 ) << "No command given, going to position ("
+              << r.endLine << "," << r.endColumn << ")";
+            goToPos( r );
+            m_viInputModeManager->clearLog();
+          } else {
+            kDebug( 13070 ) << "Invalid position: (" << r.endLine << "," << r.endColumn << ")";
+          }
+
+          resetParser();
+
+          // if normal mode was started by using Ctrl-O in insert mode,
+          // it's time to go back to insert mode.
+          if (m_viInputModeManager->getTemporaryNormalMode()) {
+              startInsertMode();
+              m_viewInternal->repaint();
+          }
+
+          return true;
+        } else {
+          // execute the specified command and supply the position returned from
+          // the motion
+
+          m_commandRange = m_motions.at( i )->execute();
+          m_linewiseCommand = m_motions.at( i )->isLineWise();
+
+          // if we didn't get an explicit start position, use the current cursor position
+          if ( m_commandRange.startLine == -1 ) {
+            Cursor c( m_view->cursorPosition() );
+            m_commandRange.startLine = c.line();
+            m_commandRange.startColumn = c.column();
+          }
+
+          // special case: When using the "w" motion in combination with an operator and
+          // the last word moved over is at the end of a line, the end of that word
+          // becomes the end of the operated text, not the first word in the next line.
+          if ( m_keys.right(1) == "w" || m_keys.right(1) == "W" ) {
+             if(m_commandRange.endLine != m_commandRange.startLine &&
+                 m_commandRange.endColumn == getLine(m_commandRange.endLine).indexOf( QRegExp("\\S") )){
+                   m_commandRange.endLine--;
+                   m_commandRange.endColumn = doc()->lineLength(m_commandRange.endLine );
+                 }
+          }
+
+          m_commandWithMotion = true;
+
+          if ( m_commandRange.valid ) {
+            kDebug( 13070 ) << "Run command" << m_commands.at( m_motionOperatorIndex )->pattern()
+              << "from (" << m_commandRange.startLine << "," << m_commandRange.endLine << ")"
+              << "to (" << m_commandRange.endLine << "," << m_commandRange.endColumn << ")";
+            executeCommand( m_commands.at( m_motionOperatorIndex ) );
           } else {
-            // execute the specified command and supply the position returned from
-            // the motion
-
-            m_commandRange = m_motions.at( i )->execute();
-            m_linewiseCommand = m_motions.at( i )->isLineWise();
-
-            // if we didn't get an explicit start position, use the current cursor position
-            if ( m_commandRange.startLine == -1 ) {
-              Cursor c( m_view->cursorPosition() );
-              m_commandRange.startLine = c.line();
-              m_commandRange.startColumn = c.column();
-            }
-
-            // special case: When using the "w" motion in combination with an operator and
-            // the last word moved over is at the end of a line, the end of that word
-            // becomes the end of the operated text, not the first word in the next line.
-            if ( m_keys.right(1) == "w" || m_keys.right(1) == "W" ) {
-               if(m_commandRange.endLine != m_commandRange.startLine &&
-                   m_commandRange.endColumn == getLine(m_commandRange.endLine).indexOf( QRegExp("\\S") )){
-                     m_commandRange.endLine--;
-                     m_commandRange.endColumn = doc()->lineLength(m_commandRange.endLine );
-                   }
-            }
-
-            m_commandWithMotion = true;
-
-            if ( m_commandRange.valid ) {
-              kDebug( 13070 ) << "Run command" << m_commands.at( m_motionOperatorIndex )->pattern()
-                << "from (" << m_commandRange.startLine << "," << m_commandRange.endLine << ")"
-                << "to (" << m_commandRange.endLine << "," << m_commandRange.endColumn << ")";
-              executeCommand( m_commands.at( m_motionOperatorIndex ) );
-            } else {
-              kDebug( 13070 ) << "Invalid range: "
-                << "from (" << m_commandRange.startLine << "," << m_commandRange.endLine << ")"
-                << "to (" << m_commandRange.endLine << "," << m_commandRange.endColumn << ")";
-            }
-
-            if( m_viInputModeManager->getCurrentViMode() == NormalMode ) {
-              m_view->setCaretStyle( KateRenderer::Block, true );
-            }
-            m_commandWithMotion = false;
-            reset();
-            return true;
+            kDebug( 13070 ) << "Invalid range: "
+              << "from (" << m_commandRange.startLine << "," << m_commandRange.endLine << ")"
+              << "to (" << m_commandRange.endLine << "," << m_commandRange.endColumn << ")";
           }
+
+          if( m_viInputModeManager->getCurrentViMode() == NormalMode ) {
+            m_view->setCaretStyle( KateRenderer::Block, true );
+          }
+          m_commandWithMotion = false;
+          reset();
+          return true;
         }
       }
     }
@@ -3122,6 +3114,70 @@ void KateViNormalMode::initializeCommands()
   ADDMOTION("a[\\[\\]]", textObjectABracket, REGEX_PATTERN  | IS_NOT_LINEWISE);
   ADDMOTION("i,", textObjectInnerComma, IS_NOT_LINEWISE );
   ADDMOTION("a,", textObjectAComma, IS_NOT_LINEWISE);
+
+  compileCommands();
+}
+
+/**
+ * put each command in the literal trie by its pattern or in the regex trie by
+ * the keys every match starts with
+ */
+template <class Command>
+static void compileTries( const QVector<Command *> &commands, KateViKeyTrie &literal, KateViKeyTrie &regex )
+{
+  literal.clear();
+  regex.clear();
+
+  for ( int i = 0; i < commands.size(); i++ ) {
+    if ( commands.at( i )->isRegexPattern() ) {
+      regex.insert( commands.at( i )->literalPrefix(), i );
+    } else {
+      literal.insert( commands.at( i )->pattern(), i );
+    }
+  }
+}
+
+/**
+ * all non-regex commands below the node of the keys match, regex commands can only
+ * match if their literal prefix is below that node or on the way to it
+ */
+template <class Command>
+static QVector<int> matchingIndices( const QVector<Command *> &commands, const KateViKeyTrie &literal,
+    const KateViKeyTrie &regex, const QString &keys )
+{
+  QVector<int> indices = literal.valuesWithPrefix( keys );
+
+  QVector<int> regexIndices = regex.valuesOfPrefixes( keys ) + regex.valuesWithPrefix( keys );
+  if ( regexIndices.isEmpty() ) {
+    return indices;
+  }
+
+  foreach ( int i, regexIndices ) {
+    if ( commands.at( i )->matches( keys ) ) {
+      indices.append( i );
+    }
+  }
+
+  // keep the order of registration, the node of the keys itself was looked at twice
+  qSort( indices );
+  indices.erase( std::unique( indices.begin(), indices.end() ), indices.end() );
+  return indices;
+}
+
+void KateViNormalMode::compileCommands()
+{
+  compileTries( m_commands, m_commandTrie, m_regexCommandTrie );
+  compileTries( m_motions, m_motionTrie, m_regexMotionTrie );
+}
+
+QVector<int> KateViNormalMode::findMatchingCommands( const QString &keys ) const
+{
+  return matchingIndices( m_commands, m_commandTrie, m_regexCommandTrie, keys );
+}
+
+QVector<int> KateViNormalMode::findMatchingMotions( const QString &keys ) const
+{
+  return matchingIndices( m_motions, m_motionTrie, m_regexMotionTrie, keys );
 }
 
 QRegExp KateViNormalMode::generateMatchingItemRegex()
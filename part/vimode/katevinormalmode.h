@@ -37,6 +37,7 @@
 #include <QRegExp>
 #include <ktexteditor/cursor.h>
 #include "katevikeyparser.h"
+#include "katevikeytrie.h"
 #include "katepartprivate_export.h"
 
 class KateViMotion;
@@ -276,6 +277,17 @@ class KATEPART_TESTS_EXPORT KateViNormalMode : public KateViModeBase
   protected:
     void resetParser();
     void initializeCommands();
+
+    /**
+     * build the tries of m_commands and m_motions, to be called after they changed
+     */
+    void compileCommands();
+
+    /**
+     * indices of the commands/motions the keys are the beginning of, in ascending order
+     */
+    QVector<int> findMatchingCommands( const QString &keys ) const;
+    QVector<int> findMatchingMotions( const QString &keys ) const;
     QRegExp generateMatchingItemRegex();
     virtual void goToPos( const KateViRange &r );
     void executeCommand( const KateViCommand* cmd );
@@ -300,6 +312,12 @@ class KATEPART_TESTS_EXPORT KateViNormalMode : public KateViModeBase
     QVector<KateViMotion *> m_motions;
     QVector<int> m_matchingCommands;
     QVector<int> m_matchingMotions;
+
+    // commands and motions by pattern, the regex ones by the keys every match starts with
+    KateViKeyTrie m_commandTrie;
+    KateViKeyTrie m_regexCommandTrie;
+    KateViKeyTrie m_motionTrie;
+    KateViKeyTrie m_regexMotionTrie;
     QStack<int> m_awaitingMotionOrTextObject;
     bool motionWillBeUsedWithCommand() { return !m_awaitingMotionOrTextObject.isEmpty(); };
 
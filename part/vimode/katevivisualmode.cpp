@@ -409,4 +409,6 @@ void KateViVisualMode::initializeCommands()
   ADDMOTION("a[\\[\\]]", textObjectABracket, REGEX_PATTERN );
   ADDMOTION("i,", textObjectInnerComma, 0 );
   ADDMOTION("a,", textObjectAComma, 0 );
+
+  compileCommands();
 }